@@ -33,9 +33,14 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include "cinder/Path2d.h"
+#include "cinder/gl/Fbo.h"
 #include "cinder/gl/GlslProg.h"
 #include "cinder/gl/Texture.h"
 
+#include <atomic>
+#include <functional>
+#include <limits>
 #include <unordered_map>
 
 typedef struct FT_FaceRec_*  FT_Face;
@@ -51,6 +56,10 @@ using SdfTextRef = std::shared_ptr<SdfText>;
 class SdfText {
 public:
 	typedef enum Alignment { LEFT, CENTER, RIGHT } Alignment;
+	//! How glyphs over Format::glyphCostLimit() are generated
+	enum class GlyphCostFallback { SIMPLIFY, LOWER_RESOLUTION, DEFER };
+
+	class MemoryResource;
 
 	//! \class Options
 	//!
@@ -70,12 +79,20 @@ public:
 		int32_t			getTextureHeight() const { return mTextureSize.y; }
 		//! Returns the size of the textures created internally for glyphs. Default \c 1024x1024
 		const ivec2&	getTextureSize() const { return mTextureSize; }
+		//! Sets whether the texture size is chosen from the glyph set instead of textureWidth() and textureHeight(). The power of two size up to getMaxTextureSize() that holds the glyphs in the fewest pages with the least unused space is used, and the last page is shrunk to the glyphs left for it. See AtlasStats for the result. Default \c false
+		Format&			autoTextureSize( bool value = true ) { mAutoTextureSize = value; return *this; }
+		//! Returns whether the texture size is chosen from the glyph set. Default \c false
+		bool			getAutoTextureSize() const { return mAutoTextureSize; }
+		//! Sets the largest texture width and height considered by autoTextureSize(). Default \c 4096
+		Format&			maxTextureSize( int32_t value ) { mMaxTextureSize = value; return *this; }
+		//! Returns the largest texture width and height considered by autoTextureSize(). Default \c 4096
+		int32_t			getMaxTextureSize() const { return mMaxTextureSize; }
 
 		Format&			sdfScale( const vec2 &value ) { mSdfScale = value; return *this; }
 		Format&			sdfScale( float value ) { return sdfScale( vec2( value ) ); }
 		const vec2&		getSdfScale() const { return mSdfScale; }
 
-		Format&			sdfPadding( const ivec2 &value ) { mSdfScale = value; return *this; }
+		Format&			sdfPadding( const ivec2 &value ) { mSdfPadding = value; return *this; }
 		const ivec2&	getSdfPadding() const { return mSdfPadding; }
 
 		Format&			sdfRange( float value ) { mSdfRange = value; return *this; }
@@ -87,13 +104,82 @@ public:
 		Format&			sdfTileSpacing( const ivec2& value ) { mSdfTileSpacing = value; return *this; }
 		const ivec2&	getSdfTileSpacing() const { return mSdfTileSpacing; }
 
+		//! Sets whether glyph outlines are embedded in saved SDFT files, so glyphs can be generated later without the original font. Default \c false
+		Format&			embedOutlines( bool value = true ) { mEmbedOutlines = value; return *this; }
+		//! Returns whether glyph outlines are embedded in saved SDFT files. Default \c false
+		bool			getEmbedOutlines() const { return mEmbedOutlines; }
+		//! Sets additional characters whose outlines are embedded when embedOutlines() is enabled. Their bounds are included when sizing atlas tiles. Default empty
+		Format&			embedChars( const std::string &utf8Chars ) { mEmbedChars = utf8Chars; return *this; }
+		//! Returns the additional characters whose outlines are embedded when embedOutlines() is enabled. Default empty
+		const std::string&	getEmbedChars() const { return mEmbedChars; }
+
+		//! Sets whether a single-channel SDF is generated instead of a multi-channel SDF. Uses a third of the texture memory at the cost of sharper corners. Default \c false
+		Format&			singleChannel( bool value = true ) { mSingleChannel = value; return *this; }
+		//! Returns whether a single-channel SDF is generated instead of a multi-channel SDF. Default \c false
+		bool			getSingleChannel() const { return mSingleChannel; }
+		//! Sets whether single-channel textures are block compressed (BC4/RGTC1), using 4 bits per texel. Falls back to uncompressed textures if unsupported. Default \c false
+		Format&			compressed( bool value = true ) { mCompressed = value; return *this; }
+		//! Returns whether single-channel textures are block compressed. Default \c false
+		bool			getCompressed() const { return mCompressed; }
+		//! Sets a directory that keeps the SDF tile of every generated glyph, keyed by the font data, the glyph and the generation parameters. Tiles are stored at the size of their glyph, so they fit atlases whose tile size changed with the charset. Atlas builds copy the tiles found there and only generate the others, so changed or overlapping charsets of a font reuse earlier work. Empty disables the cache. Default empty
+		Format&			glyphCacheDir( const fs::path &value ) { mGlyphCacheDir = value; return *this; }
+		//! Returns the directory that keeps generated glyph tiles. Default empty
+		const fs::path&	getGlyphCacheDir() const { return mGlyphCacheDir; }
+		//! Sets the memory resource of the glyph tables and atlas of the SdfText, it must outlive the SdfText. Atlases are only shared between SdfTexts on the global heap, see newDeleteResource(). \c nullptr uses the resource current on the creating thread, see ScopedMemoryResource. Default \c nullptr
+		Format&			memoryResource( MemoryResource *value ) { mMemoryResource = value; return *this; }
+		//! Returns the memory resource of the glyph tables and atlas. Default \c nullptr
+		MemoryResource*	getMemoryResource() const { return mMemoryResource; }
+		//! Sets a file that keeps how often each char of the SdfText is drawn. Draws are counted while the SdfText lives and saved when it is destroyed or by saveUsageProfile(). If the file exists at creation, the chars it lists are generated first, most drawn first, so they share the first atlas pages. Empty disables counting. Default empty
+		Format&			usageProfile( const fs::path &value ) { mUsageProfile = value; return *this; }
+		//! Returns the file that keeps how often each char is drawn. Default empty
+		const fs::path&	getUsageProfile() const { return mUsageProfile; }
+		//! Sets whether the requested chars missing from an existing usage profile are left out at creation, to be generated by addDeferredChars(). Default \c false
+		Format&			deferColdChars( bool value = true ) { mDeferColdChars = value; return *this; }
+		//! Returns whether chars missing from the usage profile are left out at creation. Default \c false
+		bool			getDeferColdChars() const { return mDeferColdChars; }
+		//! Sets strings representative of the text to draw. When the glyphs need more than one atlas page, glyphs used by the same strings are packed onto the same page so that a string touches as few pages, and draw calls, as possible. See AtlasStats::mPagesPerString. Empty packs in charset order. Default empty
+		Format&			pageCorpus( const std::vector<std::string> &value ) { mPageCorpus = value; return *this; }
+		//! Returns the strings that guide the packing of glyphs onto pages. Default empty
+		const std::vector<std::string>&	getPageCorpus() const { return mPageCorpus; }
+		//! Sets the SDF resolution of the high resolution tier as a multiple of sdfScale(). Glyphs drawn larger than highResThreshold() get a tile at this resolution, generated on the executor after their first use into pages of their own, while smaller text keeps using the base atlas. Until the tiles of a draw are ready it is drawn from the base atlas. Values up to 1 disable the tier. Default \c 0
+		Format&			highResScale( float value ) { mHighResScale = value; return *this; }
+		//! Returns the SDF resolution of the high resolution tier as a multiple of sdfScale(). Default \c 0
+		float			getHighResScale() const { return mHighResScale; }
+		//! Sets the font size in window pixels, DrawOptions::scale() and the current transform included, above which glyphs are drawn from the high resolution tier. Default \c 256
+		Format&			highResThreshold( float value ) { mHighResThreshold = value; return *this; }
+		//! Returns the font size in window pixels above which glyphs are drawn from the high resolution tier. Default \c 256
+		float			getHighResThreshold() const { return mHighResThreshold; }
+		//! Sets the generation cost, outline edges times tile texels, above which a glyph is generated with glyphCostFallback() instead of a full SDF. Glyphs that hit the limit are listed in AtlasStats::mCostlyGlyphs. 0 disables the limit. Default \c 0
+		Format&			glyphCostLimit( uint64_t value ) { mGlyphCostLimit = value; return *this; }
+		//! Returns the generation cost above which a glyph is generated with glyphCostFallback(). Default \c 0
+		uint64_t		getGlyphCostLimit() const { return mGlyphCostLimit; }
+		//! Sets how glyphs over glyphCostLimit() are generated. \c SIMPLIFY merges runs of outline edges into lines until the cost fits, \c LOWER_RESOLUTION renders the SDF at a fraction of the tile size and scales it up, glyphs still over the limit after either fall through to the next, \c DEFER leaves the tile blank and renders it on the executor, the tile is filled on the first draw after it completes. Default \c GlyphCostFallback::SIMPLIFY
+		Format&			glyphCostFallback( GlyphCostFallback value ) { mGlyphCostFallback = value; return *this; }
+		//! Returns how glyphs over glyphCostLimit() are generated. Default \c GlyphCostFallback::SIMPLIFY
+		GlyphCostFallback	getGlyphCostFallback() const { return mGlyphCostFallback; }
+
 	private:
 		ivec2			mTextureSize = ivec2( 1024 );
+		bool			mAutoTextureSize = false;
+		int32_t			mMaxTextureSize = 4096;
 		vec2			mSdfScale = vec2( 2.0f );
 		ivec2			mSdfPadding = vec2( 2.0f );
 		float			mSdfRange = 4.0f;
 		float			mSdfAngle = 3.0f;
 		ivec2			mSdfTileSpacing = ivec2( 1 );
+		bool			mEmbedOutlines = false;
+		std::string		mEmbedChars;
+		bool			mSingleChannel = false;
+		bool			mCompressed = false;
+		fs::path		mGlyphCacheDir;
+		MemoryResource	*mMemoryResource = nullptr;
+		fs::path		mUsageProfile;
+		bool			mDeferColdChars = false;
+		std::vector<std::string>	mPageCorpus;
+		float			mHighResScale = 0.0f;
+		float			mHighResThreshold = 256.0f;
+		uint64_t		mGlyphCostLimit = 0;
+		GlyphCostFallback	mGlyphCostFallback = GlyphCostFallback::SIMPLIFY;
 	};
 
 	// ---------------------------------------------------------------------------------------------
@@ -156,9 +242,19 @@ public:
 
 		//! Returns the user-specified glsl program if set. Otherwise returns nullptr.
 		const GlslProgRef&	getGlslProg() const { return mGlslProg; }
-		//! Sets a custom shader to use when the type is rendered.
+		//! Sets a custom shader to use when the type is rendered. The shader sets its own uniforms, only \c uEmbolden is set if it declares it.
 		DrawOptions&		glslProg( const GlslProgRef &glslProg ) { mGlslProg = glslProg; return *this; }
 
+		//! Returns the synthetic bold offset of the outline in pixels at the font size. Default \c 0
+		float			getEmbolden() const { return mEmbolden; }
+		//! Sets the synthetic bold offset of the outline in pixels at the font size, negative values thin the type. Advances grow by twice the offset. Limited to what the baked sdfRange can express, see SdfText::getEmbolden().
+		DrawOptions&	embolden( float value ) { mEmbolden = value; return *this; }
+
+		//! Returns the synthetic oblique skew. Default \c 0
+		float			getOblique() const { return mOblique; }
+		//! Sets the synthetic oblique skew as the horizontal shift per pixel above the baseline, 0.2 is about 11 degrees
+		DrawOptions&	oblique( float value ) { mOblique = value; return *this; }
+
 	  protected:
 		bool			mClipHorizontal, mClipVertical, mPixelSnap, mLigate;
 		float			mScale = 2.0;
@@ -168,6 +264,65 @@ public:
 		float			mGamma = 2.2f;
 		Alignment		mAlign = LEFT;
 		GlslProgRef		mGlslProg;
+		float			mEmbolden = 0.0f;
+		float			mOblique = 0.0f;
+	};
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \class MemoryResource
+	//!
+	//! Supplies the memory of the SdfText and SdfTextMesh containers, the C++11 counterpart of \c std::pmr::memory_resource. Derive from it to pool, bound or attribute text memory.
+	class MemoryResource {
+	public:
+		virtual ~MemoryResource() {}
+
+		//! Returns \a bytes of memory aligned to \a alignment
+		virtual void*	allocate( size_t bytes, size_t alignment ) = 0;
+		//! Releases \a ptr returned by allocate() with the same \a bytes and \a alignment
+		virtual void	deallocate( void *ptr, size_t bytes, size_t alignment ) = 0;
+		//! Returns whether memory allocated by \a other can be released by this resource
+		virtual bool	isEqual( const MemoryResource &other ) const { return this == &other; }
+	};
+
+	//! \class Allocator
+	//!
+	//! Allocator of the SdfText and SdfTextMesh containers forwarding to a MemoryResource, the counterpart of \c std::pmr::polymorphic_allocator. There is no default constructor, so every container names its resource; \c nullptr uses the resource current on the calling thread.
+	template <typename T>
+	class Allocator {
+	public:
+		using value_type = T;
+
+		Allocator( MemoryResource *resource ) : mResource( resource ? resource : SdfText::getMemoryResource() ) {}
+		template <typename U>
+		Allocator( const Allocator<U> &other ) : mResource( other.getResource() ) {}
+
+		T*				allocate( size_t n ) { return static_cast<T*>( mResource->allocate( n * sizeof( T ), alignof( T ) ) ); }
+		void			deallocate( T *ptr, size_t n ) { mResource->deallocate( ptr, n * sizeof( T ), alignof( T ) ); }
+		MemoryResource*	getResource() const { return mResource; }
+
+		template <typename U>
+		bool			operator==( const Allocator<U> &rhs ) const { return ( mResource == rhs.getResource() ) || mResource->isEqual( *rhs.getResource() ); }
+		template <typename U>
+		bool			operator!=( const Allocator<U> &rhs ) const { return ! ( *this == rhs ); }
+
+	private:
+		MemoryResource	*mResource;
+	};
+
+	//! \class ScopedMemoryResource
+	//!
+	//! Makes \a resource current on the calling thread for its lifetime. SdfText and SdfTextMesh instances created in the scope keep it, and the temporary containers of layout, measure and draw calls made in it allocate from it. Returned glyph lists and placements use the global heap.
+	class ScopedMemoryResource {
+	public:
+		ScopedMemoryResource( MemoryResource *resource );
+		~ScopedMemoryResource();
+
+	private:
+		ScopedMemoryResource( const ScopedMemoryResource& ) = delete;
+		ScopedMemoryResource& operator=( const ScopedMemoryResource& ) = delete;
+
+		MemoryResource	*mPrevious;
 	};
 
 	// ---------------------------------------------------------------------------------------------
@@ -245,12 +400,318 @@ public:
 		friend class SdfText;
 	};
 
+	//! Glyph tables as layout reads them, the Font maps allocated from the memory resource of the Format of an SdfText
+	using CharToGlyphTable = std::unordered_map<SdfText::Font::Char, SdfText::Font::Glyph, std::hash<SdfText::Font::Char>, std::equal_to<SdfText::Font::Char>, SdfText::Allocator<std::pair<const SdfText::Font::Char, SdfText::Font::Glyph>>>;
+	using GlyphToCharTable = std::unordered_map<SdfText::Font::Glyph, SdfText::Font::Char, std::hash<SdfText::Font::Glyph>, std::equal_to<SdfText::Font::Glyph>, SdfText::Allocator<std::pair<const SdfText::Font::Glyph, SdfText::Font::Char>>>;
+	using GlyphMetricsTable = std::map<SdfText::Font::Glyph, SdfText::Font::GlyphMetrics, std::less<SdfText::Font::Glyph>, SdfText::Allocator<std::pair<const SdfText::Font::Glyph, SdfText::Font::GlyphMetrics>>>;
+	using GlyphInfoTable = std::unordered_map<SdfText::Font::Glyph, SdfText::Font::GlyphInfo, std::hash<SdfText::Font::Glyph>, std::equal_to<SdfText::Font::Glyph>, SdfText::Allocator<std::pair<const SdfText::Font::Glyph, SdfText::Font::GlyphInfo>>>;
+
+	//! Read only view of glyph measures, over a GlyphMeasuresList from the caller or over the scratch list an internal layout call fills
+	class GlyphMeasuresView {
+	public:
+		using value_type = SdfText::Font::GlyphMeasuresList::value_type;
+
+		template <typename GlyphMeasuresT>
+		GlyphMeasuresView( const GlyphMeasuresT &glyphMeasures ) : mData( glyphMeasures.data() ), mSize( glyphMeasures.size() ) {}
+
+		const value_type*	begin() const { return mData; }
+		const value_type*	end() const { return mData + mSize; }
+		size_t				size() const { return mSize; }
+		bool				empty() const { return 0 == mSize; }
+		const value_type&	operator[]( size_t n ) const { return mData[n]; }
+
+	private:
+		const value_type	*mData;
+		size_t				mSize;
+	};
+
 	// ---------------------------------------------------------------------------------------------
 
 	struct CharPlacement {
 		SdfText::Font::Glyph	mGlyph;
 		Rectf					mSrcTexCoords;
 		Rectf					mDstRect;
+		//! Index of the glyph in the glyph measures list
+		uint32_t				mIndex = 0;
+		//! Line of the glyph in the layout
+		uint32_t				mLine = 0;
+		//! Position of the glyph in the glyph measures list normalized to [0, 1]
+		float					mRunPosition = 0.0f;
+		//! Pen position of the glyph on its baseline
+		vec2					mOrigin = vec2( 0 );
+		//! Center of the glyph's ink, rotated with \a mDstRect and not sheared by DrawOptions::oblique()
+		vec2					mInkCenter = vec2( 0 );
+		//! Direction of the glyph's baseline, \a mDstRect is rotated about \a mOrigin by it. Only text placed on a TextPath is rotated.
+		vec2					mAxis = vec2( 1, 0 );
+		//! Color of the color span containing the glyph, white if there is none
+		ColorA8u				mColor = ColorA8u( 255, 255, 255, 255 );
+
+		//! Returns \a point turned about \a mOrigin by \a mAxis, as the quad is
+		vec2					transformPoint( const vec2 &point ) const { const vec2 local = point - mOrigin; return mOrigin + ( mAxis * local.x ) + ( vec2( -mAxis.y, mAxis.x ) * local.y ); }
+		//! Writes the corners of the quad and their texture coords in draw order, two triangles 0 1 2 and 2 1 3. The quad is sheared about the baseline by \a oblique, see DrawOptions::oblique(), then turned by \a mAxis.
+		void					calcQuad( float oblique, vec2 positions[4], vec2 texCoords[4] ) const;
+		//! Returns \a mInkCenter sheared and turned with the quad
+		vec2					calcInkCenter( float oblique ) const;
+	};
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \struct ColorSpan
+	//!
+	//! Colors \a mCount glyphs starting at glyph \a mStart of a glyph measures list. Span lists are sorted by \a mStart and don't overlap.
+	struct ColorSpan {
+		uint32_t				mStart = 0;
+		uint32_t				mCount = 0;
+		ColorA8u				mColor = ColorA8u( 255, 255, 255, 255 );
+		ColorSpan() {}
+		ColorSpan( uint32_t start, uint32_t count, const ColorA8u &color ) : mStart( start ), mCount( count ), mColor( color ) {}
+	};
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \struct AtlasStats
+	//!
+	//!
+	struct AtlasStats {
+		//! Number of textures stored as BC4 blocks
+		uint32_t	mNumCompressedTextures = 0;
+		//! Mean absolute error introduced by block compression, in 8-bit distance units
+		float		mCompressionMeanError = 0.0f;
+		//! Max absolute error introduced by block compression, in 8-bit distance units
+		float		mCompressionMaxError = 0.0f;
+		//! Number of textures
+		uint32_t	mNumPages = 0;
+		//! Size of the first texture. With Format::autoTextureSize() the last texture and textures added by addChars() are sized for their own glyphs.
+		ivec2		mTextureSize = ivec2( 0 );
+		//! Size of each glyph tile including its spacing
+		ivec2		mTileSize = ivec2( 0 );
+		//! Number of glyphs in the textures
+		uint32_t	mNumGlyphs = 0;
+		//! Fraction of the texture area covered by glyph tiles
+		float		mOccupancy = 0.0f;
+		//! Number of glyph tiles copied from the glyph cache, see Format::glyphCacheDir()
+		uint32_t	mNumCachedGlyphs = 0;
+		//! Number of glyph tiles generated
+		uint32_t	mNumGeneratedGlyphs = 0;
+		//! Mean number of pages touched by a string of Format::pageCorpus(), 0 without a corpus
+		float		mPagesPerString = 0.0f;
+		//! Mean number of pages a string of Format::pageCorpus() would touch with the glyphs packed in charset order
+		float		mPagesPerStringInCharsetOrder = 0.0f;
+		//! Glyphs whose generation cost exceeded Format::glyphCostLimit(), in generation order
+		std::vector<uint32_t>	mCostlyGlyphs;
+		//! Highest generation cost, outline edges times tile texels, of the generated glyphs
+		uint64_t	mMaxGlyphCost = 0;
+		//! Highest generation cost of the costly glyphs after their fallbacks, deferred glyphs cost nothing on the generating thread
+		uint64_t	mMaxFallbackGlyphCost = 0;
+		//! Number of costly glyphs generated from a simplified outline
+		uint32_t	mNumSimplifiedGlyphs = 0;
+		//! Number of costly glyphs generated at a lower resolution, including simplified ones still over the limit
+		uint32_t	mNumLowResGlyphs = 0;
+		//! Number of costly glyphs generated in the background, including ones still over the limit at the lowest resolution
+		uint32_t	mNumDeferredGlyphs = 0;
+		//! Number of deferred glyphs whose tiles have not been written yet
+		uint32_t	mNumPendingGlyphs = 0;
+	};
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \struct FitResult
+	//!
+	//!
+	struct FitResult {
+		//! Scale to pass to DrawOptions::scale() when drawing mGlyphMeasures
+		float								mScale = 0.0f;
+		//! Whether the text fits at mScale, \c false if it does not fit even at the min scale
+		bool								mFits = false;
+		//! Glyph placements at mScale, suitable for drawGlyphs()
+		SdfText::Font::GlyphMeasuresList	mGlyphMeasures;
+		//! Bounds of the glyphs at mScale
+		Rectf								mBounds = Rectf( 0, 0, 0, 0 );
+		//! Number of layouts that were needed
+		uint32_t							mNumLayouts = 0;
+	};
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \class TextPath
+	//!
+	//! Polyline that text is laid out along. The cumulative length at each point is kept as a lookup
+	//! table so positions are found by arc length without walking the path from its start.
+	class TextPath {
+	public:
+		TextPath() {}
+		TextPath( const std::vector<vec2> &points ) { setPoints( points ); }
+		//! Flattens \a path, curves included, into a polyline. Higher \a approximationScale values give more segments.
+		TextPath( const Path2d &path, float approximationScale = 1.0f ) { setPoints( path.subdivide( approximationScale ) ); }
+		virtual ~TextPath() {}
+
+		//! Replaces the points of the path and rebuilds the length table. Repeated points are dropped.
+		void						setPoints( const std::vector<vec2> &points );
+		const std::vector<vec2>&	getPoints() const { return mPoints; }
+		bool						empty() const { return mPoints.empty(); }
+		//! Returns the length of the path in pixels
+		float						getLength() const { return mLengths.empty() ? 0.0f : mLengths.back(); }
+
+		//! Returns the position at \a distance along the path and sets \a tangent to the unit direction there. Distances before the start or past the end extend the first or last segment.
+		vec2						calcPosition( float distance, vec2 *tangent = nullptr ) const;
+		//! Evaluates \a count distances in a single pass, writing \a positions and \a tangents. Increasing runs of distances, as in a line of text, only move forward through the table.
+		void						calcPositions( const float *distances, size_t count, vec2 *positions, vec2 *tangents ) const;
+
+	private:
+		std::vector<vec2>			mPoints;
+		//! Length of the path up to each point
+		std::vector<float>			mLengths;
+	};
+
+	//! \struct GlyphTransform
+	//!
+	//! Position and rotation of a glyph laid out on a TextPath.
+	struct GlyphTransform {
+		//! Pen position of the glyph on the path
+		vec2					mOrigin = vec2( 0 );
+		//! Unit direction of the glyph's baseline
+		vec2					mAxis = vec2( 1, 0 );
+	};
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \struct TraceStats
+	//!
+	//! Timings of a replayed trace, see replayTrace().
+	struct TraceStats {
+		//! Number of calls replayed
+		uint32_t	mNumCalls = 0;
+		//! Number of SdfText instances created
+		uint32_t	mNumSdfTexts = 0;
+		//! Seconds spent creating the SdfText instances, atlas generation included
+		double		mCreateSeconds = 0.0;
+		//! Seconds spent laying out and measuring text
+		double		mLayoutSeconds = 0.0;
+		//! Seconds spent building glyph vertices
+		double		mVertexSeconds = 0.0;
+		//! Number of glyphs laid out
+		uint64_t	mNumGlyphs = 0;
+		//! Number of vertices built
+		uint64_t	mNumVertices = 0;
+		//! Seconds between the first and the last recorded call
+		double		mRecordedSeconds = 0.0;
+	};
+
+	//! Returns the font for a traced SdfText from its font name and size
+	using TraceFontFn = std::function<SdfText::Font( const std::string &name, float size )>;
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \class Executor
+	//!
+	//! Runs the parallel work of SdfText, SdfTextMesh and msdfgen. Derive from it to run that work on an existing job system.
+	class Executor {
+	public:
+		virtual ~Executor() {}
+
+		//! Queues \a task to run on a worker thread
+		virtual void	submit( const std::function<void()> &task ) = 0;
+		//! Blocks until every task submitted so far has completed
+		virtual void	wait() = 0;
+		//! Calls \a fn for every index in [0, \a count) and returns once all calls have completed. The calling thread takes part in the work. Calls made from inside \a fn run serially. If \a fn throws, the indices not yet started are skipped and the first exception is rethrown once every call has returned.
+		virtual void	parallelFor( size_t count, const std::function<void( size_t )> &fn );
+	};
+
+	using ExecutorRef = std::shared_ptr<Executor>;
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \class Impostor
+	//!
+	//! Caches static text in an offscreen texture at the current pixel scale and draws it as a single
+	//! quad. The text is rendered again when it is invalidated or its bounds, the transform scale,
+	//! the viewport or the current color change.
+	class Impostor {
+	public:
+		Impostor() {}
+		virtual ~Impostor() {}
+
+		//! Draws the cached text covering \a bounds, calling \a drawFn to render it first if needed. \a drawFn draws in the coordinates of \a bounds with premultiplied alpha, the cache is composited with premultiplied blending.
+		void		draw( const Rectf &bounds, const std::function<void()> &drawFn );
+		//! Forces the text to be rendered again on the next draw, call it when the text changes
+		void		invalidate() { mValid = false; }
+		//! Frees the offscreen texture
+		void		release();
+
+		//! Returns the number of draws served from the cache
+		uint32_t	getNumHits() const { return mNumHits; }
+		//! Returns the number of draws that rendered the text
+		uint32_t	getNumMisses() const { return mNumMisses; }
+		//! Returns the bytes used by the offscreen texture
+		size_t		getMemoryUsage() const;
+
+	private:
+		FboRef		mFbo;
+		Rectf		mBounds = Rectf( 0, 0, 0, 0 );
+		float		mPixelScale = 0.0f;
+		ivec2		mViewportSize = ivec2( 0 );
+		ColorA		mColor = ColorA( 0, 0, 0, 0 );
+		bool		mValid = false;
+		uint32_t	mNumHits = 0;
+		uint32_t	mNumMisses = 0;
+	};
+
+	// ---------------------------------------------------------------------------------------------
+
+	//! \class CommandList
+	//!
+	//! Text recorded on any thread and drawn on the GL thread. Recording runs the layout and builds
+	//! the vertices, so the list only holds finished geometry plus the font, atlas page and draw
+	//! state of each command. A list is recorded by one thread at a time, and recording must not
+	//! overlap calls that add glyphs to the same SdfText, such as addChars().
+	class CommandList {
+	public:
+		//! Records into memory of the new/delete resource, see SdfText::newDeleteResource()
+		CommandList();
+		//! Records into memory of \a memoryResource, which must outlive the list
+		explicit CommandList( MemoryResource *memoryResource );
+		virtual ~CommandList() {}
+
+		//! Records string \a str at baseline \a baseline in \a color, which multiplies the current color when the list is submitted
+		void		drawString( const SdfTextRef &sdfText, const std::string &str, const vec2 &baseline, const DrawOptions &options = DrawOptions(), const ColorA &color = ColorA::white() );
+		//! Records string \a str word wrapped inside \a fitRect and moved by \a offset in \a color
+		void		drawStringWrapped( const SdfTextRef &sdfText, const std::string &str, const Rectf &fitRect, const vec2 &offset = vec2(), const DrawOptions &options = DrawOptions(), const ColorA &color = ColorA::white() );
+		//! Records the glyphs in \a glyphMeasures at baseline \a baseline in \a color
+		void		drawGlyphs( const SdfTextRef &sdfText, const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const DrawOptions &options = DrawOptions(), const ColorA &color = ColorA::white() );
+		//! Removes all commands, the memory is kept for the next recording
+		void		clear();
+
+		bool		empty() const { return mCommands.empty(); }
+		size_t		getNumCommands() const { return mCommands.size(); }
+		size_t		getNumVertices() const { return mVertices.size(); }
+
+		//! Draws the list, see submit( lists )
+		uint32_t	submit() const;
+		//! Draws \a lists in order, must be called on the GL thread. The vertices of all lists go to the GPU in one upload and consecutive commands drawing from the same texture with the same premultiply and gamma share a draw call. Returns the number of draw calls.
+		static uint32_t	submit( const std::vector<const CommandList*> &lists );
+
+	private:
+		struct Vertex {
+			vec2		mPosition;
+			//! Normalized page coords, top down
+			vec2		mTexCoord;
+			ColorA8u	mColor;
+			float		mEmbolden;
+		};
+
+		struct Command {
+			SdfTextRef	mSdfText;
+			uint8_t		mPage;
+			bool		mPremultiply;
+			float		mGamma;
+			uint32_t	mVertexStart;
+			uint32_t	mVertexCount;
+		};
+
+		void		record( const SdfTextRef &sdfText, const GlyphMeasuresView &glyphMeasures, const vec2 &baseline, const DrawOptions &options, const ColorA &color );
+
+		std::vector<Vertex, SdfText::Allocator<Vertex>>		mVertices;
+		std::vector<Command, SdfText::Allocator<Command>>	mCommands;
 	};
 
 	// ---------------------------------------------------------------------------------------------
@@ -267,28 +728,58 @@ public:
 	static SdfTextRef		load( const DataSourceRef& source, float size = 0 );
 	static SdfTextRef		load( const fs::path& filePath, float size = 0 );
 
+	//! Creates a SdfText that only holds the char to glyph maps, glyph metrics and glyph bounds of \a font, read from the face without generating any SDF. measureString(), measureStringBounds() and getGlyphPlacements() give the same results as with create(), drawing draws nothing until makeDrawable() is called.
+	static SdfTextRef		createMetrics( const SdfText::Font &font, const Format &format = Format(), const std::string &utf8Chars = SdfText::defaultChars() );
+	//! Loads the maps, glyph metrics and glyph bounds of the SDFT file \a source, skipping over its page images. See createMetrics().
+	static SdfTextRef		loadMetrics( const DataSourceRef& source, float size = 0 );
+	static SdfTextRef		loadMetrics( const fs::path& filePath, float size = 0 );
+	//! Returns whether the SdfText only holds metrics, see createMetrics()
+	bool					isMetricsOnly() const { return mMetricsOnly; }
+	//! Generates the texture atlas of a SdfText from createMetrics(), or loads it for one from loadMetrics(), so that it can be drawn. Like addChars() it must be called on the thread that draws, layout on other threads can go on meanwhile. Logs a warning if the drawable tiles would lay out differently than the metrics did. Does nothing if it is drawable already.
+	void					makeDrawable();
+
 	//! Draws string \a str at baseline \a baseline with DrawOptions \a options
 	void	drawString( const std::string &str, const vec2 &baseline, const DrawOptions &options = DrawOptions() );
 	//! Draws string \a str fit inside \a fitRect vertically, with internal offset \a offset and DrawOptions \a options
 	void	drawString( const std::string &str, const Rectf &fitRect, const vec2 &offset = vec2(), const DrawOptions &options = DrawOptions() );
 	//! Draws word-wrapped string \a str fit inside \a fitRect, with internal offset \a offset and DrawOptions \a options.
 	void	drawStringWrapped( const std::string &str, const Rectf &fitRect, const vec2 &offset = vec2(), const DrawOptions &options = DrawOptions() );
-	//! Draws the glyphs in \a glyphMeasures at baseline \a baseline with DrawOptions \a options. \a glyphMeasures is a vector of pairs of glyph indices and offsets for the glyph baselines
+	//! Draws string \a str at baseline \a baseline on a single line, cut and ended with \a ellipsis if it is wider than \a maxWidth pixels. See truncate().
+	void	drawStringTruncated( const std::string &str, const vec2 &baseline, float maxWidth, const std::string &ellipsis = "...", const DrawOptions &options = DrawOptions() );
+	//! Draws the glyphs in \a glyphMeasures at baseline \a baseline with DrawOptions \a options. \a glyphMeasures is a vector of pairs of glyph indices and offsets for the glyph baselines. Custom shaders that declare \c vec3 \c aGlyphInfo (glyph index, line index, normalized position in the list) or \c vec2 \c aGlyphCenter (center of the glyph quad) get them per vertex, for all drawGlyphs() overloads.
 	void	drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const DrawOptions &options = DrawOptions(), const std::vector<ColorA8u> &colors = std::vector<ColorA8u>() );
-	//! Draws the glyphs in \a glyphMeasures clipped by \a clip, with \a offset added to each of the glyph offsets with DrawOptions \a options. \a glyphMeasures is a vector of pairs of glyph indices and offsets for the glyph baselines.
+	//! Draws the glyphs in \a glyphMeasures at baseline \a baseline colored by \a colorSpans. Glyphs outside of the spans use the current color, which also tints the spans. The span colors are looked up on the GPU, see colorSpanShader().
+	void	drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const std::vector<ColorSpan> &colorSpans, const DrawOptions &options = DrawOptions() );
+	//! Draws the glyphs in \a glyphMeasures clipped by \a clip, with \a offset added to each of the glyph offsets with DrawOptions \a options. \a glyphMeasures is a vector of pairs of glyph indices and offsets for the glyph baselines. With vertical clipping only the lines near \a clip are visited if the baselines are in top to bottom order, as returned by the layout functions, glyphs in any other order are all visited and cut to \a clip.
 	void	drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const Rectf &clip, vec2 offset, const DrawOptions &options = DrawOptions(), const std::vector<ColorA8u> &colors = std::vector<ColorA8u>() );
-
-	//! Returns pairs of texture and final texture and vertex coords for drawing using \a glyphMeasures, \a baseline, and \a options.
-	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeChars( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const DrawOptions &options = DrawOptions() );
+	//! Draws the glyphs in \a glyphMeasures clipped by \a clip with \a offset added to each of the glyph offsets, colored by \a colorSpans.
+	void	drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const Rectf &clip, vec2 offset, const std::vector<ColorSpan> &colorSpans, const DrawOptions &options = DrawOptions() );
+	//! Draws the glyphs in \a glyphMeasures along \a path, starting \a offset pixels along it. See calcPathTransforms().
+	void	drawGlyphsOnPath( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const TextPath &path, float offset = 0.0f, const DrawOptions &options = DrawOptions(), const std::vector<ColorA8u> &colors = std::vector<ColorA8u>() );
+	//! Draws string \a str along \a path, starting \a offset pixels along it
+	void	drawStringOnPath( const std::string &str, const TextPath &path, float offset = 0.0f, const DrawOptions &options = DrawOptions() );
+
+	//! Returns pairs of texture and final texture and vertex coords for drawing using \a glyphMeasures, \a baseline, and \a options. Each placement gets the color of its span in \a colorSpans.
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeChars( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const DrawOptions &options = DrawOptions(), const std::vector<ColorSpan> &colorSpans = std::vector<ColorSpan>() );
 	//! Returns pairs of texture and final texture and vertex coords for drawing using \a str, \a baseline, and \a options.
-	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeString( const std::string &str, const vec2 &baseline, const DrawOptions &options = DrawOptions() );
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeString( const std::string &str, const vec2 &baseline, const DrawOptions &options = DrawOptions(), const std::vector<ColorSpan> &colorSpans = std::vector<ColorSpan>() );
 	//! Returns pairs of texture and final texture and vertex coords for wrapped drawing using \a str, \a fitRect,  \a offset, and \a options.
-	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeStringWrapped( const std::string &str, const Rectf &fitRect, const vec2 &offset = vec2(), const DrawOptions &options = DrawOptions() );
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeStringWrapped( const std::string &str, const Rectf &fitRect, const vec2 &offset = vec2(), const DrawOptions &options = DrawOptions(), const std::vector<ColorSpan> &colorSpans = std::vector<ColorSpan>() );
+	//! Returns pairs of texture and final texture and vertex coords for drawing \a glyphMeasures along \a path starting \a offset pixels along it. Each placement is rotated about its CharPlacement::mOrigin by its CharPlacement::mAxis.
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeGlyphsOnPath( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const TextPath &path, float offset = 0.0f, const DrawOptions &options = DrawOptions(), const std::vector<ColorSpan> &colorSpans = std::vector<ColorSpan>() );
+	//! Returns pairs of texture and final texture and vertex coords for drawing \a str truncated to \a maxWidth with \a ellipsis at \a baseline with \a options. See truncate().
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeStringTruncated( const std::string &str, const vec2 &baseline, float maxWidth, const std::string &ellipsis = "...", const DrawOptions &options = DrawOptions() );
 	
 	//! Returns the bounds (as a Rectf) in pixels necessary to render the string \a str with DrawOptions \a options.
 	Rectf	measureStringBounds( const std::string &str, const DrawOptions &options = DrawOptions() ) const;
 	//! Returns the word-wrapped bounds (as a Rectf) in pixels necessary to render the string \a str with DrawOptions \a options.
 	Rectf	measureStringBoundsWrapped( const std::string &str, const Rectf &fitRect, const DrawOptions &options = DrawOptions() ) const;
+	//! Returns the bounds (as a Rectf) in pixels of \a glyphMeasures relative to the baseline they are drawn at with DrawOptions \a options. Useful as the bounds of an Impostor.
+	Rectf	measureGlyphBounds( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const DrawOptions &options = DrawOptions() ) const;
+	//! Returns the largest scale in [\a minScale, \a maxScale] at which \a str, word-wrapped so that the scaled lines fill the width of \a fitRect, fits inside \a fitRect. Line breaks only change at a few scales, so only a few layouts are needed. Draw the result with drawGlyphs() and DrawOptions::scale( FitResult::mScale ).
+	FitResult	fitStringWrapped( const std::string &str, const Rectf &fitRect, float minScale, float maxScale, const DrawOptions &options = DrawOptions() ) const;
+	//! Returns one transform per glyph of \a glyphMeasures laid out along \a path. The glyph baselines follow the path and each glyph is turned to the path direction at its horizontal center. Lines below the first are offset along the path normal. \a offset is the distance along the path where the text starts, added to the start given by the alignment of \a options. The path is evaluated for all glyphs in one pass.
+	std::vector<GlyphTransform>	calcPathTransforms( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const TextPath &path, float offset = 0.0f, const DrawOptions &options = DrawOptions() ) const;
 	//! Returns the size in pixels necessary to render the string \a str with DrawOptions \a options.
 	vec2	measureString( const std::string &str, const DrawOptions &options = DrawOptions() ) const;
 	//! Returns the word-wrapped size in pixels necessary to render the string \a str with DrawOptions \a options.
@@ -300,9 +791,13 @@ public:
 	std::vector<std::pair<SdfText::Font::Glyph,vec2>>		getGlyphPlacements( const std::string &str, const Rectf &fitRect, const DrawOptions &options = DrawOptions() ) const;
 	//! Returns a  word-wrapped vector of glyph/placement pairs representing \a str fit inside \a fitRect, suitable for use with drawGlyphs. Useful for caching placement and optimizing batching. Mac & iOS only.
 	std::vector<std::pair<SdfText::Font::Glyph,vec2>>		getGlyphPlacementsWrapped( const std::string &str, const Rectf &fitRect, const DrawOptions &options = DrawOptions() ) const;
+	//! Returns a vector of glyph/placement pairs representing \a str on a single line, suitable for use with drawGlyphs. If \a str is wider than \a maxWidth pixels it is cut after the last glyph that leaves room for \a ellipsis, trailing spaces are dropped and \a ellipsis is appended. The string is decoded and walked once.
+	std::vector<std::pair<SdfText::Font::Glyph,vec2>>		truncate( const std::string &str, float maxWidth, const std::string &ellipsis = "...", const DrawOptions &options = DrawOptions() ) const;
 
 	//! Returns the font the TextureFont represents
 	const SdfText::Font&	getFont() const { return mFont; }
+	//! Returns the format the SdfText was created with
+	const Format&			getFormat() const { return mFormat; }
     //! Returns the name of the font
     std::string				getName() const { return mFont.getName(); }
 	//! Returns the ascent of the font
@@ -314,29 +809,172 @@ public:
 	//! \c "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz1234567890().?!,:;'\"&*=+-/\\|@#_[]<>%^llflfiphrids"
 	static std::string		defaultChars();
 
+	//! Generates the glyphs needed to render \a utf8Chars that are not in the atlas yet, using the font face if available or the embedded outlines otherwise. Returns the number of glyphs added. A metrics only SdfText is made drawable first, see makeDrawable().
+	uint32_t				addChars( const std::string &utf8Chars );
+	//! Returns true if outlines are available to generate glyphs without the original font.
+	bool					hasEmbeddedOutlines() const { return mOutlines ? true : false; }
+	//! Generates up to \a maxChars of the chars left out at creation by Format::deferColdChars(), in the order they were requested. Call it once per frame to fill the atlas progressively. Returns the number of glyphs added.
+	uint32_t				addDeferredChars( size_t maxChars = std::numeric_limits<size_t>::max() );
+	//! Returns the number of chars left out at creation that addDeferredChars() has not generated yet
+	size_t					getNumDeferredChars() const { return mDeferredChars.size(); }
+	//! Returns how often each char has been drawn, the counts of the loaded usage profile included, most drawn first. Empty unless Format::usageProfile() is set.
+	std::vector<std::pair<SdfText::Font::Char, uint64_t>>	getUsage() const;
+	//! Adds the counts drawn since the last save to the Format::usageProfile() file, keeping the counts other SdfText instances saved to it
+	void					saveUsageProfile() const;
+
+	//! Returns statistics about the texture atlas
+	const SdfText::AtlasStats&	getAtlasStats() const;
+	//! Returns statistics about the pages of the high resolution tier, empty until a glyph has been drawn from it. See Format::highResScale().
+	const SdfText::AtlasStats&	getHighResAtlasStats() const;
+
 	uint32_t				getNumTextures() const;
+	//! Returns texture \a n of the current context. Atlas pages are kept on the CPU and uploaded on first use in each context.
 	const gl::TextureRef&	getTexture( uint32_t n ) const;
+	//! Frees the CPU copy of the atlas pages once every context that has drawn this SdfText has uploaded them. Contexts that draw for the first time afterwards will throw.
+	void					releasePageData();
+	//! Releases the textures of the current context. Call before destroying a context that has drawn this SdfText.
+	void					releaseContextTextures();
 
 	const SdfText::Font::GlyphMetricsMap&	getGlyphMetrics() const { return mGlyphMetrics; }
 	const SdfText::Font::CharToGlyphMap&	getCharToGlyph() const { return mCharToGlyph; }
 
 	static gl::GlslProgRef	defaultShader();
+	//! Returns the embolden offset of \a options in pixels at the font size, limited to just under half of the baked distance range
+	float					getEmbolden( const DrawOptions &options ) const;
+	//! Returns the embolden offset of \a options as an offset of the normalized distance sampled from the atlas, as used by the shaders' \c uEmbolden
+	float					getEmboldenDistance( const DrawOptions &options ) const;
+	//! Returns the window pixels per unit of the current model view projection and viewport, measured at the origin
+	static float			getPixelScale();
+	//! Returns the shader used with color spans. Each vertex carries the span slot in the \c aSpanIndex attribute and looks its color up in \c uSpanColors, custom shaders used with color spans need both.
+	static gl::GlslProgRef	colorSpanShader();
+	//! Returns the shader that multiplies the current color with the \c ciColor vertex attribute. Fragments outside of the \c uClipRects slot given by the \c aClipIndex vertex attribute are discarded, slot 0 is never clipped, see SdfTextMesh::setClipRect().
+	static gl::GlslProgRef	vertexColorShader();
+	//! Returns the default shader of SdfTextMesh. The current color is multiplied with the \c uSpanColors slot given by the \c aSpanIndex vertex attribute, slot 0 is white. Embolden offsets come from the \c aEmbolden attribute and clipping works as in vertexColorShader(). The mesh only stores the attributes its runs need and sets the others to constants.
+	static gl::GlslProgRef	meshShader();
+
+	//! Starts recording the draw, measure and place calls of all SdfText instances, and the runs of SdfTextMesh when it is cached, with their strings, options and timestamps to the trace file at \a filePath. Each SdfText is recorded with its font, format and characters the first time it is used. Replaces a trace in progress.
+	static void				startTrace( const fs::path &filePath );
+	//! Stops recording and returns the number of recorded calls
+	static uint32_t			stopTrace();
+	//! Runs the calls of the trace at \a filePath again without a GL context, timing layout, measuring and vertex generation. Draws and placements run the same glyph placement as the live calls, clipping, paths and the high resolution tier included, short of the GL upload. Fonts are created with \a fontFn, or from their names if it is empty. The SdfText formats are replayed except for their memory resource, glyph cache and usage profile, and custom shaders are not recorded.
+	static TraceStats		replayTrace( const fs::path &filePath, const TraceFontFn &fontFn = TraceFontFn() );
+
+	//! Returns the memory resource backed by the global heap, the default of every thread
+	static MemoryResource*		newDeleteResource();
+	//! Returns the memory resource current on the calling thread, see ScopedMemoryResource
+	static MemoryResource*		getMemoryResource();
+
+	//! Sets the executor used for all parallel work. Passing \c nullptr restores the default thread pool.
+	static void					setExecutor( const ExecutorRef &executor );
+	//! Returns the executor used for all parallel work, creating the default thread pool if none is set. The reference returned keeps the executor alive across a concurrent setExecutor().
+	static ExecutorRef			getExecutor();
 
 private:
-	SdfText( const SdfText::Font &font, const Format &format, const std::string &utf8Chars, bool generateSdf = true );
+	SdfText( const SdfText::Font &font, const Format &format, const std::string &utf8Chars, bool generateSdf = true, bool metricsOnly = false );
 	friend class SdfTextManager;
+	friend class SdfTextMesh;
+	friend class SdfTextBox;
+	friend class TraceRecorder;
+
+	//! Decides whether a call is recorded, calls made while recording another one are not
+	class TraceScope {
+	public:
+		TraceScope();
+		~TraceScope();
+		bool	isRecording() const { return mRecording; }
+	private:
+		bool	mRecording = false;
+	};
 
 	class TextureAtlas;
 	using TextureAtlasRef = std::shared_ptr<TextureAtlas>;
 
+	class GlyphOutlines;
+	using GlyphOutlinesRef = std::shared_ptr<GlyphOutlines>;
+
+	class UsageProfile;
+	using UsageProfileRef = std::shared_ptr<UsageProfile>;
+
 	SdfText::Font						mFont;
 	Format								mFormat;
 	TextureAtlasRef						mTextureAtlases;
+	//! High resolution tier, created on first use, see Format::highResScale()
+	TextureAtlasRef						mHighResAtlas;
+	//! Kept as the Font maps for getGlyphMetrics() and getCharToGlyph(), layout reads the copies in mGlyphTables from the memory resource
 	SdfText::Font::GlyphMetricsMap		mGlyphMetrics;
 	SdfText::Font::CharToGlyphMap		mCharToGlyph;
-	SdfText::Font::GlyphToCharMap		mGlyphToChar;
+	GlyphToCharTable					mGlyphToChar;
+	GlyphOutlinesRef					mOutlines;
+	UsageProfileRef						mUsage;
+	std::u32string						mDeferredChars;
+
+	//! Set until makeDrawable() builds the atlas, from the chars and glyphs below or from the SDFT source
+	bool								mMetricsOnly = false;
+	std::string							mMetricsChars;
+	std::vector<SdfText::Font::Glyph>	mMetricsGlyphs;
+	DataSourceRef						mMetricsSource;
+	float								mMetricsSourceSize = 0.0f;
+
+	//! Immutable copy of the tables and atlas parameters layout reads, replaced as a whole whenever glyphs are added or the atlas is replaced. Layout on other threads never touches mTextureAtlases.
+	struct GlyphTables {
+		CharToGlyphTable				mCharToGlyph;
+		GlyphMetricsTable				mGlyphMetrics;
+		GlyphInfoTable					mGlyphInfo;
+		std::vector<ivec2>				mPageSizes;
+		vec2							mSdfScale;
+		vec2							mSdfPadding;
+		ivec2							mSdfBitmapSize;
+		float							mSdfRange;
+	};
+
+	//! Pins the current glyph tables for its lifetime with one atomic load, readers never block writers or each other
+	class GlyphTablesReader {
+	public:
+		GlyphTablesReader( const SdfText *sdfText );
+		const GlyphTables*	operator->() const { return mTables.get(); }
+		const GlyphTables&	operator*() const { return *mTables; }
+	private:
+		std::shared_ptr<const GlyphTables>	mTables;
+	};
+
+	//! Only accessed with std::atomic_load() and std::atomic_store(), replaced tables are freed by the last reader that holds them
+	std::shared_ptr<const GlyphTables>	mGlyphTables;
 
+	//! Publishes a copy of the current glyph tables for readers
+	void	publishGlyphTables();
+
+	//! Returns whether the font's outlines are inverted when generating tiles, as for CFF fonts
+	bool				isSdfInverted() const;
+
+	static SdfTextRef	loadImpl( const DataSourceRef& source, float size, bool metricsOnly );
 	Rectf	measureStringImpl( const std::string &str, bool wrapped, const Rectf &fitRect, const DrawOptions &options ) const;
+	//! Returns the atlas to draw [\a glyphBegin, \a glyphEnd) of \a glyphMeasures from at \a pixelScale pixels per unit, or at the current transform if it is 0. Missing high resolution tiles are queued on the executor and the base atlas is returned until they are written.
+	const TextureAtlasRef&	selectAtlas( const GlyphMeasuresView &glyphMeasures, size_t glyphBegin, size_t glyphEnd, const DrawOptions &options, float pixelScale = 0.0f );
+
+	Rectf	measureGlyphBoundsImpl( const GlyphMeasuresView &glyphMeasures, const DrawOptions &options, const GlyphTables &tables ) const;
+
+	//! Tiles and SDF parameters that glyphs are placed with, from an atlas on the drawing thread or from a glyph tables snapshot on any thread
+	struct TileSource {
+		const GlyphInfoTable				*mGlyphInfo;
+		std::vector<ivec2>					mPageSizes;
+		vec2								mSdfScale;
+		vec2								mSdfPadding;
+		ivec2								mSdfBitmapSize;
+	};
+	static TileSource	getTileSource( const TextureAtlas &atlas );
+	static TileSource	getTileSource( const GlyphTables &tables );
+	//! Places the glyphs in [\a glyphBegin, \a glyphEnd) of \a glyphMeasures drawn at \a baseline into \a pagePlacements, one list per page in glyph order. With \a clip they are placed like drawGlyphs() with a clip rect and cut to it, with \a transforms they are moved onto their places on a path. Texture coords come from \a textures if they are given, from the page sizes of \a source otherwise. Drawing, placement, command lists and trace replay all place glyphs here.
+	void	placeGlyphs( const TileSource &source, const std::vector<gl::TextureRef> *textures, const GlyphMeasuresView &glyphMeasures, size_t glyphBegin, size_t glyphEnd, const vec2 &baseline, const Rectf *clip, const DrawOptions &options, const GlyphTransform *transforms, std::vector<std::vector<CharPlacement>> *pagePlacements ) const;
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>>	placeCharsImpl( const GlyphMeasuresView &glyphMeasures, const vec2 &baseline, const DrawOptions &options, const std::vector<ColorSpan> &colorSpans, const GlyphTransform *transforms );
+
+	void		traceCall( uint8_t call, const std::string &str, const Rectf &rect, const vec2 &point, float value, const std::string &extra, const DrawOptions &options ) const;
+	//! Records \a glyphMeasures drawn at \a baseline, cut to \a clip or laid out on \a path if they are set
+	void		traceGlyphs( uint8_t call, const GlyphMeasuresView &glyphMeasures, const vec2 &baseline, const Rectf *clip, const TextPath *path, float pathOffset, const DrawOptions &options ) const;
+	static void	traceMeshRun( const void *mesh, const void *run, uint32_t dirty, const SdfText *sdfText, const std::string &utf8, bool wrapped, const Rectf &fitRect, const vec2 &baseline, const vec2 &offset, const TextPath &path, float pathOffset, const DrawOptions &options );
+	static void	traceMeshCache( const void *mesh );
+	static void	traceForget( const void *ptr );
+	//! Draws [\a glyphBegin, \a glyphEnd) of \a glyphMeasures at \a baseline, see placeGlyphs() for \a clip and \a transforms
+	void	drawGlyphsImpl( const GlyphMeasuresView &glyphMeasures, size_t glyphBegin, size_t glyphEnd, const vec2 &baseline, const Rectf *clip, const DrawOptions &options, const std::vector<ColorA8u> &colors, const ColorSpan *colorSpans, size_t numColorSpans, const GlyphTransform *transforms = nullptr );
 };
 
 }} // namespace cinder::gl
\ No newline at end of file
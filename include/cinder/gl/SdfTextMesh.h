@@ -35,6 +35,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "cinder/gl/Batch.h"
 #include "cinder/gl/SdfText.h"
 
+#include <array>
+
 namespace cinder { namespace gl {
 
 class SdfTextMesh;
@@ -57,6 +59,10 @@ public:
 		WRAPPED		= 0x00000040,
 		ALIGNMENT	= 0x00000080,
 		JUSTIFY		= 0x00000100,
+		COLOR		= 0x00000200,
+		STYLE		= 0x00000400,
+		PATH		= 0x00000800,
+		CLIP		= 0x00001000,
 		ALL			= 0x7FFFFFFF
 	};
 
@@ -94,6 +100,10 @@ public:
 			Options&					setJustify( bool value = true ) { mDrawOptions.justify( value ); return *this; }
 			float						getDrawScale() const { return mDrawOptions.getScale(); }
 			Options&					setDrawScale( float value ) { mDrawOptions.scale( value ); return *this; }
+			float						getEmbolden() const { return mDrawOptions.getEmbolden(); }
+			Options&					setEmbolden( float value ) { mDrawOptions.embolden( value ); return *this; }
+			float						getOblique() const { return mDrawOptions.getOblique(); }
+			Options&					setOblique( float value ) { mDrawOptions.oblique( value ); return *this; }
 			const SdfText::DrawOptions&	getDrawOptions() const { return mDrawOptions; }
 		private:
 			friend class SdfTextMesh::Run;
@@ -122,6 +132,9 @@ public:
 		const std::string&			getText() const { return getUtf8(); }
 		void						setUtf8( const std::string &utf8 ) { if( utf8 != mUtf8 ) { mUtf8 = utf8; setDirty( Feature::TEXT ); } }
 		void						setText( const std::string &utf8 ) { setUtf8( utf8 ); }
+		//! Color spans over the glyphs of the run, glyphs outside of the spans are white. The slots of a table of the span colors are baked into the vertices when the mesh is cached, meshes without spans store no color.
+		const std::vector<SdfText::ColorSpan>&	getColorSpans() const { return mColorSpans; }
+		void						setColorSpans( const std::vector<SdfText::ColorSpan> &colorSpans ) { mColorSpans = colorSpans; setDirty( Feature::COLOR ); }
 		const Run::Options&			getOptions() const { return mOptions; }
 		const vec3&					getPosition() const { return mOptions.getPosition(); }
 		void						setPosition( const ci::vec2 &value ) { mOptions.setPosition( value ); setDirty( Feature::POSITION2 ); clearDirty( Feature::POSITION3 ); }
@@ -134,12 +147,26 @@ public:
 		void						setAlignment( SdfText::Alignment value ) { mOptions.setAlignment( value ); setDirty( Feature::ALIGNMENT ); }
 		bool						getJustify() const { return mOptions.getJustify(); }
 		void						setJustify( bool value = true ) { mOptions.setJustify( value ); setDirty( Feature::JUSTIFY ); }
+		//! Synthetic bold offset in pixels at the font size, see SdfText::DrawOptions::embolden()
+		float						getEmbolden() const { return mOptions.getEmbolden(); }
+		void						setEmbolden( float value ) { mOptions.setEmbolden( value ); setDirty( Feature::STYLE ); }
+		//! Synthetic oblique skew, see SdfText::DrawOptions::oblique()
+		float						getOblique() const { return mOptions.getOblique(); }
+		void						setOblique( float value ) { mOptions.setOblique( value ); setDirty( Feature::STYLE ); }
 		const vec2&					getBaseline() const { return mOptions.getBaseline(); }
 		void						setBaseline( const vec2 &value ) { mOptions.setBaseline( value ); }
 		bool						getWrapped() const { return mOptions.getWrapped(); }
 		void						setWrapped( bool value ) { mOptions.setWrapped( value ); }
 		const Rectf&				getFitRect() const { return mOptions.getFitRect(); }
 		void						setFitRect( const Rectf &value ) { mOptions.setFitRect( value ); }
+		//! Lays the run out along \a path starting \a offset pixels along it instead of at its baseline or fit rect. An empty path restores the regular layout.
+		const SdfText::TextPath&	getPath() const { return mPath; }
+		float						getPathOffset() const { return mPathOffset; }
+		void						setPath( const SdfText::TextPath &path, float offset = 0.0f ) { mPath = path; mPathOffset = offset; setDirty( Feature::PATH ); }
+		void						setPathOffset( float offset ) { mPathOffset = offset; setDirty( Feature::PATH ); }
+		//! Clips the run to the rect in clip slot \a clipId of its mesh, 0 draws it unclipped. Changing the rect of the slot does not rebuild the mesh, see SdfTextMesh::setClipRect().
+		uint32_t					getClipId() const { return mClipId; }
+		void						setClipId( uint32_t clipId ) { if( clipId != mClipId ) { mClipId = clipId; setDirty( Feature::CLIP ); } }
 		const Rectf&				getBounds() const { return mBounds; }
 	private:
 		Run( SdfTextMesh *sdfTextMesh, const std::string& utf8, const SdfTextRef& sdfText, const vec2 &baseline, const Run::Options &drawOptions );
@@ -150,38 +177,103 @@ public:
 		uint32_t					mFeatures = Feature::TEXT;
 		uint32_t					mDirty = Feature::NONE;
 		std::string					mUtf8;
+		std::vector<SdfText::ColorSpan>	mColorSpans;
 		Run::Options				mOptions;
+		SdfText::TextPath			mPath;
+		float						mPathOffset = 0.0f;
+		uint32_t					mClipId = 0;
 		Rectf						mBounds = Rectf( 0, 0, 0, 0 );
 	};
 
 	virtual ~SdfTextMesh() {}
 
-	static SdfTextMeshRef		create();
+	//! Creates a mesh whose run tables, vertex data and layout temporaries use \a memoryResource, which must outlive the mesh. \c nullptr uses the resource current on the calling thread, see SdfText::ScopedMemoryResource.
+	static SdfTextMeshRef		create( SdfText::MemoryResource *memoryResource = nullptr );
+	//! Returns the memory resource of the mesh
+	SdfText::MemoryResource*	getMemoryResource() const { return mMemoryResource; }
 
 	void						appendText( const SdfTextMesh::RunRef &run );
 	SdfTextMesh::RunRef			appendText( const std::string &utf8, const SdfTextRef &sdfText, const vec2& baseline, const Run::Options &options = Run::Options() );
 	SdfTextMesh::RunRef			appendText( const std::string &utf8, const SdfText::Font &font, const vec2& baseline, const Run::Options &options = Run::Options() );
 	SdfTextMesh::RunRef			appendTextWrapped( const std::string &utf8, const SdfTextRef &sdfText, const Rectf &fitRect, const Run::Options &options = Run::Options() );
 	SdfTextMesh::RunRef			appendTextWrapped( const std::string &utf8, const SdfText::Font &font, const Rectf &fitRect, const Run::Options &options = Run::Options() );
+	//! Appends a run laid out along \a path starting \a offset pixels along it, see Run::setPath()
+	SdfTextMesh::RunRef			appendTextOnPath( const std::string &utf8, const SdfTextRef &sdfText, const SdfText::TextPath &path, float offset = 0.0f, const Run::Options &options = Run::Options() );
 
 	//! Returns the runs associated with \a sdfText. If \a sdfText is null, all runs gets returned.
 	std::vector<RunRef>			getRuns( const SdfTextRef &sdfText = SdfTextRef() ) const;
 
 	void						cache();
 
+	//! Sets the shader used to draw the mesh, \c nullptr restores SdfText::meshShader(). Colors of color spans come from the \c uSpanColors slot in the \c aSpanIndex vertex attribute. Shaders that declare \c vec3 \c aGlyphInfo (glyph index in the run, line index, normalized position in the run) or \c vec2 \c aGlyphCenter (center of the glyph) get them in every vertex for per glyph animation, other meshes leave them out.
+	void						setGlslProg( const GlslProgRef &glslProg );
+	const GlslProgRef&			getGlslProg() const { return mGlslProg; }
+
 	void						draw( bool premultiply = true, float gamma = 2.2f );
 
+	enum class Greeking { WORDS, LINES };
+
+	//! Sets the on-screen font size in pixels below which the text of a font is drawn as bars, 0 disables greeking
+	void						setGreekingThreshold( float pixels ) { mGreekingThreshold = pixels; }
+	float						getGreekingThreshold() const { return mGreekingThreshold; }
+	//! Sets whether greeked text is drawn as one bar per word or per line. Both are built when the mesh is cached.
+	void						setGreeking( Greeking value ) { mGreeking = value; }
+	Greeking					getGreeking() const { return mGreeking; }
+	//! Sets the alpha the current color is multiplied with for greeked text
+	void						setGreekingAlpha( float value ) { mGreekingAlpha = value; }
+	float						getGreekingAlpha() const { return mGreekingAlpha; }
+
+	//! Enables drawing the mesh from an offscreen texture that is only rendered again when the runs, transform scale, viewport or color change. Meant for large blocks of static text.
+	void						setImpostorEnabled( bool value = true );
+	bool						isImpostorEnabled() const { return mImpostorEnabled; }
+	//! Returns the impostor for its hit, miss and memory stats
+	const SdfText::Impostor&	getImpostor() const { return mImpostor; }
+	//! Returns the bounds of all runs
+	const Rectf&				getBounds() const { return mBounds; }
+
+	//! Number of clip slots, slot 0 is reserved for unclipped runs
+	static const uint32_t		MAX_CLIP_RECTS = 15;
+	//! Sets the rect in mesh coordinates that runs with Run::setClipId() \a clipId are clipped to. \a clipId is in [1, MAX_CLIP_RECTS]. The rect is a uniform of the mesh shader, so moving it, e.g. to scroll a clipped container, neither rebuilds the mesh nor adds draw calls. Custom shaders need the \c aClipIndex attribute and \c uClipRects uniform of SdfText::meshShader().
+	void						setClipRect( uint32_t clipId, const Rectf &rect );
+	//! Removes the rect of \a clipId, its runs are drawn unclipped
+	void						clearClipRect( uint32_t clipId );
+	//! Returns the rect of \a clipId, unbounded if it is not set
+	Rectf						getClipRect( uint32_t clipId ) const;
+
 	// NOT READY
 	//void						draw( const SdfTextMesh::RunRef &run );
 
+	//! Vertex attributes stored after the position and tex coord when the runs of a mesh need them, in this order
+	enum class VertexAttrib : uint32_t {
+		SPAN_INDEX	= 0x00000001,
+		GLYPH_INFO	= 0x00000002,
+		EMBOLDEN	= 0x00000004,
+		CLIP		= 0x00000008,
+		END			= 0x00000010
+	};
+
+	//! Span color table of the indices [mIndexStart, mIndexStart + mIndexCount), slot 0 is white
+	struct SpanColorRange {
+		uint32_t				mIndexStart = 0;
+		uint32_t				mIndexCount = 0;
+		std::vector<vec4>		mColors;
+	};
+
 private:
-	SdfTextMesh();
+	SdfTextMesh( SdfText::MemoryResource *memoryResource );
 
 	struct TextBatch {
 		VboRef					mIndexBuffer;
 		VboRef					mVertexBuffer;
 		BatchRef				mBatch;
 		uint32_t				mIndexCount = 0;
+		//! VertexAttrib bits of the vertex layout
+		uint32_t				mAttribs = 0;
+		//! Embolden distance of the batch when EMBOLDEN is not in mAttribs
+		float					mEmbolden = 0.0f;
+		//! Clip slot of the batch when CLIP is not in mAttribs
+		float					mClip = 0.0f;
+		std::vector<SpanColorRange>	mSpanColorRanges;
 	};
 
 	using TextBatchMap = std::unordered_map<Texture2dRef, TextBatch>;
@@ -196,20 +288,39 @@ private:
 		uint32_t				mFeatures = Feature::TEXT;
 		uint32_t				mDirty = Feature::NONE;
 		TextBatchMap			mTextBatches;
+		// Greeking bars, word bars first then line bars
+		float					mMaxFontSize = 0.0f;
+		VboRef					mGreekVertexBuffer;
+		BatchRef				mGreekBatch;
+		uint32_t				mGreekWordVertexCount = 0;
+		uint32_t				mGreekLineVertexCount = 0;
 	};
 
 	using TextDrawRef = std::shared_ptr<TextDraw>;
-	using RunMap = std::unordered_map<SdfTextRef, std::vector<RunRef>>;
-	using TextDrawMap = std::unordered_map<SdfTextRef, TextDrawRef>;
-	using RunDrawMap = std::unordered_map<RunRef, std::vector<RunDraw>>;
+	using RunMap = std::unordered_map<SdfTextRef, std::vector<RunRef>, std::hash<SdfTextRef>, std::equal_to<SdfTextRef>, SdfText::Allocator<std::pair<const SdfTextRef, std::vector<RunRef>>>>;
+	using TextDrawMap = std::unordered_map<SdfTextRef, TextDrawRef, std::hash<SdfTextRef>, std::equal_to<SdfTextRef>, SdfText::Allocator<std::pair<const SdfTextRef, TextDrawRef>>>;
+	using RunDrawMap = std::unordered_map<RunRef, std::vector<RunDraw>, std::hash<RunRef>, std::equal_to<RunRef>, SdfText::Allocator<std::pair<const RunRef, std::vector<RunDraw>>>>;
+
+	SdfText::MemoryResource		*mMemoryResource = nullptr;
 
 	bool						mDirty = false;
+	GlslProgRef					mGlslProg;
+	Rectf						mBounds = Rectf( 0, 0, 0, 0 );
+	float						mGreekingThreshold = 0.0f;
+	Greeking					mGreeking = Greeking::WORDS;
+	float						mGreekingAlpha = 0.5f;
+	bool						mImpostorEnabled = false;
+	float						mImpostorGamma = 0.0f;
+	// Clip rects as ( x1, y1, x2, y2 ), slot 0 unbounded. Uploaded to every shader that declares them.
+	std::array<vec4, MAX_CLIP_RECTS + 1>	mClipRects;
+	SdfText::Impostor			mImpostor;
 	RunMap						mRunMaps;
 	TextDrawMap					mTextDrawMaps;
 	RunDrawMap					mRunDrawMaps;
 
 	void						updateFeatures( const Run *run );
 	void						updateDirty( const Run *run );
+	void						drawBatches( bool premultiply, float gamma );
 };
 
 }} // namespace cinder::gl
\ No newline at end of file
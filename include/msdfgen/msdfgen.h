@@ -28,6 +28,13 @@
 
 namespace msdfgen {
 
+/// Calls body(i, userData) for every i in [0, count) and returns once all calls have completed.
+typedef void (*ParallelFor)(int count, void (*body)(int, void *), void *userData);
+
+/// Sets the function that the generators use to process their rows in parallel.
+/// With NULL (the default) rows are processed serially, or with OpenMP if MSDFGEN_USE_OPENMP is defined.
+void setParallelFor(ParallelFor parallelFor);
+
 /// Generates a conventional single-channel signed distance field.
 void generateSDF(Bitmap<float> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate);
 
@@ -36,7 +36,9 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "cinder/gl/Shader.h"
 #include "cinder/gl/Vao.h"
 #include "cinder/gl/Vbo.h"
+#include "cinder/gl/draw.h"
 #include "cinder/gl/scoped.h"
+#include "cinder/gl/wrapper.h"
 #include "cinder/ip/Fill.h"
 #include "cinder/ImageIo.h"
 #include "cinder/Log.h"
@@ -64,8 +66,21 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "msdfgen/msdfgen.h"
 #include "msdfgen/util.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
 #include <set>
+#include <thread>
 #include <vector>
 #include <boost/algorithm/string.hpp>
 
@@ -103,6 +118,7 @@ static std::string kSdfFragShader =
 	"uniform vec4      uFgColor;\n"
 	"uniform float     uPremultiply;\n"
 	"uniform float     uGamma;\n"
+	"uniform float     uEmbolden;\n"
 	"varying vec2      TexCoord;\n"
 	"\n"
 	"float median( float r, float g, float b ) {\n"
@@ -122,7 +138,7 @@ static std::string kSdfFragShader =
 	"\n"	
 	"void main(void) {\n"
 	"    vec3 sample = texture2D( uTex0, TexCoord ).rgb;\n"
-	"    float sigDist = median( sample.r, sample.g, sample.b );\n"
+	"    float sigDist = median( sample.r, sample.g, sample.b ) + uEmbolden;\n"
 	"    float c = calcDiff( TexCoord );\n"
 	"    vec2 ps = vec2( 1.0 / uTexSize.x, 1.0 / uTexSize.y );\n"
 	"    float dfdx = calcDiff( TexCoord + vec2( ps.x ) ) - c;\n"
@@ -139,7 +155,7 @@ static std::string kSdfFragShader =
 	"    // Sample SDF texture (3 channels).\n"
 	"    vec3 sample = texture2D( uTex0, TexCoord ).rgb;\n"
 	"    // Calculate signed distance (in texels).\n"
-	"    float sigDist = median( sample.r, sample.g, sample.b ) - 0.5;\n"
+	"    float sigDist = median( sample.r, sample.g, sample.b ) - 0.5 + uEmbolden;\n"
 	"    // For proper anti-aliasing, we need to calculate signed distance in pixels. We do this using derivatives.\n"
 	"    vec2 gradDist = safeNormalize( vec2( dFdx( sigDist ), dFdy( sigDist ) ) );\n"
 	"    vec2 grad = vec2( gradDist.x * Jdx.x + gradDist.y * Jdy.x, gradDist.x * Jdx.y + gradDist.y * Jdy.y );\n"
@@ -155,6 +171,81 @@ static std::string kSdfFragShader =
 	"    color.rgb = mix( uFgColor.rgb, uFgColor.rgb * color.a, uPremultiply );\n"
 	"    gl_FragColor = color;\n"
 	"}\n";
+
+static std::string kSdfColorSpanVertShader =
+	"#version 100\n"
+	"precision mediump float;\n"
+	"uniform mat4 ciModelViewProjection;\n"
+	"uniform vec4 uFgColor;\n"
+	"uniform vec4 uSpanColors[64];\n"
+	"attribute vec4 ciPosition;\n"
+	"attribute vec2 ciTexCoord0;\n"
+	"attribute float aSpanIndex;\n"
+	"varying vec2 TexCoord;\n"
+	"varying vec4 FgColor;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = ciModelViewProjection * ciPosition;\n"
+	"	TexCoord = ciTexCoord0;\n"
+	"	FgColor = uFgColor * uSpanColors[int( aSpanIndex + 0.5 )];\n"
+	"}\n";
+
+static std::string kSdfVertexColorVertShader =
+	"#version 100\n"
+	"precision mediump float;\n"
+	"uniform mat4 ciModelViewProjection;\n"
+	"uniform vec4 uFgColor;\n"
+	"attribute vec4 ciPosition;\n"
+	"attribute vec2 ciTexCoord0;\n"
+	"attribute vec4 ciColor;\n"
+	"uniform vec4 uClipRects[16];\n"
+	"attribute float aEmbolden;\n"
+	"attribute float aClipIndex;\n"
+	"varying vec2 TexCoord;\n"
+	"varying vec4 FgColor;\n"
+	"varying float Embolden;\n"
+	"varying vec4 ClipRect;\n"
+	"varying vec2 ClipPos;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = ciModelViewProjection * ciPosition;\n"
+	"	TexCoord = ciTexCoord0;\n"
+	"	FgColor = uFgColor * ciColor;\n"
+	"	Embolden = aEmbolden;\n"
+	"	ClipRect = ( aClipIndex < 0.5 ) ? vec4( -1.0e9, -1.0e9, 1.0e9, 1.0e9 ) : uClipRects[int( aClipIndex + 0.5 )];\n"
+	"	ClipPos = ciPosition.xy;\n"
+	"}\n";
+
+static std::string kSdfMeshVertShader =
+	"#version 100\n"
+	"precision mediump float;\n"
+	"uniform mat4 ciModelViewProjection;\n"
+	"uniform vec4 uFgColor;\n"
+	"uniform vec4 uSpanColors[64];\n"
+	"uniform vec4 uClipRects[16];\n"
+	"attribute vec4 ciPosition;\n"
+	"attribute vec2 ciTexCoord0;\n"
+	"attribute float aSpanIndex;\n"
+	"attribute float aEmbolden;\n"
+	"attribute float aClipIndex;\n"
+	"varying vec2 TexCoord;\n"
+	"varying vec4 FgColor;\n"
+	"varying float Embolden;\n"
+	"varying vec4 ClipRect;\n"
+	"varying vec2 ClipPos;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = ciModelViewProjection * ciPosition;\n"
+	"	TexCoord = ciTexCoord0;\n"
+	"	FgColor = uFgColor * uSpanColors[int( aSpanIndex + 0.5 )];\n"
+	"	Embolden = aEmbolden;\n"
+	"	ClipRect = ( aClipIndex < 0.5 ) ? vec4( -1.0e9, -1.0e9, 1.0e9, 1.0e9 ) : uClipRects[int( aClipIndex + 0.5 )];\n"
+	"	ClipPos = ciPosition.xy;\n"
+	"}\n";
+
+static std::string kSdfFgColorIn = "varying vec4      FgColor;\n";
+static std::string kSdfEmboldenIn = "varying float     Embolden;\n";
+static std::string kSdfClipIn = "varying vec4      ClipRect;\nvarying vec2      ClipPos;\n";
 #else
 static std::string kSdfVertShader = 
 	"#version 150\n"
@@ -174,6 +265,7 @@ static std::string kSdfFragShader =
 	"uniform vec4      uFgColor;\n"
 	"uniform float     uPremultiply;\n"
 	"uniform float     uGamma;\n"
+	"uniform float     uEmbolden;\n"
 	"in vec2           TexCoord;\n"
 	"out vec4          Color;\n"
 	"\n"
@@ -196,7 +288,7 @@ static std::string kSdfFragShader =
 	"    // Sample SDF texture (3 channels).\n"
 	"    vec3 sample = texture( uTex0, TexCoord ).rgb;\n"
 	"    // Calculate signed distance (in texels).\n"
-	"    float sigDist = median( sample.r, sample.g, sample.b ) - 0.5;\n"
+	"    float sigDist = median( sample.r, sample.g, sample.b ) - 0.5 + uEmbolden;\n"
 	"    // For proper anti-aliasing, we need to calculate signed distance in pixels. We do this using derivatives.\n"
 	"    vec2 gradDist = safeNormalize( vec2( dFdx( sigDist ), dFdy( sigDist ) ) );\n"
 	"    vec2 grad = vec2( gradDist.x * Jdx.x + gradDist.y * Jdy.x, gradDist.x * Jdx.y + gradDist.y * Jdy.y );\n"
@@ -210,9 +302,539 @@ static std::string kSdfFragShader =
 	"    Color.rgb = mix( uFgColor.rgb, uFgColor.rgb * Color.a, uPremultiply );\n"
 //	"    Color = vec4( 1, 0, 0, 1 );\n"
 	"}\n";
+
+static std::string kSdfColorSpanVertShader = 
+	"#version 150\n"
+	"uniform mat4 ciModelViewProjection;\n"
+	"uniform vec4 uFgColor;\n"
+	"uniform vec4 uSpanColors[64];\n"
+	"in vec4 ciPosition;\n"
+	"in vec2 ciTexCoord0;\n"
+	"in float aSpanIndex;\n"
+	"out vec2 TexCoord;\n"
+	"out vec4 FgColor;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = ciModelViewProjection * ciPosition;\n"
+	"	TexCoord = ciTexCoord0;\n"
+	"	FgColor = uFgColor * uSpanColors[int( aSpanIndex + 0.5 )];\n"
+	"}\n";
+
+static std::string kSdfVertexColorVertShader = 
+	"#version 150\n"
+	"uniform mat4 ciModelViewProjection;\n"
+	"uniform vec4 uFgColor;\n"
+	"in vec4 ciPosition;\n"
+	"in vec2 ciTexCoord0;\n"
+	"in vec4 ciColor;\n"
+	"uniform vec4 uClipRects[16];\n"
+	"in float aEmbolden;\n"
+	"in float aClipIndex;\n"
+	"out vec2 TexCoord;\n"
+	"out vec4 FgColor;\n"
+	"out float Embolden;\n"
+	"out vec4 ClipRect;\n"
+	"out vec2 ClipPos;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = ciModelViewProjection * ciPosition;\n"
+	"	TexCoord = ciTexCoord0;\n"
+	"	FgColor = uFgColor * ciColor;\n"
+	"	Embolden = aEmbolden;\n"
+	"	ClipRect = ( aClipIndex < 0.5 ) ? vec4( -1.0e9, -1.0e9, 1.0e9, 1.0e9 ) : uClipRects[int( aClipIndex + 0.5 )];\n"
+	"	ClipPos = ciPosition.xy;\n"
+	"}\n";
+
+static std::string kSdfMeshVertShader =
+	"#version 150\n"
+	"uniform mat4 ciModelViewProjection;\n"
+	"uniform vec4 uFgColor;\n"
+	"uniform vec4 uSpanColors[64];\n"
+	"uniform vec4 uClipRects[16];\n"
+	"in vec4 ciPosition;\n"
+	"in vec2 ciTexCoord0;\n"
+	"in float aSpanIndex;\n"
+	"in float aEmbolden;\n"
+	"in float aClipIndex;\n"
+	"out vec2 TexCoord;\n"
+	"out vec4 FgColor;\n"
+	"out float Embolden;\n"
+	"out vec4 ClipRect;\n"
+	"out vec2 ClipPos;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = ciModelViewProjection * ciPosition;\n"
+	"	TexCoord = ciTexCoord0;\n"
+	"	FgColor = uFgColor * uSpanColors[int( aSpanIndex + 0.5 )];\n"
+	"	Embolden = aEmbolden;\n"
+	"	ClipRect = ( aClipIndex < 0.5 ) ? vec4( -1.0e9, -1.0e9, 1.0e9, 1.0e9 ) : uClipRects[int( aClipIndex + 0.5 )];\n"
+	"	ClipPos = ciPosition.xy;\n"
+	"}\n";
+
+static std::string kSdfFgColorIn = "in vec4           FgColor;\n";
+static std::string kSdfEmboldenIn = "in float          Embolden;\n";
+static std::string kSdfClipIn = "in vec4           ClipRect;\nin vec2           ClipPos;\n";
 #endif
 
+//! Number of spans in the color table of the color span shader, slot 0 of its uSpanColors[64] is reserved for glyphs outside of any span
+static const size_t kMaxColorSpans = 63;
+
+//! Returns the fragment shader with the foreground color, and the embolden offset if \a emboldenIn is set, taken from the vertex shader instead of uniforms. With \a clipIn fragments outside of the clip rect passed down by the vertex shader are discarded.
+static std::string makeFgColorInFragShader( bool emboldenIn, bool clipIn = false )
+{
+	std::string result = boost::replace_first_copy( kSdfFragShader, std::string( "uniform vec4      uFgColor;\n" ), kSdfFgColorIn );
+	boost::replace_all( result, "uFgColor", "FgColor" );
+	if( emboldenIn ) {
+		boost::replace_first( result, std::string( "uniform float     uEmbolden;\n" ), kSdfEmboldenIn );
+		boost::replace_all( result, "uEmbolden", "Embolden" );
+	}
+	if( clipIn ) {
+		boost::replace_first( result, kSdfFgColorIn, kSdfFgColorIn + kSdfClipIn );
+		boost::replace_first( result, std::string( "void main(void) {\n" ), std::string( "void main(void) {\n    if( any( lessThan( ClipPos, ClipRect.xy ) ) || any( greaterThanEqual( ClipPos, ClipRect.zw ) ) ) {\n        discard;\n    }\n" ) );
+	}
+	return result;
+}
+
 static gl::GlslProgRef sDefaultShader;
+static gl::GlslProgRef sColorSpanShader;
+static gl::GlslProgRef sVertexColorShader;
+static gl::GlslProgRef sMeshShader;
+
+// =================================================================================================
+// SdfText::Executor
+// =================================================================================================
+
+//! Set while the current thread runs parallelFor() work, nested calls then run serially
+static thread_local bool sInParallelFor = false;
+
+void SdfText::Executor::parallelFor( size_t count, const std::function<void( size_t )> &fn )
+{
+	if( sInParallelFor || ( count <= 1 ) ) {
+		for( size_t i = 0; i < count; ++i ) {
+			fn( i );
+		}
+		return;
+	}
+
+	// Indices are claimed by the caller and the helper tasks. Helpers that start after
+	// every index has been claimed return right away, so the state outlives this call.
+	struct State {
+		std::atomic<size_t>						next;
+		std::atomic<size_t>						done;
+		size_t									count = 0;
+		const std::function<void( size_t )>		*fn = nullptr;
+		std::mutex								mutex;
+		std::condition_variable					doneCv;
+		//! First exception thrown by fn, guarded by mutex. Once set the remaining indices are only counted.
+		std::atomic<bool>						failed;
+		std::exception_ptr						error;
+	};
+	std::shared_ptr<State> state = std::make_shared<State>();
+	state->next = 0;
+	state->done = 0;
+	state->count = count;
+	state->fn = &fn;
+	state->failed = false;
+
+	auto work = [state]() {
+		const bool inParallelFor = sInParallelFor;
+		sInParallelFor = true;
+		for( size_t i = state->next++; i < state->count; i = state->next++ ) {
+			if( ! state->failed ) {
+				try {
+					(*state->fn)( i );
+				}
+				catch( ... ) {
+					std::lock_guard<std::mutex> lock( state->mutex );
+					if( ! state->error ) {
+						state->error = std::current_exception();
+					}
+					state->failed = true;
+				}
+			}
+			if( ( ++state->done ) == state->count ) {
+				std::lock_guard<std::mutex> lock( state->mutex );
+				state->doneCv.notify_all();
+			}
+		}
+		sInParallelFor = inParallelFor;
+	};
+
+	const size_t numHelpers = std::min( count - 1, static_cast<size_t>( std::max( 1u, std::thread::hardware_concurrency() ) ) );
+	for( size_t i = 0; i < numHelpers; ++i ) {
+		submit( work );
+	}
+	work();
+
+	// Helpers may still be running fn, only rethrow once every index is done
+	std::unique_lock<std::mutex> lock( state->mutex );
+	state->doneCv.wait( lock, [&state]() { return state->done == state->count; } );
+	if( state->error ) {
+		std::rethrow_exception( state->error );
+	}
+}
+
+//! \class ThreadPoolExecutor
+//!
+//! Default executor, a fixed set of worker threads sharing one queue
+class ThreadPoolExecutor : public SdfText::Executor {
+public:
+	ThreadPoolExecutor( size_t numThreads )
+	{
+		for( size_t i = 0; i < numThreads; ++i ) {
+			mThreads.push_back( std::thread( &ThreadPoolExecutor::run, this ) );
+		}
+	}
+
+	virtual ~ThreadPoolExecutor()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			mQuit = true;
+		}
+		mTaskCv.notify_all();
+		for( auto& thread : mThreads ) {
+			thread.join();
+		}
+	}
+
+	virtual void submit( const std::function<void()> &task )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			mTasks.push_back( task );
+		}
+		mTaskCv.notify_one();
+	}
+
+	virtual void wait()
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		mIdleCv.wait( lock, [this]() { return mTasks.empty() && ( 0 == mNumActive ); } );
+	}
+
+private:
+	void run()
+	{
+		for( ;; ) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock( mMutex );
+				mTaskCv.wait( lock, [this]() { return mQuit || ( ! mTasks.empty() ); } );
+				if( mTasks.empty() ) {
+					return;
+				}
+				task = std::move( mTasks.front() );
+				mTasks.pop_front();
+				++mNumActive;
+			}
+
+			// An exception escaping a worker thread would terminate the app
+			try {
+				task();
+			}
+			catch( const std::exception &exc ) {
+				CI_LOG_E( "SdfText executor task failed: " << exc.what() );
+			}
+			catch( ... ) {
+				CI_LOG_E( "SdfText executor task failed" );
+			}
+
+			{
+				std::lock_guard<std::mutex> lock( mMutex );
+				--mNumActive;
+				if( mTasks.empty() && ( 0 == mNumActive ) ) {
+					mIdleCv.notify_all();
+				}
+			}
+		}
+	}
+
+	std::vector<std::thread>			mThreads;
+	std::deque<std::function<void()>>	mTasks;
+	std::mutex							mMutex;
+	std::condition_variable				mTaskCv;
+	std::condition_variable				mIdleCv;
+	size_t								mNumActive = 0;
+	bool								mQuit = false;
+};
+
+static SdfText::ExecutorRef sExecutor;
+static std::mutex sExecutorMutex;
+
+//! Routes the row loops of msdfgen to the executor
+static void msdfgenParallelFor( int count, void (*body)( int, void * ), void *userData )
+{
+	SdfText::getExecutor()->parallelFor( static_cast<size_t>( count ), [body, userData]( size_t i ) { body( static_cast<int>( i ), userData ); } );
+}
+
+void SdfText::setExecutor( const ExecutorRef &executor )
+{
+	std::lock_guard<std::mutex> lock( sExecutorMutex );
+	sExecutor = executor;
+	msdfgen::setParallelFor( msdfgenParallelFor );
+}
+
+SdfText::ExecutorRef SdfText::getExecutor()
+{
+	std::lock_guard<std::mutex> lock( sExecutorMutex );
+	if( ! sExecutor ) {
+		// The calling thread takes part in parallelFor(), leave a core for it
+		const size_t numThreads = std::max( 1u, std::thread::hardware_concurrency() ) - 1;
+		sExecutor = SdfText::ExecutorRef( new ThreadPoolExecutor( std::max( static_cast<size_t>( 1 ), numThreads ) ) );
+		msdfgen::setParallelFor( msdfgenParallelFor );
+	}
+	return sExecutor;
+}
+
+// =================================================================================================
+// SdfText::MemoryResource
+// =================================================================================================
+
+//! \class NewDeleteResource
+//!
+//! Allocates from the global heap. Every container of SdfText only needs the alignment \c operator \c new guarantees.
+class NewDeleteResource : public SdfText::MemoryResource {
+public:
+	virtual void* allocate( size_t bytes, size_t alignment ) override {
+		assert( alignment <= alignof( std::max_align_t ) );
+		return ::operator new( bytes );
+	}
+
+	virtual void deallocate( void *ptr, size_t, size_t ) override {
+		::operator delete( ptr );
+	}
+
+	virtual bool isEqual( const SdfText::MemoryResource &other ) const override {
+		return nullptr != dynamic_cast<const NewDeleteResource*>( &other );
+	}
+};
+
+//! Memory resource current on the calling thread, \c nullptr for the global heap
+static thread_local SdfText::MemoryResource *sMemoryResource = nullptr;
+
+SdfText::MemoryResource* SdfText::newDeleteResource()
+{
+	static NewDeleteResource sNewDeleteResource;
+	return &sNewDeleteResource;
+}
+
+SdfText::MemoryResource* SdfText::getMemoryResource()
+{
+	return sMemoryResource ? sMemoryResource : SdfText::newDeleteResource();
+}
+
+SdfText::ScopedMemoryResource::ScopedMemoryResource( MemoryResource *resource )
+	: mPrevious( sMemoryResource )
+{
+	sMemoryResource = resource;
+}
+
+SdfText::ScopedMemoryResource::~ScopedMemoryResource()
+{
+	sMemoryResource = mPrevious;
+}
+
+//! Temporary vector of a call, allocated from the memory resource current on the calling thread
+template <typename T>
+class ScratchVector : public std::vector<T, SdfText::Allocator<T>> {
+public:
+	ScratchVector() : std::vector<T, SdfText::Allocator<T>>( SdfText::Allocator<T>( SdfText::getMemoryResource() ) ) {}
+};
+
+// =================================================================================================
+// BC4 (RGTC1) encoding
+// =================================================================================================
+#if ! defined( GL_COMPRESSED_RED_RGTC1 )
+	#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+#endif
+
+#if defined( CINDER_GL_ES_2 )
+	#define SDF_SINGLE_CHANNEL_FORMAT GL_LUMINANCE
+#else
+	#define SDF_SINGLE_CHANNEL_FORMAT GL_RED
+#endif
+
+//! Returns the size in bytes of the BC4 blocks for an image of \a size
+static size_t calcBc4Size( const ivec2 &size )
+{
+	return static_cast<size_t>( ( ( size.x + 3 ) / 4 ) * ( ( size.y + 3 ) / 4 ) ) * 8;
+}
+
+//! Decodes the 8 byte block \a src into 16 texels
+static void decodeBc4Block( const uint8_t *src, uint8_t *dst )
+{
+	const int red0 = src[0];
+	const int red1 = src[1];
+	uint8_t palette[8];
+	palette[0] = static_cast<uint8_t>( red0 );
+	palette[1] = static_cast<uint8_t>( red1 );
+	if( red0 > red1 ) {
+		for( int i = 2; i < 8; ++i ) {
+			palette[i] = static_cast<uint8_t>( ( ( 8 - i ) * red0 + ( i - 1 ) * red1 + 3 ) / 7 );
+		}
+	}
+	else {
+		for( int i = 2; i < 6; ++i ) {
+			palette[i] = static_cast<uint8_t>( ( ( 6 - i ) * red0 + ( i - 1 ) * red1 + 2 ) / 5 );
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t bits = 0;
+	for( int i = 0; i < 6; ++i ) {
+		bits |= static_cast<uint64_t>( src[2 + i] ) << ( 8 * i );
+	}
+	for( int i = 0; i < 16; ++i ) {
+		dst[i] = palette[( bits >> ( 3 * i ) ) & 0x7];
+	}
+}
+
+//! Encodes 16 texels into the 8 byte block \a dst. The block uses the 8 value mode spanning
+//! the min and max of the texels. The absolute error is added to \a errorSum and \a errorMax.
+static void encodeBc4Block( const uint8_t *src, uint8_t *dst, uint64_t *errorSum, uint32_t *errorMax )
+{
+	int lo = 255;
+	int hi = 0;
+	for( int i = 0; i < 16; ++i ) {
+		lo = std::min( lo, static_cast<int>( src[i] ) );
+		hi = std::max( hi, static_cast<int>( src[i] ) );
+	}
+
+	uint64_t bits = 0;
+	if( hi > lo ) {
+		// Palette level 0 is hi and level 7 is lo, levels 1-6 map to indices 2-7
+		const int range = hi - lo;
+		for( int i = 0; i < 16; ++i ) {
+			const int level = ( 14 * ( hi - src[i] ) + range ) / ( 2 * range );
+			const uint64_t index = ( 0 == level ) ? 0 : ( ( 7 == level ) ? 1 : static_cast<uint64_t>( level + 1 ) );
+			bits |= index << ( 3 * i );
+		}
+	}
+
+	dst[0] = static_cast<uint8_t>( hi );
+	dst[1] = static_cast<uint8_t>( lo );
+	for( int i = 0; i < 6; ++i ) {
+		dst[2 + i] = static_cast<uint8_t>( ( bits >> ( 8 * i ) ) & 0xFF );
+	}
+
+	uint8_t decoded[16];
+	decodeBc4Block( dst, decoded );
+	for( int i = 0; i < 16; ++i ) {
+		const uint32_t error = static_cast<uint32_t>( std::abs( static_cast<int>( decoded[i] ) - static_cast<int>( src[i] ) ) );
+		*errorSum += error;
+		*errorMax = std::max( *errorMax, error );
+	}
+}
+
+//! Copies the 4x4 block at \a blockX, \a blockY out of \a pixels, clamping at the image edges
+static void fetchBc4Block( const uint8_t *pixels, const ivec2 &size, int blockX, int blockY, uint8_t *dst )
+{
+	for( int y = 0; y < 4; ++y ) {
+		const int py = std::min( blockY * 4 + y, size.y - 1 );
+		for( int x = 0; x < 4; ++x ) {
+			const int px = std::min( blockX * 4 + x, size.x - 1 );
+			dst[y * 4 + x] = pixels[py * size.x + px];
+		}
+	}
+}
+
+//! Encodes the tightly packed single channel \a pixels into \a blocks. Block rows are
+//! spread across the executor. Returns the mean and max absolute error in texels.
+static void encodeBc4( const uint8_t *pixels, const ivec2 &size, uint8_t *blocks, float *meanError, float *maxError )
+{
+	const int numBlocksX = ( size.x + 3 ) / 4;
+	const int numBlocksY = ( size.y + 3 ) / 4;
+
+	std::vector<uint64_t> errorSums( numBlocksY, 0 );
+	std::vector<uint32_t> errorMaxs( numBlocksY, 0 );
+	SdfText::getExecutor()->parallelFor( static_cast<size_t>( numBlocksY ), [&]( size_t row ) {
+		const int blockY = static_cast<int>( row );
+		uint8_t texels[16];
+		for( int blockX = 0; blockX < numBlocksX; ++blockX ) {
+			fetchBc4Block( pixels, size, blockX, blockY, texels );
+			encodeBc4Block( texels, blocks + 8 * ( blockY * numBlocksX + blockX ), &errorSums[row], &errorMaxs[row] );
+		}
+	} );
+
+	uint64_t errorSum = 0;
+	uint32_t errorMax = 0;
+	for( int blockY = 0; blockY < numBlocksY; ++blockY ) {
+		errorSum += errorSums[blockY];
+		errorMax = std::max( errorMax, errorMaxs[blockY] );
+	}
+	*meanError = static_cast<float>( static_cast<double>( errorSum ) / static_cast<double>( std::max( 1, size.x * size.y ) ) );
+	*maxError = static_cast<float>( errorMax );
+}
+
+//! Decodes \a blocks into the tightly packed single channel \a pixels
+static void decodeBc4( const uint8_t *blocks, const ivec2 &size, uint8_t *pixels )
+{
+	const int numBlocksX = ( size.x + 3 ) / 4;
+	const int numBlocksY = ( size.y + 3 ) / 4;
+	uint8_t texels[16];
+	for( int blockY = 0; blockY < numBlocksY; ++blockY ) {
+		for( int blockX = 0; blockX < numBlocksX; ++blockX ) {
+			decodeBc4Block( blocks + 8 * ( blockY * numBlocksX + blockX ), texels );
+			for( int y = 0; y < 4; ++y ) {
+				const int py = blockY * 4 + y;
+				for( int x = 0; x < 4; ++x ) {
+					const int px = blockX * 4 + x;
+					if( ( px < size.x ) && ( py < size.y ) ) {
+						pixels[py * size.x + px] = texels[y * 4 + x];
+					}
+				}
+			}
+		}
+	}
+}
+
+//! Returns true if BC4 textures can be uploaded as is. ES 2 has no swizzle to replicate the red channel.
+static bool isBc4Supported()
+{
+#if defined( CINDER_GL_ES_2 )
+	return false;
+#elif defined( CINDER_GL_ES )
+	return gl::isExtensionAvailable( "GL_EXT_texture_compression_rgtc" );
+#else
+	return true;
+#endif
+}
+
+//! Creates a single channel texture that samples as RRR1 so the median in the shader is the distance
+static gl::TextureRef createSingleChannelTexture( const uint8_t *pixels, const ivec2 &size )
+{
+	Channel8u channel( size.x, size.y, static_cast<ptrdiff_t>( size.x ), 1, const_cast<uint8_t *>( pixels ) );
+	gl::Texture2d::Format texFormat = gl::Texture2d::Format();
+#if ! defined( CINDER_GL_ES_2 )
+	texFormat.swizzleMask( GL_RED, GL_RED, GL_RED, GL_ONE );
+#endif
+	return gl::Texture2d::create( channel, texFormat );
+}
+
+//! Creates a texture from \a blocks, falls back to a decoded single channel texture if BC4 is not supported
+static gl::TextureRef createBc4Texture( const std::vector<uint8_t> &blocks, const ivec2 &size )
+{
+	if( ! isBc4Supported() ) {
+		std::vector<uint8_t> pixels( size.x * size.y );
+		decodeBc4( blocks.data(), size, pixels.data() );
+		return createSingleChannelTexture( pixels.data(), size );
+	}
+
+	GLuint texId = 0;
+	glGenTextures( 1, &texId );
+	ScopedTextureBind texBindScp( GL_TEXTURE_2D, texId );
+	glCompressedTexImage2D( GL_TEXTURE_2D, 0, GL_COMPRESSED_RED_RGTC1, size.x, size.y, 0, static_cast<GLsizei>( blocks.size() ), blocks.data() );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED );
+	// Texture2d takes ownership of the id
+	return gl::Texture2d::create( GL_TEXTURE_2D, texId, size.x, size.y, false );
+}
 
 // =================================================================================================
 // SdfText::TextureAtlas
@@ -225,41 +847,202 @@ public:
 		std::string mStyleName;
 		std::string mUtf8Chars;
 		ivec2		mTextureSize = ivec2( 0 );
+		bool		mAutoTextureSize = false;
 		ivec2		mSdfBitmapSize = ivec2( 0 );
+		bool		mSingleChannel = false;
+		bool		mCompressed = false;
+		uint64_t	mPageCorpusHash = 0;
+		uint64_t	mGlyphCostLimit = 0;
+		SdfText::GlyphCostFallback	mGlyphCostFallback = SdfText::GlyphCostFallback::SIMPLIFY;
 		bool operator==( const CacheKey& rhs ) const { 
 			return ( mFamilyName == rhs.mFamilyName ) &&
 				   ( mStyleName == rhs.mStyleName ) && 
 				   ( mUtf8Chars == rhs.mUtf8Chars ) &&
 				   ( mTextureSize == rhs.mTextureSize ) &&
-				   ( mSdfBitmapSize == rhs.mSdfBitmapSize );
+				   ( mAutoTextureSize == rhs.mAutoTextureSize ) &&
+				   ( mSdfBitmapSize == rhs.mSdfBitmapSize ) &&
+				   ( mSingleChannel == rhs.mSingleChannel ) &&
+				   ( mCompressed == rhs.mCompressed ) &&
+				   ( mPageCorpusHash == rhs.mPageCorpusHash ) &&
+				   ( mGlyphCostLimit == rhs.mGlyphCostLimit ) &&
+				   ( mGlyphCostFallback == rhs.mGlyphCostFallback );
 		}
 		bool operator!=( const CacheKey& rhs ) const {
 			return ( mFamilyName != rhs.mFamilyName ) ||
 				   ( mStyleName != rhs.mStyleName ) || 
 				   ( mUtf8Chars != rhs.mUtf8Chars ) ||
 				   ( mTextureSize != rhs.mTextureSize ) ||
-				   ( mSdfBitmapSize != rhs.mSdfBitmapSize );
+				   ( mAutoTextureSize != rhs.mAutoTextureSize ) ||
+				   ( mSdfBitmapSize != rhs.mSdfBitmapSize ) ||
+				   ( mSingleChannel != rhs.mSingleChannel ) ||
+				   ( mCompressed != rhs.mCompressed ) ||
+				   ( mPageCorpusHash != rhs.mPageCorpusHash ) ||
+				   ( mGlyphCostLimit != rhs.mGlyphCostLimit ) ||
+				   ( mGlyphCostFallback != rhs.mGlyphCostFallback );
 		}
 	};
 
 	typedef std::vector<std::pair<CacheKey, SdfText::TextureAtlasRef>> AtlasCacher;
 
+	using GlyphShapes = std::vector<std::pair<SdfText::Font::Glyph, msdfgen::Shape>>;
+
 	// ---------------------------------------------------------------------------------------------
 
-	virtual ~TextureAtlas() {}
+	virtual ~TextureAtlas();
 
 	static SdfText::TextureAtlasRef create( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices );
+	//! Creates an atlas without pages that carries the generation parameters of \a format and the tile size and bounds of \a glyphIndices, which layout reads. Nothing is rendered.
+	static SdfText::TextureAtlasRef createMetrics( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices );
+	//! Creates an empty atlas with the generation parameters of this one at \a scale times its SDF resolution, for glyphs appended on demand into pages of \a pageSize. Tiles are cached in \a cacheDir unless it is empty.
+	SdfText::TextureAtlasRef createScaled( float scale, const ivec2 &pageSize, const fs::path &cacheDir ) const;
 
 	static ivec2 calculateSdfBitmapSize( const vec2 &sdfScale, const ivec2& sdfPadding, const vec2 &maxGlyphSize );
 
+	//! Returns the power of two texture size, at most \a maxTextureSize, that holds \a numGlyphs tiles of \a tileStride in the fewest pages with the least unused area
+	static ivec2 calcAutoTextureSize( size_t numGlyphs, const ivec2 &tileStride, int32_t maxTextureSize );
+
+	//! Returns the glyphs that are only used for sizing the tiles, i.e. the embedded chars of \a format.
+	static std::vector<SdfText::Font::Glyph> getSizingGlyphs( FT_Face face, const SdfText::Format &format );
+
+	//! Adds \a glyphShapes to the atlas. Free tiles in the last texture are filled before new textures are created. With \a background the tiles that are not in the glyph cache are rendered on the executor, see isGlyphPending().
+	void appendGlyphs( const GlyphShapes &glyphShapes, bool background = false );
+	//! Returns whether \a glyphIndex has a tile
+	bool hasGlyph( SdfText::Font::Glyph glyphIndex ) const { return mGlyphInfo.end() != mGlyphInfo.find( glyphIndex ); }
+	//! Returns whether the tile of \a glyphIndex is still rendered in the background and blank in its page
+	bool isGlyphPending( SdfText::Font::Glyph glyphIndex ) const { return mPendingGlyphs.end() != mPendingGlyphs.find( glyphIndex ); }
+
+	//! Returns the textures of the current context. Textures are created on first use in each context, and updated when the page changed since.
+	const std::vector<gl::TextureRef>&	getTextures();
+	//! Returns the number of pages
+	uint32_t							getNumPages() const { return static_cast<uint32_t>( mPages.size() ); }
+	//! Frees the CPU copy of each page once every context that has drawn the atlas has uploaded it
+	void								releasePageData();
+	//! Waits for the deferred tiles and writes them to their pages, see SdfText::GlyphCostFallback::DEFER
+	void								finishDeferredTiles();
+	//! Releases the textures of the current context
+	void								releaseContextTextures();
+
 private:
-	TextureAtlas();
+	//! Creates an empty atlas whose glyph table uses \a memoryResource
+	TextureAtlas( SdfText::MemoryResource *memoryResource );
 	TextureAtlas( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices );
 	friend class SdfText;
 
+	//! Reads the bounds of \a glyphIndices into mGlyphInfo and sizes the tiles for them and the sizing glyphs of \a format
+	void measureGlyphs( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices );
+	//! Generation parameters of the tiles, copied into background tasks so that they don't depend on the atlas
+	struct RenderParams {
+		vec2	mSdfScale;
+		ivec2	mSdfPadding;
+		ivec2	mSdfBitmapSize;
+		float	mSdfRange;
+		float	mSdfAngle;
+		bool	mInvertSdf;
+		bool	mSingleChannel;
+	};
+
+	RenderParams getRenderParams() const;
+	//! Renders the SDF for \a shape into \a dst which has a row stride of \a rowBytes and a pixel stride of getPixelInc(). With a \a resolution below 1 the SDF is generated at that fraction of the tile size and scaled up.
+	void renderGlyphBitmap( msdfgen::Shape &shape, const vec2 &originOffset, uint8_t *dst, size_t rowBytes, float resolution = 1.0f ) const { renderGlyphBitmap( getRenderParams(), shape, originOffset, dst, rowBytes, resolution ); }
+	static void renderGlyphBitmap( const RenderParams &params, msdfgen::Shape &shape, const vec2 &originOffset, uint8_t *dst, size_t rowBytes, float resolution = 1.0f );
+	//! Checks the generation cost of \a shape against mGlyphCostLimit and records it in mStats. Over the limit the outline is simplified in place, or \a resolution is lowered or set to 0 for a deferred glyph, depending on mGlyphCostFallback. Returns whether the tile is degraded, from a simplified outline or at a lower resolution, so that it must not be cached.
+	bool applyGlyphCostGuard( SdfText::Font::Glyph glyphIndex, msdfgen::Shape &shape, float *resolution );
+	//! Renders \a shape at \a resolution on the executor and writes it to the tile of \a glyphInfo on the next getTextures() after it completes, storing it in the glyph cache if \a cacheTile. The task owns all it uses, the atlas can go away before it runs.
+	void deferTile( SdfText::Font::Glyph glyphIndex, const SdfText::Font::GlyphInfo &glyphInfo, msdfgen::Shape &&shape, float resolution = 1.0f, bool cacheTile = true );
+	//! Writes the deferred tiles that have completed to their pages
+	void writeDeferredTiles();
+	//! Returns the bytes per pixel of the page pixels, 1 for single channel and 3 for MSDF
+	size_t getPixelInc() const { return mSingleChannel ? 1 : 3; }
+
+	//! CPU copy of a page. Holds pixels for uncompressed pages and BC4 blocks for compressed pages.
+	struct Page {
+		ivec2					mSize = ivec2( 0 );
+		std::vector<uint8_t>	mData;
+		//! Incremented whenever mData changes so that textures can be updated
+		uint32_t				mRevision = 0;
+		//! Areas written by the last revisions, oldest first, so that textures only update what changed
+		std::deque<Area>		mDirtyAreas;
+
+		//! Returns the area written after \a revision, the whole page if those writes are no longer tracked
+		Area getDirtyArea( uint32_t revision ) const
+		{
+			const size_t numNewer = static_cast<size_t>( mRevision - revision );
+			if( 0 == numNewer ) {
+				return Area();
+			}
+			if( numNewer > mDirtyAreas.size() ) {
+				return Area( ivec2( 0 ), mSize );
+			}
+			Area result = mDirtyAreas[mDirtyAreas.size() - numNewer];
+			for( size_t i = mDirtyAreas.size() - numNewer + 1; i < mDirtyAreas.size(); ++i ) {
+				result.x1 = std::min( result.x1, mDirtyAreas[i].x1 );
+				result.y1 = std::min( result.y1, mDirtyAreas[i].y1 );
+				result.x2 = std::max( result.x2, mDirtyAreas[i].x2 );
+				result.y2 = std::max( result.y2, mDirtyAreas[i].y2 );
+			}
+			return result;
+		}
+	};
+
+	//! Textures of one context along with the page revisions that they hold
+	struct ContextTextures {
+		std::vector<gl::TextureRef>	mTextures;
+		std::vector<uint32_t>		mRevisions;
+		//! Expires with the context, a new context can reuse the address of a destroyed one
+		std::weak_ptr<gl::Context::PlatformData>	mPlatformData;
+	};
+
+	//! Tile of a glyph over the cost limit that is rendered in the background
+	struct DeferredTile {
+		SdfText::Font::Glyph	mGlyphIndex = 0;
+		uint32_t				mPageIndex = 0;
+		ivec2					mPosition = ivec2( 0 );
+		msdfgen::Shape			mShape;
+		std::vector<uint8_t>	mData;
+		std::atomic<bool>		mDone{ false };
+		//! Signaled with mDone, so that waiting for the tile doesn't wait for unrelated tasks
+		std::mutex				mDoneMutex;
+		std::condition_variable	mDoneCondition;
+
+		void	setDone();
+		void	waitDone();
+	};
+
+	//! Adds a page from the tightly packed \a pixels, compressing them if needed
+	void addPage( const uint8_t *pixels, const ivec2 &size );
+	//! Writes the tightly packed \a tileData to \a position of page \a pageIndex
+	void writeTile( uint32_t pageIndex, const ivec2 &position, const uint8_t *tileData );
+	//! Records \a area as written by the current revision of \a page
+	static void addDirtyArea( Page *page, const Area &area );
+	//! Creates a texture in the current context from \a page
+	gl::TextureRef createTexture( const Page &page ) const;
+	//! Replaces \a area of \a tex with the pixels of \a page
+	void updateTexture( const gl::TextureRef &tex, const Page &page, const Area &area ) const;
+	//! Drops the textures of destroyed contexts without deleting them, their names may have been reused
+	void releaseDeadContextTextures();
+	//! Frees the data of the pages that are up to date in every context
+	void releaseUploadedPages();
+	//! Updates the page counts, sizes and occupancy in mStats
+	void updatePageStats();
+
+	//! Points the glyph cache at the subdirectory of \a cacheDir for the font data of \a face and the generation parameters
+	void initGlyphCache( FT_Face face, const fs::path &cacheDir );
+	//! Places the cached tile of \a glyphIndex in the tile at \a dst, returns \c false if there is none, its metrics differ from \a glyphInfo or it is smaller than the glyph needs in this atlas
+	bool readCachedTile( SdfText::Font::Glyph glyphIndex, const SdfText::Font::GlyphInfo &glyphInfo, uint8_t *dst, size_t rowBytes ) const;
+	//! Stores the tile of \a glyphIndex at \a src in the glyph cache
+	void writeCachedTile( SdfText::Font::Glyph glyphIndex, const SdfText::Font::GlyphInfo &glyphInfo, const uint8_t *src, size_t rowBytes ) const;
+	//! Stores the tile of \a glyphIndex rendered with \a params at \a src in the glyph cache at \a cachePath, safe to call from any thread
+	static void writeCachedTile( const fs::path &cachePath, const RenderParams &params, size_t pixelInc, SdfText::Font::Glyph glyphIndex, const SdfText::Font::GlyphInfo &glyphInfo, const uint8_t *src, size_t rowBytes );
+	//! Returns the size of the normalized tile of \a glyphInfo, the lower left part of a tile rendered with \a params that holds the glyph and its distance falloff. It only depends on the glyph, unless the tile is smaller.
+	static ivec2 calcCachedTileSize( const RenderParams &params, const SdfText::Font::GlyphInfo &glyphInfo );
+
 	FT_Face							mFace = nullptr;
-	std::vector<gl::TextureRef>		mTextures;
-	SdfText::Font::GlyphInfoMap		mGlyphInfo;
+	std::vector<Page>				mPages;
+	std::map<gl::Context*, ContextTextures>	mContextTextures;
+	bool							mReleasePageData = false;
+	SdfText::GlyphInfoTable		mGlyphInfo;
+	//! Size of the first page added by appendGlyphs(), 0 for the default texture size
+	ivec2							mAppendPageSize = ivec2( 0 );
 
 	//! Base scale that SDF generator uses is size 32 at 72 DPI. A scale of 1.5, 2.0, and 3.0 translates to size 48, 64 and 96 and 72 DPI.
 	vec2						mSdfScale = vec2( 1.0f );
@@ -268,19 +1051,167 @@ private:
 	vec2						mMaxGlyphSize = vec2( 0.0f );
 	float						mMaxAscent = 0.0f;
 	float						mMaxDescent = 0.0f;
+
+	// Generation parameters, needed when glyphs are appended later
+	float						mSdfRange = 4.0f;
+	float						mSdfAngle = 3.0f;
+	ivec2						mTileSpacing = ivec2( 1 );
+	bool						mInvertSdf = false;
+	bool						mAutoTextureSize = false;
+	int32_t						mMaxTextureSize = 4096;
+	//! Directory of the glyph tiles for this font and these parameters, empty if the cache is disabled
+	fs::path					mGlyphCachePath;
+	uint64_t					mGlyphCostLimit = 0;
+	SdfText::GlyphCostFallback	mGlyphCostFallback = SdfText::GlyphCostFallback::SIMPLIFY;
+	//! Tiles rendering on the executor, in the order they were deferred
+	std::vector<std::shared_ptr<DeferredTile>>	mDeferredTiles;
+	//! Glyphs of mDeferredTiles
+	std::set<SdfText::Font::Glyph>				mPendingGlyphs;
+
+	bool						mSingleChannel = false;
+	bool						mCompressed = false;
+	SdfText::AtlasStats			mStats;
+	uint64_t					mCompressionErrorSum = 0;
+	uint64_t					mCompressionTexelCount = 0;
 };
 
-SdfText::TextureAtlas::TextureAtlas()
+SdfText::TextureAtlas::TextureAtlas( SdfText::MemoryResource *memoryResource )
+	: mGlyphInfo( SdfText::GlyphInfoTable::allocator_type( memoryResource ) )
 {
 }
 
-SdfText::TextureAtlas::TextureAtlas( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices )
-	: mFace( face ), mSdfScale( format.getSdfScale() ), mSdfPadding( format.getSdfPadding() )
+//! Returns the glyphs of each string of \a corpus that are in \a glyphIndices, as sorted positions in \a glyphIndices. Strings without any of them are dropped.
+static std::vector<std::vector<uint32_t>> mapCorpusGlyphs( FT_Face face, const std::vector<std::string> &corpus, const std::vector<SdfText::Font::Glyph> &glyphIndices )
 {
-	const ivec2& tileSpacing = format.getSdfTileSpacing();
+	std::unordered_map<SdfText::Font::Glyph, uint32_t> glyphPositions;
+	for( size_t i = 0; i < glyphIndices.size(); ++i ) {
+		glyphPositions.insert( std::make_pair( glyphIndices[i], static_cast<uint32_t>( i ) ) );
+	}
+
+	std::vector<std::vector<uint32_t>> result;
+	for( const auto& str : corpus ) {
+		std::vector<uint32_t> positions;
+		for( const auto& ch : ci::toUtf32( str ) ) {
+			auto it = glyphPositions.find( static_cast<SdfText::Font::Glyph>( FT_Get_Char_Index( face, static_cast<FT_ULong>( ch ) ) ) );
+			if( glyphPositions.end() != it ) {
+				positions.push_back( it->second );
+			}
+		}
+		std::sort( positions.begin(), positions.end() );
+		positions.erase( std::unique( positions.begin(), positions.end() ), positions.end() );
+		if( ! positions.empty() ) {
+			result.push_back( positions );
+		}
+	}
+	return result;
+}
+
+//! Returns \a glyphIndices reordered so that each run of \a pageCapacity glyphs, one page, holds glyphs used together by the strings
+//! of \a corpusGlyphs. Pages are filled greedily: the next glyph is the one sharing the most strings with the glyphs already on the
+//! page, each string weighted by the inverse of its glyph count. A page without such a glyph continues with the most used glyph left.
+static std::vector<SdfText::Font::Glyph> clusterGlyphsByCoUsage( const std::vector<SdfText::Font::Glyph> &glyphIndices, const std::vector<std::vector<uint32_t>> &corpusGlyphs, size_t pageCapacity )
+{
+	const size_t numGlyphs = glyphIndices.size();
+	std::vector<std::vector<uint32_t>> glyphStrings( numGlyphs );
+	for( size_t s = 0; s < corpusGlyphs.size(); ++s ) {
+		for( const auto& g : corpusGlyphs[s] ) {
+			glyphStrings[g].push_back( static_cast<uint32_t>( s ) );
+		}
+	}
+
+	// Seeds, most used first and charset order for ties and unused glyphs
+	std::vector<uint32_t> seeds( numGlyphs );
+	for( size_t i = 0; i < numGlyphs; ++i ) {
+		seeds[i] = static_cast<uint32_t>( i );
+	}
+	std::stable_sort( seeds.begin(), seeds.end(),
+		[&glyphStrings]( uint32_t a, uint32_t b ) -> bool {
+			return glyphStrings[a].size() > glyphStrings[b].size();
+		}
+	);
+
+	// Candidates are pushed again whenever their score grows, stale entries are skipped when popped
+	struct Candidate {
+		double		score;
+		uint32_t	glyph;
+		bool operator<( const Candidate &rhs ) const {
+			return ( score < rhs.score ) || ( ( score == rhs.score ) && ( glyph > rhs.glyph ) );
+		}
+	};
+
+	std::vector<SdfText::Font::Glyph> result;
+	result.reserve( numGlyphs );
+	std::vector<uint8_t> assigned( numGlyphs, 0 );
+	std::vector<double> scores( numGlyphs, 0.0 );
+	std::vector<uint32_t> scored;
+	size_t nextSeed = 0;
+	while( result.size() < numGlyphs ) {
+		const size_t pageEnd = std::min( numGlyphs, result.size() + pageCapacity );
+		std::priority_queue<Candidate> candidates;
+		while( result.size() < pageEnd ) {
+			uint32_t glyph = 0;
+			while( ( ! candidates.empty() ) && ( assigned[candidates.top().glyph] || ( candidates.top().score != scores[candidates.top().glyph] ) ) ) {
+				candidates.pop();
+			}
+			if( ! candidates.empty() ) {
+				glyph = candidates.top().glyph;
+				candidates.pop();
+			}
+			else {
+				while( assigned[seeds[nextSeed]] ) {
+					++nextSeed;
+				}
+				glyph = seeds[nextSeed];
+			}
+
+			assigned[glyph] = 1;
+			result.push_back( glyphIndices[glyph] );
+			for( const auto& s : glyphStrings[glyph] ) {
+				const double weight = 1.0 / static_cast<double>( corpusGlyphs[s].size() );
+				for( const auto& g : corpusGlyphs[s] ) {
+					if( assigned[g] ) {
+						continue;
+					}
+					if( 0.0 == scores[g] ) {
+						scored.push_back( g );
+					}
+					scores[g] += weight;
+					candidates.push( Candidate{ scores[g], g } );
+				}
+			}
+		}
+		// Affinities only hold within a page
+		for( const auto& g : scored ) {
+			scores[g] = 0.0;
+		}
+		scored.clear();
+	}
+	return result;
+}
+
+//! Returns the mean number of distinct pages touched by the strings of \a corpusGlyphs, \a pageFn returns the page of a glyph position
+static float calcPagesPerString( const std::vector<std::vector<uint32_t>> &corpusGlyphs, const std::function<uint32_t( uint32_t )> &pageFn )
+{
+	if( corpusGlyphs.empty() ) {
+		return 0.0f;
+	}
+	uint64_t numPages = 0;
+	std::vector<uint32_t> pages;
+	for( const auto& glyphs : corpusGlyphs ) {
+		pages.clear();
+		for( const auto& g : glyphs ) {
+			pages.push_back( pageFn( g ) );
+		}
+		std::sort( pages.begin(), pages.end() );
+		numPages += std::unique( pages.begin(), pages.end() ) - pages.begin();
+	}
+	return static_cast<float>( static_cast<double>( numPages ) / static_cast<double>( corpusGlyphs.size() ) );
+}
 
+void SdfText::TextureAtlas::measureGlyphs( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices )
+{
 	// CW (TTF) vs CCW (OTF) - SDF needs to be inverted if font is OTF
-	bool invertSdf = ( std::string( "OTTO" ) ==  std::string( reinterpret_cast<const char *>( face->stream->base ) ) );
+	mInvertSdf = ( std::string( "OTTO" ) ==  std::string( reinterpret_cast<const char *>( face->stream->base ) ) );
 
 	// Build glyph information that will be needed later
 	for( const auto& glyphIndex : glyphIndices ) {
@@ -308,12 +1239,51 @@ SdfText::TextureAtlas::TextureAtlas( FT_Face face, const SdfText::Format &format
 		}	
 	}
 
+	// Embedded glyphs are generated later using the same tile size, so they contribute to it now
+	for( const auto& glyphIndex : SdfText::TextureAtlas::getSizingGlyphs( face, format ) ) {
+		msdfgen::Shape shape;
+		if( msdfgen::loadGlyph( shape, face, glyphIndex ) ) {
+			double l, b, r, t;
+			l = b = r = t = 0.0;
+			shape.bounds( l, b, r, t );
+			mMaxGlyphSize.x = std::max( mMaxGlyphSize.x, static_cast<float>( r - l ) );
+			mMaxGlyphSize.y = std::max( mMaxGlyphSize.y, static_cast<float>( t - b ) );
+		}
+	}
+
 	// Determine render bitmap size
 	mSdfBitmapSize = SdfText::TextureAtlas::calculateSdfBitmapSize( mSdfScale, mSdfPadding, mMaxGlyphSize );
+}
+
+SdfText::TextureAtlas::TextureAtlas( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices )
+	: mFace( face ), mGlyphInfo( SdfText::GlyphInfoTable::allocator_type( format.getMemoryResource() ) ), mSdfScale( format.getSdfScale() ), mSdfPadding( format.getSdfPadding() ),
+	  mSdfRange( format.getSdfRange() ), mSdfAngle( format.getSdfAngle() ), mTileSpacing( format.getSdfTileSpacing() ),
+	  mSingleChannel( format.getSingleChannel() || format.getCompressed() ), mCompressed( format.getCompressed() )
+{
+	const ivec2& tileSpacing = format.getSdfTileSpacing();
+	mGlyphCostLimit = format.getGlyphCostLimit();
+	mGlyphCostFallback = format.getGlyphCostFallback();
+
+	measureGlyphs( face, format, glyphIndices );
+	const ivec2 tileStride = mSdfBitmapSize + tileSpacing;
 	// Determine glyph counts (per texture atlas)
-	const size_t numGlyphColumns   = ( format.getTextureWidth()  / ( mSdfBitmapSize.x + tileSpacing.x ) );
-	const size_t numGlyphRows      = ( format.getTextureHeight() / ( mSdfBitmapSize.y + tileSpacing.y ) );
-	const size_t numGlyphsPerAtlas = numGlyphColumns * numGlyphRows;
+	mAutoTextureSize = format.getAutoTextureSize();
+	mMaxTextureSize = format.getMaxTextureSize();
+	if( ! format.getGlyphCacheDir().empty() ) {
+		initGlyphCache( face, format.getGlyphCacheDir() );
+	}
+	const ivec2 textureSize = mAutoTextureSize ? calcAutoTextureSize( glyphIndices.size(), tileStride, mMaxTextureSize ) : format.getTextureSize();
+	const size_t numGlyphsPerAtlas = static_cast<size_t>( ( textureSize.x / tileStride.x ) * ( textureSize.y / tileStride.y ) );
+	if( 0 == numGlyphsPerAtlas ) {
+		throw ci::Exception( "Texture atlas tile does not fit in texture" );
+	}
+
+	// Glyphs used together share pages when a corpus says which ones are
+	std::vector<std::vector<uint32_t>> corpusGlyphs;
+	if( ! format.getPageCorpus().empty() ) {
+		corpusGlyphs = mapCorpusGlyphs( face, format.getPageCorpus(), glyphIndices );
+	}
+	const std::vector<SdfText::Font::Glyph> packedGlyphs = ( ( ! corpusGlyphs.empty() ) && ( glyphIndices.size() > numGlyphsPerAtlas ) ) ? clusterGlyphsByCoUsage( glyphIndices, corpusGlyphs, numGlyphsPerAtlas ) : glyphIndices;
 	
 	// Render position for each glyph
 	struct RenderGlyph {
@@ -321,120 +1291,128 @@ SdfText::TextureAtlas::TextureAtlas( FT_Face face, const SdfText::Format &format
 		ivec2    position;
 	};
 
-	std::vector<std::vector<RenderGlyph>> renderAtlases;
-
-	// Build the atlases
-	size_t curRenderIndex = 0;
-	ivec2 curRenderPos = ivec2( 0 );
-	std::vector<RenderGlyph> curRenderGlyphs;
-	for( std::vector<SdfText::Font::Glyph>::const_iterator glyphIndexIt = glyphIndices.begin(); glyphIndexIt != glyphIndices.end() ;  ) {
-		// Build render glyph
-		RenderGlyph renderGlyph;
-		renderGlyph.glyphIndex = *glyphIndexIt;
-		renderGlyph.position.x = curRenderPos.x;
-		renderGlyph.position.y = curRenderPos.y;
-		
-		// Add to render atlas
-		curRenderGlyphs.push_back( renderGlyph );
-
-		// Increment index
-		++curRenderIndex;
-		// Increment glyph index iterator
-		++glyphIndexIt;
-		// Advance horizontal position
-		curRenderPos.x += mSdfBitmapSize.x;
-		curRenderPos.x += tileSpacing.x;
-		// Move to next row if needed
-		if( 0 == ( curRenderIndex % numGlyphColumns ) ) {
-			curRenderPos.x = 0;
-			curRenderPos.y += mSdfBitmapSize.y;
-			curRenderPos.y += tileSpacing.y;
-		}
-
-		if( ( numGlyphsPerAtlas == curRenderIndex ) || ( glyphIndices.end() == glyphIndexIt ) ) {
-			// Copy current atlas
-			renderAtlases.push_back( curRenderGlyphs );
-			// Reset values
-			curRenderIndex = 0;
-			curRenderPos = ivec2( 0 );
-			curRenderGlyphs.clear();
-		}
-	}
-
-	// Surface
-	Surface8u surface( format.getTextureWidth(), format.getTextureHeight(), false );
-	ip::fill( &surface, Color8u( 0, 0, 0 ) );
-	uint8_t *surfaceData   = surface.getData();
-	size_t surfacePixelInc = surface.getPixelInc();
-	size_t surfaceRowBytes = surface.getRowBytes();
+	struct RenderAtlas {
+		ivec2                    size;
+		std::vector<RenderGlyph> glyphs;
+	};
+
+	// Build the atlases, with an automatic size the last one only needs to hold the glyphs left for it
+	std::vector<RenderAtlas> renderAtlases;
+	for( size_t first = 0; first < packedGlyphs.size(); first += numGlyphsPerAtlas ) {
+		const size_t count = std::min( numGlyphsPerAtlas, packedGlyphs.size() - first );
+		RenderAtlas renderAtlas;
+		renderAtlas.size = ( mAutoTextureSize && ( count < numGlyphsPerAtlas ) ) ? calcAutoTextureSize( count, tileStride, mMaxTextureSize ) : textureSize;
+		const int numGlyphColumns = renderAtlas.size.x / tileStride.x;
+		for( size_t i = 0; i < count; ++i ) {
+			RenderGlyph renderGlyph;
+			renderGlyph.glyphIndex = packedGlyphs[first + i];
+			renderGlyph.position = ivec2( static_cast<int>( i ) % numGlyphColumns, static_cast<int>( i ) / numGlyphColumns ) * tileStride;
+			renderAtlas.glyphs.push_back( renderGlyph );
+		}
+		renderAtlases.push_back( renderAtlas );
+	}
 
 	// Render the atlases
-	const double sdfRange = static_cast<double>( format.getSdfRange() );
-	const double sdfAngle = static_cast<double>( format.getSdfAngle() );
-	msdfgen::Bitmap<msdfgen::FloatRGB> sdfBitmap( mSdfBitmapSize.x, mSdfBitmapSize.y );
+	const size_t surfacePixelInc = getPixelInc();
 	uint32_t currentTextureIndex = 0;
 	for( size_t atlasIndex = 0; atlasIndex < renderAtlases.size(); ++atlasIndex ) {
-		const auto& renderGlyphs = renderAtlases[atlasIndex];
-		// Render atlas
-		for( const auto& renderGlyph : renderGlyphs ) {
-			msdfgen::Shape shape;
-			if( msdfgen::loadGlyph( shape, face, renderGlyph.glyphIndex ) ) {
-				shape.inverseYAxis = true;
-				shape.normalize();	
-				
-				// Edge color
-				msdfgen::edgeColoringSimple( shape, sdfAngle );
-
-				// Generate SDF
-				vec2 originOffset = mGlyphInfo[renderGlyph.glyphIndex].mOriginOffset;
-				float tx = mSdfPadding.x;
-				float ty = std::fabs( originOffset.y ) + mSdfPadding.y;
-				// mSdfScale will get applied to <tx, ty> by msdfgen
-				msdfgen::generateMSDF( sdfBitmap, shape, sdfRange, msdfgen::Vector2( mSdfScale.x, mSdfScale.y ), msdfgen::Vector2( tx, ty ) );
-
-				// Invert the SDF if needed, but only for glyphs that have contours to render. 
-				// Glyph without contours will produce and blank bitmap, inverting this produces
-				// a solid block. Which is undesirable.
-				if( invertSdf && ( ! shape.contours.empty() ) ) {
-					for( int y = 0; y < sdfBitmap.height(); ++y ) {
-						for( int x = 0; x < sdfBitmap.width(); ++x ) {
-							sdfBitmap( x, y ).r = 1.0f - sdfBitmap( x, y ).r;
-							sdfBitmap( x, y ).g = 1.0f - sdfBitmap( x, y ).g;
-							sdfBitmap( x, y ).b = 1.0f - sdfBitmap( x, y ).b;
-						}
-					}
-				}
-
-				// Copy bitmap
-				size_t dstOffset = ( renderGlyph.position.y * surfaceRowBytes ) + ( renderGlyph.position.x * surfacePixelInc );
-				uint8_t *dst = surfaceData + dstOffset;
-				for( int n = 0; n < mSdfBitmapSize.y; ++n ) {
-					Color8u *dstPixel = reinterpret_cast<Color8u *>( dst );
-					for( int m = 0; m < mSdfBitmapSize.x; ++m ) {
-						msdfgen::FloatRGB &src = sdfBitmap( m, n );
-						Color srcPixel = Color( src.r, src.g, src.b );
-						*dstPixel = srcPixel;
-						++dstPixel;
-					}
-					dst += surfaceRowBytes;
-				}
+		const auto& renderGlyphs = renderAtlases[atlasIndex].glyphs;
+		// Page pixels, tightly packed
+		const ivec2 pageSize = renderAtlases[atlasIndex].size;
+		const size_t surfaceRowBytes = surfacePixelInc * pageSize.x;
+		std::vector<uint8_t> surface( surfaceRowBytes * pageSize.y, 0 );
+		uint8_t *surfaceData = surface.data();
+		// Load outlines, FT_Face is not thread safe
+		std::vector<msdfgen::Shape> shapes( renderGlyphs.size() );
+		std::vector<uint8_t> loaded( renderGlyphs.size(), 0 );
+		std::vector<vec2> originOffsets( renderGlyphs.size() );
+		for( size_t i = 0; i < renderGlyphs.size(); ++i ) {
+			const auto& renderGlyph = renderGlyphs[i];
+			if( msdfgen::loadGlyph( shapes[i], face, renderGlyph.glyphIndex ) ) {
+				loaded[i] = 1;
+				originOffsets[i] = mGlyphInfo[renderGlyph.glyphIndex].mOriginOffset;
 
 				// Tex coords
 				mGlyphInfo[renderGlyph.glyphIndex].mTextureIndex = currentTextureIndex;
 				mGlyphInfo[renderGlyph.glyphIndex].mTexCoords = Area( 0, 0, mSdfBitmapSize.x, mSdfBitmapSize.y ) + renderGlyph.position;
 			}
 		}
-		// Create texture
-		gl::TextureRef tex = gl::Texture::create( surface );
-		mTextures.push_back( tex );
+		// Copy the tiles found in the glyph cache
+		std::vector<uint8_t> cached( renderGlyphs.size(), 0 );
+		if( ! mGlyphCachePath.empty() ) {
+			for( size_t i = 0; i < renderGlyphs.size(); ++i ) {
+				size_t dstOffset = ( renderGlyphs[i].position.y * surfaceRowBytes ) + ( renderGlyphs[i].position.x * surfacePixelInc );
+				if( loaded[i] && readCachedTile( renderGlyphs[i].glyphIndex, mGlyphInfo[renderGlyphs[i].glyphIndex], surfaceData + dstOffset, surfaceRowBytes ) ) {
+					cached[i] = 1;
+					++mStats.mNumCachedGlyphs;
+				}
+			}
+		}
+		// Apply the cost limit, a resolution of 0 defers the glyph
+		std::vector<float> resolutions( renderGlyphs.size(), 1.0f );
+		std::vector<uint8_t> degraded( renderGlyphs.size(), 0 );
+		for( size_t i = 0; i < renderGlyphs.size(); ++i ) {
+			if( loaded[i] && ( ! cached[i] ) ) {
+				degraded[i] = applyGlyphCostGuard( renderGlyphs[i].glyphIndex, shapes[i], &resolutions[i] ) ? 1 : 0;
+			}
+		}
+		// Render atlas, each glyph writes to its own tile
+		SdfText::getExecutor()->parallelFor( renderGlyphs.size(), [&]( size_t i ) {
+			if( ( ! loaded[i] ) || cached[i] || ( resolutions[i] <= 0.0f ) ) {
+				return;
+			}
+			// Generate SDF and copy bitmap
+			size_t dstOffset = ( renderGlyphs[i].position.y * surfaceRowBytes ) + ( renderGlyphs[i].position.x * surfacePixelInc );
+			renderGlyphBitmap( shapes[i], originOffsets[i], surfaceData + dstOffset, surfaceRowBytes, resolutions[i] );
+		} );
+		for( size_t i = 0; i < renderGlyphs.size(); ++i ) {
+			if( ( ! loaded[i] ) || cached[i] ) {
+				continue;
+			}
+			// Degraded tiles are not cached, a later run with a higher limit generates them in full
+			if( resolutions[i] <= 0.0f ) {
+				deferTile( renderGlyphs[i].glyphIndex, mGlyphInfo[renderGlyphs[i].glyphIndex], std::move( shapes[i] ), 1.0f, ! degraded[i] );
+				continue;
+			}
+			++mStats.mNumGeneratedGlyphs;
+			if( ( ! mGlyphCachePath.empty() ) && ( ! degraded[i] ) ) {
+				size_t dstOffset = ( renderGlyphs[i].position.y * surfaceRowBytes ) + ( renderGlyphs[i].position.x * surfacePixelInc );
+				writeCachedTile( renderGlyphs[i].glyphIndex, mGlyphInfo[renderGlyphs[i].glyphIndex], surfaceData + dstOffset, surfaceRowBytes );
+			}
+		}
+		// Add page, its textures are created on first use in each context
+		addPage( surfaceData, pageSize );
 		++currentTextureIndex;
 
 		// Debug output
-		//writeImage( "sdfText_" + std::to_string( atlasIndex ) + ".png", surface );
+		//writeImage( "sdfText_" + std::to_string( atlasIndex ) + ".png", Surface8u( surfaceData, pageSize.x, pageSize.y, surfaceRowBytes, SurfaceChannelOrder::RGB ) );
+	}
+
+	updatePageStats();
+	if( ! corpusGlyphs.empty() ) {
+		mStats.mPagesPerString = calcPagesPerString( corpusGlyphs, [&]( uint32_t g ) -> uint32_t {
+			auto it = mGlyphInfo.find( glyphIndices[g] );
+			return ( mGlyphInfo.end() != it ) ? it->second.mTextureIndex : 0;
+		} );
+		mStats.mPagesPerStringInCharsetOrder = calcPagesPerString( corpusGlyphs, [&]( uint32_t g ) { return static_cast<uint32_t>( g / numGlyphsPerAtlas ); } );
+		CI_LOG_I( "pages per corpus string: " << mStats.mPagesPerString << ", in charset order: " << mStats.mPagesPerStringInCharsetOrder );
+	}
+	if( mAutoTextureSize ) {
+		CI_LOG_I( "atlas pages: " << mStats.mNumPages << ", texture size: " << mStats.mTextureSize.x << "x" << mStats.mTextureSize.y << ", occupancy: " << mStats.mOccupancy );
+	}
 
-		// Reset
-		ip::fill( &surface, Color8u( 0, 0, 0 ) );		
+	if( mCompressed ) {
+		CI_LOG_I( "compressed " << mStats.mNumCompressedTextures << " atlas textures, mean error: " << mStats.mCompressionMeanError << ", max error: " << mStats.mCompressionMaxError );
 	}
+	if( ! mStats.mCostlyGlyphs.empty() ) {
+		CI_LOG_I( "glyphs over the cost limit: " << mStats.mCostlyGlyphs.size() << ", simplified: " << mStats.mNumSimplifiedGlyphs << ", lower resolution: " << mStats.mNumLowResGlyphs << ", deferred: " << mStats.mNumDeferredGlyphs << ", max cost: " << mStats.mMaxGlyphCost );
+	}
+}
+
+SdfText::TextureAtlas::~TextureAtlas()
+{
+	// Deferred tiles still rendering own their data, they are dropped when their tasks finish
+	releaseDeadContextTextures();
 }
 
 SdfText::TextureAtlasRef SdfText::TextureAtlas::create( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices )
@@ -443,2111 +1421,5564 @@ SdfText::TextureAtlasRef SdfText::TextureAtlas::create( FT_Face face, const SdfT
 	return result;
 }
 
-cinder::ivec2 SdfText::TextureAtlas::calculateSdfBitmapSize( const vec2 &sdfScale, const ivec2& sdfPadding, const vec2 &maxGlyphSize )
+SdfText::TextureAtlasRef SdfText::TextureAtlas::createMetrics( FT_Face face, const SdfText::Format &format, const std::vector<SdfText::Font::Glyph> &glyphIndices )
 {
-	ivec2 result = ivec2( ( sdfScale * ( maxGlyphSize + ( 2.0f * vec2( sdfPadding ) ) ) ) + vec2( 0.5f ) );
+	SdfText::TextureAtlasRef result = SdfText::TextureAtlasRef( new SdfText::TextureAtlas( format.getMemoryResource() ) );
+	result->mSdfScale = format.getSdfScale();
+	result->mSdfPadding = format.getSdfPadding();
+	result->mSdfRange = format.getSdfRange();
+	result->mSdfAngle = format.getSdfAngle();
+	result->mTileSpacing = format.getSdfTileSpacing();
+	result->mSingleChannel = format.getSingleChannel() || format.getCompressed();
+	result->mCompressed = format.getCompressed();
+	result->mGlyphCostLimit = format.getGlyphCostLimit();
+	result->mGlyphCostFallback = format.getGlyphCostFallback();
+	// Layout places the tiles, so each glyph gets one at the origin of a page that is never created
+	result->measureGlyphs( face, format, glyphIndices );
+	for( auto& it : result->mGlyphInfo ) {
+		it.second.mTextureIndex = 0;
+		it.second.mTexCoords = Area( 0, 0, result->mSdfBitmapSize.x, result->mSdfBitmapSize.y );
+	}
 	return result;
 }
 
-// =================================================================================================
-// SdfTextManager
-// =================================================================================================
-class SdfTextManager {
-public:
-	~SdfTextManager();
-
-	static SdfTextManager			*instance();
-
-	FT_Library						getLibrary() const { return mLibrary; }
-
-	const std::vector<std::string>&	getNames( bool forceRefresh );
-	SdfText::Font					getDefault() const;
-
-	struct FontInfo {
-		std::string 	key;
-		std::string 	name;
-		fs::path 		path;
-		FontInfo() {}
-		FontInfo( const std::string& aKey, const std::string& aName, const fs::path& aPath ) 
-			: key( aKey ), name( aName ), path( aPath ) {}
-	};
-
-	FontInfo 						getFontInfo( const std::string& fontName ) const;
-
-private:
-	SdfTextManager();
-
-	static SdfTextManager			*sInstance;
-
-	FT_Library						mLibrary = nullptr;
-	bool							mFontsEnumerated = false;
-	std::vector<std::string>		mFontNames;
-	std::vector<FontInfo>			mFontInfos;
-	std::set<FT_Face>				mTrackedFaces;
-	mutable SdfText::Font			mDefault;
-
-	SdfText::TextureAtlas::AtlasCacher		mTrackedTextureAtlases;
-
-	void							acquireFontNamesAndPaths();
-	void							faceCreated( FT_Face face );
-	void							faceDestroyed( FT_Face face );
-
-	SdfText::TextureAtlasRef		getTextureAtlas( FT_Face face, const SdfText::Format &format, const std::string &utf8Chars, const std::vector<SdfText::Font::Glyph> &glyphIndices );
-
-	friend class SdfText;
-	friend class SdfText::FontData;
-	friend bool SdfTextFontManager_destroyStaticInstance();
-};
-
-// =================================================================================================
-// SdfTextBox
-// =================================================================================================
-class SdfTextBox {
-public:
-	enum { GROW = 0 };
-	
-	SdfTextBox( const SdfText *sdfText ) : mSdfText( sdfText ), mAlign( SdfText::LEFT ), mSize( GROW, GROW ), mInvalid( true ), mLigate( true ) {}
-
-	SdfTextBox&				size( ivec2 sz ) { setSize( sz ); return *this; }
-	SdfTextBox&				size( int width, int height ) { setSize( ivec2( width, height ) ); return *this; }
-	ivec2					getSize() const { return mSize; }
-	void					setSize( ivec2 sz ) { mSize = sz; mInvalid = true; }
-
-	SdfTextBox&				text( const std::string &t ) { setText( t ); return *this; }
-	const std::string&		getText() const { return mText; }
-	void					setText( const std::string &t ) { mText = t; mInvalid = true; }
-	void					appendText( const std::string &t ) { mText += t; mInvalid = true; }
-
-	SdfTextBox&				ligate( bool ligateText = true ) { setLigate( ligateText ); return *this; }
-	bool					getLigate() const { return mLigate; }
-	void					setLigate( bool ligateText ) { mLigate = ligateText; }
-
-	SdfTextBox&				alignment( SdfText::Alignment align ) { setAlignment( align ); return *this; }
-	SdfText::Alignment		getAlignment() const { return mAlign; }
-	void					setAlignment( SdfText::Alignment align ) { mAlign = align; mInvalid = true; }
-
-	std::vector<std::string>			calculateLineBreaks() const;
-	SdfText::Font::GlyphMeasuresList	measureGlyphs( const SdfText::DrawOptions& drawOptions ) const;
-
-private:
-	const SdfText		*mSdfText = nullptr;
-	SdfText::Alignment	mAlign;
-	ivec2				mSize;
-	std::string			mText;
-	bool				mLigate;
-	mutable bool		mInvalid;
-};
+SdfText::TextureAtlasRef SdfText::TextureAtlas::createScaled( float scale, const ivec2 &pageSize, const fs::path &cacheDir ) const
+{
+	SdfText::TextureAtlasRef result = SdfText::TextureAtlasRef( new SdfText::TextureAtlas( mGlyphInfo.get_allocator().getResource() ) );
+	result->mFace = mFace;
+	result->mSdfScale = mSdfScale * scale;
+	result->mSdfPadding = mSdfPadding;
+	result->mMaxGlyphSize = mMaxGlyphSize;
+	result->mMaxAscent = mMaxAscent;
+	result->mMaxDescent = mMaxDescent;
+	result->mSdfRange = mSdfRange;
+	result->mSdfAngle = mSdfAngle;
+	result->mTileSpacing = mTileSpacing;
+	result->mInvertSdf = mInvertSdf;
+	result->mSingleChannel = mSingleChannel;
+	result->mCompressed = mCompressed;
+	result->mMaxTextureSize = mMaxTextureSize;
+	result->mGlyphCostLimit = mGlyphCostLimit;
+	result->mGlyphCostFallback = mGlyphCostFallback;
+	result->mSdfBitmapSize = calculateSdfBitmapSize( result->mSdfScale, result->mSdfPadding, result->mMaxGlyphSize );
+
+	// Pages hold at least one tile
+	const ivec2 tileStride = result->mSdfBitmapSize + result->mTileSpacing;
+	result->mAppendPageSize = pageSize;
+	while( ( result->mAppendPageSize.x < tileStride.x ) && ( result->mAppendPageSize.x < mMaxTextureSize ) ) {
+		result->mAppendPageSize.x *= 2;
+	}
+	while( ( result->mAppendPageSize.y < tileStride.y ) && ( result->mAppendPageSize.y < mMaxTextureSize ) ) {
+		result->mAppendPageSize.y *= 2;
+	}
 
-// =================================================================================================
-// SdfTexttManager Implementation
-// =================================================================================================
-SdfTextManager* SdfTextManager::sInstance = nullptr;
+	if( ! cacheDir.empty() ) {
+		result->initGlyphCache( mFace, cacheDir );
+	}
+	return result;
+}
 
-bool SdfTextFontManager_destroyStaticInstance() 
+cinder::ivec2 SdfText::TextureAtlas::calculateSdfBitmapSize( const vec2 &sdfScale, const ivec2& sdfPadding, const vec2 &maxGlyphSize )
 {
-	if( nullptr != SdfTextManager::sInstance ) {
-		delete SdfTextManager::sInstance;
-		SdfTextManager::sInstance = nullptr;
-	}
-	return true;
+	ivec2 result = ivec2( ( sdfScale * ( maxGlyphSize + ( 2.0f * vec2( sdfPadding ) ) ) ) + vec2( 0.5f ) );
+	return result;
 }
 
-SdfTextManager::SdfTextManager()
+cinder::ivec2 SdfText::TextureAtlas::calcAutoTextureSize( size_t numGlyphs, const ivec2 &tileStride, int32_t maxTextureSize )
 {
-	FT_Error ftRes = FT_Init_FreeType( &mLibrary );
-	if( FT_Err_Ok != ftRes ) {
-		throw FontInvalidNameExc("Failed to initialize FreeType2");
+	// Smallest power of two that holds one tile
+	ivec2 minSize = ivec2( 1 );
+	while( ( minSize.x < tileStride.x ) && ( minSize.x < maxTextureSize ) ) {
+		minSize.x *= 2;
+	}
+	while( ( minSize.y < tileStride.y ) && ( minSize.y < maxTextureSize ) ) {
+		minSize.y *= 2;
 	}
 
-	acquireFontNamesAndPaths();
-#if defined( CINDER_MSW )
-	// Registry operations can be rejected by Windows so no fonts will be picked up 
-	// on the initial scan. So we can multiple times.
-	if( mFontInfos.empty() ) {
-		for( int i = 0; i < 5; ++i ) {
-			acquireFontNamesAndPaths();
-			if( ! mFontInfos.empty() ) {
-				break;
+	ivec2 result = minSize;
+	size_t bestNumPages = std::numeric_limits<size_t>::max();
+	uint64_t bestArea = std::numeric_limits<uint64_t>::max();
+	for( int32_t width = minSize.x; width <= maxTextureSize; width *= 2 ) {
+		for( int32_t height = minSize.y; height <= maxTextureSize; height *= 2 ) {
+			const size_t numGlyphsPerPage = static_cast<size_t>( ( width / tileStride.x ) * ( height / tileStride.y ) );
+			if( 0 == numGlyphsPerPage ) {
+				continue;
+			}
+			const size_t numPages = std::max<size_t>( 1, ( numGlyphs + numGlyphsPerPage - 1 ) / numGlyphsPerPage );
+			const uint64_t area = static_cast<uint64_t>( numPages ) * width * height;
+			// Fewest pages first, then least area, then the squarest size
+			const bool better = ( numPages < bestNumPages ) || 
+								( ( numPages == bestNumPages ) && ( area < bestArea ) ) ||
+								( ( numPages == bestNumPages ) && ( area == bestArea ) && ( std::abs( width - height ) < std::abs( result.x - result.y ) ) );
+			if( better ) {
+				result = ivec2( width, height );
+				bestNumPages = numPages;
+				bestArea = area;
 			}
-			::Sleep( 10 );
 		}
 	}
-#endif
+	return result;
 }
 
-SdfTextManager::~SdfTextManager()
+void SdfText::TextureAtlas::updatePageStats()
 {
-	if( nullptr != mLibrary ) {
-		for( auto& face : mTrackedFaces ) {
-			FT_Done_Face( face );
+	uint64_t pageArea = 0;
+	for( const auto& page : mPages ) {
+		pageArea += static_cast<uint64_t>( page.mSize.x ) * page.mSize.y;
+	}
+	uint32_t numGlyphs = 0;
+	for( const auto& it : mGlyphInfo ) {
+		if( it.second.mTexCoords.getWidth() > 0 ) {
+			++numGlyphs;
 		}
+	}
+	const ivec2 tileStride = mSdfBitmapSize + mTileSpacing;
+	mStats.mNumPages = static_cast<uint32_t>( mPages.size() );
+	mStats.mTextureSize = mPages.empty() ? ivec2( 0 ) : mPages.front().mSize;
+	mStats.mTileSize = tileStride;
+	mStats.mNumGlyphs = numGlyphs;
+	mStats.mOccupancy = ( pageArea > 0 ) ? static_cast<float>( static_cast<double>( numGlyphs ) * tileStride.x * tileStride.y / static_cast<double>( pageArea ) ) : 0.0f;
+}
 
-		FT_Done_FreeType( mLibrary );
+std::vector<SdfText::Font::Glyph> SdfText::TextureAtlas::getSizingGlyphs( FT_Face face, const SdfText::Format &format )
+{
+	std::vector<SdfText::Font::Glyph> result;
+	if( format.getEmbedOutlines() ) {
+		std::u32string utf32Chars = ci::toUtf32( format.getEmbedChars() );
+		for( const auto& ch : utf32Chars ) {
+			result.push_back( static_cast<SdfText::Font::Glyph>( FT_Get_Char_Index( face, static_cast<FT_ULong>( ch ) ) ) );
+		}
 	}
+	return result;
+}
 
-#if defined( CINDER_MAC )
-#elif defined( CINDER_WINRT )
-#elif defined( CINDER_ANDROID ) || defined( CINDER_LINUX )
-#endif
+//! Returns the number of edges in the contours of \a shape
+static size_t countShapeEdges( const msdfgen::Shape &shape )
+{
+	size_t result = 0;
+	for( const auto& contour : shape.contours ) {
+		result += contour.edges.size();
+	}
+	return result;
 }
 
-SdfTextManager* SdfTextManager::instance()
+//! Replaces runs of consecutive edges of \a shape with lines between their end points so that it has about \a maxEdges edges. Contours keep at least three edges.
+static void simplifyShape( msdfgen::Shape &shape, size_t maxEdges )
 {
-	if( nullptr == SdfTextManager::sInstance ) {
-		SdfTextManager::sInstance =  new SdfTextManager();
-		if( nullptr != SdfTextManager::sInstance ) {
-			ci::app::App::get()->getSignalShouldQuit().connect( SdfTextFontManager_destroyStaticInstance );
+	const size_t numEdges = countShapeEdges( shape );
+	const size_t step = ( numEdges + std::max<size_t>( maxEdges, 1 ) - 1 ) / std::max<size_t>( maxEdges, 1 );
+	if( step <= 1 ) {
+		return;
+	}
+
+	for( auto& contour : shape.contours ) {
+		const size_t count = contour.edges.size();
+		const size_t contourStep = std::min( step, std::max<size_t>( count / 3, 1 ) );
+		if( contourStep <= 1 ) {
+			continue;
+		}
+		// Contours stay closed since each line ends where the next run starts
+		std::vector<msdfgen::EdgeHolder> edges;
+		for( size_t first = 0; first < count; first += contourStep ) {
+			const size_t last = std::min( first + contourStep, count ) - 1;
+			edges.push_back( msdfgen::EdgeHolder( contour.edges[first]->point( 0.0 ), contour.edges[last]->point( 1.0 ) ) );
 		}
+		contour.edges.swap( edges );
 	}
-	
-	return SdfTextManager::sInstance;
 }
 
-#if defined( CINDER_MAC )
-void SdfTextManager::acquireFontNamesAndPaths()
+//! Returns the linear interpolation between the texels \a a and \a b
+static float lerpTexel( float a, float b, float t )
 {
-	NSFontManager *nsFontManager = [NSFontManager sharedFontManager];
-    NSArray *nsFontNames = [nsFontManager availableFonts];
-    for( NSString *nsFontName in nsFontNames ) {
-        std::string fontName = std::string( [nsFontName UTF8String] );
-        mFontNames.push_back( fontName );
-        
-        CTFontDescriptorRef ctFont = CTFontDescriptorCreateWithNameAndSize( (__bridge CFStringRef)nsFontName, (CGFloat)24 );
-        CFURLRef url = (CFURLRef)CTFontDescriptorCopyAttribute( ctFont, kCTFontURLAttribute );
-        NSString *nsFontPath = [NSString stringWithString:[(NSURL *)CFBridgingRelease(url) path]];
-        std::string fontFilePath = std::string( [nsFontPath UTF8String] );
-        
-        if( fs::exists( fontFilePath ) ) {
-			std::string fontKey = boost::to_lower_copy( fontName );
-			auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
-				[fontKey]( const FontInfo& elem ) -> bool {
-					return elem.key == fontKey;
-				}
-			);
-			if( std::end( mFontInfos ) == it ) {
-                // Build font info
-                FontInfo fontInfo = FontInfo( fontKey, fontName, fontFilePath );
-                mFontInfos.push_back( fontInfo );
-                mFontNames.push_back( fontName );
-            }
-        }
-    }
+	return a + ( b - a ) * t;
 }
-#elif defined( CINDER_COCOA_TOUCH )
-void SdfTextManager::acquireFontNamesAndPaths()
+
+//! Returns the linear interpolation between the texels \a a and \a b
+static msdfgen::FloatRGB lerpTexel( const msdfgen::FloatRGB &a, const msdfgen::FloatRGB &b, float t )
 {
-    NSArray *nsFamilyNames = [UIFont familyNames];
-    for( NSString *nsFamilyName in nsFamilyNames ) {
-        NSArray *nsFontNames = [UIFont fontNamesForFamilyName:nsFamilyName];
-        for( NSString *nsFontName in nsFontNames ) {
-            std::string fontName = std::string( [nsFontName UTF8String] );
-            mFontNames.push_back( fontName );
-            
-            CTFontDescriptorRef ctFont = CTFontDescriptorCreateWithNameAndSize( (__bridge CFStringRef)nsFontName, (CGFloat)24 );
-            CFURLRef url = (CFURLRef)CTFontDescriptorCopyAttribute( ctFont, kCTFontURLAttribute );
-            NSString *nsFontPath = [NSString stringWithString:[(NSURL *)CFBridgingRelease(url) path]];
-            std::string fontFilePath = std::string( [nsFontPath UTF8String] );
-            
-            if( fs::exists( fontFilePath ) ) {
-                std::string fontKey = boost::to_lower_copy( fontName );
-                auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
-                    [fontKey]( const FontInfo& elem ) -> bool {
-                        return elem.key == fontKey;
-                    }
-                );
-                if( std::end( mFontInfos ) == it ) {
-                    // Build font info
-                    FontInfo fontInfo = FontInfo( fontKey, fontName, fontFilePath );
-                    mFontInfos.push_back( fontInfo );
-                    mFontNames.push_back( fontName );
-                }
-            }
-        }
-    }
+	return msdfgen::FloatRGB( lerpTexel( a.r, b.r, t ), lerpTexel( a.g, b.g, t ), lerpTexel( a.b, b.b, t ) );
 }
-#elif defined( CINDER_MSW )
-void SdfTextManager::acquireFontNamesAndPaths()
+
+//! Returns \a src scaled up to \a size with bilinear filtering, both bitmaps cover the same area
+template <typename T>
+static msdfgen::Bitmap<T> upsampleBitmap( const msdfgen::Bitmap<T> &src, const ivec2 &size )
 {
-	static const LPWSTR kFontRegistryPath = L"Software\\Microsoft\\Windows NT\\CurrentVersion\\Fonts";
+	msdfgen::Bitmap<T> result( size.x, size.y );
+	const vec2 ratio = vec2( src.width(), src.height() ) / vec2( size );
+	for( int n = 0; n < size.y; ++n ) {
+		const float y = std::min( std::max( ( n + 0.5f ) * ratio.y - 0.5f, 0.0f ), static_cast<float>( src.height() - 1 ) );
+		const int y0 = static_cast<int>( y );
+		const int y1 = std::min( y0 + 1, src.height() - 1 );
+		for( int m = 0; m < size.x; ++m ) {
+			const float x = std::min( std::max( ( m + 0.5f ) * ratio.x - 0.5f, 0.0f ), static_cast<float>( src.width() - 1 ) );
+			const int x0 = static_cast<int>( x );
+			const int x1 = std::min( x0 + 1, src.width() - 1 );
+			const float fx = x - x0;
+			result( m, n ) = lerpTexel( lerpTexel( src( x0, y0 ), src( x1, y0 ), fx ), lerpTexel( src( x0, y1 ), src( x1, y1 ), fx ), y - y0 );
+		}
+	}
+	return result;
+}
 
-	// Open Windows font registry key
-	HKEY hKey = nullptr;
-	LONG result = RegOpenKeyEx( HKEY_LOCAL_MACHINE, kFontRegistryPath, 0, KEY_READ, &hKey );
-	if( ERROR_SUCCESS != result ) {
-		return;
+SdfText::TextureAtlas::RenderParams SdfText::TextureAtlas::getRenderParams() const
+{
+	RenderParams result = { mSdfScale, mSdfPadding, mSdfBitmapSize, mSdfRange, mSdfAngle, mInvertSdf, mSingleChannel };
+	return result;
+}
+
+void SdfText::TextureAtlas::renderGlyphBitmap( const RenderParams &params, msdfgen::Shape &shape, const vec2 &originOffset, uint8_t *dst, size_t rowBytes, float resolution )
+{
+	shape.inverseYAxis = true;
+	shape.normalize();	
+				
+	// Edge color
+	msdfgen::edgeColoringSimple( shape, static_cast<double>( params.mSdfAngle ) );
+
+	// Generate SDF
+	float tx = params.mSdfPadding.x;
+	float ty = std::fabs( originOffset.y ) + params.mSdfPadding.y;
+	// Invert the SDF if needed, but only for glyphs that have contours to render. 
+	// Glyph without contours will produce and blank bitmap, inverting this produces
+	// a solid block. Which is undesirable.
+	const bool invert = params.mInvertSdf && ( ! shape.contours.empty() );
+	// A lower resolution renders the same area on a coarser grid, the range is in shape units and stays the same
+	ivec2 renderSize = params.mSdfBitmapSize;
+	if( resolution < 1.0f ) {
+		renderSize.x = std::max( 1, static_cast<int>( std::ceil( params.mSdfBitmapSize.x * resolution ) ) );
+		renderSize.y = std::max( 1, static_cast<int>( std::ceil( params.mSdfBitmapSize.y * resolution ) ) );
 	}
-	
-	// Get info for registry key
-	DWORD maxValueNameSize, maxValueDataSize;
-	result = RegQueryInfoKey( hKey, 0, 0, 0, 0, 0, 0, 0, &maxValueNameSize, &maxValueDataSize, 0, 0 );
-	if( ERROR_SUCCESS != result ) {
+	const vec2 renderScale = params.mSdfScale * vec2( renderSize ) / vec2( params.mSdfBitmapSize );
+
+	// Single channel - a plain SDF
+	if( params.mSingleChannel ) {
+		msdfgen::Bitmap<float> sdfBitmap( renderSize.x, renderSize.y );
+		msdfgen::generateSDF( sdfBitmap, shape, static_cast<double>( params.mSdfRange ), msdfgen::Vector2( renderScale.x, renderScale.y ), msdfgen::Vector2( tx, ty ) );
+		if( renderSize != params.mSdfBitmapSize ) {
+			sdfBitmap = upsampleBitmap( sdfBitmap, params.mSdfBitmapSize );
+		}
+		for( int n = 0; n < params.mSdfBitmapSize.y; ++n ) {
+			uint8_t *dstRow = dst + ( n * rowBytes );
+			for( int m = 0; m < params.mSdfBitmapSize.x; ++m ) {
+				float value = invert ? ( 1.0f - sdfBitmap( m, n ) ) : sdfBitmap( m, n );
+				dstRow[m] = static_cast<uint8_t>( std::max( 0.0f, std::min( 1.0f, value ) ) * 255.0f );
+			}
+		}
 		return;
 	}
 
-	DWORD valueIndex = 0;
-	LPWSTR valueName = new WCHAR[maxValueNameSize];
-	LPBYTE valueData = new BYTE[maxValueDataSize];
-	DWORD valueNameSize, valueDataSize, valueType;
+	// mSdfScale will get applied to <tx, ty> by msdfgen
+	msdfgen::Bitmap<msdfgen::FloatRGB> sdfBitmap( renderSize.x, renderSize.y );
+	msdfgen::generateMSDF( sdfBitmap, shape, static_cast<double>( params.mSdfRange ), msdfgen::Vector2( renderScale.x, renderScale.y ), msdfgen::Vector2( tx, ty ) );
+	if( renderSize != params.mSdfBitmapSize ) {
+		sdfBitmap = upsampleBitmap( sdfBitmap, params.mSdfBitmapSize );
+	}
 
-	// Enumerate registry keys
-	do {
-		valueNameSize = maxValueNameSize;
-		valueDataSize = maxValueDataSize;
+	if( invert ) {
+		for( int y = 0; y < sdfBitmap.height(); ++y ) {
+			for( int x = 0; x < sdfBitmap.width(); ++x ) {
+				sdfBitmap( x, y ).r = 1.0f - sdfBitmap( x, y ).r;
+				sdfBitmap( x, y ).g = 1.0f - sdfBitmap( x, y ).g;
+				sdfBitmap( x, y ).b = 1.0f - sdfBitmap( x, y ).b;
+			}
+		}
+	}
 
-		// Clear the buffers
-		std::memset( valueName, 0, maxValueNameSize*sizeof( WCHAR ) );
-		std::memset( valueData, 0, maxValueDataSize*sizeof( BYTE ) );
+	// Copy bitmap
+	for( int n = 0; n < params.mSdfBitmapSize.y; ++n ) {
+		uint8_t *dstRow = dst + ( n * rowBytes );
+		for( int m = 0; m < params.mSdfBitmapSize.x; ++m ) {
+			msdfgen::FloatRGB &src = sdfBitmap( m, n );
+			Color srcPixel = Color( src.r, src.g, src.b );
+			*reinterpret_cast<Color8u *>( dstRow + ( m * 3 ) ) = srcPixel;
+		}
+	}
+}
 
-		// Read registry key values
-		result = RegEnumValue( hKey, valueIndex, valueName, &valueNameSize, 0, &valueType, valueData, &valueDataSize );
-		++valueIndex;
+bool SdfText::TextureAtlas::applyGlyphCostGuard( SdfText::Font::Glyph glyphIndex, msdfgen::Shape &shape, float *resolution )
+{
+	*resolution = 1.0f;
+	// Generation visits every edge for every texel of the tile
+	const uint64_t tileArea = static_cast<uint64_t>( mSdfBitmapSize.x ) * static_cast<uint64_t>( mSdfBitmapSize.y );
+	const uint64_t cost = static_cast<uint64_t>( countShapeEdges( shape ) ) * tileArea;
+	mStats.mMaxGlyphCost = std::max( mStats.mMaxGlyphCost, cost );
+	if( ( 0 == mGlyphCostLimit ) || ( cost <= mGlyphCostLimit ) ) {
+		return false;
+	}
 
-		// Bail if read fails
-		if( ( ERROR_SUCCESS != result ) || ( REG_SZ != valueType ) ) {
-			continue;
-		}
+	mStats.mCostlyGlyphs.push_back( glyphIndex );
+	bool simplified = false;
+	// Each fallback hands what is still over the limit to the next one, simplifying keeps at least a line per
+	// contour and the resolution doesn't go below a quarter, only deferring always gets the glyph off this thread
+	uint64_t remainingCost = cost;
+	SdfText::GlyphCostFallback fallback = mGlyphCostFallback;
+	if( SdfText::GlyphCostFallback::SIMPLIFY == fallback ) {
+		simplifyShape( shape, static_cast<size_t>( mGlyphCostLimit / std::max<uint64_t>( tileArea, 1 ) ) );
+		remainingCost = static_cast<uint64_t>( countShapeEdges( shape ) ) * tileArea;
+		simplified = true;
+		++mStats.mNumSimplifiedGlyphs;
+		CI_LOG_W( "glyph " << glyphIndex << " is over the cost limit, " << cost << ", simplified from " << ( cost / tileArea ) << " to " << countShapeEdges( shape ) << " edges" );
+		fallback = SdfText::GlyphCostFallback::LOWER_RESOLUTION;
+	}
+	if( ( SdfText::GlyphCostFallback::LOWER_RESOLUTION == fallback ) && ( remainingCost > mGlyphCostLimit ) ) {
+		// The cost goes with the texel count, below a quarter of the resolution the glyph is unreadable
+		const float fit = static_cast<float>( std::sqrt( static_cast<double>( mGlyphCostLimit ) / static_cast<double>( remainingCost ) ) );
+		*resolution = std::max( 0.25f, fit );
+		remainingCost = static_cast<uint64_t>( static_cast<double>( remainingCost ) * ( *resolution ) * ( *resolution ) );
+		++mStats.mNumLowResGlyphs;
+		CI_LOG_W( "glyph " << glyphIndex << " is over the cost limit, " << cost << ", rendered at " << *resolution << " times the tile resolution" );
+		fallback = SdfText::GlyphCostFallback::DEFER;
+	}
+	if( ( SdfText::GlyphCostFallback::DEFER == fallback ) && ( remainingCost > mGlyphCostLimit ) ) {
+		// Deferred tiles render at full resolution in the background
+		*resolution = 0.0f;
+		remainingCost = 0;
+		++mStats.mNumDeferredGlyphs;
+		CI_LOG_W( "glyph " << glyphIndex << " is over the cost limit, " << cost << ", deferred" );
+	}
+	mStats.mMaxFallbackGlyphCost = std::max( mStats.mMaxFallbackGlyphCost, remainingCost );
+	// A deferred tile renders at full resolution, it is only degraded if it was simplified first
+	return simplified || ( ( *resolution > 0.0f ) && ( *resolution < 1.0f ) );
+}
 
-		// Build font info
-		const std::string kTrueTypeTag = "(TrueType)";
-		// Font name
-		std::wstring wsFontName = std::wstring( valueName, valueNameSize );
-		std::string fontName = ci::toUtf8( reinterpret_cast<const char16_t *>( wsFontName.c_str() ), wsFontName.length() * sizeof( char16_t ) );
-		// Font file path
-		//std::wstring wsFontFilePath = std::wstring( reinterpret_cast<LPWSTR>( valueData ), valueDataSize );
-		std::wstring wsFontFilePath;
-		for( size_t i = 0; i < valueDataSize; ++i ) {
-			WCHAR ch = reinterpret_cast<LPWSTR>( valueData )[i];
-			if( 0 == ch ) {
-				break;
+void SdfText::TextureAtlas::deferTile( SdfText::Font::Glyph glyphIndex, const SdfText::Font::GlyphInfo &glyphInfo, msdfgen::Shape &&shape, float resolution, bool cacheTile )
+{
+	std::shared_ptr<DeferredTile> tile = std::make_shared<DeferredTile>();
+	tile->mGlyphIndex = glyphIndex;
+	tile->mPageIndex = glyphInfo.mTextureIndex;
+	tile->mPosition = ivec2( glyphInfo.mTexCoords.x1, glyphInfo.mTexCoords.y1 );
+	tile->mShape = std::move( shape );
+	tile->mData.resize( getPixelInc() * mSdfBitmapSize.x * mSdfBitmapSize.y, 0 );
+	mDeferredTiles.push_back( tile );
+	mPendingGlyphs.insert( glyphIndex );
+	++mStats.mNumPendingGlyphs;
+
+	// The task only holds copies and the tile, the atlas may be destroyed or replaced before it runs
+	const RenderParams params = getRenderParams();
+	const SdfText::Font::GlyphInfo info = glyphInfo;
+	const fs::path cachePath = cacheTile ? mGlyphCachePath : fs::path();
+	const size_t pixelInc = getPixelInc();
+	const size_t rowBytes = pixelInc * mSdfBitmapSize.x;
+	SdfText::getExecutor()->submit( [params, tile, info, cachePath, pixelInc, rowBytes, resolution]() {
+		try {
+			renderGlyphBitmap( params, tile->mShape, info.mOriginOffset, tile->mData.data(), rowBytes, resolution );
+			if( ! cachePath.empty() ) {
+				writeCachedTile( cachePath, params, pixelInc, tile->mGlyphIndex, info, tile->mData.data(), rowBytes );
 			}
-			wsFontFilePath.push_back( ch );		
 		}
-		std::string fontFilePath = ci::toUtf8( reinterpret_cast<const char16_t *>( wsFontFilePath.c_str() ), wsFontFilePath.length() * sizeof( char16_t ) );
-		// Process True Type font
-		if( std::string::npos != fontName.find( kTrueTypeTag ) ) {
-			boost::replace_all( fontName, kTrueTypeTag, "" );
-			boost::trim( fontName );
-			std::string fontKey = boost::to_lower_copy( fontName );
-			auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
-				[fontKey]( const FontInfo& elem ) -> bool {
-					return elem.key == fontKey;
-				}
-			);
-			if( std::end( mFontInfos ) == it ) {
-				fontFilePath = "C:\\Windows\\Fonts\\" + fontFilePath;
-				if( fs::exists( fontFilePath ) ) {
-					// Build font info
-					FontInfo fontInfo = FontInfo( fontKey, fontName, fontFilePath );
-					mFontInfos.push_back( fontInfo );
-					mFontNames.push_back( fontName );
-				}
-			}
+		catch( const std::exception& e ) {
+			CI_LOG_E( "failed rendering deferred glyph " << tile->mGlyphIndex << ": " << e.what() );
 		}
-	} 
-	while( ERROR_NO_MORE_ITEMS != result  );
+		tile->setDone();
+	} );
+}
 
-	delete [] valueName;
-	delete [] valueData;
+void SdfText::TextureAtlas::DeferredTile::setDone()
+{
+	std::lock_guard<std::mutex> lock( mDoneMutex );
+	mDone = true;
+	mDoneCondition.notify_all();
 }
-#elif defined( CINDER_WINRT ) 
-void SdfTextManager::acquireFontNamesAndPaths()
+
+void SdfText::TextureAtlas::DeferredTile::waitDone()
 {
+	std::unique_lock<std::mutex> lock( mDoneMutex );
+	mDoneCondition.wait( lock, [this]() -> bool { return mDone; } );
 }
-#elif defined( CINDER_ANDROID )
-void SdfTextManager::acquireFontNamesAndPaths()
+
+void SdfText::TextureAtlas::writeDeferredTiles()
 {
-	fs::path systemFontDir = "/system/fonts";
-	if( fs::exists( systemFontDir ) && fs::is_directory( systemFontDir ) ) {
-		fs::directory_iterator end_iter;
-		for( fs::directory_iterator dir_iter( systemFontDir ) ; dir_iter != end_iter ; ++dir_iter ) {
-			if( fs::is_regular_file( dir_iter->status() ) ) {
-				fs::path fontPath = dir_iter->path();
+	for( auto it = mDeferredTiles.begin(); it != mDeferredTiles.end(); ) {
+		const DeferredTile &tile = **it;
+		if( ! tile.mDone ) {
+			++it;
+			continue;
+		}
 
-				FT_Face tmpFace;
-				FT_Error error = FT_New_Face( mLibrary, fontPath.string().c_str(), 0, &tmpFace );
-				if( error ) {
-					continue;
-				}
+		writeTile( tile.mPageIndex, tile.mPosition, tile.mData.data() );
+		mPendingGlyphs.erase( tile.mGlyphIndex );
+		++mStats.mNumGeneratedGlyphs;
+		--mStats.mNumPendingGlyphs;
+		it = mDeferredTiles.erase( it );
+	}
+}
 
-				std::string fontName = ci::linux::ftutil::GetFontName( tmpFace, fontPath.stem().string() );
-				std::string keyName = fontName;
-				std::transform( keyName.begin(), keyName.end(), keyName.begin(), [](char c) -> char { return (c >= 'A' && c <='Z') ? (c + 32) : c; } );
-				mFontInfos.push_back( FontInfo( keyName, fontName, fontPath ) );
+void SdfText::TextureAtlas::finishDeferredTiles()
+{
+	for( const auto& tile : mDeferredTiles ) {
+		tile->waitDone();
+	}
+	writeDeferredTiles();
+}
 
-				const std::string regular = "regular";
-				size_t startPos = keyName.find( regular );
-				if( std::string::npos != startPos ) {
-					keyName.replace( startPos, regular.length(), "" );
-					mFontInfos.push_back( FontInfo( keyName, fontName, fontPath ) );
-				} 	
+//! Returns the 64-bit FNV-1a hash of \a size bytes at \a data continuing from \a hash
+static uint64_t hashBytes( const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL )
+{
+	const uint8_t *bytes = static_cast<const uint8_t *>( data );
+	for( size_t i = 0; i < size; ++i ) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
 
-				FT_Done_Face( tmpFace );
-			}
-		}
+void SdfText::TextureAtlas::initGlyphCache( FT_Face face, const fs::path &cacheDir )
+{
+	// Faces are created from memory, without the font data there is nothing to key the tiles by
+	if( ( nullptr == face ) || ( nullptr == face->stream ) || ( nullptr == face->stream->base ) ) {
+		CI_LOG_W( "glyph cache needs a font loaded from memory, caching disabled" );
+		return;
 	}
+
+	const uint64_t fontHash = hashBytes( face->stream->base, static_cast<size_t>( face->stream->size ) );
+	// Everything that changes the tile pixels except the tile size, which follows the largest glyph of the charset. Tiles are stored normalized, see calcCachedTileSize().
+	const uint8_t singleChannel = mSingleChannel ? 1 : 0;
+	const uint8_t invert = mInvertSdf ? 1 : 0;
+	uint64_t paramsHash = hashBytes( &mSdfScale, sizeof( mSdfScale ) );
+	paramsHash = hashBytes( &mSdfPadding, sizeof( mSdfPadding ), paramsHash );
+	paramsHash = hashBytes( &mSdfRange, sizeof( mSdfRange ), paramsHash );
+	paramsHash = hashBytes( &mSdfAngle, sizeof( mSdfAngle ), paramsHash );
+	paramsHash = hashBytes( &singleChannel, sizeof( singleChannel ), paramsHash );
+	paramsHash = hashBytes( &invert, sizeof( invert ), paramsHash );
+
+	std::stringstream ss;
+	ss << std::hex << std::setfill( '0' ) << std::setw( 16 ) << fontHash << "-" << std::setw( 16 ) << paramsHash;
+	mGlyphCachePath = cacheDir / ss.str();
 }
-#elif defined( CINDER_LINUX )
-void SdfTextManager::acquireFontNamesAndPaths()
+
+ivec2 SdfText::TextureAtlas::calcCachedTileSize( const RenderParams &params, const SdfText::Font::GlyphInfo &glyphInfo )
 {
-	if( ::FcInit() ) {
-		::FcPattern   *pat = ::FcPatternCreate();
-		::FcObjectSet *os  = ::FcObjectSetBuild( FC_FILE, FC_FAMILY, FC_STYLE, (char *)0 );
-		::FcFontSet   *fs  = ::FcFontList (0, pat, os);
-	
-		for( size_t i = 0; i < fs->nfont; ++i ) {
-			//::FcPattern *font = fs->fonts[i];
-			//::FcChar8 *family = nullptr;
-			//if( ::FcPatternGetString( font, FC_FAMILY, 0, &family ) == FcResultMatch ) {					
-			//	std::cout << "Found font family: " << family << std::endl;
-			//	//string fontName = std::string( (const char*)family );
-			//	//mFontNames.push_back( fontName );
-			//}
+	// Tiles are rendered from the lower left corner, offset by the padding, see renderGlyphBitmap()
+	const vec2 extent = vec2( std::max( 0.0f, glyphInfo.mOriginOffset.x + glyphInfo.mSize.x ), glyphInfo.mOriginOffset.y + glyphInfo.mSize.y + std::fabs( glyphInfo.mOriginOffset.y ) );
+	// Past the padding and half the range the distance is clamped, one more texel covers filtering
+	const vec2 falloff = vec2( std::max( static_cast<float>( params.mSdfPadding.x ), 0.5f * params.mSdfRange ), std::max( static_cast<float>( params.mSdfPadding.y ), 0.5f * params.mSdfRange ) );
+	const vec2 size = params.mSdfScale * ( extent + vec2( params.mSdfPadding ) + falloff ) + vec2( 1.0f );
+	return ivec2( std::min( static_cast<int>( std::ceil( size.x ) ), params.mSdfBitmapSize.x ), std::min( static_cast<int>( std::ceil( size.y ) ), params.mSdfBitmapSize.y ) );
+}
 
-			::FcPattern *fcFont = fs->fonts[i];
-			::FcChar8 *fcFileName = nullptr;
-			if( ::FcResultMatch == ::FcPatternGetString( fcFont, FC_FILE, 0, &fcFileName ) ) {
-				std::string fontFilePath = std::string( (const char*)fcFileName );
-				
-				// Skip anything that isn't ttf or otf
-				std::string lcfn = boost::to_lower_copy( fontFilePath );
-				boost::trim( lcfn );
-				if( ! ( boost::ends_with( lcfn, ".ttf" ) || boost::ends_with( lcfn, ".otf" ) ) ) {
-					continue;
-				}
+bool SdfText::TextureAtlas::readCachedTile( SdfText::Font::Glyph glyphIndex, const SdfText::Font::GlyphInfo &glyphInfo, uint8_t *dst, size_t rowBytes ) const
+{
+	const fs::path filePath = mGlyphCachePath / ( std::to_string( glyphIndex ) + ".sdfg" );
+	if( ! fs::exists( filePath ) ) {
+		return false;
+	}
 
-				::FcChar8 *fcFamily = nullptr;
-				::FcChar8 *fcStyle = nullptr;
-				::FcResult fcFamilyRes = ::FcPatternGetString( fcFont, FC_FAMILY, 0, &fcFamily );
-				::FcResult fcStyleRes = ::FcPatternGetString( fcFont, FC_STYLE, 0, &fcStyle );
-				if( ( ::FcResultMatch != fcFamilyRes ) || ( ::FcResultMatch != fcStyleRes ) ) {
-					continue;
-				}
+	try {
+		ci::IStreamRef is = ci::DataSourcePath::create( filePath )->createStream();
+		if( ! is ) {
+			return false;
+		}
+		uint8_t ident[4];
+		is->readData( ident, 4 );
+		if( std::string( "SDFG" ) != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+			return false;
+		}
+		uint32_t version = 0;
+		ivec2 size = ivec2( 0 );
+		uint32_t pixelInc = 0;
+		vec2 originOffset = vec2( 0 );
+		vec2 glyphSize = vec2( 0 );
+		is->readLittle( &version );
+		is->readLittle( &size.x );
+		is->readLittle( &size.y );
+		is->readLittle( &pixelInc );
+		is->readLittle( &originOffset.x );
+		is->readLittle( &originOffset.y );
+		is->readLittle( &glyphSize.x );
+		is->readLittle( &glyphSize.y );
+		if( ( 2 != version ) || ( pixelInc != getPixelInc() ) || ( originOffset != glyphInfo.mOriginOffset ) || ( glyphSize != glyphInfo.mSize ) ) {
+			return false;
+		}
+		// A tile cached from an atlas with smaller tiles may be cut off
+		const ivec2 placeSize = calcCachedTileSize( getRenderParams(), glyphInfo );
+		if( ( size.x < placeSize.x ) || ( size.y < placeSize.y ) ) {
+			return false;
+		}
+		const size_t tileRowBytes = pixelInc * size.x;
+		std::vector<uint8_t> tileData( tileRowBytes * size.y );
+		is->readData( tileData.data(), tileData.size() );
+		// The rest of the tile is outside the distance range
+		const size_t placeRowBytes = pixelInc * placeSize.x;
+		for( int y = 0; y < mSdfBitmapSize.y; ++y ) {
+			std::memset( dst + ( y * rowBytes ), 0, pixelInc * mSdfBitmapSize.x );
+		}
+		for( int y = 0; y < placeSize.y; ++y ) {
+			std::memcpy( dst + ( ( mSdfBitmapSize.y - placeSize.y + y ) * rowBytes ), tileData.data() + ( ( size.y - placeSize.y + y ) * tileRowBytes ), placeRowBytes );
+		}
+	}
+	catch( const std::exception& e ) {
+		CI_LOG_W( "failed reading cached glyph " << glyphIndex << ": " << e.what() );
+		return false;
+	}
+	return true;
+}
 
-				std::string family = std::string( (const char*)fcFamily );
-				std::string style = std::string( (const char*)fcStyle );
-				std::string fontName = family + ( style.empty() ? "" : ( " " + style ) );
-				
-				std::string fontKey = boost::to_lower_copy( fontName );
-				auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
-					[fontKey]( const FontInfo& elem ) -> bool {
-						return elem.key == fontKey;
-					}
-				);
-				if( std::end( mFontInfos ) == it ) {
-					if( fs::exists( fontFilePath ) ) {
-						// Build font info
-						FontInfo fontInfo = FontInfo( fontKey, fontName, fontFilePath );
-						mFontInfos.push_back( fontInfo );
-						mFontNames.push_back( fontName );
+void SdfText::TextureAtlas::writeCachedTile( SdfText::Font::Glyph glyphIndex, const SdfText::Font::GlyphInfo &glyphInfo, const uint8_t *src, size_t rowBytes ) const
+{
+	writeCachedTile( mGlyphCachePath, getRenderParams(), getPixelInc(), glyphIndex, glyphInfo, src, rowBytes );
+}
+
+//! Returns a file name suffix that is unique across the threads and processes writing to the same directory
+static std::string makeTempFileSuffix()
+{
+	static std::atomic<uint32_t> sCounter{ 0 };
+	std::random_device device;
+	std::stringstream ss;
+	ss << std::hex << std::setfill( '0' ) << std::setw( 8 ) << device() << std::setw( 8 ) << device() << "-" << sCounter++;
+	return ss.str();
+}
+
+void SdfText::TextureAtlas::writeCachedTile( const fs::path &cachePath, const RenderParams &params, size_t pixelInc, SdfText::Font::Glyph glyphIndex, const SdfText::Font::GlyphInfo &glyphInfo, const uint8_t *src, size_t rowBytes )
+{
+	const fs::path filePath = cachePath / ( std::to_string( glyphIndex ) + ".sdfg" );
+	// Write next to the tile and rename so that readers in other processes never see a partial file
+	const fs::path tempPath = cachePath / ( std::to_string( glyphIndex ) + "." + makeTempFileSuffix() + ".tmp" );
+	// Only the lower left part that holds the glyph, so the tile fits atlases of any tile size
+	const ivec2 size = calcCachedTileSize( params, glyphInfo );
+	try {
+		{
+			auto os = ci::writeFile( tempPath, true )->getStream();
+			if( ! os ) {
+				return;
+			}
+			const uint32_t version = 2;
+			os->writeData( "SDFG", 4 );
+			os->writeLittle( version );
+			os->writeLittle( size.x );
+			os->writeLittle( size.y );
+			os->writeLittle( static_cast<uint32_t>( pixelInc ) );
+			os->writeLittle( glyphInfo.mOriginOffset.x );
+			os->writeLittle( glyphInfo.mOriginOffset.y );
+			os->writeLittle( glyphInfo.mSize.x );
+			os->writeLittle( glyphInfo.mSize.y );
+			const size_t tileRowBytes = pixelInc * size.x;
+			for( int y = params.mSdfBitmapSize.y - size.y; y < params.mSdfBitmapSize.y; ++y ) {
+				os->writeData( src + ( y * rowBytes ), tileRowBytes );
+			}
+		}
+		fs::rename( tempPath, filePath );
+	}
+	catch( const std::exception& e ) {
+		CI_LOG_W( "failed caching glyph " << glyphIndex << ": " << e.what() );
+	}
+}
+
+void SdfText::TextureAtlas::addPage( const uint8_t *pixels, const ivec2 &size )
+{
+	Page page;
+	page.mSize = size;
+
+	if( mCompressed ) {
+		page.mData.resize( calcBc4Size( size ) );
+		float meanError = 0.0f;
+		float maxError = 0.0f;
+		encodeBc4( pixels, size, page.mData.data(), &meanError, &maxError );
+
+		// Running mean and max across all compressed pages
+		const uint64_t texelCount = static_cast<uint64_t>( size.x * size.y );
+		mCompressionErrorSum += static_cast<uint64_t>( meanError * static_cast<float>( texelCount ) + 0.5f );
+		mCompressionTexelCount += texelCount;
+		mStats.mNumCompressedTextures += 1;
+		mStats.mCompressionMeanError = static_cast<float>( static_cast<double>( mCompressionErrorSum ) / static_cast<double>( mCompressionTexelCount ) );
+		mStats.mCompressionMaxError = std::max( mStats.mCompressionMaxError, maxError );
+	}
+	else {
+		page.mData.assign( pixels, pixels + ( getPixelInc() * size.x * size.y ) );
+	}
+
+	mPages.push_back( std::move( page ) );
+}
+
+//! Number of page writes whose areas are kept for partial texture updates, contexts further behind update the whole page
+static const size_t kMaxDirtyAreas = 64;
+
+void SdfText::TextureAtlas::addDirtyArea( Page *page, const Area &area )
+{
+	page->mDirtyAreas.push_back( area );
+	if( page->mDirtyAreas.size() > kMaxDirtyAreas ) {
+		page->mDirtyAreas.pop_front();
+	}
+}
+
+void SdfText::TextureAtlas::writeTile( uint32_t pageIndex, const ivec2 &position, const uint8_t *tileData )
+{
+	Page &page = mPages[pageIndex];
+	if( page.mData.empty() ) {
+		throw ci::Exception( "Texture atlas page data has been released" );
+	}
+	++page.mRevision;
+
+	if( ! mCompressed ) {
+		const size_t pixelInc = getPixelInc();
+		const size_t tileRowBytes = pixelInc * mSdfBitmapSize.x;
+		const size_t pageRowBytes = pixelInc * page.mSize.x;
+		for( int n = 0; n < mSdfBitmapSize.y; ++n ) {
+			std::copy( tileData + ( n * tileRowBytes ), tileData + ( ( n + 1 ) * tileRowBytes ), page.mData.data() + ( ( position.y + n ) * pageRowBytes ) + ( position.x * pixelInc ) );
+		}
+		addDirtyArea( &page, Area( position, position + mSdfBitmapSize ) );
+		return;
+	}
+
+	// Re-encode the 4x4 blocks that the tile touches. Texels of neighboring tiles come from
+	// the decoded blocks, tile spacing keeps them blank in practice.
+	const ivec2 numBlocks = ( page.mSize + ivec2( 3 ) ) / 4;
+	const ivec2 blockMin = position / 4;
+	const ivec2 blockMax = ivec2( std::min( ( position.x + mSdfBitmapSize.x + 3 ) / 4, numBlocks.x ), std::min( ( position.y + mSdfBitmapSize.y + 3 ) / 4, numBlocks.y ) );
+	uint64_t errorSum = 0;
+	uint32_t errorMax = 0;
+	uint8_t texels[16];
+	for( int blockY = blockMin.y; blockY < blockMax.y; ++blockY ) {
+		for( int blockX = blockMin.x; blockX < blockMax.x; ++blockX ) {
+			uint8_t *block = page.mData.data() + 8 * ( blockY * numBlocks.x + blockX );
+			decodeBc4Block( block, texels );
+			for( int y = 0; y < 4; ++y ) {
+				for( int x = 0; x < 4; ++x ) {
+					const ivec2 tilePos = ivec2( blockX * 4 + x, blockY * 4 + y ) - position;
+					if( ( tilePos.x >= 0 ) && ( tilePos.y >= 0 ) && ( tilePos.x < mSdfBitmapSize.x ) && ( tilePos.y < mSdfBitmapSize.y ) ) {
+						texels[y * 4 + x] = tileData[tilePos.y * mSdfBitmapSize.x + tilePos.x];
 					}
 				}
+			}
+			encodeBc4Block( texels, block, &errorSum, &errorMax );
+		}
+	}
+	mStats.mCompressionMaxError = std::max( mStats.mCompressionMaxError, static_cast<float>( errorMax ) );
+	// Compressed updates cover whole blocks
+	addDirtyArea( &page, Area( blockMin * 4, ivec2( std::min( blockMax.x * 4, page.mSize.x ), std::min( blockMax.y * 4, page.mSize.y ) ) ) );
+}
 
-				//std::cout << fcFamily << " " << fcStyle << " : " << fontFilePath << std::endl;
+gl::TextureRef SdfText::TextureAtlas::createTexture( const Page &page ) const
+{
+	if( mCompressed ) {
+		return createBc4Texture( page.mData, page.mSize );
+	}
 
-				/*
-				DataSourceRef dataSource = ci::loadFile( fontFilePath );
-				if( ! dataSource ) {
-					throw FontLoadFailedExc( "Couldn't find file for " + aName );
-				}
+	if( mSingleChannel ) {
+		return createSingleChannelTexture( page.mData.data(), page.mSize );
+	}
 
-				mFileData = dataSource->getBuffer();
-				FT_Error error = FT_New_Memory_Face(
-					FontManager::instance()->mLibrary, 
-					(FT_Byte*)mFileData->getData(), 
-					mFileData->getSize(), 
-					0, 
-					&mFace
-				);
-				if( error ) {
-					throw FontInvalidNameExc( "Failed to create a face for " + aName );
+	Surface8u surface( const_cast<uint8_t *>( page.mData.data() ), page.mSize.x, page.mSize.y, static_cast<ptrdiff_t>( 3 * page.mSize.x ), SurfaceChannelOrder::RGB );
+	return gl::Texture::create( surface );
+}
+
+void SdfText::TextureAtlas::updateTexture( const gl::TextureRef &tex, const Page &page, const Area &area ) const
+{
+	const ivec2 size = area.getSize();
+	if( ( size.x <= 0 ) || ( size.y <= 0 ) ) {
+		return;
+	}
+
+	// ES 2 has no unpack row length, areas narrower than the page are copied to tightly packed rows
+	ScopedTextureBind texBindScp( tex );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	if( mCompressed && isBc4Supported() ) {
+		// Areas start on block boundaries
+		const int numBlocksX = ( page.mSize.x + 3 ) / 4;
+		const ivec2 blockMin = area.getUL() / 4;
+		const ivec2 blockMax = ( area.getLR() + ivec2( 3 ) ) / 4;
+		const size_t rowBytes = 8 * ( blockMax.x - blockMin.x );
+		const uint8_t *blocks = page.mData.data() + 8 * ( blockMin.y * numBlocksX + blockMin.x );
+		std::vector<uint8_t> areaBlocks;
+		if( ( blockMax.x - blockMin.x ) != numBlocksX ) {
+			areaBlocks.resize( rowBytes * ( blockMax.y - blockMin.y ) );
+			for( int blockY = blockMin.y; blockY < blockMax.y; ++blockY ) {
+				const uint8_t *src = page.mData.data() + 8 * ( blockY * numBlocksX + blockMin.x );
+				std::copy( src, src + rowBytes, areaBlocks.data() + ( blockY - blockMin.y ) * rowBytes );
+			}
+			blocks = areaBlocks.data();
+		}
+		glCompressedTexSubImage2D( tex->getTarget(), 0, area.x1, area.y1, size.x, size.y, GL_COMPRESSED_RED_RGTC1, static_cast<GLsizei>( rowBytes * ( blockMax.y - blockMin.y ) ), blocks );
+	}
+	else if( mCompressed ) {
+		const int numBlocksX = ( page.mSize.x + 3 ) / 4;
+		std::vector<uint8_t> pixels( size.x * size.y );
+		uint8_t texels[16];
+		for( int blockY = area.y1 / 4; blockY < ( area.y2 + 3 ) / 4; ++blockY ) {
+			for( int blockX = area.x1 / 4; blockX < ( area.x2 + 3 ) / 4; ++blockX ) {
+				decodeBc4Block( page.mData.data() + 8 * ( blockY * numBlocksX + blockX ), texels );
+				for( int y = 0; y < 4; ++y ) {
+					for( int x = 0; x < 4; ++x ) {
+						const ivec2 pos = ivec2( blockX * 4 + x, blockY * 4 + y ) - area.getUL();
+						if( ( pos.x >= 0 ) && ( pos.y >= 0 ) && ( pos.x < size.x ) && ( pos.y < size.y ) ) {
+							pixels[pos.y * size.x + pos.x] = texels[y * 4 + x];
+						}
+					}
 				}
+			}
+		}
+		glTexSubImage2D( tex->getTarget(), 0, area.x1, area.y1, size.x, size.y, SDF_SINGLE_CHANNEL_FORMAT, GL_UNSIGNED_BYTE, pixels.data() );
+	}
+	else {
+		const GLenum dataFormat = mSingleChannel ? SDF_SINGLE_CHANNEL_FORMAT : GL_RGB;
+		const size_t pixelInc = getPixelInc();
+		const size_t pageRowBytes = pixelInc * page.mSize.x;
+		const size_t rowBytes = pixelInc * size.x;
+		const uint8_t *pixels = page.mData.data() + ( area.y1 * pageRowBytes ) + ( area.x1 * pixelInc );
+		std::vector<uint8_t> areaPixels;
+		if( size.x != page.mSize.x ) {
+			areaPixels.resize( rowBytes * size.y );
+			for( int n = 0; n < size.y; ++n ) {
+				std::copy( pixels + ( n * pageRowBytes ), pixels + ( n * pageRowBytes ) + rowBytes, areaPixels.data() + ( n * rowBytes ) );
+			}
+			pixels = areaPixels.data();
+		}
+		glTexSubImage2D( tex->getTarget(), 0, area.x1, area.y1, size.x, size.y, dataFormat, GL_UNSIGNED_BYTE, pixels );
+	}
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+}
 
-				FT_Select_Charmap( mFace, FT_ENCODING_UNICODE );
-				FT_Set_Char_Size( mFace, 0, (int)aSize * 64, 0, 72 );
-				*/
-			}			
+void SdfText::TextureAtlas::releaseDeadContextTextures()
+{
+	for( auto it = mContextTextures.begin(); it != mContextTextures.end(); ) {
+		if( ! it->second.mPlatformData.expired() ) {
+			++it;
+			continue;
 		}
+		for( auto& texture : it->second.mTextures ) {
+			texture->setDoNotDispose( true );
+		}
+		it = mContextTextures.erase( it );
+	}
+}
 
-		::FcObjectSetDestroy( os );
-		::FcPatternDestroy( pat );
-		::FcFontSetDestroy( fs );
+const std::vector<gl::TextureRef>& SdfText::TextureAtlas::getTextures()
+{
+	if( ! mDeferredTiles.empty() ) {
+		writeDeferredTiles();
+	}
 
-		::FcFini();
+	releaseDeadContextTextures();
+	gl::Context *context = gl::context();
+	ContextTextures &contextTextures = mContextTextures[context];
+	if( contextTextures.mPlatformData.expired() ) {
+		contextTextures.mPlatformData = context->getPlatformData();
+	}
+	std::vector<gl::TextureRef> &textures = contextTextures.mTextures;
+	std::vector<uint32_t> &revisions = contextTextures.mRevisions;
+	for( size_t i = 0; i < mPages.size(); ++i ) {
+		const Page &page = mPages[i];
+		const bool created = ( i < textures.size() );
+		if( created && ( revisions[i] == page.mRevision ) ) {
+			continue;
+		}
+
+		if( page.mData.empty() ) {
+			throw ci::Exception( "Texture atlas page data was released before it was uploaded to this context" );
+		}
+
+		if( created ) {
+			updateTexture( textures[i], page, page.getDirtyArea( revisions[i] ) );
+			revisions[i] = page.mRevision;
+		}
+		else {
+			textures.push_back( createTexture( page ) );
+			revisions.push_back( page.mRevision );
+		}
+	}
+
+	// Drop the dirty areas that every context has uploaded
+	for( size_t i = 0; i < mPages.size(); ++i ) {
+		Page &page = mPages[i];
+		uint32_t numBehind = 0;
+		for( const auto& it : mContextTextures ) {
+			const std::vector<uint32_t> &contextRevisions = it.second.mRevisions;
+			if( i < contextRevisions.size() ) {
+				numBehind = std::max( numBehind, page.mRevision - contextRevisions[i] );
+			}
+		}
+		while( page.mDirtyAreas.size() > numBehind ) {
+			page.mDirtyAreas.pop_front();
+		}
+	}
+
+	if( mReleasePageData ) {
+		releaseUploadedPages();
 	}
+
+	return textures;
 }
-#endif
 
-void SdfTextManager::faceCreated( FT_Face face ) 
+void SdfText::TextureAtlas::releasePageData()
 {
-	mTrackedFaces.insert( face );
+	mReleasePageData = true;
+	releaseUploadedPages();
 }
 
-void SdfTextManager::faceDestroyed( FT_Face face ) 
+void SdfText::TextureAtlas::releaseContextTextures()
 {
-	mTrackedFaces.erase( face );
+	mContextTextures.erase( gl::context() );
 }
 
-SdfText::TextureAtlasRef SdfTextManager::getTextureAtlas( FT_Face face, const SdfText::Format &format, const std::string &utf8Chars, const std::vector<SdfText::Font::Glyph> &glyphIndices )
+void SdfText::TextureAtlas::releaseUploadedPages()
 {
-	std::u32string utf32Chars = ci::toUtf32( utf8Chars );
-	// Add a space if needed
-	if( std::string::npos == utf8Chars.find( ' ' ) ) {
-		utf32Chars += ci::toUtf32( " " );
+	releaseDeadContextTextures();
+	if( mContextTextures.empty() ) {
+		return;
 	}
 
-	// Build the maps and information pieces that will be needed later
-	vec2 maxGlyphSize = vec2( 0 );
-	for( const auto& ch : utf32Chars ) {
-		FT_UInt glyphIndex = FT_Get_Char_Index( face, static_cast<FT_ULong>( ch ) );
-		// Glyph bounds, 
+	for( size_t i = 0; i < mPages.size(); ++i ) {
+		Page &page = mPages[i];
+		if( page.mData.empty() ) {
+			continue;
+		}
+
+		bool uploaded = true;
+		for( const auto& it : mContextTextures ) {
+			const std::vector<uint32_t> &revisions = it.second.mRevisions;
+			uploaded = uploaded && ( i < revisions.size() ) && ( revisions[i] == page.mRevision );
+		}
+		// Deferred tiles still have to be written to the page
+		for( const auto& tile : mDeferredTiles ) {
+			uploaded = uploaded && ( tile->mPageIndex != i );
+		}
+
+		if( uploaded ) {
+			std::vector<uint8_t>().swap( page.mData );
+		}
+	}
+}
+
+void SdfText::TextureAtlas::appendGlyphs( const GlyphShapes &glyphShapes, bool background )
+{
+	if( glyphShapes.empty() ) {
+		return;
+	}
+
+	if( ( mSdfBitmapSize.x <= 0 ) || ( mSdfBitmapSize.y <= 0 ) ) {
+		throw ci::Exception( "Texture atlas has no tile size" );
+	}
+
+	// Page size follows the existing pages, otherwise the default format
+	ivec2 textureSize = mPages.empty() ? ( ( mAppendPageSize.x > 0 ) ? mAppendPageSize : SdfText::Format().getTextureSize() ) : mPages.back().mSize;
+	const ivec2 tileStride = mSdfBitmapSize + mTileSpacing;
+	int numGlyphColumns   = textureSize.x / tileStride.x;
+	int numGlyphRows      = textureSize.y / tileStride.y;
+	int numGlyphsPerAtlas = numGlyphColumns * numGlyphRows;
+	if( numGlyphsPerAtlas <= 0 ) {
+		throw ci::Exception( "Texture atlas tile does not fit in texture" );
+	}
+
+	// Find the first free tile after the last one used in the last page, unless its data was released
+	int nextTile = numGlyphsPerAtlas;
+	if( ( ! mPages.empty() ) && ( ! mPages.back().mData.empty() ) ) {
+		const uint32_t lastTextureIndex = static_cast<uint32_t>( mPages.size() - 1 );
+		int lastTile = -1;
+		for( const auto& it : mGlyphInfo ) {
+			const auto& glyphInfo = it.second;
+			if( glyphInfo.mTextureIndex != lastTextureIndex ) {
+				continue;
+			}
+			int tile = ( glyphInfo.mTexCoords.y1 / tileStride.y ) * numGlyphColumns + ( glyphInfo.mTexCoords.x1 / tileStride.x );
+			lastTile = std::max( lastTile, tile );
+		}
+		nextTile = lastTile + 1;
+	}
+
+	// Assign tiles first so that the glyphs can be rendered in parallel
+	std::vector<SdfText::Font::GlyphInfo> glyphInfos;
+	std::vector<ivec2> positions;
+	for( const auto& glyphShape : glyphShapes ) {
+		const SdfText::Font::Glyph glyphIndex = glyphShape.first;
+		const msdfgen::Shape &shape = glyphShape.second;
+
+		double l, b, r, t;
+		l = b = r = t = 0.0;
+		shape.bounds( l, b, r, t );
+		SdfText::Font::GlyphInfo glyphInfo = {};
+		glyphInfo.mOriginOffset = vec2( l, b );
+		glyphInfo.mSize = vec2( r - l, t - b );
+		if( ( glyphInfo.mSize.x > mMaxGlyphSize.x ) || ( glyphInfo.mSize.y > mMaxGlyphSize.y ) ) {
+			CI_LOG_W( "glyph " << glyphIndex << " is larger than the atlas tiles and will be clipped" );
+		}
+
+		// Start a new page if the last one is full, sized for the glyphs left when the size is automatic
+		if( nextTile >= numGlyphsPerAtlas ) {
+			if( mAutoTextureSize ) {
+				textureSize = calcAutoTextureSize( glyphShapes.size() - glyphInfos.size(), tileStride, mMaxTextureSize );
+				numGlyphColumns = textureSize.x / tileStride.x;
+				numGlyphRows = textureSize.y / tileStride.y;
+				numGlyphsPerAtlas = numGlyphColumns * numGlyphRows;
+			}
+			std::vector<uint8_t> pixels( getPixelInc() * textureSize.x * textureSize.y, 0 );
+			addPage( pixels.data(), textureSize );
+			nextTile = 0;
+		}
+
+		const ivec2 position = ivec2( nextTile % numGlyphColumns, nextTile / numGlyphColumns ) * tileStride;
+		glyphInfo.mTextureIndex = static_cast<uint32_t>( mPages.size() - 1 );
+		glyphInfo.mTexCoords = Area( 0, 0, mSdfBitmapSize.x, mSdfBitmapSize.y ) + position;
+		glyphInfos.push_back( glyphInfo );
+		positions.push_back( position );
+
+		++nextTile;
+	}
+
+	// Render the tightly packed tiles, copying the ones found in the glyph cache
+	const size_t tileSize = getPixelInc() * mSdfBitmapSize.x * mSdfBitmapSize.y;
+	const size_t tileRowBytes = getPixelInc() * mSdfBitmapSize.x;
+	std::vector<uint8_t> tileData( glyphShapes.size() * tileSize, 0 );
+	std::vector<uint8_t> cached( glyphShapes.size(), 0 );
+	if( ! mGlyphCachePath.empty() ) {
+		for( size_t i = 0; i < glyphShapes.size(); ++i ) {
+			if( readCachedTile( glyphShapes[i].first, glyphInfos[i], tileData.data() + ( i * tileSize ), tileRowBytes ) ) {
+				cached[i] = 1;
+				++mStats.mNumCachedGlyphs;
+			}
+		}
+	}
+	// Apply the cost limit, a resolution of 0 defers the glyph
+	std::vector<msdfgen::Shape> shapes( glyphShapes.size() );
+	std::vector<float> resolutions( glyphShapes.size(), 1.0f );
+	std::vector<uint8_t> degraded( glyphShapes.size(), 0 );
+	for( size_t i = 0; i < glyphShapes.size(); ++i ) {
+		if( ! cached[i] ) {
+			shapes[i] = glyphShapes[i].second;
+			degraded[i] = applyGlyphCostGuard( glyphShapes[i].first, shapes[i], &resolutions[i] ) ? 1 : 0;
+		}
+	}
+	if( ! background ) {
+		SdfText::getExecutor()->parallelFor( glyphShapes.size(), [&]( size_t i ) {
+			if( cached[i] || ( resolutions[i] <= 0.0f ) ) {
+				return;
+			}
+			renderGlyphBitmap( shapes[i], glyphInfos[i].mOriginOffset, tileData.data() + ( i * tileSize ), tileRowBytes, resolutions[i] );
+		} );
+	}
+	for( size_t i = 0; i < glyphShapes.size(); ++i ) {
+		if( cached[i] ) {
+			continue;
+		}
+		// Degraded tiles are not cached, a later run with a higher limit generates them in full
+		if( background || ( resolutions[i] <= 0.0f ) ) {
+			deferTile( glyphShapes[i].first, glyphInfos[i], std::move( shapes[i] ), ( resolutions[i] > 0.0f ) ? resolutions[i] : 1.0f, ! degraded[i] );
+			continue;
+		}
+		++mStats.mNumGeneratedGlyphs;
+		if( ( ! mGlyphCachePath.empty() ) && ( ! degraded[i] ) ) {
+			writeCachedTile( glyphShapes[i].first, glyphInfos[i], tileData.data() + ( i * tileSize ), tileRowBytes );
+		}
+	}
+
+	for( size_t i = 0; i < glyphShapes.size(); ++i ) {
+		writeTile( glyphInfos[i].mTextureIndex, positions[i], tileData.data() + ( i * tileSize ) );
+		mGlyphInfo[glyphShapes[i].first] = glyphInfos[i];
+	}
+
+	updatePageStats();
+}
+
+// =================================================================================================
+// SdfText::GlyphOutlines
+// =================================================================================================
+class SdfText::GlyphOutlines {
+public:
+	virtual ~GlyphOutlines() {}
+
+	//! Creates outlines for \a glyphIndices and for the glyphs of \a embedUtf32Chars that are not in \a charToGlyph.
+	static SdfText::GlyphOutlinesRef create( FT_Face face, const std::vector<SdfText::Font::Glyph> &glyphIndices, const std::u32string &embedUtf32Chars, const SdfText::Font::CharToGlyphMap &charToGlyph );
+
+	void								write( const ci::OStreamRef &os ) const;
+	//! Reads outlines written by write(). Metrics are multiplied by \a fontSizeScale.
+	static SdfText::GlyphOutlinesRef	read( const ci::IStreamRef &is, float fontSizeScale );
+
+private:
+	GlyphOutlines() {}
+	friend class SdfText;
+
+	//! Chars and metrics of the embedded glyphs that are not in the atlas yet
+	SdfText::Font::CharToGlyphMap					mCharToGlyph;
+	SdfText::Font::GlyphMetricsMap					mGlyphMetrics;
+	//! Unnormalized outlines of all embedded glyphs
+	std::map<SdfText::Font::Glyph, msdfgen::Shape>	mShapes;
+};
+
+//! Returns the metrics for \a glyphIndex at the current size of \a face
+static SdfText::Font::GlyphMetrics loadGlyphMetrics( FT_Face face, SdfText::Font::Glyph glyphIndex )
+{
+	FT_Load_Glyph( face, glyphIndex, FT_LOAD_DEFAULT );
+	FT_GlyphSlot slot = face->glyph;
+	SdfText::Font::GlyphMetrics glyphMetrics;
+	glyphMetrics.advance = vec2( slot->linearHoriAdvance, slot->linearVertAdvance ) / 65536.0f;
+	glyphMetrics.minimum = vec2( slot->metrics.horiBearingX, slot->metrics.vertBearingY - slot->metrics.height ) / 65536.0f;
+	glyphMetrics.maximum = vec2( slot->metrics.horiBearingX + slot->metrics.width, slot->metrics.vertBearingY ) / 65536.0f;
+	return glyphMetrics;
+}
+
+SdfText::GlyphOutlinesRef SdfText::GlyphOutlines::create( FT_Face face, const std::vector<SdfText::Font::Glyph> &glyphIndices, const std::u32string &embedUtf32Chars, const SdfText::Font::CharToGlyphMap &charToGlyph )
+{
+	SdfText::GlyphOutlinesRef result = SdfText::GlyphOutlinesRef( new SdfText::GlyphOutlines() );
+
+	for( const auto& glyphIndex : glyphIndices ) {
 		msdfgen::Shape shape;
 		if( msdfgen::loadGlyph( shape, face, glyphIndex ) ) {
-			double l, b, r, t;
-			l = b = r = t = 0.0;
-			shape.bounds( l, b, r, t );
-			// Glyph bounds
-			Rectf bounds = Rectf( 
-				static_cast<float>( l ), 
-				static_cast<float>( b ), 
-				static_cast<float>( r ), 
-				static_cast<float>( t ) );
-			// Max glyph size
-			maxGlyphSize.x = std::max( maxGlyphSize.x, bounds.getWidth() );
-			maxGlyphSize.y = std::max( maxGlyphSize.y, bounds.getHeight() );
-		}	
+			result->mShapes[glyphIndex] = shape;
+		}
 	}
-	
-	SdfText::TextureAtlas::CacheKey key;
-	key.mFamilyName = std::string( face->family_name );
-	key.mStyleName = std::string( face->style_name );
-	key.mUtf8Chars = utf8Chars;
-	key.mTextureSize = format.getTextureSize();
-	key.mSdfBitmapSize = SdfText::TextureAtlas::calculateSdfBitmapSize( format.getSdfScale(), format.getSdfPadding(), maxGlyphSize );
 
-	// Result
-	SdfText::TextureAtlasRef result;
-	// Look for the texture atlas 
-	auto it = std::find_if( std::begin( mTrackedTextureAtlases ), std::end( mTrackedTextureAtlases ),
-		[key]( const std::pair<SdfText::TextureAtlas::CacheKey, SdfText::TextureAtlasRef>& elem ) -> bool {
-			return elem.first == key;
+	for( const auto& ch : embedUtf32Chars ) {
+		if( charToGlyph.end() != charToGlyph.find( ch ) ) {
+			continue;
+		}
+
+		SdfText::Font::Glyph glyphIndex = static_cast<SdfText::Font::Glyph>( FT_Get_Char_Index( face, static_cast<FT_ULong>( ch ) ) );
+		result->mCharToGlyph[ch] = glyphIndex;
+		if( result->mShapes.end() != result->mShapes.find( glyphIndex ) ) {
+			continue;
+		}
+
+		msdfgen::Shape shape;
+		if( msdfgen::loadGlyph( shape, face, glyphIndex ) ) {
+			result->mShapes[glyphIndex] = shape;
+			result->mGlyphMetrics[glyphIndex] = loadGlyphMetrics( face, glyphIndex );
 		}
-	);
-	// Use the texture atlas if a matching one is found
-	if( mTrackedTextureAtlases.end() != it ) {
-		result = it->second;
 	}
-	// ...otherwise build a new one
-	else {
-		result = SdfText::TextureAtlas::create( face, format, glyphIndices );
-		mTrackedTextureAtlases.push_back( std::make_pair( key, result ) );
+
+	return result;
+}
+
+void SdfText::GlyphOutlines::write( const ci::OStreamRef &os ) const
+{
+	// Chars/glyphs
+	os->writeLittle( static_cast<uint32_t>( mCharToGlyph.size() ) );
+	for( const auto& it : mCharToGlyph ) {
+		os->writeLittle( static_cast<uint32_t>( it.first ) );
+		os->writeLittle( it.second );
+	}
+
+	// Glyph metrics
+	os->writeLittle( static_cast<uint32_t>( mGlyphMetrics.size() ) );
+	for( const auto& it : mGlyphMetrics ) {
+		const SdfText::Font::GlyphMetrics& metrics = it.second;
+		os->writeLittle( it.first );
+		os->writeLittle( metrics.advance.x );
+		os->writeLittle( metrics.advance.y );
+		os->writeLittle( metrics.minimum.x );
+		os->writeLittle( metrics.minimum.y );
+		os->writeLittle( metrics.maximum.x );
+		os->writeLittle( metrics.maximum.y );
+	}
+
+	// Shapes - each edge is written as its point count followed by its points
+	os->writeLittle( static_cast<uint32_t>( mShapes.size() ) );
+	for( const auto& it : mShapes ) {
+		const msdfgen::Shape& shape = it.second;
+		os->writeLittle( it.first );
+		os->writeLittle( static_cast<uint32_t>( shape.contours.size() ) );
+		for( const auto& contour : shape.contours ) {
+			os->writeLittle( static_cast<uint32_t>( contour.edges.size() ) );
+			for( const auto& edge : contour.edges ) {
+				const msdfgen::Point2 *points = nullptr;
+				uint8_t numPoints = 0;
+				if( const msdfgen::LinearSegment *linear = dynamic_cast<const msdfgen::LinearSegment *>( static_cast<const msdfgen::EdgeSegment *>( edge ) ) ) {
+					points = linear->p;
+					numPoints = 2;
+				}
+				else if( const msdfgen::QuadraticSegment *quadratic = dynamic_cast<const msdfgen::QuadraticSegment *>( static_cast<const msdfgen::EdgeSegment *>( edge ) ) ) {
+					points = quadratic->p;
+					numPoints = 3;
+				}
+				else if( const msdfgen::CubicSegment *cubic = dynamic_cast<const msdfgen::CubicSegment *>( static_cast<const msdfgen::EdgeSegment *>( edge ) ) ) {
+					points = cubic->p;
+					numPoints = 4;
+				}
+				os->write( numPoints );
+				for( uint8_t i = 0; i < numPoints; ++i ) {
+					os->writeLittle( static_cast<float>( points[i].x ) );
+					os->writeLittle( static_cast<float>( points[i].y ) );
+				}
+			}
+		}
+	}
+}
+
+SdfText::GlyphOutlinesRef SdfText::GlyphOutlines::read( const ci::IStreamRef &is, float fontSizeScale )
+{
+	SdfText::GlyphOutlinesRef result = SdfText::GlyphOutlinesRef( new SdfText::GlyphOutlines() );
+
+	// Chars/glyphs
+	uint32_t numChars = 0;
+	is->readLittle( &numChars );
+	for( uint32_t i = 0; i < numChars; ++i ) {
+		uint32_t ch = 0;
+		SdfText::Font::Glyph glyph = 0;
+		is->readLittle( &ch );
+		is->readLittle( &glyph );
+		result->mCharToGlyph[static_cast<SdfText::Font::Char>( ch )] = glyph;
+	}
+
+	// Glyph metrics
+	uint32_t numGlyphMetrics = 0;
+	is->readLittle( &numGlyphMetrics );
+	for( uint32_t i = 0; i < numGlyphMetrics; ++i ) {
+		SdfText::Font::Glyph glyph = 0;
+		SdfText::Font::GlyphMetrics metrics = {};
+		is->readLittle( &glyph );
+		is->readLittle( &(metrics.advance.x) );
+		is->readLittle( &(metrics.advance.y) );
+		is->readLittle( &(metrics.minimum.x) );
+		is->readLittle( &(metrics.minimum.y) );
+		is->readLittle( &(metrics.maximum.x) );
+		is->readLittle( &(metrics.maximum.y) );
+		metrics.advance *= fontSizeScale;
+		metrics.minimum *= fontSizeScale;
+		metrics.maximum *= fontSizeScale;
+		result->mGlyphMetrics[glyph] = metrics;
+	}
+
+	// Shapes
+	uint32_t numShapes = 0;
+	is->readLittle( &numShapes );
+	for( uint32_t i = 0; i < numShapes; ++i ) {
+		SdfText::Font::Glyph glyph = 0;
+		is->readLittle( &glyph );
+		msdfgen::Shape& shape = result->mShapes[glyph];
+		uint32_t numContours = 0;
+		is->readLittle( &numContours );
+		for( uint32_t j = 0; j < numContours; ++j ) {
+			msdfgen::Contour& contour = shape.addContour();
+			uint32_t numEdges = 0;
+			is->readLittle( &numEdges );
+			for( uint32_t k = 0; k < numEdges; ++k ) {
+				uint8_t numPoints = 0;
+				is->read( &numPoints );
+				msdfgen::Point2 points[4];
+				for( uint8_t n = 0; ( n < numPoints ) && ( n < 4 ); ++n ) {
+					float x = 0.0f;
+					float y = 0.0f;
+					is->readLittle( &x );
+					is->readLittle( &y );
+					points[n] = msdfgen::Point2( x, y );
+				}
+				switch( numPoints ) {
+					case 2: contour.addEdge( msdfgen::EdgeHolder( points[0], points[1] ) ); break;
+					case 3: contour.addEdge( msdfgen::EdgeHolder( points[0], points[1], points[2] ) ); break;
+					case 4: contour.addEdge( msdfgen::EdgeHolder( points[0], points[1], points[2], points[3] ) ); break;
+					default: throw ci::Exception( "Invalid outline edge" );
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+// =================================================================================================
+// SdfTextManager
+// =================================================================================================
+class SdfTextManager {
+public:
+	~SdfTextManager();
+
+	static SdfTextManager			*instance();
+
+	FT_Library						getLibrary() const { return mLibrary; }
+
+	const std::vector<std::string>&	getNames( bool forceRefresh );
+	SdfText::Font					getDefault() const;
+
+	struct FontInfo {
+		std::string 	key;
+		std::string 	name;
+		fs::path 		path;
+		FontInfo() {}
+		FontInfo( const std::string& aKey, const std::string& aName, const fs::path& aPath ) 
+			: key( aKey ), name( aName ), path( aPath ) {}
+	};
+
+	FontInfo 						getFontInfo( const std::string& fontName ) const;
+
+private:
+	SdfTextManager();
+
+	static SdfTextManager			*sInstance;
+
+	FT_Library						mLibrary = nullptr;
+	bool							mFontsEnumerated = false;
+	std::vector<std::string>		mFontNames;
+	std::vector<FontInfo>			mFontInfos;
+	std::set<FT_Face>				mTrackedFaces;
+	mutable SdfText::Font			mDefault;
+
+	SdfText::TextureAtlas::AtlasCacher		mTrackedTextureAtlases;
+
+	void							acquireFontNamesAndPaths();
+	void							faceCreated( FT_Face face );
+	void							faceDestroyed( FT_Face face );
+
+	SdfText::TextureAtlasRef		getTextureAtlas( FT_Face face, const SdfText::Format &format, const std::string &utf8Chars, const std::vector<SdfText::Font::Glyph> &glyphIndices );
+
+	friend class SdfText;
+	friend class SdfText::FontData;
+	friend bool SdfTextFontManager_destroyStaticInstance();
+};
+
+// =================================================================================================
+// SdfTextBox
+// =================================================================================================
+class SdfTextBox {
+public:
+	enum { GROW = 0 };
+	
+	SdfTextBox( const SdfText *sdfText ) : mSdfText( sdfText ), mAlign( SdfText::LEFT ), mSize( GROW, GROW ), mInvalid( true ), mLigate( true ) {}
+
+	SdfTextBox&				size( ivec2 sz ) { setSize( sz ); return *this; }
+	SdfTextBox&				size( int width, int height ) { setSize( ivec2( width, height ) ); return *this; }
+	ivec2					getSize() const { return mSize; }
+	void					setSize( ivec2 sz ) { mSize = sz; mInvalid = true; }
+
+	SdfTextBox&				text( const std::string &t ) { setText( t ); return *this; }
+	const std::string&		getText() const { return mText; }
+	void					setText( const std::string &t ) { mText = t; mInvalid = true; }
+	void					appendText( const std::string &t ) { mText += t; mInvalid = true; }
+
+	SdfTextBox&				ligate( bool ligateText = true ) { setLigate( ligateText ); return *this; }
+	bool					getLigate() const { return mLigate; }
+	void					setLigate( bool ligateText ) { mLigate = ligateText; }
+
+	SdfTextBox&				alignment( SdfText::Alignment align ) { setAlignment( align ); return *this; }
+	SdfText::Alignment		getAlignment() const { return mAlign; }
+	void					setAlignment( SdfText::Alignment align ) { mAlign = align; mInvalid = true; }
+
+	//! Sets the width that lines are wrapped and aligned to, overriding the width of size()
+	SdfTextBox&				wrapWidth( float width ) { setWrapWidth( width ); return *this; }
+	float					getWrapWidth() const { return ( mWrapWidth >= 0.0f ) ? mWrapWidth : static_cast<float>( mSize.x ); }
+	void					setWrapWidth( float width ) { mWrapWidth = width; mInvalid = true; }
+
+	//! Returns the lines of the text measured with \a tables. If \a maxFitWidth and \a minOverflowWidth are set they receive the widest candidate line that fit and the narrowest that did not, the line breaks stay the same for wrap widths in [maxFitWidth, minOverflowWidth).
+	ScratchVector<std::string>			calculateLineBreaks( const SdfText::GlyphTables &tables, float *maxFitWidth = nullptr, float *minOverflowWidth = nullptr, float extraAdvance = 0.0f ) const;
+	SdfText::Font::GlyphMeasuresList	measureGlyphs( const SdfText::DrawOptions& drawOptions, float *maxFitWidth = nullptr, float *minOverflowWidth = nullptr ) const;
+	//! Lays out the glyphs into \a result, a GlyphMeasuresList or the ScratchVector of an internal layout call
+	template <typename GlyphMeasuresT>
+	void								measureGlyphs( const SdfText::DrawOptions& drawOptions, GlyphMeasuresT *result, float *maxFitWidth = nullptr, float *minOverflowWidth = nullptr ) const;
+	//! Lays out the glyphs with \a tables, the snapshot that the caller keeps reading for the rest of its pass
+	template <typename GlyphMeasuresT>
+	void								measureGlyphs( const SdfText::GlyphTables &tables, const SdfText::DrawOptions& drawOptions, GlyphMeasuresT *result, float *maxFitWidth = nullptr, float *minOverflowWidth = nullptr ) const;
+
+private:
+	const SdfText		*mSdfText = nullptr;
+	SdfText::Alignment	mAlign;
+	ivec2				mSize;
+	std::string			mText;
+	bool				mLigate;
+	float				mWrapWidth = -1.0f;
+	mutable bool		mInvalid;
+};
+
+// =================================================================================================
+// SdfTexttManager Implementation
+// =================================================================================================
+SdfTextManager* SdfTextManager::sInstance = nullptr;
+
+bool SdfTextFontManager_destroyStaticInstance() 
+{
+	if( nullptr != SdfTextManager::sInstance ) {
+		delete SdfTextManager::sInstance;
+		SdfTextManager::sInstance = nullptr;
+	}
+	return true;
+}
+
+SdfTextManager::SdfTextManager()
+{
+	FT_Error ftRes = FT_Init_FreeType( &mLibrary );
+	if( FT_Err_Ok != ftRes ) {
+		throw FontInvalidNameExc("Failed to initialize FreeType2");
+	}
+
+	acquireFontNamesAndPaths();
+#if defined( CINDER_MSW )
+	// Registry operations can be rejected by Windows so no fonts will be picked up 
+	// on the initial scan. So we can multiple times.
+	if( mFontInfos.empty() ) {
+		for( int i = 0; i < 5; ++i ) {
+			acquireFontNamesAndPaths();
+			if( ! mFontInfos.empty() ) {
+				break;
+			}
+			::Sleep( 10 );
+		}
+	}
+#endif
+}
+
+SdfTextManager::~SdfTextManager()
+{
+	if( nullptr != mLibrary ) {
+		for( auto& face : mTrackedFaces ) {
+			FT_Done_Face( face );
+		}
+
+		FT_Done_FreeType( mLibrary );
+	}
+
+#if defined( CINDER_MAC )
+#elif defined( CINDER_WINRT )
+#elif defined( CINDER_ANDROID ) || defined( CINDER_LINUX )
+#endif
+}
+
+SdfTextManager* SdfTextManager::instance()
+{
+	if( nullptr == SdfTextManager::sInstance ) {
+		SdfTextManager::sInstance =  new SdfTextManager();
+		if( nullptr != SdfTextManager::sInstance ) {
+			ci::app::App::get()->getSignalShouldQuit().connect( SdfTextFontManager_destroyStaticInstance );
+		}
+	}
+	
+	return SdfTextManager::sInstance;
+}
+
+#if defined( CINDER_MAC )
+void SdfTextManager::acquireFontNamesAndPaths()
+{
+	NSFontManager *nsFontManager = [NSFontManager sharedFontManager];
+    NSArray *nsFontNames = [nsFontManager availableFonts];
+    for( NSString *nsFontName in nsFontNames ) {
+        std::string fontName = std::string( [nsFontName UTF8String] );
+        mFontNames.push_back( fontName );
+        
+        CTFontDescriptorRef ctFont = CTFontDescriptorCreateWithNameAndSize( (__bridge CFStringRef)nsFontName, (CGFloat)24 );
+        CFURLRef url = (CFURLRef)CTFontDescriptorCopyAttribute( ctFont, kCTFontURLAttribute );
+        NSString *nsFontPath = [NSString stringWithString:[(NSURL *)CFBridgingRelease(url) path]];
+        std::string fontFilePath = std::string( [nsFontPath UTF8String] );
+        
+        if( fs::exists( fontFilePath ) ) {
+			std::string fontKey = boost::to_lower_copy( fontName );
+			auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
+				[fontKey]( const FontInfo& elem ) -> bool {
+					return elem.key == fontKey;
+				}
+			);
+			if( std::end( mFontInfos ) == it ) {
+                // Build font info
+                FontInfo fontInfo = FontInfo( fontKey, fontName, fontFilePath );
+                mFontInfos.push_back( fontInfo );
+                mFontNames.push_back( fontName );
+            }
+        }
+    }
+}
+#elif defined( CINDER_COCOA_TOUCH )
+void SdfTextManager::acquireFontNamesAndPaths()
+{
+    NSArray *nsFamilyNames = [UIFont familyNames];
+    for( NSString *nsFamilyName in nsFamilyNames ) {
+        NSArray *nsFontNames = [UIFont fontNamesForFamilyName:nsFamilyName];
+        for( NSString *nsFontName in nsFontNames ) {
+            std::string fontName = std::string( [nsFontName UTF8String] );
+            mFontNames.push_back( fontName );
+            
+            CTFontDescriptorRef ctFont = CTFontDescriptorCreateWithNameAndSize( (__bridge CFStringRef)nsFontName, (CGFloat)24 );
+            CFURLRef url = (CFURLRef)CTFontDescriptorCopyAttribute( ctFont, kCTFontURLAttribute );
+            NSString *nsFontPath = [NSString stringWithString:[(NSURL *)CFBridgingRelease(url) path]];
+            std::string fontFilePath = std::string( [nsFontPath UTF8String] );
+            
+            if( fs::exists( fontFilePath ) ) {
+                std::string fontKey = boost::to_lower_copy( fontName );
+                auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
+                    [fontKey]( const FontInfo& elem ) -> bool {
+                        return elem.key == fontKey;
+                    }
+                );
+                if( std::end( mFontInfos ) == it ) {
+                    // Build font info
+                    FontInfo fontInfo = FontInfo( fontKey, fontName, fontFilePath );
+                    mFontInfos.push_back( fontInfo );
+                    mFontNames.push_back( fontName );
+                }
+            }
+        }
+    }
+}
+#elif defined( CINDER_MSW )
+void SdfTextManager::acquireFontNamesAndPaths()
+{
+	static const LPWSTR kFontRegistryPath = L"Software\\Microsoft\\Windows NT\\CurrentVersion\\Fonts";
+
+	// Open Windows font registry key
+	HKEY hKey = nullptr;
+	LONG result = RegOpenKeyEx( HKEY_LOCAL_MACHINE, kFontRegistryPath, 0, KEY_READ, &hKey );
+	if( ERROR_SUCCESS != result ) {
+		return;
+	}
+	
+	// Get info for registry key
+	DWORD maxValueNameSize, maxValueDataSize;
+	result = RegQueryInfoKey( hKey, 0, 0, 0, 0, 0, 0, 0, &maxValueNameSize, &maxValueDataSize, 0, 0 );
+	if( ERROR_SUCCESS != result ) {
+		return;
+	}
+
+	DWORD valueIndex = 0;
+	LPWSTR valueName = new WCHAR[maxValueNameSize];
+	LPBYTE valueData = new BYTE[maxValueDataSize];
+	DWORD valueNameSize, valueDataSize, valueType;
+
+	// Enumerate registry keys
+	do {
+		valueNameSize = maxValueNameSize;
+		valueDataSize = maxValueDataSize;
+
+		// Clear the buffers
+		std::memset( valueName, 0, maxValueNameSize*sizeof( WCHAR ) );
+		std::memset( valueData, 0, maxValueDataSize*sizeof( BYTE ) );
+
+		// Read registry key values
+		result = RegEnumValue( hKey, valueIndex, valueName, &valueNameSize, 0, &valueType, valueData, &valueDataSize );
+		++valueIndex;
+
+		// Bail if read fails
+		if( ( ERROR_SUCCESS != result ) || ( REG_SZ != valueType ) ) {
+			continue;
+		}
+
+		// Build font info
+		const std::string kTrueTypeTag = "(TrueType)";
+		// Font name
+		std::wstring wsFontName = std::wstring( valueName, valueNameSize );
+		std::string fontName = ci::toUtf8( reinterpret_cast<const char16_t *>( wsFontName.c_str() ), wsFontName.length() * sizeof( char16_t ) );
+		// Font file path
+		//std::wstring wsFontFilePath = std::wstring( reinterpret_cast<LPWSTR>( valueData ), valueDataSize );
+		std::wstring wsFontFilePath;
+		for( size_t i = 0; i < valueDataSize; ++i ) {
+			WCHAR ch = reinterpret_cast<LPWSTR>( valueData )[i];
+			if( 0 == ch ) {
+				break;
+			}
+			wsFontFilePath.push_back( ch );		
+		}
+		std::string fontFilePath = ci::toUtf8( reinterpret_cast<const char16_t *>( wsFontFilePath.c_str() ), wsFontFilePath.length() * sizeof( char16_t ) );
+		// Process True Type font
+		if( std::string::npos != fontName.find( kTrueTypeTag ) ) {
+			boost::replace_all( fontName, kTrueTypeTag, "" );
+			boost::trim( fontName );
+			std::string fontKey = boost::to_lower_copy( fontName );
+			auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
+				[fontKey]( const FontInfo& elem ) -> bool {
+					return elem.key == fontKey;
+				}
+			);
+			if( std::end( mFontInfos ) == it ) {
+				fontFilePath = "C:\\Windows\\Fonts\\" + fontFilePath;
+				if( fs::exists( fontFilePath ) ) {
+					// Build font info
+					FontInfo fontInfo = FontInfo( fontKey, fontName, fontFilePath );
+					mFontInfos.push_back( fontInfo );
+					mFontNames.push_back( fontName );
+				}
+			}
+		}
+	} 
+	while( ERROR_NO_MORE_ITEMS != result  );
+
+	delete [] valueName;
+	delete [] valueData;
+}
+#elif defined( CINDER_WINRT ) 
+void SdfTextManager::acquireFontNamesAndPaths()
+{
+}
+#elif defined( CINDER_ANDROID )
+void SdfTextManager::acquireFontNamesAndPaths()
+{
+	fs::path systemFontDir = "/system/fonts";
+	if( fs::exists( systemFontDir ) && fs::is_directory( systemFontDir ) ) {
+		fs::directory_iterator end_iter;
+		for( fs::directory_iterator dir_iter( systemFontDir ) ; dir_iter != end_iter ; ++dir_iter ) {
+			if( fs::is_regular_file( dir_iter->status() ) ) {
+				fs::path fontPath = dir_iter->path();
+
+				FT_Face tmpFace;
+				FT_Error error = FT_New_Face( mLibrary, fontPath.string().c_str(), 0, &tmpFace );
+				if( error ) {
+					continue;
+				}
+
+				std::string fontName = ci::linux::ftutil::GetFontName( tmpFace, fontPath.stem().string() );
+				std::string keyName = fontName;
+				std::transform( keyName.begin(), keyName.end(), keyName.begin(), [](char c) -> char { return (c >= 'A' && c <='Z') ? (c + 32) : c; } );
+				mFontInfos.push_back( FontInfo( keyName, fontName, fontPath ) );
+
+				const std::string regular = "regular";
+				size_t startPos = keyName.find( regular );
+				if( std::string::npos != startPos ) {
+					keyName.replace( startPos, regular.length(), "" );
+					mFontInfos.push_back( FontInfo( keyName, fontName, fontPath ) );
+				} 	
+
+				FT_Done_Face( tmpFace );
+			}
+		}
+	}
+}
+#elif defined( CINDER_LINUX )
+void SdfTextManager::acquireFontNamesAndPaths()
+{
+	if( ::FcInit() ) {
+		::FcPattern   *pat = ::FcPatternCreate();
+		::FcObjectSet *os  = ::FcObjectSetBuild( FC_FILE, FC_FAMILY, FC_STYLE, (char *)0 );
+		::FcFontSet   *fs  = ::FcFontList (0, pat, os);
+	
+		for( size_t i = 0; i < fs->nfont; ++i ) {
+			//::FcPattern *font = fs->fonts[i];
+			//::FcChar8 *family = nullptr;
+			//if( ::FcPatternGetString( font, FC_FAMILY, 0, &family ) == FcResultMatch ) {					
+			//	std::cout << "Found font family: " << family << std::endl;
+			//	//string fontName = std::string( (const char*)family );
+			//	//mFontNames.push_back( fontName );
+			//}
+
+			::FcPattern *fcFont = fs->fonts[i];
+			::FcChar8 *fcFileName = nullptr;
+			if( ::FcResultMatch == ::FcPatternGetString( fcFont, FC_FILE, 0, &fcFileName ) ) {
+				std::string fontFilePath = std::string( (const char*)fcFileName );
+				
+				// Skip anything that isn't ttf or otf
+				std::string lcfn = boost::to_lower_copy( fontFilePath );
+				boost::trim( lcfn );
+				if( ! ( boost::ends_with( lcfn, ".ttf" ) || boost::ends_with( lcfn, ".otf" ) ) ) {
+					continue;
+				}
+
+				::FcChar8 *fcFamily = nullptr;
+				::FcChar8 *fcStyle = nullptr;
+				::FcResult fcFamilyRes = ::FcPatternGetString( fcFont, FC_FAMILY, 0, &fcFamily );
+				::FcResult fcStyleRes = ::FcPatternGetString( fcFont, FC_STYLE, 0, &fcStyle );
+				if( ( ::FcResultMatch != fcFamilyRes ) || ( ::FcResultMatch != fcStyleRes ) ) {
+					continue;
+				}
+
+				std::string family = std::string( (const char*)fcFamily );
+				std::string style = std::string( (const char*)fcStyle );
+				std::string fontName = family + ( style.empty() ? "" : ( " " + style ) );
+				
+				std::string fontKey = boost::to_lower_copy( fontName );
+				auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
+					[fontKey]( const FontInfo& elem ) -> bool {
+						return elem.key == fontKey;
+					}
+				);
+				if( std::end( mFontInfos ) == it ) {
+					if( fs::exists( fontFilePath ) ) {
+						// Build font info
+						FontInfo fontInfo = FontInfo( fontKey, fontName, fontFilePath );
+						mFontInfos.push_back( fontInfo );
+						mFontNames.push_back( fontName );
+					}
+				}
+
+				//std::cout << fcFamily << " " << fcStyle << " : " << fontFilePath << std::endl;
+
+				/*
+				DataSourceRef dataSource = ci::loadFile( fontFilePath );
+				if( ! dataSource ) {
+					throw FontLoadFailedExc( "Couldn't find file for " + aName );
+				}
+
+				mFileData = dataSource->getBuffer();
+				FT_Error error = FT_New_Memory_Face(
+					FontManager::instance()->mLibrary, 
+					(FT_Byte*)mFileData->getData(), 
+					mFileData->getSize(), 
+					0, 
+					&mFace
+				);
+				if( error ) {
+					throw FontInvalidNameExc( "Failed to create a face for " + aName );
+				}
+
+				FT_Select_Charmap( mFace, FT_ENCODING_UNICODE );
+				FT_Set_Char_Size( mFace, 0, (int)aSize * 64, 0, 72 );
+				*/
+			}			
+		}
+
+		::FcObjectSetDestroy( os );
+		::FcPatternDestroy( pat );
+		::FcFontSetDestroy( fs );
+
+		::FcFini();
+	}
+}
+#endif
+
+void SdfTextManager::faceCreated( FT_Face face ) 
+{
+	mTrackedFaces.insert( face );
+}
+
+void SdfTextManager::faceDestroyed( FT_Face face ) 
+{
+	mTrackedFaces.erase( face );
+}
+
+SdfText::TextureAtlasRef SdfTextManager::getTextureAtlas( FT_Face face, const SdfText::Format &format, const std::string &utf8Chars, const std::vector<SdfText::Font::Glyph> &glyphIndices )
+{
+	std::u32string utf32Chars = ci::toUtf32( utf8Chars );
+	// Add a space if needed
+	if( std::string::npos == utf8Chars.find( ' ' ) ) {
+		utf32Chars += ci::toUtf32( " " );
+	}
+
+	// Build the maps and information pieces that will be needed later
+	vec2 maxGlyphSize = vec2( 0 );
+	for( const auto& ch : utf32Chars ) {
+		FT_UInt glyphIndex = FT_Get_Char_Index( face, static_cast<FT_ULong>( ch ) );
+		// Glyph bounds, 
+		msdfgen::Shape shape;
+		if( msdfgen::loadGlyph( shape, face, glyphIndex ) ) {
+			double l, b, r, t;
+			l = b = r = t = 0.0;
+			shape.bounds( l, b, r, t );
+			// Glyph bounds
+			Rectf bounds = Rectf( 
+				static_cast<float>( l ), 
+				static_cast<float>( b ), 
+				static_cast<float>( r ), 
+				static_cast<float>( t ) );
+			// Max glyph size
+			maxGlyphSize.x = std::max( maxGlyphSize.x, bounds.getWidth() );
+			maxGlyphSize.y = std::max( maxGlyphSize.y, bounds.getHeight() );
+		}	
+	}
+	// Embedded glyphs contribute to the tile size
+	for( const auto& glyphIndex : SdfText::TextureAtlas::getSizingGlyphs( face, format ) ) {
+		msdfgen::Shape shape;
+		if( msdfgen::loadGlyph( shape, face, glyphIndex ) ) {
+			double l, b, r, t;
+			l = b = r = t = 0.0;
+			shape.bounds( l, b, r, t );
+			maxGlyphSize.x = std::max( maxGlyphSize.x, static_cast<float>( r - l ) );
+			maxGlyphSize.y = std::max( maxGlyphSize.y, static_cast<float>( t - b ) );
+		}
+	}
+	
+	SdfText::TextureAtlas::CacheKey key;
+	key.mFamilyName = std::string( face->family_name );
+	key.mStyleName = std::string( face->style_name );
+	key.mUtf8Chars = utf8Chars;
+	key.mAutoTextureSize = format.getAutoTextureSize();
+	key.mTextureSize = key.mAutoTextureSize ? ivec2( format.getMaxTextureSize() ) : format.getTextureSize();
+	key.mSdfBitmapSize = SdfText::TextureAtlas::calculateSdfBitmapSize( format.getSdfScale(), format.getSdfPadding(), maxGlyphSize );
+	key.mSingleChannel = format.getSingleChannel() || format.getCompressed();
+	key.mCompressed = format.getCompressed();
+	// Atlases built under another cost guard have other tiles degraded
+	key.mGlyphCostLimit = format.getGlyphCostLimit();
+	key.mGlyphCostFallback = format.getGlyphCostFallback();
+	for( const auto& str : format.getPageCorpus() ) {
+		key.mPageCorpusHash = hashBytes( str.data(), str.size() + 1, key.mPageCorpusHash );
+	}
+	// The manager outlives any caller's resource, so only atlases on the global heap are kept for sharing
+	SdfText::MemoryResource *memoryResource = format.getMemoryResource() ? format.getMemoryResource() : SdfText::getMemoryResource();
+	if( memoryResource != SdfText::newDeleteResource() ) {
+		return SdfText::TextureAtlas::create( face, format, glyphIndices );
+	}
+
+	// Result
+	SdfText::TextureAtlasRef result;
+	// Look for the texture atlas 
+	auto it = std::find_if( std::begin( mTrackedTextureAtlases ), std::end( mTrackedTextureAtlases ),
+		[key]( const std::pair<SdfText::TextureAtlas::CacheKey, SdfText::TextureAtlasRef>& elem ) -> bool {
+			return elem.first == key;
+		}
+	);
+	// Use the texture atlas if a matching one is found
+	if( mTrackedTextureAtlases.end() != it ) {
+		result = it->second;
+	}
+	// ...otherwise build a new one
+	else {
+		result = SdfText::TextureAtlas::create( face, format, glyphIndices );
+		mTrackedTextureAtlases.push_back( std::make_pair( key, result ) );
+	}
+
+	return result;
+}
+
+SdfTextManager::FontInfo SdfTextManager::getFontInfo( const std::string& fontName ) const
+{
+	SdfTextManager::FontInfo result;
+
+#if defined( CINDER_MAC )
+#elif defined( CINDER_MSW ) || defined( CINDER_WINRT )
+	result.key  = "arial";
+	result.name = "Arial";
+	result.path = "C:\\Windows\\Fonts\\arial.ttf";
+#elif defined( CINDER_ANDROID )
+	result.key  = "roboto regular";
+	result.name = "Roboto Regular";
+	result.path = "/system/fonts/Roboto-Regular.ttf";
+#elif defined( CINDER_LINUX )	
+#endif
+
+	std::string lcfn = boost::to_lower_copy( fontName );
+	boost::trim( lcfn );
+
+	auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
+		[lcfn]( const SdfTextManager::FontInfo &elem ) -> bool {
+			return elem.key == lcfn;
+		}
+	);
+
+	if( std::end( mFontInfos ) != it ) {
+		result = *it;
+	}
+	else {
+		std::vector<std::string> tokens = ci::split( lcfn, ' ' );
+		float highScore = 0.0f;
+		for( const auto& fontInfos : mFontInfos ) {
+			int hits = 0;
+			for( const auto& tok : tokens ) {
+				if( std::string::npos != fontInfos.key.find( tok ) ) {
+					hits += static_cast<int>( tok.size() );	
+				}
+			}
+
+			if( hits > 0 ) {
+				std::vector<std::string> keyTokens = ci::split( fontInfos.key, ' ' );
+				float keyScore = ( keyTokens.size() == tokens.size() ) ? 0.25f : 0.0f;
+				float hitScore = static_cast<float>( hits ) / static_cast<float>( fontInfos.key.length() - ( keyTokens.size() - 1 ) );
+				hitScore = 0.75f * std::min( hitScore, 1.0f );
+				float totalScore = keyScore + hitScore;
+				if( totalScore > highScore ) {
+					highScore = totalScore;
+					result = fontInfos;
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+const std::vector<std::string>& SdfTextManager::getNames( bool forceRefresh )
+{
+	if( ( ! mFontsEnumerated ) || forceRefresh ) {
+		mFontInfos.clear();
+		mFontNames.clear();
+
+		acquireFontNamesAndPaths();
+#if defined( CINDER_MSW )
+		// Registry operations can be rejected by Windows so no fonts will be picked up 
+		// on the initial scan. So we can multiple times.
+		if( mFontInfos.empty() ) {
+			for( int i = 0; i < 5; ++i ) {
+				acquireFontNamesAndPaths();
+				if( ! mFontInfos.empty() ) {
+					break;
+				}
+				::Sleep( 10 );
+			}
+		}
+#endif        
+
+		mFontsEnumerated = true;
+	}
+
+/*
+	if( ( ! mFontsEnumerated ) || forceRefresh ) {
+		mFontNames.clear();
+#if defined( CINDER_MAC )
+		NSArray *fontNames = [nsFontManager availableFonts];
+		for( NSString *fontName in fontNames ) {
+			mFontNames.push_back( string( [fontName UTF8String] ) );
+		}
+#elif defined( CINDER_COCOA_TOUCH )
+		NSArray *familyNames = [UIFont familyNames];
+		for( NSString *familyName in familyNames ) {
+			NSArray *fontNames = [UIFont fontNamesForFamilyName:familyName];
+			for( NSString *fontName in fontNames ) {
+				mFontNames.push_back( string( [fontName UTF8String] ) );
+			}
+		}
+#elif defined( CINDER_MSW )
+	acquireFontPaths();
+	// Registry operations can be rejected by Windows so no fonts will be picked up 
+	// on the initial scan. So we can multiple times.
+	if( mFontInfos.empty() ) {
+		for( int i = 0; i < 5; ++i ) {
+			acquireFontPaths();
+			if( ! mFontInfos.empty() ) {
+				break;
+			}
+			::Sleep( 10 );
+		}
+	}
+#elif defined( CINDER_WINRT )
+		Platform::Array<Platform::String^>^ fontNames = FontEnumeration::FontEnumerator().ListSystemFonts();
+		for( unsigned i = 0; i < fontNames->Length; ++i ) {
+			const wchar_t *start = fontNames[i]->Begin();
+			const wchar_t *end = fontNames[i]->End();
+			mFontNames.push_back(std::string(start, end));
+		}
+#elif defined( CINDER_ANDROID )
+		std::set<std::string> uniqueNames;
+		for( const auto& fontInfos : mFontInfos ) {
+			uniqueNames.insert( fontInfos.name );
+		}
+
+		for( const auto& name : uniqueNames ) {
+			mFontNames.push_back( name );
+		}
+#elif defined( CINDER_LINUX )
+		if( ::FcInit() ) {
+			::FcPattern   *pat = ::FcPatternCreate();
+			::FcObjectSet *os  = ::FcObjectSetBuild( FC_FILE, FC_FAMILY, FC_STYLE, (char *)0 );
+			::FcFontSet   *fs  = ::FcFontList (0, pat, os);
+		
+			for( size_t i = 0; i < fs->nfont; ++i ) {
+				::FcPattern *font = fs->fonts[i];
+				::FcChar8 *family = nullptr;
+				if( ::FcPatternGetString( font, FC_FAMILY, 0, &family ) == FcResultMatch ) 
+				{					
+					string fontName = std::string( (const char*)family );
+					mFontNames.push_back( fontName );
+				}
+			}
+
+			::FcObjectSetDestroy( os );
+			::FcPatternDestroy( pat );
+			::FcFontSetDestroy( fs );
+
+			::FcFini();
+		}
+#endif
+		mFontsEnumerated = true;
+	}
+*/	
+
+	return mFontNames;
+}
+
+SdfText::Font SdfTextManager::getDefault() const
+{
+	if( ! mDefault ) {
+#if defined( CINDER_COCOA )        
+		mDefault = SdfText::Font( "Helvetica", 32.0f );
+#elif defined( CINDER_MSW ) || defined( CINDER_WINRT )
+		mDefault = SdfText::Font( "Arial", 32.0f );
+#elif defined( CINDER_ANDROID ) || defined( CINDER_LINUX )
+		mDefault = SdfText::Font( "Roboto", 32.0f );
+#endif
+	}
+
+	return mDefault;
+}
+
+// =================================================================================================
+// SdfTextBox Implementation
+// =================================================================================================
+struct LineProcessor 
+{
+	LineProcessor( ScratchVector<std::string> *strings ) : mStrings( strings ) {}
+	void operator()( const char *line, size_t len ) const { mStrings->push_back( std::string( line, len ) ); }
+	mutable ScratchVector<std::string> *mStrings = nullptr;
+};
+
+struct LineMeasure 
+{
+	LineMeasure( float maxWidth, const SdfText::GlyphMetricsTable &cachedGlyphMetrics, const SdfText::CharToGlyphTable& charToGlyphMap, float *maxFitWidth = nullptr, float *minOverflowWidth = nullptr, float extraAdvance = 0.0f ) 
+		: mMaxWidth( maxWidth ), mCachedGlyphMetrics( cachedGlyphMetrics ), mCharToGlyphMap( charToGlyphMap ), mMaxFitWidth( maxFitWidth ), mMinOverflowWidth( minOverflowWidth ), mExtraAdvance( extraAdvance ) {}
+
+	bool operator()( const char *line, size_t len ) const {
+		if( mMaxWidth >= MAX_SIZE ) {
+			// too big anyway so just return true
+			return true;
+		}
+
+		SdfText::Font::Glyph subGlyphIndex = 0;
+		// Use space for glyph substitution 
+		{
+			auto glyphIndexIt = mCharToGlyphMap.find( static_cast<uint32_t>( ' ' ) );
+			if( mCharToGlyphMap.end() != glyphIndexIt ) {
+				subGlyphIndex = glyphIndexIt->second;
+			}
+		}
+
+		std::u32string utf32Chars = ci::toUtf32( std::string( line, len ) );
+		float measuredWidth = 0;
+		vec2 pen = { 0, 0 };
+		for( const auto& ch : utf32Chars ) {
+			auto glyphIndexIt = mCharToGlyphMap.find( static_cast<uint32_t>( ch ) );
+			if( mCharToGlyphMap.end() == glyphIndexIt ) {
+				continue;
+			}
+
+			SdfText::Font::Glyph glyphIndex = glyphIndexIt->second;
+			auto glyphMetricIt = mCachedGlyphMetrics.find( glyphIndex );
+			if( mCachedGlyphMetrics.end() == glyphMetricIt ) {
+				continue;
+			}
+
+			const vec2& advance = glyphMetricIt->second.advance;		
+			pen.x += advance.x + mExtraAdvance;
+			pen.y += advance.y;
+			measuredWidth = pen.x;
+		}
+
+		bool result = ( measuredWidth <= mMaxWidth );
+		// Record the widths at which the line breaks would change
+		if( result && ( nullptr != mMaxFitWidth ) ) {
+			*mMaxFitWidth = std::max( *mMaxFitWidth, measuredWidth );
+		}
+		else if( ( ! result ) && ( nullptr != mMinOverflowWidth ) ) {
+			*mMinOverflowWidth = std::min( *mMinOverflowWidth, measuredWidth );
+		}
+		return result;
+	}
+
+	float									mMaxWidth = 0;
+	const SdfText::GlyphMetricsTable	&mCachedGlyphMetrics;
+	const SdfText::CharToGlyphTable		&mCharToGlyphMap;
+	float									*mMaxFitWidth = nullptr;
+	float									*mMinOverflowWidth = nullptr;
+	float									mExtraAdvance = 0.0f;
+};
+
+ScratchVector<std::string> SdfTextBox::calculateLineBreaks( const SdfText::GlyphTables &tables, float *maxFitWidth, float *minOverflowWidth, float extraAdvance ) const
+{
+	const auto& charToGlyph = tables.mCharToGlyph;
+	const auto& glyphMetrics = tables.mGlyphMetrics;
+	const float wrapWidth = getWrapWidth();
+
+	ScratchVector<std::string> result;
+	std::function<void(const char *,size_t)> lineFn = LineProcessor( &result );		
+	lineBreakUtf8( mText.c_str(), LineMeasure( ( wrapWidth > 0 ) ? wrapWidth : MAX_SIZE, glyphMetrics, charToGlyph, maxFitWidth, minOverflowWidth, extraAdvance ), lineFn );
+	return result;
+}
+
+SdfText::Font::GlyphMeasuresList SdfTextBox::measureGlyphs( const SdfText::DrawOptions& drawOptions, float *maxFitWidth, float *minOverflowWidth ) const
+{
+	SdfText::Font::GlyphMeasuresList result;
+	measureGlyphs( drawOptions, &result, maxFitWidth, minOverflowWidth );
+	return result;
+}
+
+template <typename GlyphMeasuresT>
+void SdfTextBox::measureGlyphs( const SdfText::DrawOptions& drawOptions, GlyphMeasuresT *result, float *maxFitWidth, float *minOverflowWidth ) const
+{
+	// Glyphs can be added while the text is laid out on another thread, the line breaks and the measures read the same tables
+	SdfText::GlyphTablesReader tables( mSdfText );
+	measureGlyphs( *tables, drawOptions, result, maxFitWidth, minOverflowWidth );
+}
+
+template <typename GlyphMeasuresT>
+void SdfTextBox::measureGlyphs( const SdfText::GlyphTables &tables, const SdfText::DrawOptions& drawOptions, GlyphMeasuresT *result, float *maxFitWidth, float *minOverflowWidth ) const
+{
+	if( mText.empty() ) {
+		return;
+	}
+
+	const auto& font = mSdfText->getFont();
+	const float fontSizeScale = font.getSize() / 32.0f;
+	const float ascent        = font.getAscent();
+	const float descent       = font.getDescent();
+	const float leading       = drawOptions.getLeading();
+	const float drawScale	  = drawOptions.getScale();
+	const auto  align         = drawOptions.getAlignment();
+	const float lineHeight    = fontSizeScale * drawScale * ( ascent + descent + leading );
+
+	const float wrapWidth     = getWrapWidth();
+	// Synthetic bold grows the outline on both sides of every glyph
+	const float embolden      = mSdfText->getEmbolden( drawOptions );
+	const vec2  emboldenGrow  = vec2( 2.0f * embolden, 0.0f );
+
+	// Calculate the line breaks
+	ScratchVector<std::string> mLines = calculateLineBreaks( tables, maxFitWidth, minOverflowWidth, emboldenGrow.x );
+	if( mLines.empty() ) {
+		return;
+	}
+
+	// Build measures
+	const auto& charToGlyph = tables.mCharToGlyph;
+	const auto& glyphMetrics = tables.mGlyphMetrics;
+	std::u32string utf32Chars, nextUtf32Chars;
+	float curY = 0;
+
+	for( ScratchVector<std::string>::const_iterator lineIt = mLines.begin(); lineIt != mLines.end(); ++lineIt ) {
+		// Fetch current line and prefetch next. This way we can look ahead.
+		if( nextUtf32Chars.empty() ) {
+			utf32Chars = ci::toUtf32( boost::algorithm::trim_right_copy( *lineIt ) );
+		}
+		else {
+			std::swap( utf32Chars, nextUtf32Chars );
+		}
+
+		if( ( lineIt + 1 ) != mLines.end() ) {
+			nextUtf32Chars = ci::toUtf32( boost::algorithm::trim_right_copy( *( lineIt + 1 ) ) );
+		}
+		else {
+			nextUtf32Chars.clear();
+		}
+
+		// Layout current line of text.
+		size_t               index = result->size();
+		size_t               spaceCount = 0;
+		size_t               glyphCount = 0;
+		SdfText::Font::Glyph spaceIndex = ~0;
+		SdfText::Font::Glyph glyphIndex = ~0;
+		vec2                 advance = vec2( 0 );
+		vec2                 adjust = vec2( 0 );
+
+		vec2 pen = { 0, 0 };
+		for( const auto& ch : utf32Chars ) {
+			auto glyphIndexIt = charToGlyph.find( static_cast<uint32_t>( ch ) );
+			if( charToGlyph.end() == glyphIndexIt ) {
+				continue;
+			}
+			 
+			glyphIndex = glyphIndexIt->second;
+			auto glyphMetricIt = glyphMetrics.find( glyphIndex );
+			if( glyphMetrics.end() == glyphMetricIt ) {
+				continue;
+			}
+
+			advance = glyphMetricIt->second.advance + emboldenGrow;
+			adjust = advance - ( glyphMetricIt->second.maximum + emboldenGrow );
+
+			glyphCount++;
+			if( ch == 32 ) {
+				spaceCount++;
+				spaceIndex = glyphIndex;
+			}
+
+			float xPos = pen.x + embolden;
+			result->push_back( std::make_pair( (uint32_t)glyphIndex, vec2( xPos, curY ) ) );
+
+			pen += advance;
+		}
+
+		// Apply alignment as a post-process.
+		bool aligned = false;
+		if( drawOptions.getJustify() ) {
+			const bool isLastLine = nextUtf32Chars.empty();
+			if( spaceCount > 0 && !isLastLine ) {
+				float space = ( wrapWidth - ( pen.x + advance.x - adjust.x ) );
+				float offset = 0.0f;
+				for( size_t i = index; i < result->size(); ++i ) {
+					( *result )[i].second.x += offset;
+					// 75% of the extra spacing comes from adjusting every character.
+					offset += ( 0.75f * space ) / glyphCount;
+					if( ( *result )[i].first == spaceIndex ) {
+						// 25% of the extra spacing comes from adjusting white space characters only.
+						offset += ( 0.25f * space ) / spaceCount;
+					}
+				}
+				aligned = true;
+			}
+		}
+
+		if( ! aligned ){
+			switch( align ) {
+				case SdfText::LEFT:
+				break;
+				case SdfText::CENTER: {
+					float offset = ( wrapWidth - ( pen.x + advance.x - adjust.x ) ) * 0.5f;
+					if( offset > 0.0f ) {
+						for( size_t i = index; i < result->size(); ++i )
+							( *result )[i].second.x += offset;
+					}
+				}
+				break;
+				case SdfText::RIGHT: {
+					float offset = ( wrapWidth - ( pen.x + advance.x - adjust.x ) );
+					if( offset > 0.0f ) {
+						for( size_t i = index; i < result->size(); ++i )
+							( *result )[i].second.x += offset;
+					}
+				}
+				break;
+			}
+		}
+
+		curY += lineHeight; 
+	}
+}
+
+// =================================================================================================
+// SdfText::FontData
+// =================================================================================================
+class SdfText::FontData {
+public:
+	FontData( const ci::DataSourceRef &dataSource ) {
+		if(! dataSource) {
+			return;
+		}
+
+		mFileData = dataSource->getBuffer();
+		if( ! mFileData ) {
+			return;
+		}
+
+		auto fontManager = SdfTextManager::instance();
+		if( nullptr != fontManager ) {
+			FT_Error ftRes = FT_New_Memory_Face(
+				fontManager->getLibrary(),
+				reinterpret_cast<FT_Byte*>( mFileData->getData() ),
+				static_cast<FT_Long>( mFileData->getSize() ),
+				0,
+				&mFace
+			);
+
+			if( FT_Err_Ok != ftRes ) {
+				throw std::runtime_error("Failed to load font data");
+			}
+
+			fontManager->faceCreated( mFace );
+		}
+	}
+
+	virtual ~FontData() {
+		auto fontManager = SdfTextManager::instance();
+		if( ( nullptr != fontManager ) && ( nullptr != mFace ) ) {
+			fontManager->faceDestroyed( mFace );
+		}
+	}
+
+	static SdfText::FontDataRef create( const ci::DataSourceRef &dataSource ) {
+		SdfText::FontDataRef result = SdfText::FontDataRef( new SdfText::FontData( dataSource ) );
+		return result;
+	}
+
+	FT_Face	getFace() const {
+		return mFace;
+	}
+
+private:
+	ci::BufferRef	mFileData;
+	FT_Face			mFace = nullptr;
+};
+
+// =================================================================================================
+// SdfText::Font
+// =================================================================================================
+SdfText::Font::Font( const std::string &name, float size )
+	: mName( name ), mSize( size )
+{
+	auto fontManager = SdfTextManager::instance();
+	if( nullptr != fontManager ) {
+		SdfTextManager::FontInfo info = fontManager->getFontInfo( name );
+		if( ! ci::fs::exists( info.path ) ) {
+			throw std::runtime_error( info.path.string() + " does not exist" );
+		}
+
+		auto dataSource = ci::loadFile( info.path );
+		loadFontData( dataSource );
+	}
+}
+
+SdfText::Font::Font( DataSourceRef dataSource, float size )
+	: mSize( size )
+{
+	if( dataSource->isFilePath() ) {
+		auto fontDataSource = ci::loadFile( dataSource->getFilePath() );
+		loadFontData( fontDataSource );
+	}
+	else {
+		loadFontData( dataSource );
+	}
+}
+
+SdfText::Font::~Font()
+{
+}
+
+void SdfText::Font::loadFontData( const ci::DataSourceRef &dataSource )
+{
+	mData = SdfText::FontData::create( dataSource );
+	FT_Select_Charmap( mData->getFace(), FT_ENCODING_UNICODE );
+
+	FT_F26Dot6 finalSize = static_cast<FT_F26Dot6>( mSize * 64.0f );
+	FT_Set_Char_Size( mData->getFace(), 0, finalSize , 0, 72 );
+
+	// Extract the name if needed
+	if( mName.empty() ) {
+		FT_SfntName sn = {};
+		if( FT_Err_Ok == FT_Get_Sfnt_Name( mData->getFace(), TT_NAME_ID_FULL_NAME, &sn ) ) {
+			// If full name isn't available use family and style name
+			if( sn.string_len > 0  && ( 0 == sn.string[0] ) ) {
+				// Fallback to this name
+				mName = "(Unknown)";
+				std::string familyName = mData->getFace()->family_name;
+				std::string styleName = mData->getFace()->style_name;
+				if( ! familyName.empty() ) {
+					mName = familyName;
+					if( ! styleName.empty() ) {
+						styleName += ( " " + styleName );
+					}
+				}
+			}
+			else {
+				mName = std::string( reinterpret_cast<const char *>( sn.string ), sn.string_len );
+			}
+		}
+	}
+
+	// Units per EM
+	mUnitsPerEm = mData->getFace()->units_per_EM;
+
+	// Glyph scale
+	float glyphScale = 2048.0f / static_cast<float>( mUnitsPerEm );
+
+	// Height
+	mHeight = glyphScale * ( mData->getFace()->height / 64.0f );
+
+	// Leading
+	mLeading = glyphScale * ( mData->getFace()->height - ( std::abs( mData->getFace()->ascender ) + std::abs( mData->getFace()->descender ) ) ) / 64.0f;
+
+	// Ascent
+	mAscent = glyphScale * std::fabs( mData->getFace()->ascender / 64.0f );
+
+	// Descent
+	mDescent = glyphScale * std::fabs( mData->getFace()->descender / 64.0f );
+}
+
+SdfText::Font::Glyph SdfText::Font::getGlyphIndex( size_t idx ) const
+{
+	return static_cast<SdfText::Font::Glyph>( idx );
+}
+
+SdfText::Font::Glyph SdfText::Font::getGlyphChar( char utf8Char ) const
+{
+	FT_UInt glyphIndex = FT_Get_Char_Index( mData->getFace(), static_cast<FT_ULong>( utf8Char ) );
+	return static_cast<SdfText::Font::Glyph>( glyphIndex );
+}
+
+std::vector<SdfText::Font::Glyph> SdfText::Font::getGlyphs( const std::string &utf8Chars ) const
+{
+	std::vector<SdfText::Font::Glyph> result;
+	// Convert to UTF32
+	std::u32string utf32Chars = ci::toUtf32( utf8Chars );
+	// Build the maps and information pieces that will be needed later
+	for( const auto& ch : utf32Chars ) {
+		FT_UInt glyphIndex = FT_Get_Char_Index( mData->getFace(), static_cast<FT_ULong>( ch ) );
+		result.push_back( static_cast<SdfText::Font::Glyph>( glyphIndex ) );
+	}
+	return result;
+}
+
+FT_Face SdfText::Font::getFace() const
+{
+	return mData ? mData->getFace() : nullptr;
+}
+
+const std::vector<std::string>& SdfText::Font::getNames( bool forceRefresh )
+{
+	return SdfTextManager::instance()->getNames( forceRefresh );
+}
+
+SdfText::Font SdfText::Font::getDefault()
+{
+	return SdfTextManager::instance()->getDefault();
+}
+
+// =================================================================================================
+// SdfText::UsageProfile
+// =================================================================================================
+
+//! Counts how often each glyph of an SdfText is drawn, on top of the char counts of a saved profile
+class SdfText::UsageProfile {
+public:
+	UsageProfile( const fs::path &filePath ) : mFilePath( filePath ) {}
+
+	const fs::path&	getFilePath() const { return mFilePath; }
+	bool			hasLoadedCounts() const { return ! mLoadedCounts.empty(); }
+
+	//! Reads the char counts of the profile file, a missing or unreadable file leaves them empty
+	void			read();
+	//! Adds the counts recorded since the last save, mapped to chars by \a glyphToChar, to the counts in the profile file and writes the sum. Other SdfText instances or runs sharing the file may have saved since it was read, their counts are kept.
+	void			save( const SdfText::GlyphToCharTable &glyphToChar );
+	//! Counts the glyphs in [\a glyphBegin, \a glyphEnd) of \a glyphMeasures
+	void			record( const SdfText::GlyphMeasuresView &glyphMeasures, size_t glyphBegin, size_t glyphEnd );
+	//! Returns the loaded counts plus the recorded ones mapped to chars by \a glyphToChar, most drawn first
+	std::vector<std::pair<SdfText::Font::Char, uint64_t>>	calcCharCounts( const SdfText::GlyphToCharTable &glyphToChar ) const;
+
+private:
+	//! Adds the char counts of the profile file to \a charCounts, throws if the file is unreadable
+	void			readCounts( std::unordered_map<SdfText::Font::Char, uint64_t> *charCounts ) const;
+	//! Writes \a charCounts to the profile file, most drawn first
+	void			write( const std::unordered_map<SdfText::Font::Char, uint64_t> &charCounts ) const;
+
+	fs::path												mFilePath;
+	mutable std::mutex										mMutex;
+	std::unordered_map<SdfText::Font::Char, uint64_t>		mLoadedCounts;
+	//! Counts recorded since the last save
+	std::unordered_map<SdfText::Font::Glyph, uint64_t>		mGlyphCounts;
+};
+
+//! Returns \a charCounts sorted most drawn first
+static std::vector<std::pair<SdfText::Font::Char, uint64_t>> sortCharCounts( const std::unordered_map<SdfText::Font::Char, uint64_t> &charCounts )
+{
+	std::vector<std::pair<SdfText::Font::Char, uint64_t>> result( charCounts.begin(), charCounts.end() );
+	std::sort( result.begin(), result.end(),
+		[]( const std::pair<SdfText::Font::Char, uint64_t> &a, const std::pair<SdfText::Font::Char, uint64_t> &b ) -> bool {
+			return ( a.second > b.second ) || ( ( a.second == b.second ) && ( a.first < b.first ) );
+		}
+	);
+	return result;
+}
+
+void SdfText::UsageProfile::read()
+{
+	try {
+		readCounts( &mLoadedCounts );
+	}
+	catch( const std::exception& e ) {
+		CI_LOG_W( "failed reading usage profile " << mFilePath << ": " << e.what() );
+		mLoadedCounts.clear();
+	}
+}
+
+void SdfText::UsageProfile::readCounts( std::unordered_map<SdfText::Font::Char, uint64_t> *charCounts ) const
+{
+	if( ! fs::exists( mFilePath ) ) {
+		return;
+	}
+	ci::IStreamRef is = ci::DataSourcePath::create( mFilePath )->createStream();
+	uint8_t ident[4];
+	is->readData( ident, 4 );
+	if( std::string( "SDFU" ) != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+		throw ci::Exception( "Usage profile ident not found" );
+	}
+	uint32_t version = 0;
+	uint32_t numChars = 0;
+	is->readLittle( &version );
+	if( 1 != version ) {
+		throw ci::Exception( "Unsupported usage profile version" );
+	}
+	is->readLittle( &numChars );
+	for( uint32_t i = 0; i < numChars; ++i ) {
+		uint32_t ch = 0;
+		uint64_t count = 0;
+		is->readLittle( &ch );
+		is->readLittle( &count );
+		( *charCounts )[static_cast<SdfText::Font::Char>( ch )] += count;
+	}
+}
+
+void SdfText::UsageProfile::save( const SdfText::GlyphToCharTable &glyphToChar )
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+
+	// Start from the file as it is now, a corrupt one is replaced
+	std::unordered_map<SdfText::Font::Char, uint64_t> charCounts;
+	try {
+		readCounts( &charCounts );
+	}
+	catch( const std::exception& e ) {
+		CI_LOG_W( "replacing unreadable usage profile " << mFilePath << ": " << e.what() );
+		charCounts.clear();
+	}
+	for( const auto& it : mGlyphCounts ) {
+		auto charIt = glyphToChar.find( it.first );
+		if( glyphToChar.end() != charIt ) {
+			charCounts[charIt->second] += it.second;
+		}
+	}
+	write( charCounts );
+
+	// The saved counts are in the file now, so the next save does not add them again
+	mLoadedCounts = charCounts;
+	mGlyphCounts.clear();
+}
+
+void SdfText::UsageProfile::write( const std::unordered_map<SdfText::Font::Char, uint64_t> &charCounts ) const
+{
+	// Write next to the profile and rename so that a crash never leaves a partial file, processes saving the same profile each write their own file
+	const fs::path tempPath = mFilePath.string() + "." + makeTempFileSuffix() + ".tmp";
+	{
+		auto os = ci::writeFile( tempPath, true )->getStream();
+		if( ! os ) {
+			throw ci::Exception( "Invalid usage profile file" );
+		}
+		const uint32_t version = 1;
+		const uint32_t numChars = static_cast<uint32_t>( charCounts.size() );
+		os->writeData( "SDFU", 4 );
+		os->writeLittle( version );
+		os->writeLittle( numChars );
+		for( const auto& it : sortCharCounts( charCounts ) ) {
+			os->writeLittle( static_cast<uint32_t>( it.first ) );
+			os->writeLittle( it.second );
+		}
+	}
+	fs::rename( tempPath, mFilePath );
+}
+
+void SdfText::UsageProfile::record( const SdfText::GlyphMeasuresView &glyphMeasures, size_t glyphBegin, size_t glyphEnd )
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	for( size_t i = glyphBegin; i < glyphEnd; ++i ) {
+		++mGlyphCounts[glyphMeasures[i].first];
+	}
+}
+
+std::vector<std::pair<SdfText::Font::Char, uint64_t>> SdfText::UsageProfile::calcCharCounts( const SdfText::GlyphToCharTable &glyphToChar ) const
+{
+	std::unordered_map<SdfText::Font::Char, uint64_t> charCounts;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		charCounts = mLoadedCounts;
+		for( const auto& it : mGlyphCounts ) {
+			auto charIt = glyphToChar.find( it.first );
+			if( glyphToChar.end() != charIt ) {
+				charCounts[charIt->second] += it.second;
+			}
+		}
+	}
+	return sortCharCounts( charCounts );
+}
+
+//! Returns the chars of \a charCounts that \a utf32Chars requests followed by the requested chars they miss. With \a deferCold
+//! the missing chars go to \a deferred instead, except for the space that line breaking relies on. Profiled chars that are
+//! not requested are left out, the profile may be shared with other char sets.
+static std::u32string orderCharsByUsage( const std::u32string &utf32Chars, const std::vector<std::pair<SdfText::Font::Char, uint64_t>> &charCounts, bool deferCold, std::u32string *deferred )
+{
+	const std::set<SdfText::Font::Char> requested( utf32Chars.begin(), utf32Chars.end() );
+	std::u32string result;
+	std::set<SdfText::Font::Char> hotChars;
+	for( const auto& it : charCounts ) {
+		if( requested.end() != requested.find( it.first ) ) {
+			result.push_back( it.first );
+			hotChars.insert( it.first );
+		}
+	}
+	for( const auto& ch : utf32Chars ) {
+		if( ! hotChars.insert( ch ).second ) {
+			continue;
+		}
+		if( deferCold && ( 32 != ch ) ) {
+			deferred->push_back( ch );
+		}
+		else {
+			result.push_back( ch );
+		}
+	}
+	return result;
+}
+
+// =================================================================================================
+// SdfText
+// =================================================================================================
+SdfText::SdfText( const SdfText::Font &font, const Format &format, const std::string &utf8Chars, bool generateSdf, bool metricsOnly )
+	: mFont( font ), mFormat( format ),
+	  mGlyphToChar( SdfText::GlyphToCharTable::allocator_type( format.getMemoryResource() ) )
+{
+	// The atlas and outlines built below keep the resource of the format
+	ScopedMemoryResource memScp( mGlyphToChar.get_allocator().getResource() );
+
+	if( generateSdf ) {
+		FT_Face face = font.getFace();
+		if( nullptr == face ) {
+			throw std::runtime_error( "null font face" );
+		}
+
+		// Convert characters from UTF8 to UTF32
+		std::u32string utf32Chars = ci::toUtf32( utf8Chars );
+		// Add a space if needed
+		if( std::string::npos == utf8Chars.find( ' ' ) ) {
+			utf32Chars += ci::toUtf32( " " );
+		}
+
+		// Chars drawn in earlier runs come first, the others can wait for addDeferredChars()
+		std::string atlasChars = utf8Chars;
+		if( ! format.getUsageProfile().empty() ) {
+			mUsage = UsageProfileRef( new UsageProfile( format.getUsageProfile() ) );
+			mUsage->read();
+			if( mUsage->hasLoadedCounts() ) {
+				utf32Chars = orderCharsByUsage( utf32Chars, mUsage->calcCharCounts( mGlyphToChar ), format.getDeferColdChars(), &mDeferredChars );
+				atlasChars = ci::toUtf8( utf32Chars );
+			}
+		}
+
+		// Build char/glyph maps
+		std::vector<SdfText::Font::Glyph> glyphIndices;
+		for( const auto &ch : utf32Chars ) {
+			// Lookup glyph index based on char
+			SdfText::Font::Glyph glyphIndex = static_cast<SdfText::Font::Glyph>( FT_Get_Char_Index( face, static_cast<FT_ULong>( ch ) ) );
+
+			// Unique glyph
+			auto it = std::find_if( std::begin( glyphIndices ), std::end( glyphIndices ),
+				[glyphIndex]( const SdfText::Font::Glyph &elem ) -> bool {
+					return ( elem == glyphIndex );
+				}
+			);
+			if( std::end( glyphIndices ) == it ) {
+				glyphIndices.push_back( glyphIndex );
+			}
+
+			// Character to glyph index and vice versa
+			mCharToGlyph[static_cast<SdfText::Font::Char>( ch )] = glyphIndex;
+			mGlyphToChar[glyphIndex] = static_cast<SdfText::Font::Char>( ch );
+		}
+
+		// Get texture atlas - will build if necessary
+		if( metricsOnly ) {
+			// Layout only reads the generation parameters and glyph bounds, makeDrawable() builds the atlas
+			mTextureAtlases = SdfText::TextureAtlas::createMetrics( face, format, glyphIndices );
+			mMetricsOnly = true;
+			mMetricsChars = atlasChars;
+			mMetricsGlyphs = glyphIndices;
+		}
+		else {
+			mTextureAtlases = SdfTextManager::instance()->getTextureAtlas( face, format, atlasChars, glyphIndices );
+		}
+
+		// Build glyph metrics
+		{
+			FT_Face face = mFont.getFace();
+			for( const auto &glyphIndex : glyphIndices ) {
+				mGlyphMetrics[glyphIndex] = loadGlyphMetrics( face, glyphIndex );
+			}
+		}
+
+		// Embed outlines if requested
+		if( format.getEmbedOutlines() ) {
+			mOutlines = SdfText::GlyphOutlines::create( face, glyphIndices, ci::toUtf32( format.getEmbedChars() ), mCharToGlyph );
+		}
+	}
+
+	publishGlyphTables();
+}
+
+SdfText::~SdfText()
+{
+	traceForget( this );
+
+	if( mUsage ) {
+		try {
+			saveUsageProfile();
+		}
+		catch( const std::exception& e ) {
+			CI_LOG_W( "failed saving usage profile " << mUsage->getFilePath() << ": " << e.what() );
+		}
+	}
+}
+
+SdfTextRef SdfText::create( const SdfText::Font &font, const Format &format, const std::string &supportedChars )
+{
+	SdfTextRef result = SdfTextRef( new SdfText( font, format, supportedChars ) );
+	return result;
+}
+
+SdfTextRef SdfText::createMetrics( const SdfText::Font &font, const Format &format, const std::string &utf8Chars )
+{
+	SdfTextRef result = SdfTextRef( new SdfText( font, format, utf8Chars, true, true ) );
+	return result;
+}
+
+void SdfText::makeDrawable()
+{
+	if( ! mMetricsOnly ) {
+		return;
+	}
+
+	ScopedMemoryResource memScp( mGlyphToChar.get_allocator().getResource() );
+	const SdfText::TextureAtlasRef metricsAtlas = mTextureAtlases;
+	if( mMetricsSource ) {
+		SdfTextRef full = loadImpl( mMetricsSource, mMetricsSourceSize, false );
+		mTextureAtlases = full->mTextureAtlases;
+		mMetricsSource.reset();
+	}
+	else {
+		FT_Face face = mFont.getFace();
+		if( nullptr == face ) {
+			throw ci::Exception( "Generating the texture atlas requires a font face" );
+		}
+		mTextureAtlases = SdfTextManager::instance()->getTextureAtlas( face, mFormat, mMetricsChars, mMetricsGlyphs );
+		mMetricsChars.clear();
+		mMetricsGlyphs.clear();
+	}
+	mMetricsOnly = false;
+	// Layout on other threads only reads the published tables, it moves to the new atlas with them
+	publishGlyphTables();
+
+	// Layout done before must stay valid, so the tiles have to be placed as they were measured
+	bool sameLayout = ( metricsAtlas->mSdfBitmapSize == mTextureAtlases->mSdfBitmapSize );
+	for( const auto& it : metricsAtlas->mGlyphInfo ) {
+		auto drawableIt = mTextureAtlases->mGlyphInfo.find( it.first );
+		if( ( mTextureAtlases->mGlyphInfo.end() == drawableIt ) || ( it.second.mOriginOffset != drawableIt->second.mOriginOffset ) || ( it.second.mSize != drawableIt->second.mSize ) || ( it.second.mTexCoords.getSize() != drawableIt->second.mTexCoords.getSize() ) ) {
+			sameLayout = false;
+			break;
+		}
+	}
+	if( ! sameLayout ) {
+		CI_LOG_W( "layout of the drawable SdfText differs from its metrics, measured bounds are stale" );
+	}
+}
+
+cinder::gl::SdfTextRef SdfText::create( const fs::path& filePath, const SdfText::Font &font, const Format &format, const std::string &utf8Chars )
+{
+	SdfTextRef result;
+	if( fs::exists( filePath ) ) {
+		result = SdfText::load( filePath, font.getSize() );
+	}
+	else {
+		result = create( font, format, utf8Chars );
+		if( result ) {
+			// Save first
+			SdfText::save( filePath, result );
+			// Load to ensure parity
+			result = SdfText::load( filePath, font.getSize() );
+		}
+	}
+	return result;
+}
+
+void SdfText::save(const ci::DataTargetRef& target, const SdfTextRef& sdfText)
+{
+	// Version 2 adds optional sections after the texture atlases, version 4 prefixes each section with its byte length
+	const uint32_t kCurrentVersion = 0x00000004;
+
+	if( ! target ) {
+		throw ci::Exception( "Invalid data target" );
+	}
+
+	auto os = target->getStream();
+	if( ! os ) {
+		throw ci::Exception( "Invalid out stream" );
+	}
+
+	if( ( ! sdfText->mTextureAtlases ) || sdfText->isMetricsOnly() ) {
+		throw ci::Exception( "No texture atlases" );
+	}
+
+	// File ident: SDFT
+	os->write( static_cast<uint8_t>( 'S' ) );
+	os->write( static_cast<uint8_t>( 'D' ) );
+	os->write( static_cast<uint8_t>( 'F' ) );
+	os->write( static_cast<uint8_t>( 'T' ) );
+
+	// Version
+	os->writeLittle( kCurrentVersion );
+
+	// Name
+	{
+		const std::string name = sdfText->getFont().getName();
+		const uint32_t nameLength = static_cast<uint32_t>( name.length() );
+		os->writeLittle( nameLength );
+		os->writeData( name.data(), nameLength );
+	}
+
+	// Size
+	os->writeLittle( sdfText->getFont().getSize() );
+	// Leading
+	os->writeLittle( sdfText->getFont().getLeading() );
+	// Height
+	os->writeLittle( sdfText->getFont().getHeight() );
+	// Ascent
+	os->writeLittle( sdfText->getFont().getAscent() );
+	// Descent
+	os->writeLittle( sdfText->getFont().getDescent() );
+
+	// Char/glyph maps
+	{
+		// Char/glyph ident: CHGL
+		os->write( static_cast<uint8_t>( 'C' ) );
+		os->write( static_cast<uint8_t>( 'H' ) );
+		os->write( static_cast<uint8_t>( 'G' ) );
+		os->write( static_cast<uint8_t>( 'L' ) );
+
+		// Number of chars
+		const uint32_t numChars = static_cast<uint32_t>( sdfText->mCharToGlyph.size() );
+		os->writeLittle( numChars );
+		// Chars/glyphs
+		for( const auto& it : sdfText->mCharToGlyph ) {
+			uint32_t ch = static_cast<uint32_t>( it.first );
+			const SdfText::Font::Glyph& glyph = it.second;
+			os->writeLittle( ch );
+			os->writeLittle( glyph );
+		}		
+	}
+
+	// Glyph metrics
+	{
+		// Glyph metrics ident: GLMT
+		os->write( static_cast<uint8_t>( 'G' ) );
+		os->write( static_cast<uint8_t>( 'L' ) );
+		os->write( static_cast<uint8_t>( 'M' ) );
+		os->write( static_cast<uint8_t>( 'T' ) );
+	
+		// Number of glyph metrics
+		const uint32_t numGlyphMetrics = static_cast<uint32_t>( sdfText->mGlyphMetrics.size() );
+		os->writeLittle( numGlyphMetrics );
+		// Glyph metrics
+		for( const auto& it : sdfText->mGlyphMetrics ) {
+			const SdfText::Font::Glyph& glyph = it.first;
+			const SdfText::Font::GlyphMetrics& metrics = it.second;
+			os->writeLittle( glyph );
+			os->writeLittle( metrics.advance.x );
+			os->writeLittle( metrics.advance.y );
+			os->writeLittle( metrics.minimum.x );
+			os->writeLittle( metrics.minimum.y );
+			os->writeLittle( metrics.maximum.x );
+			os->writeLittle( metrics.maximum.y );
+		}
+	}
+
+	// Texture atlases
+	{
+		// Texture atlases ident: TXAT
+		os->write( static_cast<uint8_t>( 'T' ) );
+		os->write( static_cast<uint8_t>( 'X' ) );
+		os->write( static_cast<uint8_t>( 'A' ) );
+		os->write( static_cast<uint8_t>( 'T' ) );
+
+		// SDF scale
+		os->writeLittle( sdfText->mTextureAtlases->mSdfScale.x );
+		os->writeLittle( sdfText->mTextureAtlases->mSdfScale.y );
+		// SDF padding
+		os->writeLittle( sdfText->mTextureAtlases->mSdfPadding.x );
+		os->writeLittle( sdfText->mTextureAtlases->mSdfPadding.y );
+		// SDF bitmap size
+		os->writeLittle( sdfText->mTextureAtlases->mSdfBitmapSize.x );
+		os->writeLittle( sdfText->mTextureAtlases->mSdfBitmapSize.y );
+		// Max glyph size
+		os->writeLittle( sdfText->mTextureAtlases->mMaxGlyphSize.x );
+		os->writeLittle( sdfText->mTextureAtlases->mMaxGlyphSize.y );
+		// Max ascent
+		os->writeLittle( sdfText->mTextureAtlases->mMaxAscent );
+		// Max descent
+		os->writeLittle( sdfText->mTextureAtlases->mMaxDescent );
+		// Page flags - bit 0: single channel, bit 1: BC4 compressed
+		uint32_t pageFlags = 0;
+		pageFlags |= sdfText->mTextureAtlases->mSingleChannel ? 0x1 : 0x0;
+		pageFlags |= sdfText->mTextureAtlases->mCompressed ? 0x2 : 0x0;
+		os->writeLittle( pageFlags );
+	
+		// Number of glyphs
+		const uint32_t numChars = static_cast<uint32_t>( sdfText->mTextureAtlases->mGlyphInfo.size() );
+		os->writeLittle( numChars );
+		// Glyph info
+		for( const auto& it : sdfText->mTextureAtlases->mGlyphInfo ) {
+			const SdfText::Font::Glyph& glyph = it.first;
+			const SdfText::Font::GlyphInfo& glyphInfo = it.second;
+			os->writeLittle( glyph );
+			os->writeLittle( glyphInfo.mTextureIndex );
+			os->writeLittle( glyphInfo.mTexCoords.x1 );
+			os->writeLittle( glyphInfo.mTexCoords.y1 );
+			os->writeLittle( glyphInfo.mTexCoords.x2 );
+			os->writeLittle( glyphInfo.mTexCoords.y2 );
+			os->writeLittle( glyphInfo.mOriginOffset.x );
+			os->writeLittle( glyphInfo.mOriginOffset.y );
+			os->writeLittle( glyphInfo.mSize.x );
+			os->writeLittle( glyphInfo.mSize.y );
+		}
+
+		// Number of textures, with the deferred tiles written
+		sdfText->mTextureAtlases->finishDeferredTiles();
+		const uint32_t numTextures = sdfText->mTextureAtlases->getNumPages();
+		os->writeLittle( numTextures );
+		// Textures
+		for( uint32_t i = 0; i < numTextures; ++i ) {
+			const SdfText::TextureAtlas::Page& page = sdfText->mTextureAtlases->mPages[i];
+			// Compressed textures are written as their BC4 blocks
+			if( sdfText->mTextureAtlases->mCompressed ) {
+				if( page.mData.empty() ) {
+					throw ci::Exception( "Compressed texture atlas page data has been released" );
+				}
+				// BC4 ident: BC4F
+				os->write( static_cast<uint8_t>( 'B' ) );
+				os->write( static_cast<uint8_t>( 'C' ) );
+				os->write( static_cast<uint8_t>( '4' ) );
+				os->write( static_cast<uint8_t>( 'F' ) );
+				os->writeLittle( static_cast<uint32_t>( page.mSize.x ) );
+				os->writeLittle( static_cast<uint32_t>( page.mSize.y ) );
+				os->writeLittle( static_cast<uint32_t>( page.mData.size() ) );
+				os->writeData( page.mData.data(), page.mData.size() );
+				continue;
+			}
+
+			// Write page to PNG using memory buffer, read back the texture if the page data has been released
+			ImageSourceRef pngSource;
+			uint8_t *pageData = const_cast<uint8_t *>( page.mData.data() );
+			if( page.mData.empty() ) {
+				pngSource = sdfText->getTexture( i )->createSource();
+			}
+			else if( sdfText->mTextureAtlases->mSingleChannel ) {
+				pngSource = Channel8u( page.mSize.x, page.mSize.y, static_cast<ptrdiff_t>( page.mSize.x ), 1, pageData );
+			}
+			else {
+				pngSource = Surface8u( pageData, page.mSize.x, page.mSize.y, static_cast<ptrdiff_t>( 3 * page.mSize.x ), SurfaceChannelOrder::RGB );
+			}
+			OStreamMemRef pngStream = OStreamMem::create();
+			DataTargetStreamRef pngTarget = DataTargetStream::createRef( pngStream );
+			writeImage( pngTarget, pngSource, ImageTarget::Options(), "png" );					
+			// PNG ident: PNG
+			os->write( static_cast<uint8_t>( 'P' ) );
+			os->write( static_cast<uint8_t>( 'N' ) );
+			os->write( static_cast<uint8_t>( 'G' ) );
+			os->write( static_cast<uint8_t>( 'F' ) );			
+			// Create buffer
+			const size_t pngBufferSize = static_cast<size_t>( pngStream->tell() );
+			BufferRef buffer = ci::Buffer::create( pngStream->getBuffer(), pngBufferSize );
+			// Write buffer
+			os->writeLittle( static_cast<uint32_t>( buffer->getSize() ) );
+			os->write( *buffer );
+		}
+	}
+
+	// Optional sections
+	{
+		const uint32_t numSections = sdfText->mOutlines ? 1 : 0;
+		os->writeLittle( numSections );
+
+		if( sdfText->mOutlines ) {
+			// Outlines ident: OUTL
+			os->write( static_cast<uint8_t>( 'O' ) );
+			os->write( static_cast<uint8_t>( 'U' ) );
+			os->write( static_cast<uint8_t>( 'T' ) );
+			os->write( static_cast<uint8_t>( 'L' ) );
+
+			// Section data goes through memory so that its length can be written first
+			ci::OStreamMemRef sectionStream = ci::OStreamMem::create();
+
+			// Generation parameters
+			sectionStream->writeLittle( sdfText->mTextureAtlases->mSdfRange );
+			sectionStream->writeLittle( sdfText->mTextureAtlases->mSdfAngle );
+			sectionStream->writeLittle( sdfText->mTextureAtlases->mTileSpacing.x );
+			sectionStream->writeLittle( sdfText->mTextureAtlases->mTileSpacing.y );
+			sectionStream->writeLittle( static_cast<uint32_t>( sdfText->mTextureAtlases->mInvertSdf ? 1 : 0 ) );
+
+			sdfText->mOutlines->write( sectionStream );
+
+			// Section length
+			const uint32_t sectionLength = static_cast<uint32_t>( sectionStream->tell() );
+			os->writeLittle( sectionLength );
+			os->writeData( sectionStream->getBuffer(), sectionLength );
+		}
+	}
+}
+
+void SdfText::save( const ci::fs::path& filePath, const SdfTextRef& sdfText )
+{
+	SdfText::save( ci::writeFile( filePath, true ), sdfText );
+}
+
+SdfTextRef SdfText::load( const ci::DataSourceRef& source, float size )
+{
+	return loadImpl( source, size, false );
+}
+
+SdfTextRef SdfText::loadMetrics( const ci::DataSourceRef& source, float size )
+{
+	return loadImpl( source, size, true );
+}
+
+SdfTextRef SdfText::loadImpl( const ci::DataSourceRef& source, float size, bool metricsOnly )
+{
+	ci::IStreamRef is = source->createStream();
+	if( ! is ) {
+		throw ci::Exception( "Invalid source" );
+	}
+	
+	// File ident: SDFT
+	{
+		uint8_t ident[4];
+		is->readData( ident, 4 );
+		if( std::string( "SDFT") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+			throw ci::Exception( "Not a SDF text cache file" );
+		}
+	}
+
+	// Version
+	uint32_t version = 0;
+	is->readLittle( &version );
+
+	// Font
+	SdfText::Font font;
+
+	// Name
+	{
+		uint32_t nameLength = 0;
+		is->readLittle( &nameLength );
+		std::vector<uint8_t> nameBuf( nameLength );
+		is->readData( nameBuf.data(), nameLength );
+		font.mName = std::string( reinterpret_cast<const char *>( nameBuf.data() ), nameBuf.size() );
+	}
+
+	// Size
+	is->readLittle( &(font.mSize) );
+	// Leading
+	is->readLittle( &(font.mLeading) );
+	// Height
+	is->readLittle( &(font.mHeight) );
+	// Ascent
+	is->readLittle( &(font.mAscent) );
+	// Descent
+	is->readLittle( &(font.mDescent) );
+
+	// Override font size if it's requested
+	float fontSizeScale = 1.0f;
+	if( size > 0.0f ) {
+		fontSizeScale = size / font.mSize;
+		font.mSize = size;
+	}
+
+	// Create SdfText
+	SdfText::Format format = SdfText::Format();
+	SdfTextRef sdfText = SdfTextRef( new SdfText( font, format, "", false ) );
+
+	// Char/glyph maps
+	{
+		// Char/glyph ident: CHGL
+		uint8_t ident[4];
+		is->readData( ident, 4 );
+		if( std::string( "CHGL") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+			throw ci::Exception( "Char/glyph ident not found" );
+		}
+
+		// Number of chars
+		uint32_t numChars = 0;
+		is->readLittle( &numChars );
+		// Chars/glyphs
+		for( uint32_t i = 0; i < numChars; ++i ) {
+			uint32_t ch = 0;
+			SdfText::Font::Glyph glyph = 0;
+			is->readLittle( &ch );
+			is->readLittle( &glyph );
+			SdfText::Font::Char sdftCh = static_cast<SdfText::Font::Char>( ch );
+			sdfText->mCharToGlyph[sdftCh] = glyph;
+			sdfText->mGlyphToChar[glyph] = sdftCh;
+		}		
+	}
+
+	// Glyph metrics
+	{
+		// File ident: SDFT
+		uint8_t ident[4];
+		is->readData( ident, 4 );
+		if( std::string( "GLMT") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+			throw ci::Exception( "Glyph metrics ident not found" );
+		}
+
+		// Number of glyph metrics
+		uint32_t numGlyphMetrics = 0;
+		is->readLittle( &numGlyphMetrics );
+		// Glyph metrics
+		for( uint32_t i = 0; i < numGlyphMetrics; ++i ) {
+			SdfText::Font::Glyph glyph = 0;
+			SdfText::Font::GlyphMetrics metrics = {};
+			is->readLittle( &glyph );
+			is->readLittle( &(metrics.advance.x) );
+			is->readLittle( &(metrics.advance.y) );
+			is->readLittle( &( metrics.minimum.x ) );
+			is->readLittle( &( metrics.minimum.y ) );
+			is->readLittle( &( metrics.maximum.x ) );
+			is->readLittle( &( metrics.maximum.y ) );
+			metrics.advance *= fontSizeScale;
+			metrics.minimum *= fontSizeScale;
+			metrics.maximum *= fontSizeScale;
+			sdfText->mGlyphMetrics[glyph] = metrics;
+		}
+	}
+
+	// Texture atlases
+	{
+		// File ident: TXAT
+		uint8_t ident[4];
+		is->readData( ident, 4 );
+		if( std::string( "TXAT") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+			throw ci::Exception( "Texture atlas ident not found" );
+		}
+
+		// Create TextureAtlas
+		TextureAtlasRef textureAtlases = TextureAtlasRef( new TextureAtlas( sdfText->mGlyphToChar.get_allocator().getResource() ) );
+
+		// SDF scale
+		is->readLittle( &(textureAtlases->mSdfScale.x) );
+		is->readLittle( &(textureAtlases->mSdfScale.y) );
+		// SDF padding
+		is->readLittle( &(textureAtlases->mSdfPadding.x) );
+		is->readLittle( &(textureAtlases->mSdfPadding.y) );
+		// SDF bitmap size
+		is->readLittle( &(textureAtlases->mSdfBitmapSize.x) );
+		is->readLittle( &(textureAtlases->mSdfBitmapSize.y) );
+		// Max glyph size
+		is->readLittle( &(textureAtlases->mMaxGlyphSize.x) );
+		is->readLittle( &(textureAtlases->mMaxGlyphSize.y) );
+		// Max ascent
+		is->readLittle( &(textureAtlases->mMaxAscent) );
+		// Max descent
+		is->readLittle( &(textureAtlases->mMaxDescent) );
+		// Page flags
+		if( version >= 0x00000003 ) {
+			uint32_t pageFlags = 0;
+			is->readLittle( &pageFlags );
+			textureAtlases->mSingleChannel = ( 0 != ( pageFlags & 0x1 ) );
+			textureAtlases->mCompressed = ( 0 != ( pageFlags & 0x2 ) );
+		}
+
+		// Number of glyphs
+		uint32_t numGlyphs = 0;
+		is->readLittle( &numGlyphs );
+		// Glyph info, kept without the pages since layout reads the tile bounds
+		for( uint32_t i = 0; i < numGlyphs; ++i ) {
+			SdfText::Font::Glyph glyph = 0;
+			SdfText::Font::GlyphInfo glyphInfo = {};
+			is->readLittle( &glyph );
+			is->readLittle( &(glyphInfo.mTextureIndex) );
+			is->readLittle( &(glyphInfo.mTexCoords.x1) );
+			is->readLittle( &(glyphInfo.mTexCoords.y1) );
+			is->readLittle( &(glyphInfo.mTexCoords.x2) );
+			is->readLittle( &(glyphInfo.mTexCoords.y2) );
+			is->readLittle( &(glyphInfo.mOriginOffset.x) );
+			is->readLittle( &(glyphInfo.mOriginOffset.y) );
+			is->readLittle( &(glyphInfo.mSize.x) );
+			is->readLittle( &(glyphInfo.mSize.y) );
+			textureAtlases->mGlyphInfo[glyph] = glyphInfo;
+		}
+
+		// Number of textures
+		uint32_t numTextures = 0;
+		is->readLittle( &numTextures );
+		// Textures
+		for( uint32_t i = 0; i < numTextures; ++i ) {		
+			// PNG ident: PNGF, BC4 ident: BC4F
+			uint8_t ident[4];
+			is->readData( ident, 4 );
+			if( std::string( "BC4F") == std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+				uint32_t width = 0;
+				uint32_t height = 0;
+				uint32_t blocksSize = 0;
+				is->readLittle( &width );
+				is->readLittle( &height );
+				is->readLittle( &blocksSize );
+				if( metricsOnly ) {
+					is->seekRelative( static_cast<off_t>( blocksSize ) );
+					continue;
+				}
+				const ivec2 size = ivec2( static_cast<int>( width ), static_cast<int>( height ) );
+				if( calcBc4Size( size ) != static_cast<size_t>( blocksSize ) ) {
+					throw ci::Exception( "BC4 texture size mismatch" );
+				}
+				SdfText::TextureAtlas::Page page;
+				page.mSize = size;
+				page.mData.resize( blocksSize );
+				is->readData( page.mData.data(), page.mData.size() );
+				textureAtlases->mPages.push_back( std::move( page ) );
+				textureAtlases->mStats.mNumCompressedTextures += 1;
+				continue;
+			}
+			if( std::string( "PNGF") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+				throw ci::Exception( "PNG ident not found" );
+			}
+			// Read buffer
+			uint32_t bufferSize = 0;
+			is->readLittle( &bufferSize );
+			if( metricsOnly ) {
+				is->seekRelative( static_cast<off_t>( bufferSize ) );
+				continue;
+			}
+			BufferRef buffer = Buffer::create( bufferSize );
+			is->readData( buffer->getData(), buffer->getSize() );
+			// Decode into a tightly packed page, textures are created on first use in each context
+			ImageSourceRef pngSource = loadImage( DataSourceBuffer::create( buffer ) );
+			SdfText::TextureAtlas::Page page;
+			if( textureAtlases->mSingleChannel ) {
+				Channel8u channel( pngSource );
+				page.mSize = channel.getSize();
+				page.mData.resize( page.mSize.x * page.mSize.y );
+				for( int y = 0; y < page.mSize.y; ++y ) {
+					const uint8_t *src = channel.getData( ivec2( 0, y ) );
+					for( int x = 0; x < page.mSize.x; ++x ) {
+						page.mData[y * page.mSize.x + x] = src[x * channel.getIncrement()];
+					}
+				}
+			}
+			else {
+				Surface8u surface( pngSource );
+				page.mSize = surface.getSize();
+				page.mData.resize( 3 * page.mSize.x * page.mSize.y );
+				for( int y = 0; y < page.mSize.y; ++y ) {
+					const uint8_t *src = surface.getData( ivec2( 0, y ) );
+					uint8_t *dst = page.mData.data() + ( 3 * y * page.mSize.x );
+					for( int x = 0; x < page.mSize.x; ++x ) {
+						dst[3 * x + 0] = src[x * surface.getPixelInc() + surface.getRedOffset()];
+						dst[3 * x + 1] = src[x * surface.getPixelInc() + surface.getGreenOffset()];
+						dst[3 * x + 2] = src[x * surface.getPixelInc() + surface.getBlueOffset()];
+					}
+				}
+			}
+			textureAtlases->mPages.push_back( std::move( page ) );
+		}
+		textureAtlases->updatePageStats();
+
+		sdfText->mTextureAtlases = textureAtlases;
+		if( metricsOnly ) {
+			sdfText->mMetricsOnly = true;
+			sdfText->mMetricsSource = source;
+			sdfText->mMetricsSourceSize = size;
+		}
+	}
+
+	// Optional sections
+	if( version >= 0x00000002 ) {
+		uint32_t numSections = 0;
+		is->readLittle( &numSections );
+		for( uint32_t i = 0; i < numSections; ++i ) {
+			uint8_t ident[4];
+			is->readData( ident, 4 );
+			const std::string sectionIdent = std::string( reinterpret_cast<const char*>( ident ), 4 );
+			// Section length, unknown sections of newer versions are skipped
+			uint32_t sectionLength = 0;
+			off_t sectionStart = 0;
+			if( version >= 0x00000004 ) {
+				is->readLittle( &sectionLength );
+				sectionStart = is->tell();
+			}
+			if( "OUTL" == sectionIdent ) {
+				// Generation parameters
+				uint32_t invertSdf = 0;
+				is->readLittle( &(sdfText->mTextureAtlases->mSdfRange) );
+				is->readLittle( &(sdfText->mTextureAtlases->mSdfAngle) );
+				is->readLittle( &(sdfText->mTextureAtlases->mTileSpacing.x) );
+				is->readLittle( &(sdfText->mTextureAtlases->mTileSpacing.y) );
+				is->readLittle( &invertSdf );
+				sdfText->mTextureAtlases->mInvertSdf = ( 0 != invertSdf );
+
+				sdfText->mOutlines = SdfText::GlyphOutlines::read( is, fontSizeScale );
+			}
+			else if( version < 0x00000004 ) {
+				throw ci::Exception( "Unknown section ident: " + sectionIdent );
+			}
+			else {
+				CI_LOG_I( "skipping unknown section: " << sectionIdent );
+			}
+
+			// Sections of newer versions may carry more data than is read here
+			if( version >= 0x00000004 ) {
+				is->seekAbsolute( sectionStart + static_cast<off_t>( sectionLength ) );
+			}
+		}
 	}
 
-	return result;
+	// The sections can change the generation parameters that layout reads
+	sdfText->publishGlyphTables();
+
+	return sdfText;
 }
 
-SdfTextManager::FontInfo SdfTextManager::getFontInfo( const std::string& fontName ) const
+SdfTextRef SdfText::load( const ci::fs::path& filePath, float size )
 {
-	SdfTextManager::FontInfo result;
-
-#if defined( CINDER_MAC )
-#elif defined( CINDER_MSW ) || defined( CINDER_WINRT )
-	result.key  = "arial";
-	result.name = "Arial";
-	result.path = "C:\\Windows\\Fonts\\arial.ttf";
-#elif defined( CINDER_ANDROID )
-	result.key  = "roboto regular";
-	result.name = "Roboto Regular";
-	result.path = "/system/fonts/Roboto-Regular.ttf";
-#elif defined( CINDER_LINUX )	
-#endif
+	return SdfText::load( ci::DataSourcePath::create( filePath ), size );
+}
 
-	std::string lcfn = boost::to_lower_copy( fontName );
-	boost::trim( lcfn );
+SdfTextRef SdfText::loadMetrics( const ci::fs::path& filePath, float size )
+{
+	return SdfText::loadMetrics( ci::DataSourcePath::create( filePath ), size );
+}
 
-	auto it = std::find_if( std::begin( mFontInfos ), std::end( mFontInfos ),
-		[lcfn]( const SdfTextManager::FontInfo &elem ) -> bool {
-			return elem.key == lcfn;
-		}
-	);
+//! Calls recorded in a trace, see SdfText::startTrace()
+enum TraceCall : uint8_t {
+	TRACE_SDF_TEXT = 1,
+	TRACE_DRAW_STRING,
+	TRACE_DRAW_STRING_FIT,
+	TRACE_DRAW_STRING_WRAPPED,
+	TRACE_DRAW_STRING_TRUNCATED,
+	TRACE_DRAW_GLYPHS,
+	TRACE_MEASURE_STRING,
+	TRACE_MEASURE_STRING_WRAPPED,
+	TRACE_PLACE_STRING,
+	TRACE_PLACE_STRING_WRAPPED,
+	TRACE_PLACE_STRING_TRUNCATED,
+	TRACE_GLYPH_PLACEMENTS,
+	TRACE_GLYPH_PLACEMENTS_FIT,
+	TRACE_GLYPH_PLACEMENTS_WRAPPED,
+	TRACE_TRUNCATE,
+	TRACE_MESH_RUN,
+	TRACE_MESH_CACHE,
+	TRACE_DRAW_GLYPHS_ON_PATH,
+	TRACE_PLACE_GLYPHS_ON_PATH
+};
 
-	if( std::end( mFontInfos ) != it ) {
-		result = *it;
+//! Returns the slot in the color table for the glyph at \a glyphIndex, 0 if it is outside of all spans.
+//! \a spanIdx is a cursor into \a colorSpans that only moves forward as \a glyphIndex increases.
+static uint16_t findColorSpanSlot( const SdfText::ColorSpan *colorSpans, size_t numColorSpans, size_t glyphIndex, size_t *spanIdx )
+{
+	while( ( *spanIdx < numColorSpans ) && ( glyphIndex >= ( colorSpans[*spanIdx].mStart + colorSpans[*spanIdx].mCount ) ) ) {
+		++(*spanIdx);
 	}
-	else {
-		std::vector<std::string> tokens = ci::split( lcfn, ' ' );
-		float highScore = 0.0f;
-		for( const auto& fontInfos : mFontInfos ) {
-			int hits = 0;
-			for( const auto& tok : tokens ) {
-				if( std::string::npos != fontInfos.key.find( tok ) ) {
-					hits += static_cast<int>( tok.size() );	
-				}
-			}
+	if( ( *spanIdx < numColorSpans ) && ( glyphIndex >= colorSpans[*spanIdx].mStart ) ) {
+		return static_cast<uint16_t>( *spanIdx + 1 );
+	}
+	return 0;
+}
 
-			if( hits > 0 ) {
-				std::vector<std::string> keyTokens = ci::split( fontInfos.key, ' ' );
-				float keyScore = ( keyTokens.size() == tokens.size() ) ? 0.25f : 0.0f;
-				float hitScore = static_cast<float>( hits ) / static_cast<float>( fontInfos.key.length() - ( keyTokens.size() - 1 ) );
-				hitScore = 0.75f * std::min( hitScore, 1.0f );
-				float totalScore = keyScore + hitScore;
-				if( totalScore > highScore ) {
-					highScore = totalScore;
-					result = fontInfos;
-				}
-			}
-		}
+//! Uploads the color table for \a colorSpans, slot 0 is white so glyphs outside of the spans keep the current color
+static void setColorSpanUniforms( const gl::GlslProgRef &shader, const SdfText::ColorSpan *colorSpans, size_t numColorSpans )
+{
+	std::vector<vec4> spanColors( numColorSpans + 1, vec4( 1.0f ) );
+	for( size_t i = 0; i < numColorSpans; ++i ) {
+		const ColorA color = ColorA( colorSpans[i].mColor );
+		spanColors[i + 1] = vec4( color.r, color.g, color.b, color.a );
 	}
+	shader->uniform( "uSpanColors", spanColors.data(), static_cast<int>( spanColors.size() ) );
+}
 
-	return result;
+//! Returns the distance between the baselines laid out by SdfTextBox::measureGlyphs() for \a options
+static float calcLineHeight( const SdfText::Font &font, const SdfText::DrawOptions &options )
+{
+	return ( font.getSize() / 32.0f ) * options.getScale() * ( font.getAscent() + font.getDescent() + options.getLeading() );
 }
 
-const std::vector<std::string>& SdfTextManager::getNames( bool forceRefresh )
+//! Returns the line of a glyph whose baseline is \a y below the first baseline
+static uint32_t calcLineIndex( float y, float lineHeight )
 {
-	if( ( ! mFontsEnumerated ) || forceRefresh ) {
-		mFontInfos.clear();
-		mFontNames.clear();
+	return ( lineHeight > 0.0f ) ? static_cast<uint32_t>( std::max( 0.0f, std::floor( ( y / lineHeight ) + 0.5f ) ) ) : 0;
+}
 
-		acquireFontNamesAndPaths();
-#if defined( CINDER_MSW )
-		// Registry operations can be rejected by Windows so no fonts will be picked up 
-		// on the initial scan. So we can multiple times.
-		if( mFontInfos.empty() ) {
-			for( int i = 0; i < 5; ++i ) {
-				acquireFontNamesAndPaths();
-				if( ! mFontInfos.empty() ) {
-					break;
-				}
-				::Sleep( 10 );
-			}
-		}
-#endif        
+//! Returns the center of the ink of \a glyphInfo for a glyph whose pen position is \a origin, \a fontScale maps shape units to draw units. The tile around the ink is padded and sized for the largest glyph, so its center is not the glyph's.
+static vec2 calcGlyphInkCenter( const SdfText::Font::GlyphInfo &glyphInfo, const vec2 &origin, const vec2 &fontScale )
+{
+	const vec2 inkCenter = glyphInfo.mOriginOffset + ( 0.5f * glyphInfo.mSize );
+	return origin + ( fontScale * vec2( inkCenter.x, -inkCenter.y ) );
+}
 
-		mFontsEnumerated = true;
-	}
+//! Splits \a colorSpans into consecutive glyph ranges whose spans fit in the color table and calls \a fn for each
+static void forEachColorSpanRange( size_t numGlyphs, const std::vector<SdfText::ColorSpan> &colorSpans, const std::function<void(size_t, size_t, const SdfText::ColorSpan *, size_t)> &fn )
+{
+	size_t spanBegin = 0;
+	size_t glyphBegin = 0;
+	do {
+		const size_t numSpans = std::min( kMaxColorSpans, colorSpans.size() - spanBegin );
+		const size_t spanEnd = spanBegin + numSpans;
+		const size_t glyphEnd = ( spanEnd < colorSpans.size() ) ? std::min<size_t>( colorSpans[spanEnd].mStart, numGlyphs ) : numGlyphs;
+		fn( glyphBegin, glyphEnd, colorSpans.data() + spanBegin, numSpans );
+		glyphBegin = glyphEnd;
+		spanBegin = spanEnd;
+	} while( spanBegin < colorSpans.size() );
+}
 
-/*
-	if( ( ! mFontsEnumerated ) || forceRefresh ) {
-		mFontNames.clear();
-#if defined( CINDER_MAC )
-		NSArray *fontNames = [nsFontManager availableFonts];
-		for( NSString *fontName in fontNames ) {
-			mFontNames.push_back( string( [fontName UTF8String] ) );
-		}
-#elif defined( CINDER_COCOA_TOUCH )
-		NSArray *familyNames = [UIFont familyNames];
-		for( NSString *familyName in familyNames ) {
-			NSArray *fontNames = [UIFont fontNamesForFamilyName:familyName];
-			for( NSString *fontName in fontNames ) {
-				mFontNames.push_back( string( [fontName UTF8String] ) );
-			}
-		}
-#elif defined( CINDER_MSW )
-	acquireFontPaths();
-	// Registry operations can be rejected by Windows so no fonts will be picked up 
-	// on the initial scan. So we can multiple times.
-	if( mFontInfos.empty() ) {
-		for( int i = 0; i < 5; ++i ) {
-			acquireFontPaths();
-			if( ! mFontInfos.empty() ) {
-				break;
-			}
-			::Sleep( 10 );
-		}
+void SdfText::drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const DrawOptions &options, const std::vector<ColorA8u> &colors )
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceGlyphs( TRACE_DRAW_GLYPHS, glyphMeasures, baseline, nullptr, nullptr, 0.0f, options );
 	}
-#elif defined( CINDER_WINRT )
-		Platform::Array<Platform::String^>^ fontNames = FontEnumeration::FontEnumerator().ListSystemFonts();
-		for( unsigned i = 0; i < fontNames->Length; ++i ) {
-			const wchar_t *start = fontNames[i]->Begin();
-			const wchar_t *end = fontNames[i]->End();
-			mFontNames.push_back(std::string(start, end));
-		}
-#elif defined( CINDER_ANDROID )
-		std::set<std::string> uniqueNames;
-		for( const auto& fontInfos : mFontInfos ) {
-			uniqueNames.insert( fontInfos.name );
-		}
 
-		for( const auto& name : uniqueNames ) {
-			mFontNames.push_back( name );
-		}
-#elif defined( CINDER_LINUX )
-		if( ::FcInit() ) {
-			::FcPattern   *pat = ::FcPatternCreate();
-			::FcObjectSet *os  = ::FcObjectSetBuild( FC_FILE, FC_FAMILY, FC_STYLE, (char *)0 );
-			::FcFontSet   *fs  = ::FcFontList (0, pat, os);
-		
-			for( size_t i = 0; i < fs->nfont; ++i ) {
-				::FcPattern *font = fs->fonts[i];
-				::FcChar8 *family = nullptr;
-				if( ::FcPatternGetString( font, FC_FAMILY, 0, &family ) == FcResultMatch ) 
-				{					
-					string fontName = std::string( (const char*)family );
-					mFontNames.push_back( fontName );
-				}
-			}
+	drawGlyphsImpl( glyphMeasures, 0, glyphMeasures.size(), baseline, nullptr, options, colors, nullptr, 0 );
+}
 
-			::FcObjectSetDestroy( os );
-			::FcPatternDestroy( pat );
-			::FcFontSetDestroy( fs );
+void SdfText::drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const std::vector<ColorSpan> &colorSpans, const DrawOptions &options )
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceGlyphs( TRACE_DRAW_GLYPHS, glyphMeasures, baseline, nullptr, nullptr, 0.0f, options );
+	}
 
-			::FcFini();
+	forEachColorSpanRange( glyphMeasures.size(), colorSpans, 
+		[&]( size_t glyphBegin, size_t glyphEnd, const ColorSpan *spans, size_t numSpans ) {
+			drawGlyphsImpl( glyphMeasures, glyphBegin, glyphEnd, baseline, nullptr, options, std::vector<ColorA8u>(), spans, numSpans );
 		}
-#endif
-		mFontsEnumerated = true;
+	);
+}
+
+void SdfText::drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const Rectf &clip, vec2 offset, const DrawOptions &options, const std::vector<ColorA8u> &colors )
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceGlyphs( TRACE_DRAW_GLYPHS, glyphMeasures, offset, &clip, nullptr, 0.0f, options );
 	}
-*/	
 
-	return mFontNames;
+	drawGlyphsImpl( glyphMeasures, 0, glyphMeasures.size(), offset, &clip, options, colors, nullptr, 0 );
 }
 
-SdfText::Font SdfTextManager::getDefault() const
+void SdfText::drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const Rectf &clip, vec2 offset, const std::vector<ColorSpan> &colorSpans, const DrawOptions &options )
 {
-	if( ! mDefault ) {
-#if defined( CINDER_COCOA )        
-		mDefault = SdfText::Font( "Helvetica", 32.0f );
-#elif defined( CINDER_MSW ) || defined( CINDER_WINRT )
-		mDefault = SdfText::Font( "Arial", 32.0f );
-#elif defined( CINDER_ANDROID ) || defined( CINDER_LINUX )
-		mDefault = SdfText::Font( "Roboto", 32.0f );
-#endif
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceGlyphs( TRACE_DRAW_GLYPHS, glyphMeasures, offset, &clip, nullptr, 0.0f, options );
 	}
 
-	return mDefault;
+	forEachColorSpanRange( glyphMeasures.size(), colorSpans, 
+		[&]( size_t glyphBegin, size_t glyphEnd, const ColorSpan *spans, size_t numSpans ) {
+			drawGlyphsImpl( glyphMeasures, glyphBegin, glyphEnd, offset, &clip, options, std::vector<ColorA8u>(), spans, numSpans );
+		}
+	);
 }
 
-// =================================================================================================
-// SdfTextBox Implementation
-// =================================================================================================
-struct LineProcessor 
+void SdfText::CharPlacement::calcQuad( float oblique, vec2 positions[4], vec2 texCoords[4] ) const
 {
-	LineProcessor( std::vector<std::string> *strings ) : mStrings( strings ) {}
-	void operator()( const char *line, size_t len ) const { mStrings->push_back( std::string( line, len ) ); }
-	mutable std::vector<std::string> *mStrings = nullptr;
-};
+	// Synthetic oblique shears the quad about the glyph baseline
+	const float skewTop = oblique * ( mOrigin.y - mDstRect.getY1() );
+	const float skewBottom = oblique * ( mOrigin.y - mDstRect.getY2() );
+	positions[0] = transformPoint( vec2( mDstRect.getX2() + skewTop, mDstRect.getY1() ) );
+	positions[1] = transformPoint( vec2( mDstRect.getX1() + skewTop, mDstRect.getY1() ) );
+	positions[2] = transformPoint( vec2( mDstRect.getX2() + skewBottom, mDstRect.getY2() ) );
+	positions[3] = transformPoint( vec2( mDstRect.getX1() + skewBottom, mDstRect.getY2() ) );
+	texCoords[0] = vec2( mSrcTexCoords.getX2(), mSrcTexCoords.getY1() );
+	texCoords[1] = vec2( mSrcTexCoords.getX1(), mSrcTexCoords.getY1() );
+	texCoords[2] = vec2( mSrcTexCoords.getX2(), mSrcTexCoords.getY2() );
+	texCoords[3] = vec2( mSrcTexCoords.getX1(), mSrcTexCoords.getY2() );
+}
 
-struct LineMeasure 
+vec2 SdfText::CharPlacement::calcInkCenter( float oblique ) const
 {
-	LineMeasure( float maxWidth, const SdfText::Font::GlyphMetricsMap &cachedGlyphMetrics, const SdfText::Font::CharToGlyphMap& charToGlyphMap ) 
-		: mMaxWidth( maxWidth ), mCachedGlyphMetrics( cachedGlyphMetrics ), mCharToGlyphMap( charToGlyphMap ) {}
+	return transformPoint( vec2( mInkCenter.x + ( oblique * ( mOrigin.y - mInkCenter.y ) ), mInkCenter.y ) );
+}
 
-	bool operator()( const char *line, size_t len ) const {
-		if( mMaxWidth >= MAX_SIZE ) {
-			// too big anyway so just return true
-			return true;
+SdfText::TileSource SdfText::getTileSource( const TextureAtlas &atlas )
+{
+	TileSource result = { &atlas.mGlyphInfo, std::vector<ivec2>(), atlas.mSdfScale, atlas.mSdfPadding, atlas.mSdfBitmapSize };
+	for( const auto& page : atlas.mPages ) {
+		result.mPageSizes.push_back( page.mSize );
+	}
+	return result;
+}
+
+SdfText::TileSource SdfText::getTileSource( const GlyphTables &tables )
+{
+	TileSource result = { &tables.mGlyphInfo, tables.mPageSizes, tables.mSdfScale, tables.mSdfPadding, tables.mSdfBitmapSize };
+	return result;
+}
+
+void SdfText::placeGlyphs( const TileSource &source, const std::vector<gl::TextureRef> *textures, const GlyphMeasuresView &glyphMeasures, size_t glyphBegin, size_t glyphEnd, const vec2 &baselineIn, const Rectf *clip, const DrawOptions &options, const GlyphTransform *transforms, std::vector<std::vector<CharPlacement>> *pagePlacements ) const
+{
+	const auto& glyphMap = *source.mGlyphInfo;
+	const auto& sdfScale = source.mSdfScale;
+	const auto& sdfPadding = source.mSdfPadding;
+	const size_t numPages = textures ? std::min( textures->size(), source.mPageSizes.size() ) : source.mPageSizes.size();
+	for( auto& placements : *pagePlacements ) {
+		placements.clear();
+	}
+	pagePlacements->resize( numPages );
+
+	const vec2 fontRenderScale = vec2( mFont.getSize() ) / ( 32.0f * sdfScale );
+	const vec2 fontOriginScale = vec2( mFont.getSize() ) / 32.0f;
+
+	const float scale = options.getScale();
+	const float lineHeight = calcLineHeight( mFont, options );
+	const float runPositionScale = ( glyphMeasures.size() > 1 ) ? 1.0f / static_cast<float>( glyphMeasures.size() - 1 ) : 0.0f;
+	const vec2 baseline = options.getPixelSnap() ? vec2( floor( baselineIn.x ), floor( baselineIn.y ) ) : baselineIn;
+
+	// Glyphs are laid out line by line so their baselines are sorted, only the lines near the clip
+	// rect need to be visited. A glyph quad can't reach further from its baseline than a tile.
+	// Caller supplied measures may be in any order, those are all visited and cut one by one.
+	auto visibleBegin = glyphMeasures.begin() + glyphBegin;
+	auto visibleEnd = glyphMeasures.begin() + glyphEnd;
+	auto byBaseline = []( const std::pair<Font::Glyph,vec2> &a, const std::pair<Font::Glyph,vec2> &b ) { return a.second.y < b.second.y; };
+	if( clip && options.getClipVertical() && ( scale > 0.0f ) && ( nullptr == transforms ) && std::is_sorted( visibleBegin, visibleEnd, byBaseline ) ) {
+		const float margin = ( 2.0f * source.mSdfBitmapSize.y * fontRenderScale.y ) + ( sdfPadding.y * fontRenderScale.y / scale ) + ( 1.0f / scale );
+		const float minY = ( clip->y1 - baseline.y ) / scale - margin;
+		const float maxY = ( clip->y2 - baseline.y ) / scale + margin;
+		visibleBegin = std::lower_bound( visibleBegin, visibleEnd, minY, 
+			[]( const std::pair<Font::Glyph,vec2> &glyphMeasure, float y ) { return glyphMeasure.second.y < y; } );
+		visibleEnd = std::upper_bound( visibleBegin, visibleEnd, maxY, 
+			[]( float y, const std::pair<Font::Glyph,vec2> &glyphMeasure ) { return y < glyphMeasure.second.y; } );
+	}
+
+	for( auto glyphIt = visibleBegin; glyphIt != visibleEnd; ++glyphIt ) {
+		SdfText::GlyphInfoTable::const_iterator glyphInfoIt = glyphMap.find( glyphIt->first );
+		if( ( glyphInfoIt == glyphMap.end() ) || ( glyphInfoIt->second.mTextureIndex >= numPages ) ) {
+			continue;
 		}
 
-		SdfText::Font::Glyph subGlyphIndex = 0;
-		// Use space for glyph substitution 
-		{
-			auto glyphIndexIt = mCharToGlyphMap.find( static_cast<uint32_t>( ' ' ) );
-			if( mCharToGlyphMap.end() != glyphIndexIt ) {
-				subGlyphIndex = glyphIndexIt->second;
-			}
+		const auto &glyphInfo = glyphInfoIt->second;
+		const auto &originOffset = glyphInfo.mOriginOffset;
+
+		Rectf srcTexCoords;
+		if( textures ) {
+			srcTexCoords = (*textures)[glyphInfo.mTextureIndex]->getAreaTexCoords( glyphInfo.mTexCoords );
+		}
+		else {
+			// Texture coords of the page, top down
+			const vec2 pageSize = vec2( source.mPageSizes[glyphInfo.mTextureIndex] );
+			srcTexCoords = Rectf( glyphInfo.mTexCoords );
+			srcTexCoords = Rectf( srcTexCoords.x1 / pageSize.x, srcTexCoords.y1 / pageSize.y, srcTexCoords.x2 / pageSize.x, srcTexCoords.y2 / pageSize.y );
 		}
 
-		std::u32string utf32Chars = ci::toUtf32( std::string( line, len ) );
-		float measuredWidth = 0;
-		vec2 pen = { 0, 0 };
-		for( const auto& ch : utf32Chars ) {
-			auto glyphIndexIt = mCharToGlyphMap.find( static_cast<uint32_t>( ch ) );
-			if( mCharToGlyphMap.end() == glyphIndexIt ) {
-				continue;
+		Rectf destRect = Rectf( glyphInfo.mTexCoords );
+		if( clip ) {
+			destRect.scale( fontRenderScale );
+			destRect -= destRect.getUpperLeft();
+			destRect.scale( scale );
+			destRect += glyphIt->second * scale;
+			destRect += baseline;
+			vec2 scaledOriginOffset = fontOriginScale * originOffset;
+			destRect += vec2( floor( scaledOriginOffset.x + 0.5f ), floor( -scaledOriginOffset.y ) ) * scale;
+			destRect += fontRenderScale * vec2( -sdfPadding.x, -sdfPadding.y );
+			if( options.getPixelSnap() ) {
+				destRect -= vec2( destRect.x1 - floor( destRect.x1 ), destRect.y1 - floor( destRect.y1 ) );	
 			}
 
-			SdfText::Font::Glyph glyphIndex = glyphIndexIt->second;
-			auto glyphMetricIt = mCachedGlyphMetrics.find( glyphIndex );
-			if( mCachedGlyphMetrics.end() == glyphMetricIt ) {
+			Rectf clipped( destRect );
+			if( options.getClipHorizontal() ) {
+				clipped.x1 = std::max( destRect.x1, clip->x1 );
+				clipped.x2 = std::min( destRect.x2, clip->x2 );
+			}
+			if( options.getClipVertical() ) {
+				clipped.y1 = std::max( destRect.y1, clip->y1 );
+				clipped.y2 = std::min( destRect.y2, clip->y2 );
+			}
+			if( clipped.x1 >= clipped.x2 || clipped.y1 >= clipped.y2 ) {
 				continue;
 			}
 
-			const vec2& advance = glyphMetricIt->second.advance;		
-			pen.x += advance.x;
-			pen.y += advance.y;
-			measuredWidth = pen.x;
+			vec2 coordScale = vec2( srcTexCoords.getWidth() / destRect.getWidth(), srcTexCoords.getHeight() / destRect.getHeight() );
+			srcTexCoords.x1 = srcTexCoords.x1 + ( clipped.x1 - destRect.x1 ) * coordScale.x;
+			srcTexCoords.x2 = srcTexCoords.x1 + ( clipped.x2 - clipped.x1  ) * coordScale.x;
+			srcTexCoords.y1 = srcTexCoords.y1 + ( clipped.y1 - destRect.y1 ) * coordScale.y;
+			srcTexCoords.y2 = srcTexCoords.y1 + ( clipped.y2 - clipped.y1  ) * coordScale.y;
+			destRect = clipped;
+		}
+		else {
+			destRect.scale( scale );
+			destRect -= destRect.getUpperLeft();
+			vec2 offset = vec2( 0, -( destRect.getHeight() ) );
+			// Reverse the transformation applied during SDF generation
+			float tx = sdfPadding.x;
+			float ty = std::fabs( originOffset.y ) + sdfPadding.y;
+			offset += scale * sdfScale * vec2( -tx, ty );
+			// Use origin scale for horizontal offset
+			offset += scale * fontOriginScale * vec2( originOffset.x, 0.0f );
+			destRect += offset;
+			destRect.scale( fontRenderScale );
+
+			destRect += glyphIt->second * scale;
+			destRect += baseline;
 		}
 
-		bool result = ( measuredWidth <= mMaxWidth );
-		return result;
+		SdfText::CharPlacement place;
+		place.mGlyph = glyphIt->first;
+		place.mSrcTexCoords = srcTexCoords;
+		place.mDstRect = destRect;
+		place.mIndex = static_cast<uint32_t>( glyphIt - glyphMeasures.begin() );
+		place.mLine = calcLineIndex( glyphIt->second.y, lineHeight );
+		place.mRunPosition = place.mIndex * runPositionScale;
+		place.mOrigin = baseline + ( glyphIt->second * scale );
+		place.mInkCenter = calcGlyphInkCenter( glyphInfo, place.mOrigin, scale * fontOriginScale );
+		if( transforms ) {
+			// Move the quad from its pen position to its place on the path, it is turned about it by mAxis
+			const auto &transform = transforms[place.mIndex];
+			const vec2 move = transform.mOrigin - place.mOrigin;
+			place.mDstRect += move;
+			place.mInkCenter += move;
+			place.mOrigin = transform.mOrigin;
+			place.mAxis = transform.mAxis;
+		}
+		(*pagePlacements)[glyphInfo.mTextureIndex].push_back( place );
 	}
+}
 
-	float									mMaxWidth = 0;
-	const SdfText::Font::GlyphMetricsMap	&mCachedGlyphMetrics;
-	const SdfText::Font::CharToGlyphMap		&mCharToGlyphMap;
-};
-
-std::vector<std::string> SdfTextBox::calculateLineBreaks() const
+void SdfText::drawGlyphsImpl( const GlyphMeasuresView &glyphMeasures, size_t glyphBegin, size_t glyphEnd, const vec2 &baseline, const Rectf *clip, const DrawOptions &options, const std::vector<ColorA8u> &colors, const ColorSpan *colorSpans, size_t numColorSpans, const GlyphTransform *transforms )
 {
-	const auto& charToGlyph = mSdfText->getCharToGlyph();
-	const auto& glyphMetrics = mSdfText->getGlyphMetrics();
+	const auto& atlas = selectAtlas( glyphMeasures, glyphBegin, glyphEnd, options );
+	const auto& textures = atlas->getTextures();
 
-	std::vector<std::string> result;
-	std::function<void(const char *,size_t)> lineFn = LineProcessor( &result );		
-	lineBreakUtf8( mText.c_str(), LineMeasure( ( mSize.x > 0 ) ? static_cast<float>( mSize.x ) : MAX_SIZE, glyphMetrics, charToGlyph ), lineFn );
-	return result;
-}
+	if( textures.empty() ) {
+		return;
+	}
 
-SdfText::Font::GlyphMeasuresList SdfTextBox::measureGlyphs( const SdfText::DrawOptions& drawOptions ) const
-{
-	SdfText::Font::GlyphMeasuresList result;
+	if( mUsage ) {
+		mUsage->record( glyphMeasures, glyphBegin, glyphEnd );
+	}
 
-	if( mText.empty() ) {
-		return result;
+	if( ! colors.empty() ) {
+		assert( glyphMeasures.size() == colors.size() );
 	}
 
-	const auto& font = mSdfText->getFont();
-	const float fontSizeScale = font.getSize() / 32.0f;
-	const float ascent        = font.getAscent();
-	const float descent       = font.getDescent();
-	const float leading       = drawOptions.getLeading();
-	const float drawScale	  = drawOptions.getScale();
-	const auto  align         = drawOptions.getAlignment();
-	const float lineHeight    = fontSizeScale * drawScale * ( ascent + descent + leading );
+	std::vector<std::vector<CharPlacement>> pagePlacements;
+	placeGlyphs( getTileSource( *atlas ), &textures, glyphMeasures, glyphBegin, glyphEnd, baseline, clip, options, transforms, &pagePlacements );
 
-	// Calculate the line breaks
-	std::vector<std::string> mLines = calculateLineBreaks();
-	if( mLines.empty() ) {
-		return result;
+	auto shader = options.getGlslProg();
+	if( ! shader ) {
+		shader = ( numColorSpans > 0 ) ? SdfText::colorSpanShader() : SdfText::defaultShader();
 	}
+	ScopedTextureBind texBindScp( textures[0] );
+	ScopedGlslProg glslScp( shader );
 
-	// Build measures
-	const auto& charToGlyph = mSdfText->getCharToGlyph();
-	const auto& glyphMetrics = mSdfText->getGlyphMetrics();
-	std::u32string utf32Chars, nextUtf32Chars;
-	float curY = 0;
+	if( ! options.getGlslProg() ) {
+		shader->uniform( "uFgColor", gl::context()->getCurrentColor() );
+		shader->uniform( "uPremultiply", options.getPremultiply() ? 1.0f : 0.0f );
+		shader->uniform( "uGamma", options.getGamma() );
+#if defined(CINDER_GL_ES)
+		shader->uniform( "uTexSize", vec2( textures[0]->getSize() ) );
+#endif
+	}
+	// Custom shaders only get the embolden distance if they declare it
+	if( ( ! options.getGlslProg() ) || ( shader->getUniformLocation( "uEmbolden" ) >= 0 ) ) {
+		shader->uniform( "uEmbolden", getEmboldenDistance( options ) );
+	}
+	if( numColorSpans > 0 ) {
+		setColorSpanUniforms( shader, colorSpans, numColorSpans );
+	}
 
-	for( std::vector<std::string>::const_iterator lineIt = mLines.begin(); lineIt != mLines.end(); ++lineIt ) {
-		// Fetch current line and prefetch next. This way we can look ahead.
-		if( nextUtf32Chars.empty() ) {
-			utf32Chars = ci::toUtf32( boost::algorithm::trim_right_copy( *lineIt ) );
-		}
-		else {
-			std::swap( utf32Chars, nextUtf32Chars );
-		}
+	// Per glyph attributes are only built for shaders that declare them
+	const int glyphInfoLoc = shader->getAttribLocation( "aGlyphInfo" );
+	const int glyphCenterLoc = shader->getAttribLocation( "aGlyphCenter" );
+	const float oblique = options.getOblique();
 
-		if( ( lineIt + 1 ) != mLines.end() ) {
-			nextUtf32Chars = ci::toUtf32( boost::algorithm::trim_right_copy( *( lineIt + 1 ) ) );
-		}
-		else {
-			nextUtf32Chars.clear();
+	for( size_t texIdx = 0; texIdx < pagePlacements.size(); ++texIdx ) {
+		const auto& placements = pagePlacements[texIdx];
+		if( placements.empty() ) {
+			continue;
 		}
 
-		// Layout current line of text.
-		size_t               index = result.size();
-		size_t               spaceCount = 0;
-		size_t               glyphCount = 0;
-		SdfText::Font::Glyph spaceIndex = ~0;
-		SdfText::Font::Glyph glyphIndex = ~0;
-		vec2                 advance = vec2( 0 );
-		vec2                 adjust = vec2( 0 );
-
-		vec2 pen = { 0, 0 };
-		for( const auto& ch : utf32Chars ) {
-			auto glyphIndexIt = charToGlyph.find( static_cast<uint32_t>( ch ) );
-			if( charToGlyph.end() == glyphIndexIt ) {
-				continue;
-			}
-			 
-			glyphIndex = glyphIndexIt->second;
-			auto glyphMetricIt = glyphMetrics.find( glyphIndex );
-			if( glyphMetrics.end() == glyphMetricIt ) {
-				continue;
-			}
+		ScratchVector<float> verts, texCoords;
+		ScratchVector<ColorA8u> vertColors;
+		ScratchVector<uint16_t> spanIndices;
+		ScratchVector<float> glyphInfos, glyphCenters;
+		size_t spanIdx = 0;
+		const gl::TextureRef &curTex = textures[texIdx];
 
-			advance = glyphMetricIt->second.advance;
-			adjust = advance - glyphMetricIt->second.maximum;
+		ScratchVector<uint32_t> indices;
+		uint32_t curIdx = 0;
+		GLenum indexType = GL_UNSIGNED_INT;
 
-			glyphCount++;
-			if( ch == 32 ) {
-				spaceCount++;
-				spaceIndex = glyphIndex;
+		for( const auto& place : placements ) {
+			vec2 corners[4], cornerTexCoords[4];
+			place.calcQuad( oblique, corners, cornerTexCoords );
+			for( int i = 0; i < 4; ++i ) {
+				verts.push_back( corners[i].x ); verts.push_back( corners[i].y );
+				texCoords.push_back( cornerTexCoords[i].x ); texCoords.push_back( cornerTexCoords[i].y );
 			}
 
-			float xPos = pen.x;
-			result.push_back( std::make_pair( (uint32_t)glyphIndex, vec2( xPos, curY ) ) );
-
-			pen += advance;
-		}
+			if( ! colors.empty() ) {
+				vertColors.insert( vertColors.end(), 4, colors[place.mIndex] );
+			}
 
-		// Apply alignment as a post-process.
-		bool aligned = false;
-		if( drawOptions.getJustify() ) {
-			const bool isLastLine = nextUtf32Chars.empty();
-			if( spaceCount > 0 && !isLastLine ) {
-				float space = ( mSize.x - ( pen.x + advance.x - adjust.x ) );
-				float offset = 0.0f;
-				for( size_t i = index; i < result.size(); ++i ) {
-					result[i].second.x += offset;
-					// 75% of the extra spacing comes from adjusting every character.
-					offset += ( 0.75f * space ) / glyphCount;
-					if( result[i].first == spaceIndex ) {
-						// 25% of the extra spacing comes from adjusting white space characters only.
-						offset += ( 0.25f * space ) / spaceCount;
-					}
-				}
-				aligned = true;
+			if( numColorSpans > 0 ) {
+				const uint16_t slot = findColorSpanSlot( colorSpans, numColorSpans, place.mIndex, &spanIdx );
+				spanIndices.insert( spanIndices.end(), 4, slot );
 			}
-		}
 
-		if( ! aligned ){
-			switch( align ) {
-				case SdfText::LEFT:
-				break;
-				case SdfText::CENTER: {
-					float offset = ( mSize.x - ( pen.x + advance.x - adjust.x ) ) * 0.5f;
-					if( offset > 0.0f ) {
-						for( size_t i = index; i < result.size(); ++i )
-							result[i].second.x += offset;
-					}
+			if( glyphInfoLoc >= 0 ) {
+				const float info[3] = { static_cast<float>( place.mIndex ), static_cast<float>( place.mLine ), place.mRunPosition };
+				for( int i = 0; i < 4; ++i ) {
+					glyphInfos.insert( glyphInfos.end(), info, info + 3 );
 				}
-				break;
-				case SdfText::RIGHT: {
-					float offset = ( mSize.x - ( pen.x + advance.x - adjust.x ) );
-					if( offset > 0.0f ) {
-						for( size_t i = index; i < result.size(); ++i )
-							result[i].second.x += offset;
-					}
+			}
+			if( glyphCenterLoc >= 0 ) {
+				const vec2 center = place.calcInkCenter( oblique );
+				for( int i = 0; i < 4; ++i ) {
+					glyphCenters.push_back( center.x ); glyphCenters.push_back( center.y );
 				}
-				break;
 			}
-		}
-
-		curY += lineHeight; 
-	}
 
-	return result;
-}
-
-// =================================================================================================
-// SdfText::FontData
-// =================================================================================================
-class SdfText::FontData {
-public:
-	FontData( const ci::DataSourceRef &dataSource ) {
-		if(! dataSource) {
-			return;
+			indices.push_back( curIdx + 0 ); indices.push_back( curIdx + 1 ); indices.push_back( curIdx + 2 );
+			indices.push_back( curIdx + 2 ); indices.push_back( curIdx + 1 ); indices.push_back( curIdx + 3 );
+			curIdx += 4;
 		}
-
-		mFileData = dataSource->getBuffer();
-		if( ! mFileData ) {
-			return;
+		
+		curTex->bind();
+#if defined(CINDER_GL_ES)
+		// Pages can differ in size when the texture size is chosen automatically
+		if( ! options.getGlslProg() ) {
+			shader->uniform( "uTexSize", vec2( curTex->getSize() ) );
 		}
+#endif
+		auto ctx = gl::context();
+		size_t dataSize = (verts.size() + texCoords.size()) * sizeof(float) + vertColors.size() * sizeof(ColorA8u) + spanIndices.size() * sizeof(uint16_t) + ( glyphInfos.size() + glyphCenters.size() ) * sizeof(float);
+		gl::ScopedVao vaoScp( ctx->getDefaultVao() );
+		ctx->getDefaultVao()->replacementBindBegin();
+		VboRef defaultElementVbo = ctx->getDefaultElementVbo( indices.size() * sizeof(curIdx) );
+		VboRef defaultArrayVbo = ctx->getDefaultArrayVbo( dataSize );
 
-		auto fontManager = SdfTextManager::instance();
-		if( nullptr != fontManager ) {
-			FT_Error ftRes = FT_New_Memory_Face(
-				fontManager->getLibrary(),
-				reinterpret_cast<FT_Byte*>( mFileData->getData() ),
-				static_cast<FT_Long>( mFileData->getSize() ),
-				0,
-				&mFace
-			);
+		ScopedBuffer vboArrayScp( defaultArrayVbo );
+		ScopedBuffer vboElScp( defaultElementVbo );
 
-			if( FT_Err_Ok != ftRes ) {
-				throw std::runtime_error("Failed to load font data");
+		size_t dataOffset = 0;
+		int posLoc = shader->getAttribSemanticLocation( geom::Attrib::POSITION );
+		if( posLoc >= 0 ) {
+			enableVertexAttribArray( posLoc );
+			vertexAttribPointer( posLoc, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
+			defaultArrayVbo->bufferSubData( dataOffset, verts.size() * sizeof(float), verts.data() );
+			dataOffset += verts.size() * sizeof(float);
+		}
+		int texLoc = shader->getAttribSemanticLocation( geom::Attrib::TEX_COORD_0 );
+		if( texLoc >= 0 ) {
+			enableVertexAttribArray( texLoc );
+			vertexAttribPointer( texLoc, 2, GL_FLOAT, GL_FALSE, 0, (void*)dataOffset );
+			defaultArrayVbo->bufferSubData( dataOffset, texCoords.size() * sizeof(float), texCoords.data() );
+			dataOffset += texCoords.size() * sizeof(float);
+		}
+		if( ! vertColors.empty() ) {
+			int colorLoc = shader->getAttribSemanticLocation( geom::Attrib::COLOR );
+			if( colorLoc >= 0 ) {
+				enableVertexAttribArray( colorLoc );
+				vertexAttribPointer( colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)dataOffset );
+				defaultArrayVbo->bufferSubData( dataOffset, vertColors.size() * sizeof(ColorA8u), vertColors.data() );
+				dataOffset += vertColors.size() * sizeof(ColorA8u);				
 			}
-
-			fontManager->faceCreated( mFace );
 		}
-	}
-
-	virtual ~FontData() {
-		auto fontManager = SdfTextManager::instance();
-		if( ( nullptr != fontManager ) && ( nullptr != mFace ) ) {
-			fontManager->faceDestroyed( mFace );
+		if( ! spanIndices.empty() ) {
+			int spanLoc = shader->getAttribLocation( "aSpanIndex" );
+			if( spanLoc >= 0 ) {
+				enableVertexAttribArray( spanLoc );
+				vertexAttribPointer( spanLoc, 1, GL_UNSIGNED_SHORT, GL_FALSE, 0, (void*)dataOffset );
+				defaultArrayVbo->bufferSubData( dataOffset, spanIndices.size() * sizeof(uint16_t), spanIndices.data() );
+				dataOffset += spanIndices.size() * sizeof(uint16_t);
+			}
+		}
+		if( ! glyphInfos.empty() ) {
+			enableVertexAttribArray( glyphInfoLoc );
+			vertexAttribPointer( glyphInfoLoc, 3, GL_FLOAT, GL_FALSE, 0, (void*)dataOffset );
+			defaultArrayVbo->bufferSubData( dataOffset, glyphInfos.size() * sizeof(float), glyphInfos.data() );
+			dataOffset += glyphInfos.size() * sizeof(float);
 		}
+		if( ! glyphCenters.empty() ) {
+			enableVertexAttribArray( glyphCenterLoc );
+			vertexAttribPointer( glyphCenterLoc, 2, GL_FLOAT, GL_FALSE, 0, (void*)dataOffset );
+			defaultArrayVbo->bufferSubData( dataOffset, glyphCenters.size() * sizeof(float), glyphCenters.data() );
+			dataOffset += glyphCenters.size() * sizeof(float);
+		}
+
+		defaultElementVbo->bufferSubData( 0, indices.size() * sizeof(curIdx), indices.data() );
+		ctx->getDefaultVao()->replacementBindEnd();
+		gl::setDefaultShaderVars();
+		ctx->drawElements( GL_TRIANGLES, (GLsizei)indices.size(), indexType, 0 );
 	}
+}
 
-	static SdfText::FontDataRef create( const ci::DataSourceRef &dataSource ) {
-		SdfText::FontDataRef result = SdfText::FontDataRef( new SdfText::FontData( dataSource ) );
-		return result;
+void SdfText::drawGlyphsOnPath( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const TextPath &path, float offset, const DrawOptions &options, const std::vector<ColorA8u> &colors )
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceGlyphs( TRACE_DRAW_GLYPHS_ON_PATH, glyphMeasures, vec2( 0 ), nullptr, &path, offset, options );
 	}
 
-	FT_Face	getFace() const {
-		return mFace;
+	const std::vector<GlyphTransform> transforms = calcPathTransforms( glyphMeasures, path, offset, options );
+	drawGlyphsImpl( glyphMeasures, 0, glyphMeasures.size(), vec2( 0 ), nullptr, options, colors, nullptr, 0, transforms.data() );
+}
+
+void SdfText::drawStringOnPath( const std::string &str, const TextPath &path, float offset, const DrawOptions &options )
+{
+	drawGlyphsOnPath( getGlyphPlacements( str, options ), path, offset, options );
+}
+
+void SdfText::drawString( const std::string &str, const vec2 &baseline, const DrawOptions &options )
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_DRAW_STRING, str, Rectf( 0, 0, 0, 0 ), baseline, 0.0f, std::string(), options );
 	}
 
-private:
-	ci::BufferRef	mFileData;
-	FT_Face			mFace = nullptr;
-};
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
+	ScratchVector<SdfText::Font::GlyphMeasuresList::value_type> glyphMeasures;
+	tbox.measureGlyphs( options, &glyphMeasures );
+	drawGlyphsImpl( glyphMeasures, 0, glyphMeasures.size(), baseline, nullptr, options, std::vector<ColorA8u>(), nullptr, 0 );
+}
 
-// =================================================================================================
-// SdfText::Font
-// =================================================================================================
-SdfText::Font::Font( const std::string &name, float size )
-	: mName( name ), mSize( size )
+void SdfText::drawString( const std::string &str, const Rectf &fitRect, const vec2 &offset, const DrawOptions &options )
 {
-	auto fontManager = SdfTextManager::instance();
-	if( nullptr != fontManager ) {
-		SdfTextManager::FontInfo info = fontManager->getFontInfo( name );
-		if( ! ci::fs::exists( info.path ) ) {
-			throw std::runtime_error( info.path.string() + " does not exist" );
-		}
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_DRAW_STRING_FIT, str, fitRect, offset, 0.0f, std::string(), options );
+	}
 
-		auto dataSource = ci::loadFile( info.path );
-		loadFontData( dataSource );
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, (int)fitRect.getHeight() ).ligate( options.getLigate() );
+	ScratchVector<SdfText::Font::GlyphMeasuresList::value_type> glyphMeasures;
+	tbox.measureGlyphs( options, &glyphMeasures );
+	drawGlyphsImpl( glyphMeasures, 0, glyphMeasures.size(), fitRect.getUpperLeft() + offset, &fitRect, options, std::vector<ColorA8u>(), nullptr, 0 );
+}
+
+void SdfText::drawStringWrapped( const std::string &str, const Rectf &fitRect, const vec2 &offset, const DrawOptions &options )
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_DRAW_STRING_WRAPPED, str, fitRect, offset, 0.0f, std::string(), options );
 	}
+
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() );
+	ScratchVector<SdfText::Font::GlyphMeasuresList::value_type> glyphMeasures;
+	tbox.measureGlyphs( options, &glyphMeasures );
+	drawGlyphsImpl( glyphMeasures, 0, glyphMeasures.size(), fitRect.getUpperLeft() + offset, nullptr, options, std::vector<ColorA8u>(), nullptr, 0 );
 }
 
-SdfText::Font::Font( DataSourceRef dataSource, float size )
-	: mSize( size )
+void SdfText::drawStringTruncated( const std::string &str, const vec2 &baseline, float maxWidth, const std::string &ellipsis, const DrawOptions &options )
 {
-	if( dataSource->isFilePath() ) {
-		auto fontDataSource = ci::loadFile( dataSource->getFilePath() );
-		loadFontData( fontDataSource );
-	}
-	else {
-		loadFontData( dataSource );
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_DRAW_STRING_TRUNCATED, str, Rectf( 0, 0, 0, 0 ), baseline, maxWidth, ellipsis, options );
 	}
+
+	SdfText::Font::GlyphMeasuresList glyphMeasures = truncate( str, maxWidth, ellipsis, options );
+	drawGlyphs( glyphMeasures, baseline, options );
 }
 
-SdfText::Font::~Font()
+std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeChars( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const DrawOptions &options, const std::vector<ColorSpan> &colorSpans )
 {
+	return placeCharsImpl( glyphMeasures, baseline, options, colorSpans, nullptr );
 }
 
-void SdfText::Font::loadFontData( const ci::DataSourceRef &dataSource )
+std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeCharsImpl( const GlyphMeasuresView &glyphMeasures, const vec2 &baseline, const DrawOptions &options, const std::vector<ColorSpan> &colorSpans, const GlyphTransform *transforms )
 {
-	mData = SdfText::FontData::create( dataSource );
-	FT_Select_Charmap( mData->getFace(), FT_ENCODING_UNICODE );
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> result;
 
-	FT_F26Dot6 finalSize = static_cast<FT_F26Dot6>( mSize * 64.0f );
-	FT_Set_Char_Size( mData->getFace(), 0, finalSize , 0, 72 );
+	if( mUsage ) {
+		mUsage->record( glyphMeasures, 0, glyphMeasures.size() );
+	}
 
-	// Extract the name if needed
-	if( mName.empty() ) {
-		FT_SfntName sn = {};
-		if( FT_Err_Ok == FT_Get_Sfnt_Name( mData->getFace(), TT_NAME_ID_FULL_NAME, &sn ) ) {
-			// If full name isn't available use family and style name
-			if( sn.string_len > 0  && ( 0 == sn.string[0] ) ) {
-				// Fallback to this name
-				mName = "(Unknown)";
-				std::string familyName = mData->getFace()->family_name;
-				std::string styleName = mData->getFace()->style_name;
-				if( ! familyName.empty() ) {
-					mName = familyName;
-					if( ! styleName.empty() ) {
-						styleName += ( " " + styleName );
-					}
+	const auto& textures = mTextureAtlases->getTextures();
+	std::vector<std::vector<CharPlacement>> pagePlacements;
+	placeGlyphs( getTileSource( *mTextureAtlases ), &textures, glyphMeasures, 0, glyphMeasures.size(), baseline, nullptr, options, transforms, &pagePlacements );
+	for( size_t texIdx = 0; texIdx < pagePlacements.size(); ++texIdx ) {
+		auto& charPlacements = pagePlacements[texIdx];
+		if( charPlacements.empty() ) {
+			continue;
+		}
+		if( ! colorSpans.empty() ) {
+			size_t spanIdx = 0;
+			for( auto& place : charPlacements ) {
+				const uint16_t slot = findColorSpanSlot( colorSpans.data(), colorSpans.size(), place.mIndex, &spanIdx );
+				if( slot > 0 ) {
+					place.mColor = colorSpans[slot - 1].mColor;
 				}
 			}
-			else {
-				mName = std::string( reinterpret_cast<const char *>( sn.string ), sn.string_len );
-			}
 		}
+		result.push_back( std::make_pair( static_cast<uint8_t>( texIdx ), std::move( charPlacements ) ) );
 	}
 
-	// Units per EM
-	mUnitsPerEm = mData->getFace()->units_per_EM;
-
-	// Glyph scale
-	float glyphScale = 2048.0f / static_cast<float>( mUnitsPerEm );
-
-	// Height
-	mHeight = glyphScale * ( mData->getFace()->height / 64.0f );
-
-	// Leading
-	mLeading = glyphScale * ( mData->getFace()->height - ( std::abs( mData->getFace()->ascender ) + std::abs( mData->getFace()->descender ) ) ) / 64.0f;
+	return result;
+}
 
-	// Ascent
-	mAscent = glyphScale * std::fabs( mData->getFace()->ascender / 64.0f );
+std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeString( const std::string &str, const vec2 &baseline, const DrawOptions &options, const std::vector<ColorSpan> &colorSpans )
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_PLACE_STRING, str, Rectf( 0, 0, 0, 0 ), baseline, 0.0f, std::string(), options );
+	}
 
-	// Descent
-	mDescent = glyphScale * std::fabs( mData->getFace()->descender / 64.0f );
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
+	ScratchVector<SdfText::Font::GlyphMeasuresList::value_type> glyphMeasures;
+	tbox.measureGlyphs( options, &glyphMeasures );
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> result = placeCharsImpl( glyphMeasures, baseline, options, colorSpans, nullptr );
+	return result;
 }
 
-SdfText::Font::Glyph SdfText::Font::getGlyphIndex( size_t idx ) const
+std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeStringWrapped( const std::string &str, const Rectf &fitRect, const vec2 &offset, const DrawOptions &options, const std::vector<ColorSpan> &colorSpans )
 {
-	return static_cast<SdfText::Font::Glyph>( idx );
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_PLACE_STRING_WRAPPED, str, fitRect, offset, 0.0f, std::string(), options );
+	}
+
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() );
+	ScratchVector<SdfText::Font::GlyphMeasuresList::value_type> glyphMeasures;
+	tbox.measureGlyphs( options, &glyphMeasures );
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> result = placeCharsImpl( glyphMeasures, fitRect.getUpperLeft() + offset, options, colorSpans, nullptr );
+	return result;
 }
 
-SdfText::Font::Glyph SdfText::Font::getGlyphChar( char utf8Char ) const
+std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeGlyphsOnPath( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const TextPath &path, float offset, const DrawOptions &options, const std::vector<ColorSpan> &colorSpans )
 {
-	FT_UInt glyphIndex = FT_Get_Char_Index( mData->getFace(), static_cast<FT_ULong>( utf8Char ) );
-	return static_cast<SdfText::Font::Glyph>( glyphIndex );
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceGlyphs( TRACE_PLACE_GLYPHS_ON_PATH, glyphMeasures, vec2( 0 ), nullptr, &path, offset, options );
+	}
+
+	DrawOptions pathOptions = options;
+	pathOptions.pixelSnap( false );
+	const std::vector<GlyphTransform> transforms = calcPathTransforms( glyphMeasures, path, offset, options );
+	return placeCharsImpl( glyphMeasures, vec2( 0 ), pathOptions, colorSpans, transforms.data() );
 }
 
-std::vector<SdfText::Font::Glyph> SdfText::Font::getGlyphs( const std::string &utf8Chars ) const
+std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeStringTruncated( const std::string &str, const vec2 &baseline, float maxWidth, const std::string &ellipsis, const DrawOptions &options )
 {
-	std::vector<SdfText::Font::Glyph> result;
-	// Convert to UTF32
-	std::u32string utf32Chars = ci::toUtf32( utf8Chars );
-	// Build the maps and information pieces that will be needed later
-	for( const auto& ch : utf32Chars ) {
-		FT_UInt glyphIndex = FT_Get_Char_Index( mData->getFace(), static_cast<FT_ULong>( ch ) );
-		result.push_back( static_cast<SdfText::Font::Glyph>( glyphIndex ) );
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_PLACE_STRING_TRUNCATED, str, Rectf( 0, 0, 0, 0 ), baseline, maxWidth, ellipsis, options );
 	}
+
+	SdfText::Font::GlyphMeasuresList glyphMeasures = truncate( str, maxWidth, ellipsis, options );
+	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> result = placeChars( glyphMeasures, baseline, options );
 	return result;
 }
 
-FT_Face SdfText::Font::getFace() const
+Rectf SdfText::measureStringImpl( const std::string &str, bool wrapped, const Rectf &fitRect, const DrawOptions &options ) const
 {
-	return mData->getFace();
+	SdfTextBox tbox = wrapped ? SdfTextBox( this ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() )
+                              : SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
+	
+	// Glyphs can be added while the text is measured on another thread, the layout and the bounds read the same tables
+	GlyphTablesReader tables( this );
+	ScratchVector<SdfText::Font::GlyphMeasuresList::value_type> glyphMeasures;
+	tbox.measureGlyphs( *tables, options, &glyphMeasures );
+	return measureGlyphBoundsImpl( glyphMeasures, options, *tables );
 }
 
-const std::vector<std::string>& SdfText::Font::getNames( bool forceRefresh )
+Rectf SdfText::measureGlyphBounds( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const DrawOptions &options ) const
 {
-	return SdfTextManager::instance()->getNames( forceRefresh );
+	// Glyphs can be added while the text is measured on another thread
+	GlyphTablesReader tables( this );
+	return measureGlyphBoundsImpl( glyphMeasures, options, *tables );
 }
 
-SdfText::Font SdfText::Font::getDefault()
+Rectf SdfText::measureGlyphBoundsImpl( const GlyphMeasuresView &glyphMeasures, const DrawOptions &options, const GlyphTables &tables ) const
 {
-	return SdfTextManager::instance()->getDefault();
-}
+	const SdfText::GlyphInfoTable& glyphMap = tables.mGlyphInfo;
+	const auto& sdfScale = tables.mSdfScale;
+	const auto& sdfPadding = tables.mSdfPadding;
+	const vec2 fontRenderScale = vec2( mFont.getSize() ) / ( 32.0f * tables.mSdfScale );
+	const vec2 fontOriginScale = vec2( mFont.getSize() ) / 32.0f;
+	const float scale = options.getScale();
+	const float embolden = getEmbolden( options ) * scale;
+	const float oblique = options.getOblique();
 
-// =================================================================================================
-// SdfText
-// =================================================================================================
-SdfText::SdfText( const SdfText::Font &font, const Format &format, const std::string &utf8Chars, bool generateSdf )
-	: mFont( font ), mFormat( format )
-{
-	if( generateSdf ) {
-		FT_Face face = font.getFace();
-		if( nullptr == face ) {
-			throw std::runtime_error( "null font face" );
-		}
+	Rectf result = Rectf( 0, 0, 0, 0 );
+    for( const SdfText::GlyphMeasuresView::value_type *glyphIt = glyphMeasures.begin(); glyphIt != glyphMeasures.end(); ++glyphIt ) {
+        SdfText::GlyphInfoTable::const_iterator glyphInfoIt = glyphMap.find( glyphIt->first );
+        if(  glyphInfoIt == glyphMap.end() ) {
+            continue;
+        }
 
-		// Convert characters from UTF8 to UTF32
-		std::u32string utf32Chars = ci::toUtf32( utf8Chars );
-		// Add a space if needed
-		if( std::string::npos == utf8Chars.find( ' ' ) ) {
-			utf32Chars += ci::toUtf32( " " );
-		}
+		const auto &glyphInfo = glyphInfoIt->second;          
+        const auto &originOffset = glyphInfo.mOriginOffset;
+		const auto &size = glyphInfo.mSize;
 
-		// Build char/glyph maps
-		std::vector<SdfText::Font::Glyph> glyphIndices;
-		for( const auto &ch : utf32Chars ) {
-			// Lookup glyph index based on char
-			SdfText::Font::Glyph glyphIndex = static_cast<SdfText::Font::Glyph>( FT_Get_Char_Index( face, static_cast<FT_ULong>( ch ) ) );
+        Rectf destRect = Rectf( glyphInfo.mTexCoords );
+        destRect.scale( scale );
+        destRect -= destRect.getUpperLeft();
+        vec2 offset = vec2( 0, -( destRect.getHeight() ) );
+        // Reverse the transformation applied during SDF generation
+        float tx = sdfPadding.x;
+        float ty = std::fabs( originOffset.y ) + sdfPadding.y;
+        offset += scale * sdfScale * vec2( -tx, ty );
+        // Use origin scale for horizontal offset
+        offset += scale * fontOriginScale * vec2( originOffset.x, 0.0f );
+        destRect += offset;
+        destRect.scale( fontRenderScale );
 
-			// Unique glyph
-			auto it = std::find_if( std::begin( glyphIndices ), std::end( glyphIndices ),
-				[glyphIndex]( const SdfText::Font::Glyph &elem ) -> bool {
-					return ( elem == glyphIndex );
-				}
-			);
-			if( std::end( glyphIndices ) == it ) {
-				glyphIndices.push_back( glyphIndex );
-			}
+		destRect += glyphIt->second * scale;
 
-			// Character to glyph index and vice versa
-			mCharToGlyph[static_cast<SdfText::Font::Char>( ch )] = glyphIndex;
-			mGlyphToChar[glyphIndex] = static_cast<SdfText::Font::Char>( ch );
+		destRect.x1 += ( ( sdfPadding.x + originOffset.x ) * fontOriginScale.x );
+		destRect.y2 -= ( sdfPadding.y * fontOriginScale.y );
+		destRect.x2 = destRect.x1 + ( ( size.x + 1.0f ) * fontOriginScale.x );
+		destRect.y1 = destRect.y2 - ( ( size.y + 1.0f ) * fontOriginScale.y );
+		destRect.x1 -= ( 0.5f * fontOriginScale.x );
+		destRect.y1 -= ( 0.5f * fontOriginScale.y );
+		destRect.x2 += ( 0.5f * fontOriginScale.x );
+		destRect.y2 += ( 0.5f * fontOriginScale.y );
+		destRect.x1 -= embolden;
+		destRect.y1 -= embolden;
+		destRect.x2 += embolden;
+		destRect.y2 += embolden;
+		if( oblique != 0.0f ) {
+			// Skew about the glyph baseline
+			const float baselineY = glyphIt->second.y * scale;
+			const float top = oblique * ( baselineY - destRect.y1 );
+			const float bottom = oblique * ( baselineY - destRect.y2 );
+			destRect.x1 += std::min( top, bottom );
+			destRect.x2 += std::max( top, bottom );
 		}
 
-		// Get texture atlas - will build if necessary
-		mTextureAtlases = SdfTextManager::instance()->getTextureAtlas( face, format, utf8Chars, glyphIndices );
-
-		// Build glyph metrics
-		{
-			FT_Face face = mFont.getFace();
-			for( const auto &glyphIndex : glyphIndices ) {
-				FT_Load_Glyph( face, glyphIndex, FT_LOAD_DEFAULT );
-				FT_GlyphSlot slot = face->glyph;
-				SdfText::Font::GlyphMetrics glyphMetrics;
-				glyphMetrics.advance = vec2( slot->linearHoriAdvance, slot->linearVertAdvance ) / 65536.0f;
-				glyphMetrics.minimum = vec2( slot->metrics.horiBearingX, slot->metrics.vertBearingY - slot->metrics.height ) / 65536.0f;
-				glyphMetrics.maximum = vec2( slot->metrics.horiBearingX + slot->metrics.width, slot->metrics.vertBearingY ) / 65536.0f;
-				mGlyphMetrics[glyphIndex] = glyphMetrics;
-			}
+		if( ( result.getWidth() > 0 ) || ( result.getHeight() > 0 ) ) {
+			result.x1 = std::min( result.x1, destRect.x1 );
+			result.y1 = std::min( result.y1, destRect.y1 );
+			result.x2 = std::max( result.x2, destRect.x2 );
+			result.y2 = std::max( result.y2, destRect.y2 );
+		}
+		else {
+			result = destRect;
 		}
 	}
-}
 
-SdfText::~SdfText()
-{
+	return result;
 }
 
-SdfTextRef SdfText::create( const SdfText::Font &font, const Format &format, const std::string &supportedChars )
+Rectf SdfText::measureStringBounds( const std::string &str, const DrawOptions &options ) const
 {
-	SdfTextRef result = SdfTextRef( new SdfText( font, format, supportedChars ) );
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_MEASURE_STRING, str, Rectf( 0, 0, 0, 0 ), vec2( 0 ), 0.0f, std::string(), options );
+	}
+
+    Rectf result = measureStringImpl( str, false, Rectf( 0, 0, 0, 0 ), options );
+    return result;
+
+/*
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
+	SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
+
+	const SdfText::GlyphInfoTable& glyphMap = mTextureAtlases->mGlyphInfo;
+	const auto& sdfScale = mTextureAtlases->mSdfScale;
+	const auto& sdfPadding = mTextureAtlases->mSdfPadding;
+	const vec2 fontRenderScale = vec2( mFont.getSize() ) / ( 32.0f * mTextureAtlases->mSdfScale );
+	const vec2 fontOriginScale = vec2( mFont.getSize() ) / 32.0f;
+	const float scale = options.getScale();
+
+	Rectf result = Rectf( 0, 0, 0, 0 );
+    for( std::vector<std::pair<SdfText::Font::Glyph,vec2> >::const_iterator glyphIt = glyphMeasures.begin(); glyphIt != glyphMeasures.end(); ++glyphIt ) {
+        SdfText::GlyphInfoTable::const_iterator glyphInfoIt = glyphMap.find( glyphIt->first );
+        if(  glyphInfoIt == glyphMap.end() ) {
+            continue;
+        }
+
+		const auto &glyphInfo = glyphInfoIt->second;          
+        const auto &originOffset = glyphInfo.mOriginOffset;
+		const auto &size = glyphInfo.mSize;
+
+        Rectf destRect = Rectf( glyphInfo.mTexCoords );
+        destRect.scale( scale );
+        destRect -= destRect.getUpperLeft();
+        vec2 offset = vec2( 0, -( destRect.getHeight() ) );
+        // Reverse the transformation applied during SDF generation
+        float tx = sdfPadding.x;
+        float ty = std::fabs( originOffset.y ) + sdfPadding.y;
+        offset += scale * sdfScale * vec2( -tx, ty );
+        // Use origin scale for horizontal offset
+        offset += scale * fontOriginScale * vec2( originOffset.x, 0.0f );
+        destRect += offset;
+        destRect.scale( fontRenderScale );
+
+		destRect += glyphIt->second * scale;
+
+		destRect.x1 += ( ( sdfPadding.x + originOffset.x ) * fontOriginScale.x );
+		destRect.y2 -= ( sdfPadding.y * fontOriginScale.y );
+		destRect.x2 = destRect.x1 + ( ( size.x + 1.0f ) * fontOriginScale.x );
+		destRect.y1 = destRect.y2 - ( ( size.y + 1.0f ) * fontOriginScale.y );
+		destRect.x1 -= ( 0.5f * fontOriginScale.x );
+		destRect.y1 -= ( 0.5f * fontOriginScale.y );
+		destRect.x2 += ( 0.5f * fontOriginScale.x );
+		destRect.y2 += ( 0.5f * fontOriginScale.y );
+
+		if( ( result.getWidth() > 0 ) || ( result.getHeight() > 0 ) ) {
+			result.x1 = std::min( result.x1, destRect.x1 );
+			result.y1 = std::min( result.y1, destRect.y1 );
+			result.x2 = std::max( result.x2, destRect.x2 );
+			result.y2 = std::max( result.y2, destRect.y2 );
+		}
+		else {
+			result = destRect;
+		}
+	}
+
 	return result;
+*/
 }
 
-cinder::gl::SdfTextRef SdfText::create( const fs::path& filePath, const SdfText::Font &font, const Format &format, const std::string &utf8Chars )
+Rectf SdfText::measureStringBoundsWrapped( const std::string &str, const Rectf &fitRect, const DrawOptions &options ) const
 {
-	SdfTextRef result;
-	if( fs::exists( filePath ) ) {
-		result = SdfText::load( filePath, font.getSize() );
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_MEASURE_STRING_WRAPPED, str, fitRect, vec2( 0 ), 0.0f, std::string(), options );
 	}
-	else {
-		result = create( font, format, utf8Chars );
-		if( result ) {
-			// Save first
-			SdfText::save( filePath, result );
-			// Load to ensure parity
-			result = SdfText::load( filePath, font.getSize() );
+
+    Rectf result = measureStringImpl( str, true, fitRect, options );
+    return result;
+}
+
+SdfText::FitResult SdfText::fitStringWrapped( const std::string &str, const Rectf &fitRect, float minScale, float maxScale, const DrawOptions &options ) const
+{
+	FitResult result;
+
+	const float width  = fitRect.getWidth();
+	const float height = fitRect.getHeight();
+	const float lineHeight = ( mFont.getSize() / 32.0f ) * ( mFont.getAscent() + mFont.getDescent() + options.getLeading() );
+
+	// One relayout: glyph measures, bounds and the wrap widths between which the line breaks hold
+	float maxFitWidth = 0.0f;
+	float minOverflowWidth = MAX_SIZE;
+	auto layout = [&]( float scale ) {
+		const DrawOptions scaledOptions = DrawOptions( options ).scale( scale );
+		SdfTextBox tbox = SdfTextBox( this ).text( str ).size( (int)width, (int)height ).wrapWidth( width / scale ).ligate( options.getLigate() );
+		maxFitWidth = 0.0f;
+		minOverflowWidth = MAX_SIZE;
+		result.mScale = scale;
+		result.mGlyphMeasures = tbox.measureGlyphs( scaledOptions, &maxFitWidth, &minOverflowWidth );
+		result.mBounds = measureGlyphBounds( result.mGlyphMeasures, scaledOptions );
+		result.mFits = ( result.mBounds.getWidth() <= width ) && ( result.mBounds.getHeight() <= height );
+		++result.mNumLayouts;
+	};
+
+	// Walk down from the max scale. Line breaks only change when the wrap width crosses the width of
+	// a candidate line, so each relayout either finds the best scale for its line breaks or jumps
+	// straight to the next scale at which the line breaks change.
+	const uint32_t kMaxLayouts = 32;
+	float scale = maxScale;
+	while( ( scale >= minScale ) && ( result.mNumLayouts < kMaxLayouts ) ) {
+		layout( scale );
+		if( result.mFits ) {
+			return result;
+		}
+
+		// The line breaks hold for scales in ( lowerScale, scale ]
+		const float lowerScale = ( minOverflowWidth < MAX_SIZE ) ? ( width / minOverflowWidth ) : 0.0f;
+
+		// For fixed line breaks the width grows linearly with the scale. The height is the line pitch,
+		// which is scaled by the layout and again when placed, times the number of lines plus the
+		// glyph extent which grows linearly.
+		float maxY = 0.0f;
+		for( const auto& glyphMeasure : result.mGlyphMeasures ) {
+			maxY = std::max( maxY, glyphMeasure.second.y );
+		}
+		const float numPitches = ( lineHeight > 0.0f ) ? std::floor( maxY / ( lineHeight * scale ) + 0.5f ) : 0.0f;
+		const float a = numPitches * lineHeight;
+		const float b = std::max( 0.0f, ( result.mBounds.getHeight() - ( a * scale * scale ) ) / scale );
+		float heightScale = maxScale;
+		if( a > 0.0f ) {
+			heightScale = ( -b + std::sqrt( ( b * b ) + ( 4.0f * a * height ) ) ) / ( 2.0f * a );
+		}
+		else if( b > 0.0f ) {
+			heightScale = height / b;
+		}
+		const float widthScale = ( result.mBounds.getWidth() > 0.0f ) ? ( scale * width / result.mBounds.getWidth() ) : maxScale;
+		const float candidate = std::min( scale, std::min( heightScale, widthScale ) ) * 0.9999f;
+
+		if( ( candidate > lowerScale ) && ( candidate < scale ) ) {
+			// Same line breaks, the next relayout confirms the fit
+			scale = candidate;
+		}
+		else if( lowerScale < scale ) {
+			// Jump to where a rejected line starts to fit
+			scale = lowerScale;
+		}
+		else {
+			scale *= 0.9999f;
 		}
 	}
+
+	// Does not fit, report the min scale
+	if( ( result.mScale != minScale ) || ( 0 == result.mNumLayouts ) ) {
+		layout( minScale );
+	}
 	return result;
 }
 
-void SdfText::save(const ci::DataTargetRef& target, const SdfTextRef& sdfText)
+std::vector<SdfText::GlyphTransform> SdfText::calcPathTransforms( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const TextPath &path, float offset, const DrawOptions &options ) const
 {
-	const uint32_t kCurrentVersion = 0x00000001;
-
-	if( ! target ) {
-		throw ci::Exception( "Invalid data target" );
+	std::vector<GlyphTransform> result( glyphMeasures.size() );
+	if( glyphMeasures.empty() || path.empty() ) {
+		return result;
 	}
 
-	auto os = target->getStream();
-	if( ! os ) {
-		throw ci::Exception( "Invalid out stream" );
+	const float scale = options.getScale();
+	const float grow = 2.0f * getEmbolden( options );
+	// Glyphs can be added while the path is laid out on another thread
+	GlyphTablesReader tables( this );
+	const auto& glyphMetrics = tables->mGlyphMetrics;
+
+	// Distance along the path of each glyph center, in pixels from the start of the text
+	std::vector<float> distances( glyphMeasures.size() );
+	float width = 0.0f;
+	for( size_t i = 0; i < glyphMeasures.size(); ++i ) {
+		const auto &glyphMeasure = glyphMeasures[i];
+		auto glyphMetricIt = glyphMetrics.find( glyphMeasure.first );
+		const float advance = ( ( glyphMetrics.end() != glyphMetricIt ) ? glyphMetricIt->second.advance.x + grow : 0.0f ) * scale;
+		distances[i] = ( glyphMeasure.second.x * scale ) + ( 0.5f * advance );
+		width = std::max( width, ( glyphMeasure.second.x * scale ) + advance );
 	}
 
-	if( ! sdfText->mTextureAtlases ) {
-		throw ci::Exception( "No texture atlases" );
+	float start = offset;
+	switch( options.getAlignment() ) {
+		case SdfText::Alignment::CENTER: start += 0.5f * ( path.getLength() - width ); break;
+		case SdfText::Alignment::RIGHT: start += path.getLength() - width; break;
+		default: break;
 	}
-
-	// File ident: SDFT
-	os->write( static_cast<uint8_t>( 'S' ) );
-	os->write( static_cast<uint8_t>( 'D' ) );
-	os->write( static_cast<uint8_t>( 'F' ) );
-	os->write( static_cast<uint8_t>( 'T' ) );
-
-	// Version
-	os->writeLittle( kCurrentVersion );
-
-	// Name
-	{
-		const std::string name = sdfText->getFont().getName();
-		const uint32_t nameLength = static_cast<uint32_t>( name.length() );
-		os->writeLittle( nameLength );
-		os->writeData( name.data(), nameLength );
+	for( auto &distance : distances ) {
+		distance += start;
 	}
 
-	// Size
-	os->writeLittle( sdfText->getFont().getSize() );
-	// Leading
-	os->writeLittle( sdfText->getFont().getLeading() );
-	// Height
-	os->writeLittle( sdfText->getFont().getHeight() );
-	// Ascent
-	os->writeLittle( sdfText->getFont().getAscent() );
-	// Descent
-	os->writeLittle( sdfText->getFont().getDescent() );
-
-	// Char/glyph maps
-	{
-		// Char/glyph ident: CHGL
-		os->write( static_cast<uint8_t>( 'C' ) );
-		os->write( static_cast<uint8_t>( 'H' ) );
-		os->write( static_cast<uint8_t>( 'G' ) );
-		os->write( static_cast<uint8_t>( 'L' ) );
+	std::vector<vec2> positions( glyphMeasures.size() ), tangents( glyphMeasures.size() );
+	path.calcPositions( distances.data(), distances.size(), positions.data(), tangents.data() );
 
-		// Number of chars
-		const uint32_t numChars = static_cast<uint32_t>( sdfText->mCharToGlyph.size() );
-		os->writeLittle( numChars );
-		// Chars/glyphs
-		for( const auto& it : sdfText->mCharToGlyph ) {
-			uint32_t ch = static_cast<uint32_t>( it.first );
-			const SdfText::Font::Glyph& glyph = it.second;
-			os->writeLittle( ch );
-			os->writeLittle( glyph );
-		}		
+	for( size_t i = 0; i < glyphMeasures.size(); ++i ) {
+		// Back up from the glyph center to the pen position along the tangent, lines below the first move along the normal
+		const vec2 &tangent = tangents[i];
+		const vec2 normal = vec2( -tangent.y, tangent.x );
+		const float penToCenter = distances[i] - start - ( glyphMeasures[i].second.x * scale );
+		result[i].mOrigin = positions[i] - ( tangent * penToCenter ) + ( normal * ( glyphMeasures[i].second.y * scale ) );
+		result[i].mAxis = tangent;
 	}
 
-	// Glyph metrics
-	{
-		// Glyph metrics ident: GLMT
-		os->write( static_cast<uint8_t>( 'G' ) );
-		os->write( static_cast<uint8_t>( 'L' ) );
-		os->write( static_cast<uint8_t>( 'M' ) );
-		os->write( static_cast<uint8_t>( 'T' ) );
-	
-		// Number of glyph metrics
-		const uint32_t numGlyphMetrics = static_cast<uint32_t>( sdfText->mGlyphMetrics.size() );
-		os->writeLittle( numGlyphMetrics );
-		// Glyph metrics
-		for( const auto& it : sdfText->mGlyphMetrics ) {
-			const SdfText::Font::Glyph& glyph = it.first;
-			const SdfText::Font::GlyphMetrics& metrics = it.second;
-			os->writeLittle( glyph );
-			os->writeLittle( metrics.advance.x );
-			os->writeLittle( metrics.advance.y );
-			os->writeLittle( metrics.minimum.x );
-			os->writeLittle( metrics.minimum.y );
-			os->writeLittle( metrics.maximum.x );
-			os->writeLittle( metrics.maximum.y );
-		}
-	}
+	return result;
+}
 
-	// Texture atlases
-	{
-		// Texture atlases ident: TXAT
-		os->write( static_cast<uint8_t>( 'T' ) );
-		os->write( static_cast<uint8_t>( 'X' ) );
-		os->write( static_cast<uint8_t>( 'A' ) );
-		os->write( static_cast<uint8_t>( 'T' ) );
+vec2 SdfText::measureString( const std::string &str, const DrawOptions &options ) const
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_MEASURE_STRING, str, Rectf( 0, 0, 0, 0 ), vec2( 0 ), 0.0f, std::string(), options );
+	}
 
-		// SDF scale
-		os->writeLittle( sdfText->mTextureAtlases->mSdfScale.x );
-		os->writeLittle( sdfText->mTextureAtlases->mSdfScale.y );
-		// SDF padding
-		os->writeLittle( sdfText->mTextureAtlases->mSdfPadding.x );
-		os->writeLittle( sdfText->mTextureAtlases->mSdfPadding.y );
-		// SDF bitmap size
-		os->writeLittle( sdfText->mTextureAtlases->mSdfBitmapSize.x );
-		os->writeLittle( sdfText->mTextureAtlases->mSdfBitmapSize.y );
-		// Max glyph size
-		os->writeLittle( sdfText->mTextureAtlases->mMaxGlyphSize.x );
-		os->writeLittle( sdfText->mTextureAtlases->mMaxGlyphSize.y );
-		// Max ascent
-		os->writeLittle( sdfText->mTextureAtlases->mMaxAscent );
-		// Max descent
-		os->writeLittle( sdfText->mTextureAtlases->mMaxDescent );
-	
-		// Number of glyphs
-		const uint32_t numChars = static_cast<uint32_t>( sdfText->mTextureAtlases->mGlyphInfo.size() );
-		os->writeLittle( numChars );
-		// Glyph info
-		for( const auto& it : sdfText->mTextureAtlases->mGlyphInfo ) {
-			const SdfText::Font::Glyph& glyph = it.first;
-			const SdfText::Font::GlyphInfo& glyphInfo = it.second;
-			os->writeLittle( glyph );
-			os->writeLittle( glyphInfo.mTextureIndex );
-			os->writeLittle( glyphInfo.mTexCoords.x1 );
-			os->writeLittle( glyphInfo.mTexCoords.y1 );
-			os->writeLittle( glyphInfo.mTexCoords.x2 );
-			os->writeLittle( glyphInfo.mTexCoords.y2 );
-			os->writeLittle( glyphInfo.mOriginOffset.x );
-			os->writeLittle( glyphInfo.mOriginOffset.y );
-			os->writeLittle( glyphInfo.mSize.x );
-			os->writeLittle( glyphInfo.mSize.y );
-		}
+    Rectf bounds = measureStringImpl( str, false, Rectf( 0, 0, 0, 0 ), options );
+	vec2 result = vec2( bounds.getWidth(), bounds.getHeight() );
+	return result;
+}
 
-		// Number of textures
-		const uint32_t numTextures = static_cast<uint32_t>( sdfText->mTextureAtlases->mTextures.size() );
-		os->writeLittle( numTextures );
-		// Textures
-		for( const auto& tex : sdfText->mTextureAtlases->mTextures ) {
-			// Write texture to PNG using memory buffer
-			ImageSourceRef pngSource = tex->createSource();
-			OStreamMemRef pngStream = OStreamMem::create();
-			DataTargetStreamRef pngTarget = DataTargetStream::createRef( pngStream );
-			writeImage( pngTarget, pngSource, ImageTarget::Options(), "png" );					
-			// PNG ident: PNG
-			os->write( static_cast<uint8_t>( 'P' ) );
-			os->write( static_cast<uint8_t>( 'N' ) );
-			os->write( static_cast<uint8_t>( 'G' ) );
-			os->write( static_cast<uint8_t>( 'F' ) );			
-			// Create buffer
-			const size_t pngBufferSize = static_cast<size_t>( pngStream->tell() );
-			BufferRef buffer = ci::Buffer::create( pngStream->getBuffer(), pngBufferSize );
-			// Write buffer
-			os->writeLittle( static_cast<uint32_t>( buffer->getSize() ) );
-			os->write( *buffer );
-		}
+vec2 SdfText::measureStringWrapped( const std::string &str, const Rectf &fitRect, const DrawOptions &options ) const
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_MEASURE_STRING_WRAPPED, str, fitRect, vec2( 0 ), 0.0f, std::string(), options );
 	}
+
+    Rectf bounds = measureStringImpl( str, true, fitRect, options );
+	vec2 result = vec2( bounds.getWidth(), bounds.getHeight() );
+	return result;
 }
 
-void SdfText::save( const ci::fs::path& filePath, const SdfTextRef& sdfText )
+std::vector<std::pair<SdfText::Font::Glyph, vec2>> SdfText::getGlyphPlacements( const std::string &str, const DrawOptions &options ) const
 {
-	SdfText::save( ci::writeFile( filePath, true ), sdfText );
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_GLYPH_PLACEMENTS, str, Rectf( 0, 0, 0, 0 ), vec2( 0 ), 0.0f, std::string(), options );
+	}
+
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
+	return tbox.measureGlyphs(  options );
 }
 
-SdfTextRef SdfText::load( const ci::DataSourceRef& source, float size )
+std::vector<std::pair<SdfText::Font::Glyph, vec2>> SdfText::getGlyphPlacements( const std::string &str, const Rectf &fitRect, const DrawOptions &options ) const
 {
-	ci::IStreamRef is = source->createStream();
-	if( ! is ) {
-		throw ci::Exception( "Invalid source" );
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_GLYPH_PLACEMENTS_FIT, str, fitRect, vec2( 0 ), 0.0f, std::string(), options );
 	}
-	
-	// File ident: SDFT
-	{
-		uint8_t ident[4];
-		is->readData( ident, 4 );
-		if( std::string( "SDFT") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
-			throw ci::Exception( "Not a SDF text cache file" );
-		}
-	}
-
-	// Version
-	uint32_t version = 0;
-	is->readLittle( &version );
 
-	// Font
-	SdfText::Font font;
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, (int)fitRect.getHeight() ).ligate( options.getLigate() );
+	return tbox.measureGlyphs( options );
+}
 
-	// Name
-	{
-		uint32_t nameLength = 0;
-		is->readLittle( &nameLength );
-		std::vector<uint8_t> nameBuf( nameLength );
-		is->readData( nameBuf.data(), nameLength );
-		font.mName = std::string( reinterpret_cast<const char *>( nameBuf.data() ), nameBuf.size() );
+std::vector<std::pair<SdfText::Font::Glyph, vec2>> SdfText::getGlyphPlacementsWrapped( const std::string &str, const Rectf &fitRect, const DrawOptions &options ) const
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_GLYPH_PLACEMENTS_WRAPPED, str, fitRect, vec2( 0 ), 0.0f, std::string(), options );
 	}
 
-	// Size
-	is->readLittle( &(font.mSize) );
-	// Leading
-	is->readLittle( &(font.mLeading) );
-	// Height
-	is->readLittle( &(font.mHeight) );
-	// Ascent
-	is->readLittle( &(font.mAscent) );
-	// Descent
-	is->readLittle( &(font.mDescent) );
+	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() );
+	return tbox.measureGlyphs( options );
+}
 
-	// Override font size if it's requested
-	float fontSizeScale = 1.0f;
-	if( size > 0.0f ) {
-		fontSizeScale = size / font.mSize;
-		font.mSize = size;
+SdfText::Font::GlyphMeasuresList SdfText::truncate( const std::string &str, float maxWidth, const std::string &ellipsis, const DrawOptions &options ) const
+{
+	TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		traceCall( TRACE_TRUNCATE, str, Rectf( 0, 0, 0, 0 ), vec2( 0 ), maxWidth, ellipsis, options );
 	}
 
-	// Create SdfText
-	SdfText::Format format = SdfText::Format();
-	SdfTextRef sdfText = SdfTextRef( new SdfText( font, format, "", false ) );
-
-	// Char/glyph maps
-	{
-		// Char/glyph ident: CHGL
-		uint8_t ident[4];
-		is->readData( ident, 4 );
-		if( std::string( "CHGL") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
-			throw ci::Exception( "Char/glyph ident not found" );
-		}
+	SdfText::Font::GlyphMeasuresList result;
 
-		// Number of chars
-		uint32_t numChars = 0;
-		is->readLittle( &numChars );
-		// Chars/glyphs
-		for( uint32_t i = 0; i < numChars; ++i ) {
-			uint32_t ch = 0;
-			SdfText::Font::Glyph glyph = 0;
-			is->readLittle( &ch );
-			is->readLittle( &glyph );
-			SdfText::Font::Char sdftCh = static_cast<SdfText::Font::Char>( ch );
-			sdfText->mCharToGlyph[sdftCh] = glyph;
-			sdfText->mGlyphToChar[glyph] = sdftCh;
-		}		
+	// Glyph positions are unscaled, so is the limit
+	const float limit = maxWidth / options.getScale();
+	// Synthetic bold widens every glyph like SdfTextBox does
+	const float embolden = getEmbolden( options );
+	// Glyphs can be added while the text is truncated on another thread, the text and the ellipsis read the same tables
+	GlyphTablesReader tables( this );
+	const auto& charToGlyph = tables->mCharToGlyph;
+	const auto& glyphMetrics = tables->mGlyphMetrics;
+
+	// Glyph, advance and right edge relative to the pen, unmapped chars are skipped like SdfTextBox does
+	struct GlyphAdvance {
+		SdfText::Font::Glyph	glyph;
+		float					advance;
+		float					extent;
+		bool					space;
+	};
+	auto appendGlyphs = [&charToGlyph, &glyphMetrics, embolden]( const std::string &utf8, ScratchVector<GlyphAdvance> *glyphs ) {
+		std::u32string utf32Chars = ci::toUtf32( utf8 );
+		for( const auto& ch : utf32Chars ) {
+			auto glyphIndexIt = charToGlyph.find( static_cast<uint32_t>( ch ) );
+			if( charToGlyph.end() == glyphIndexIt ) {
+				continue;
+			}
+			auto glyphMetricIt = glyphMetrics.find( glyphIndexIt->second );
+			if( glyphMetrics.end() == glyphMetricIt ) {
+				continue;
+			}
+			GlyphAdvance glyphAdvance = { glyphIndexIt->second, glyphMetricIt->second.advance.x + ( 2.0f * embolden ), glyphMetricIt->second.maximum.x + ( 2.0f * embolden ), ( 32 == ch ) };
+			glyphs->push_back( glyphAdvance );
+		}
+	};
+
+	ScratchVector<GlyphAdvance> ellipsisGlyphs;
+	appendGlyphs( ellipsis, &ellipsisGlyphs );
+	float ellipsisWidth = 0.0f;
+	for( size_t i = 0; i < ellipsisGlyphs.size(); ++i ) {
+		ellipsisWidth = ( ( i + 1 ) < ellipsisGlyphs.size() ) ? ( ellipsisWidth + ellipsisGlyphs[i].advance ) : ( ellipsisWidth + ellipsisGlyphs[i].extent );
 	}
 
-	// Glyph metrics
-	{
-		// File ident: SDFT
-		uint8_t ident[4];
-		is->readData( ident, 4 );
-		if( std::string( "GLMT") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
-			throw ci::Exception( "Glyph metrics ident not found" );
+	ScratchVector<GlyphAdvance> glyphs;
+	appendGlyphs( str, &glyphs );
+
+	// Walk the cumulative advances. numKept is the number of glyphs that still leave room for the ellipsis.
+	float pen = 0.0f;
+	size_t numKept = 0;
+	float keptPen = 0.0f;
+	bool overflow = false;
+	for( size_t i = 0; i < glyphs.size(); ++i ) {
+		if( ( pen + glyphs[i].extent ) > limit ) {
+			overflow = true;
+			break;
 		}
-
-		// Number of glyph metrics
-		uint32_t numGlyphMetrics = 0;
-		is->readLittle( &numGlyphMetrics );
-		// Glyph metrics
-		for( uint32_t i = 0; i < numGlyphMetrics; ++i ) {
-			SdfText::Font::Glyph glyph = 0;
-			SdfText::Font::GlyphMetrics metrics = {};
-			is->readLittle( &glyph );
-			is->readLittle( &(metrics.advance.x) );
-			is->readLittle( &(metrics.advance.y) );
-			is->readLittle( &( metrics.minimum.x ) );
-			is->readLittle( &( metrics.minimum.y ) );
-			is->readLittle( &( metrics.maximum.x ) );
-			is->readLittle( &( metrics.maximum.y ) );
-			metrics.advance *= fontSizeScale;
-			metrics.minimum *= fontSizeScale;
-			metrics.maximum *= fontSizeScale;
-			sdfText->mGlyphMetrics[glyph] = metrics;
+		result.push_back( std::make_pair( glyphs[i].glyph, vec2( pen + embolden, 0.0f ) ) );
+		pen += glyphs[i].advance;
+		if( ( pen + ellipsisWidth ) <= limit ) {
+			numKept = i + 1;
+			keptPen = pen;
 		}
 	}
 
-	// Texture atlases
-	{
-		// File ident: TXAT
-		uint8_t ident[4];
-		is->readData( ident, 4 );
-		if( std::string( "TXAT") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
-			throw ci::Exception( "Texture atlas ident not found" );
-		}
+	if( ! overflow ) {
+		return result;
+	}
 
-		// Create TextureAtlas
-		TextureAtlasRef textureAtlases = TextureAtlasRef( new TextureAtlas() );
+	// Drop trailing spaces so the ellipsis follows the last visible glyph
+	while( ( numKept > 0 ) && glyphs[numKept - 1].space ) {
+		--numKept;
+		keptPen -= glyphs[numKept].advance;
+	}
+	result.resize( numKept );
 
-		// SDF scale
-		is->readLittle( &(textureAtlases->mSdfScale.x) );
-		is->readLittle( &(textureAtlases->mSdfScale.y) );
-		// SDF padding
-		is->readLittle( &(textureAtlases->mSdfPadding.x) );
-		is->readLittle( &(textureAtlases->mSdfPadding.y) );
-		// SDF bitmap size
-		is->readLittle( &(textureAtlases->mSdfBitmapSize.x) );
-		is->readLittle( &(textureAtlases->mSdfBitmapSize.y) );
-		// Max glyph size
-		is->readLittle( &(textureAtlases->mMaxGlyphSize.x) );
-		is->readLittle( &(textureAtlases->mMaxGlyphSize.y) );
-		// Max ascent
-		is->readLittle( &(textureAtlases->mMaxAscent) );
-		// Max descent
-		is->readLittle( &(textureAtlases->mMaxDescent) );
+	for( const auto& glyphAdvance : ellipsisGlyphs ) {
+		result.push_back( std::make_pair( glyphAdvance.glyph, vec2( keptPen + embolden, 0.0f ) ) );
+		keptPen += glyphAdvance.advance;
+	}
 
-		// Number of glyphs
-		uint32_t numGlyphs = 0;
-		is->readLittle( &numGlyphs );
-		// Glyph info
-		for( uint32_t i = 0; i < numGlyphs; ++i ) {
-			SdfText::Font::Glyph glyph = 0;
-			SdfText::Font::GlyphInfo glyphInfo = {};
-			is->readLittle( &glyph );
-			is->readLittle( &(glyphInfo.mTextureIndex) );
-			is->readLittle( &(glyphInfo.mTexCoords.x1) );
-			is->readLittle( &(glyphInfo.mTexCoords.y1) );
-			is->readLittle( &(glyphInfo.mTexCoords.x2) );
-			is->readLittle( &(glyphInfo.mTexCoords.y2) );
-			is->readLittle( &(glyphInfo.mOriginOffset.x) );
-			is->readLittle( &(glyphInfo.mOriginOffset.y) );
-			is->readLittle( &(glyphInfo.mSize.x) );
-			is->readLittle( &(glyphInfo.mSize.y) );
-			textureAtlases->mGlyphInfo[glyph] = glyphInfo;
+	return result;
+}
+
+std::string SdfText::defaultChars()
+{ 
+	return "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz1234567890().?!,:;'\"&*=+-/\\|@#_[]<>%^llflfiphrids\303\251\303\241\303\250\303\240"; 
+}
+
+uint32_t SdfText::addChars( const std::string &utf8Chars )
+{
+	// New glyphs go into the atlas, so it has to exist first
+	makeDrawable();
+
+	// Loaded fonts don't have a face, so the embedded outlines are used instead
+	FT_Face face = mFont.getFace();
+	if( ( nullptr == face ) && ( ! mOutlines ) ) {
+		throw ci::Exception( "Adding chars requires a font face or embedded outlines" );
+	}
+
+	SdfText::TextureAtlas::GlyphShapes glyphShapes;
+	std::u32string utf32Chars = ci::toUtf32( utf8Chars );
+	for( const auto& ch : utf32Chars ) {
+		if( mCharToGlyph.end() != mCharToGlyph.find( ch ) ) {
+			continue;
 		}
 
-		// Number of textures
-		uint32_t numTextures = 0;
-		is->readLittle( &numTextures );
-		// Textures
-		for( uint32_t i = 0; i < numTextures; ++i ) {		
-			// PNG ident: PNGF
-			uint8_t ident[4];
-			is->readData( ident, 4 );
-			if( std::string( "PNGF") != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
-				throw ci::Exception( "PNG ident not found" );
+		SdfText::Font::Glyph glyphIndex = 0;
+		SdfText::Font::GlyphMetrics glyphMetrics = {};
+		msdfgen::Shape shape;
+		if( nullptr != face ) {
+			glyphIndex = static_cast<SdfText::Font::Glyph>( FT_Get_Char_Index( face, static_cast<FT_ULong>( ch ) ) );
+			if( ! msdfgen::loadGlyph( shape, face, glyphIndex ) ) {
+				continue;
 			}
-			// Read buffer
-			uint32_t bufferSize = 0;
-			is->readLittle( &bufferSize );
-			BufferRef buffer = Buffer::create( bufferSize );
-			is->readData( buffer->getData(), buffer->getSize() );
-			// Create surface
-			ImageSourceRef pngSource = loadImage( DataSourceBuffer::create( buffer ) );
-			gl::TextureRef tex = gl::Texture2d::create( pngSource );
-			// Add texture
-			textureAtlases->mTextures.push_back( tex );
+			glyphMetrics = loadGlyphMetrics( face, glyphIndex );
+			// Keep the outlines complete so a saved copy can still be extended
+			if( mOutlines ) {
+				mOutlines->mShapes[glyphIndex] = shape;
+			}
+		}
+		else {
+			auto charIt = mOutlines->mCharToGlyph.find( ch );
+			if( mOutlines->mCharToGlyph.end() == charIt ) {
+				continue;
+			}
+			glyphIndex = charIt->second;
+			auto shapeIt = mOutlines->mShapes.find( glyphIndex );
+			if( mOutlines->mShapes.end() == shapeIt ) {
+				continue;
+			}
+			shape = shapeIt->second;
+			auto metricsIt = mOutlines->mGlyphMetrics.find( glyphIndex );
+			glyphMetrics = ( mOutlines->mGlyphMetrics.end() != metricsIt ) ? metricsIt->second : mGlyphMetrics[glyphIndex];
 		}
 
-		sdfText->mTextureAtlases = textureAtlases;
+		// Char is now part of the atlas
+		mCharToGlyph[ch] = glyphIndex;
+		mGlyphToChar[glyphIndex] = ch;
+		if( mOutlines ) {
+			mOutlines->mCharToGlyph.erase( ch );
+			mOutlines->mGlyphMetrics.erase( glyphIndex );
+		}
+
+		// Multiple chars can map to the same glyph
+		const bool rendered = ( mTextureAtlases->mGlyphInfo.end() != mTextureAtlases->mGlyphInfo.find( glyphIndex ) );
+		const bool pending = std::any_of( std::begin( glyphShapes ), std::end( glyphShapes ),
+			[glyphIndex]( const std::pair<SdfText::Font::Glyph, msdfgen::Shape> &elem ) -> bool {
+				return elem.first == glyphIndex;
+			}
+		);
+		if( rendered || pending ) {
+			continue;
+		}
+
+		mGlyphMetrics[glyphIndex] = glyphMetrics;
+		glyphShapes.push_back( std::make_pair( glyphIndex, shape ) );
 	}
 
-	return sdfText;
+	mTextureAtlases->appendGlyphs( glyphShapes );
+	publishGlyphTables();
+
+	return static_cast<uint32_t>( glyphShapes.size() );
 }
 
-SdfTextRef SdfText::load( const ci::fs::path& filePath, float size )
+bool SdfText::isSdfInverted() const
 {
-	return SdfText::load( ci::DataSourcePath::create( filePath ), size );
+	return mTextureAtlases && mTextureAtlases->mInvertSdf;
 }
 
-void SdfText::drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baselineIn, const DrawOptions &options, const std::vector<ColorA8u> &colors )
+SdfText::GlyphTablesReader::GlyphTablesReader( const SdfText *sdfText )
+	: mTables( std::atomic_load( &sdfText->mGlyphTables ) )
 {
-	const auto& textures = mTextureAtlases->mTextures;
-	const auto& glyphMap = mTextureAtlases->mGlyphInfo;
-	const auto& sdfScale = mTextureAtlases->mSdfScale;
-	const auto& sdfPadding = mTextureAtlases->mSdfPadding;
-	const auto& sdfBitmapSize = mTextureAtlases->mSdfBitmapSize;
+}
 
-	if( textures.empty() ) {
-		return;
+void SdfText::publishGlyphTables()
+{
+	// The copies come from the resource of the format
+	SdfText::MemoryResource *memoryResource = mGlyphToChar.get_allocator().getResource();
+	SdfText::CharToGlyphTable charToGlyph( mCharToGlyph.begin(), mCharToGlyph.end(), mCharToGlyph.bucket_count(), mCharToGlyph.hash_function(), mCharToGlyph.key_eq(), SdfText::CharToGlyphTable::allocator_type( memoryResource ) );
+	SdfText::GlyphMetricsTable glyphMetrics( mGlyphMetrics.begin(), mGlyphMetrics.end(), mGlyphMetrics.key_comp(), SdfText::GlyphMetricsTable::allocator_type( memoryResource ) );
+	std::shared_ptr<GlyphTables> tables = std::make_shared<GlyphTables>( GlyphTables{ std::move( charToGlyph ), std::move( glyphMetrics ), SdfText::GlyphInfoTable( SdfText::GlyphInfoTable::allocator_type( memoryResource ) ), std::vector<ivec2>(), vec2( 1.0f ), vec2( 0.0f ), ivec2( 0 ), 0.0f } );
+	if( mTextureAtlases ) {
+		tables->mGlyphInfo = mTextureAtlases->mGlyphInfo;
+		tables->mSdfScale = mTextureAtlases->mSdfScale;
+		tables->mSdfPadding = vec2( mTextureAtlases->mSdfPadding );
+		tables->mSdfBitmapSize = mTextureAtlases->mSdfBitmapSize;
+		tables->mSdfRange = mTextureAtlases->mSdfRange;
+		for( const auto& page : mTextureAtlases->mPages ) {
+			tables->mPageSizes.push_back( page.mSize );
+		}
 	}
 
-	if( ! colors.empty() ) {
-		assert( glyphMeasures.size() == colors.size() );
-	}
+	// Readers that still hold the previous tables keep them alive until they are done
+	std::atomic_store( &mGlyphTables, std::shared_ptr<const GlyphTables>( std::move( tables ) ) );
+}
 
-	auto shader = options.getGlslProg();
-	if( ! shader ) {
-		shader = SdfText::defaultShader();
+uint32_t SdfText::addDeferredChars( size_t maxChars )
+{
+	const size_t numChars = std::min( maxChars, mDeferredChars.size() );
+	if( 0 == numChars ) {
+		return 0;
 	}
-	ScopedTextureBind texBindScp( textures[0] );
-	ScopedGlslProg glslScp( shader );
+	const std::u32string utf32Chars = mDeferredChars.substr( 0, numChars );
+	mDeferredChars.erase( 0, numChars );
+	return addChars( ci::toUtf8( utf32Chars ) );
+}
 
-	vec2 baseline = baselineIn;
+std::vector<std::pair<SdfText::Font::Char, uint64_t>> SdfText::getUsage() const
+{
+	std::vector<std::pair<SdfText::Font::Char, uint64_t>> result;
+	if( mUsage ) {
+		result = mUsage->calcCharCounts( mGlyphToChar );
+	}
+	return result;
+}
 
-	if( ! options.getGlslProg() ) {
-		shader->uniform( "uFgColor", gl::context()->getCurrentColor() );
-		shader->uniform( "uPremultiply", options.getPremultiply() ? 1.0f : 0.0f );
-		shader->uniform( "uGamma", options.getGamma() );
-#if defined(CINDER_GL_ES)
-		shader->uniform( "uTexSize", vec2( textures[0]->getSize() ) );
-#endif
+void SdfText::saveUsageProfile() const
+{
+	if( ! mUsage ) {
+		throw ci::Exception( "No usage profile, see Format::usageProfile()" );
 	}
+	mUsage->save( mGlyphToChar );
+}
 
-	const vec2 fontRenderScale = vec2( mFont.getSize() ) / ( 32.0f * mTextureAtlases->mSdfScale );
-	const vec2 fontOriginScale = vec2( mFont.getSize() ) / 32.0f;
+const SdfText::AtlasStats& SdfText::getAtlasStats() const
+{
+	return mTextureAtlases->mStats;
+}
 
-	const float scale = options.getScale();
-	for( size_t texIdx = 0; texIdx < textures.size(); ++texIdx ) {
-		std::vector<float> verts, texCoords;
-		std::vector<ColorA8u> vertColors;
-		const gl::TextureRef &curTex = textures[texIdx];
+const SdfText::AtlasStats& SdfText::getHighResAtlasStats() const
+{
+	static const SdfText::AtlasStats sEmptyStats;
+	return mHighResAtlas ? mHighResAtlas->mStats : sEmptyStats;
+}
 
-		std::vector<uint32_t> indices;
-		uint32_t curIdx = 0;
-		GLenum indexType = GL_UNSIGNED_INT;
+const SdfText::TextureAtlasRef& SdfText::selectAtlas( const GlyphMeasuresView &glyphMeasures, size_t glyphBegin, size_t glyphEnd, const DrawOptions &options, float pixelScale )
+{
+	if( mMetricsOnly || ( mFormat.getHighResScale() <= 1.0f ) ) {
+		return mTextureAtlases;
+	}
+	const float pixelSize = mFont.getSize() * options.getScale() * ( ( pixelScale > 0.0f ) ? pixelScale : getPixelScale() );
+	if( pixelSize < mFormat.getHighResThreshold() ) {
+		return mTextureAtlases;
+	}
 
-		if( options.getPixelSnap() ) {
-			baseline = vec2( floor( baseline.x ), floor( baseline.y ) );
+	// Tiles come from the font face or the embedded outlines, like addChars()
+	FT_Face face = mFont.getFace();
+	if( ( nullptr == face ) && ( ! mOutlines ) ) {
+		return mTextureAtlases;
+	}
+	if( ! mHighResAtlas ) {
+		mHighResAtlas = mTextureAtlases->createScaled( mFormat.getHighResScale(), mFormat.getTextureSize(), ( nullptr != face ) ? mFormat.getGlyphCacheDir() : fs::path() );
+	}
+	// Picks up the tiles that completed since the last draw
+	mHighResAtlas->writeDeferredTiles();
+
+	SdfText::TextureAtlas::GlyphShapes glyphShapes;
+	std::set<SdfText::Font::Glyph> pending;
+	for( size_t i = glyphBegin; i < glyphEnd; ++i ) {
+		const SdfText::Font::Glyph glyphIndex = glyphMeasures[i].first;
+		if( mHighResAtlas->hasGlyph( glyphIndex ) || ( ! mTextureAtlases->hasGlyph( glyphIndex ) ) || ( ! pending.insert( glyphIndex ).second ) ) {
+			continue;
 		}
-			
-		for( std::vector<std::pair<SdfText::Font::Glyph,vec2> >::const_iterator glyphIt = glyphMeasures.begin(); glyphIt != glyphMeasures.end(); ++glyphIt ) {
-			SdfText::Font::GlyphInfoMap::const_iterator glyphInfoIt = glyphMap.find( glyphIt->first );
-			if(  glyphInfoIt == glyphMap.end() ) {
+		msdfgen::Shape shape;
+		if( nullptr != face ) {
+			if( ! msdfgen::loadGlyph( shape, face, glyphIndex ) ) {
 				continue;
 			}
-				
-			const auto &glyphInfo = glyphInfoIt->second;
-			if( glyphInfo.mTextureIndex != texIdx ) {
+		}
+		else {
+			auto shapeIt = mOutlines->mShapes.find( glyphIndex );
+			if( mOutlines->mShapes.end() == shapeIt ) {
 				continue;
 			}
+			shape = shapeIt->second;
+		}
+		glyphShapes.push_back( std::make_pair( glyphIndex, shape ) );
+	}
+	// Rendered on the executor so that the first draw past the threshold doesn't stall the frame
+	mHighResAtlas->appendGlyphs( glyphShapes, true );
+
+	// Glyphs without a finished high resolution tile keep the whole draw on the base atlas
+	for( size_t i = glyphBegin; i < glyphEnd; ++i ) {
+		const SdfText::Font::Glyph glyphIndex = glyphMeasures[i].first;
+		if( mTextureAtlases->hasGlyph( glyphIndex ) && ( ( ! mHighResAtlas->hasGlyph( glyphIndex ) ) || mHighResAtlas->isGlyphPending( glyphIndex ) ) ) {
+			return mTextureAtlases;
+		}
+	}
+	return mHighResAtlas;
+}
 
-			const auto &originOffset = glyphInfo.mOriginOffset;
-
-			Rectf srcTexCoords = curTex->getAreaTexCoords( glyphInfo.mTexCoords );
-			Rectf destRect = Rectf( glyphInfo.mTexCoords );
-			destRect.scale( scale );
-			destRect -= destRect.getUpperLeft();
-			vec2 offset = vec2( 0, -( destRect.getHeight() ) );
-			// Reverse the transformation applied during SDF generation
-			float tx = sdfPadding.x;
-			float ty = std::fabs( originOffset.y ) + sdfPadding.y;
-			offset += scale * sdfScale * vec2( -tx, ty );
-			// Use origin scale for horizontal offset
-			offset += scale * fontOriginScale * vec2( originOffset.x, 0.0f );
-			destRect += offset;
-			destRect.scale( fontRenderScale );
+uint32_t SdfText::getNumTextures() const
+{
+	return mTextureAtlases->getNumPages();
+}
 
-			destRect += glyphIt->second * scale;
-			destRect += baseline;
-			
-			verts.push_back( destRect.getX2() ); verts.push_back( destRect.getY1() );
-			verts.push_back( destRect.getX1() ); verts.push_back( destRect.getY1() );
-			verts.push_back( destRect.getX2() ); verts.push_back( destRect.getY2() );
-			verts.push_back( destRect.getX1() ); verts.push_back( destRect.getY2() );
-
-			texCoords.push_back( srcTexCoords.getX2() ); texCoords.push_back( srcTexCoords.getY1() );
-			texCoords.push_back( srcTexCoords.getX1() ); texCoords.push_back( srcTexCoords.getY1() );
-			texCoords.push_back( srcTexCoords.getX2() ); texCoords.push_back( srcTexCoords.getY2() );
-			texCoords.push_back( srcTexCoords.getX1() ); texCoords.push_back( srcTexCoords.getY2() );
-			
-			if( ! colors.empty() ) {
-				for( int i = 0; i < 4; ++i ) {
-					vertColors.push_back( colors[glyphIt-glyphMeasures.begin()] );
-				}
-			}
+const gl::TextureRef& SdfText::getTexture(uint32_t n) const
+{
+	return mTextureAtlases->getTextures()[static_cast<size_t>( n )];
+}
 
-			indices.push_back( curIdx + 0 ); indices.push_back( curIdx + 1 ); indices.push_back( curIdx + 2 );
-			indices.push_back( curIdx + 2 ); indices.push_back( curIdx + 1 ); indices.push_back( curIdx + 3 );
-			curIdx += 4;
-		}
-		
-		if( curIdx == 0 ) {
-			continue;
-		}
-		
-		curTex->bind();
-		auto ctx = gl::context();
-		size_t dataSize = (verts.size() + texCoords.size()) * sizeof(float) + vertColors.size() * sizeof(ColorA8u);
-		gl::ScopedVao vaoScp( ctx->getDefaultVao() );
-		ctx->getDefaultVao()->replacementBindBegin();
-		VboRef defaultElementVbo = ctx->getDefaultElementVbo( indices.size() * sizeof(curIdx) );
-		VboRef defaultArrayVbo = ctx->getDefaultArrayVbo( dataSize );
+void SdfText::releasePageData()
+{
+	mTextureAtlases->releasePageData();
+	if( mHighResAtlas ) {
+		mHighResAtlas->releasePageData();
+	}
+}
 
-		ScopedBuffer vboArrayScp( defaultArrayVbo );
-		ScopedBuffer vboElScp( defaultElementVbo );
+void SdfText::releaseContextTextures()
+{
+	mTextureAtlases->releaseContextTextures();
+	if( mHighResAtlas ) {
+		mHighResAtlas->releaseContextTextures();
+	}
+}
 
-		size_t dataOffset = 0;
-		int posLoc = shader->getAttribSemanticLocation( geom::Attrib::POSITION );
-		if( posLoc >= 0 ) {
-			enableVertexAttribArray( posLoc );
-			vertexAttribPointer( posLoc, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
-			defaultArrayVbo->bufferSubData( dataOffset, verts.size() * sizeof(float), verts.data() );
-			dataOffset += verts.size() * sizeof(float);
-		}
-		int texLoc = shader->getAttribSemanticLocation( geom::Attrib::TEX_COORD_0 );
-		if( texLoc >= 0 ) {
-			enableVertexAttribArray( texLoc );
-			vertexAttribPointer( texLoc, 2, GL_FLOAT, GL_FALSE, 0, (void*)dataOffset );
-			defaultArrayVbo->bufferSubData( dataOffset, texCoords.size() * sizeof(float), texCoords.data() );
-			dataOffset += texCoords.size() * sizeof(float);
-		}
-		if( ! vertColors.empty() ) {
-			int colorLoc = shader->getAttribSemanticLocation( geom::Attrib::COLOR );
-			if( colorLoc >= 0 ) {
-				enableVertexAttribArray( colorLoc );
-				vertexAttribPointer( colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)dataOffset );
-				defaultArrayVbo->bufferSubData( dataOffset, vertColors.size() * sizeof(ColorA8u), vertColors.data() );
-				dataOffset += vertColors.size() * sizeof(ColorA8u);				
-			}
+gl::GlslProgRef SdfText::defaultShader()
+{
+	if( ! sDefaultShader ) {
+		try {
+			sDefaultShader = gl::GlslProg::create( kSdfVertShader, kSdfFragShader );
 		}
+		catch( const std::exception& e ) {
+			CI_LOG_E( "SdfText::defaultShader error: " << e.what() );
+		}
+	}
+	return sDefaultShader;
+}
 
-		defaultElementVbo->bufferSubData( 0, indices.size() * sizeof(curIdx), indices.data() );
-		ctx->getDefaultVao()->replacementBindEnd();
-		gl::setDefaultShaderVars();
-		ctx->drawElements( GL_TRIANGLES, (GLsizei)indices.size(), indexType, 0 );
+gl::GlslProgRef SdfText::colorSpanShader()
+{
+	if( ! sColorSpanShader ) {
+		try {
+			sColorSpanShader = gl::GlslProg::create( kSdfColorSpanVertShader, makeFgColorInFragShader( false ) );
+		}
+		catch( const std::exception& e ) {
+			CI_LOG_E( "SdfText::colorSpanShader error: " << e.what() );
+		}
 	}
+	return sColorSpanShader;
 }
 
-void SdfText::drawGlyphs( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const Rectf &clip, vec2 offset, const DrawOptions &options, const std::vector<ColorA8u> &colors )
+gl::GlslProgRef SdfText::vertexColorShader()
 {
-	const auto& textures = mTextureAtlases->mTextures;
-	const auto& glyphMap = mTextureAtlases->mGlyphInfo;
-	const auto& sdfPadding = mTextureAtlases->mSdfPadding;
-	const auto& sdfBitmapSize = mTextureAtlases->mSdfBitmapSize;
+	if( ! sVertexColorShader ) {
+		try {
+			sVertexColorShader = gl::GlslProg::create( kSdfVertexColorVertShader, makeFgColorInFragShader( true, true ) );
+		}
+		catch( const std::exception& e ) {
+			CI_LOG_E( "SdfText::vertexColorShader error: " << e.what() );
+		}
+	}
+	return sVertexColorShader;
+}
 
-	if( textures.empty() ) {
-		return;
+gl::GlslProgRef SdfText::meshShader()
+{
+	if( ! sMeshShader ) {
+		try {
+			sMeshShader = gl::GlslProg::create( kSdfMeshVertShader, makeFgColorInFragShader( true, true ) );
+		}
+		catch( const std::exception& e ) {
+			CI_LOG_E( "SdfText::meshShader error: " << e.what() );
+		}
 	}
+	return sMeshShader;
+}
 
-	if( ! colors.empty() ) {
-		assert( glyphMeasures.size() == colors.size() );
+float SdfText::getEmbolden( const DrawOptions &options ) const
+{
+	// The baked distance range is in pixels at 32 px, an offset of half the range is the edge of the field
+	const float maxEmbolden = 0.45f * GlyphTablesReader( this )->mSdfRange * ( mFont.getSize() / 32.0f );
+	return std::min( std::max( options.getEmbolden(), -maxEmbolden ), maxEmbolden );
+}
+
+float SdfText::getEmboldenDistance( const DrawOptions &options ) const
+{
+	// Distances are stored as distance / range + 0.5
+	const float range = GlyphTablesReader( this )->mSdfRange * ( mFont.getSize() / 32.0f );
+	return ( range > 0.0f ) ? ( getEmbolden( options ) / range ) : 0.0f;
+}
+
+float SdfText::getPixelScale()
+{
+	const mat4 mvp = gl::getModelViewProjection();
+	const Area viewport = gl::getViewport();
+	const vec2 halfSize = vec2( viewport.getSize() ) * 0.5f;
+	auto toWindow = [&]( const vec4 &p ) { return vec2( p.x / p.w, p.y / p.w ) * halfSize; };
+	const vec2 origin = toWindow( mvp * vec4( 0, 0, 0, 1 ) );
+	const vec2 unitX = toWindow( mvp * vec4( 1, 0, 0, 1 ) );
+	const vec2 unitY = toWindow( mvp * vec4( 0, 1, 0, 1 ) );
+	return std::max( length( unitX - origin ), length( unitY - origin ) );
+}
+
+// =================================================================================================
+// SdfText::TextPath
+// =================================================================================================
+
+void SdfText::TextPath::setPoints( const std::vector<vec2> &points )
+{
+	mPoints.clear();
+	mLengths.clear();
+	mPoints.reserve( points.size() );
+	mLengths.reserve( points.size() );
+	for( const auto &point : points ) {
+		if( mPoints.empty() ) {
+			mPoints.push_back( point );
+			mLengths.push_back( 0.0f );
+			continue;
+		}
+		const float segmentLength = length( point - mPoints.back() );
+		if( segmentLength <= 0.0f ) {
+			continue;
+		}
+		mLengths.push_back( mLengths.back() + segmentLength );
+		mPoints.push_back( point );
 	}
+}
 
-	auto shader = options.getGlslProg();
-	if( ! shader ) {
-		shader = SdfText::defaultShader();
+vec2 SdfText::TextPath::calcPosition( float distance, vec2 *tangent ) const
+{
+	vec2 position, direction;
+	calcPositions( &distance, 1, &position, &direction );
+	if( tangent ) {
+		*tangent = direction;
 	}
-	ScopedTextureBind texBindScp( textures[0] );
-	ScopedGlslProg glslScp( shader );
+	return position;
+}
 
-	if( ! options.getGlslProg() ) {
-		shader->uniform( "uFgColor", gl::context()->getCurrentColor() );
-		shader->uniform( "uPremultiply", options.getPremultiply() ? 1.0f : 0.0f );
-		shader->uniform( "uGamma", options.getGamma() );
-#if defined(CINDER_GL_ES)
-		shader->uniform( "uTexSize", vec2( textures[0]->getSize() ) );
-#endif
+void SdfText::TextPath::calcPositions( const float *distances, size_t count, vec2 *positions, vec2 *tangents ) const
+{
+	if( mPoints.size() < 2 ) {
+		const vec2 point = mPoints.empty() ? vec2( 0 ) : mPoints.front();
+		for( size_t i = 0; i < count; ++i ) {
+			positions[i] = point;
+			tangents[i] = vec2( 1, 0 );
+		}
+		return;
 	}
 
-	const vec2 fontRenderScale = vec2( mFont.getSize() ) / ( 32.0f * mTextureAtlases->mSdfScale );
-	const vec2 fontOriginScale = vec2( mFont.getSize() ) / 32.0f;
+	// Segment i runs from point i to point i + 1
+	const size_t lastSegment = mPoints.size() - 2;
+	size_t segment = 0;
+	for( size_t i = 0; i < count; ++i ) {
+		const float distance = distances[i];
+		if( distance < mLengths[segment] ) {
+			// Went backwards, look the segment up again
+			auto it = std::upper_bound( mLengths.begin(), mLengths.end(), distance );
+			segment = ( it == mLengths.begin() ) ? 0 : static_cast<size_t>( it - mLengths.begin() ) - 1;
+		}
+		while( ( segment < lastSegment ) && ( distance >= mLengths[segment + 1] ) ) {
+			++segment;
+		}
+		segment = std::min( segment, lastSegment );
+
+		const vec2 &p0 = mPoints[segment];
+		const vec2 &p1 = mPoints[segment + 1];
+		const float segmentLength = mLengths[segment + 1] - mLengths[segment];
+		const vec2 direction = ( p1 - p0 ) / segmentLength;
+		positions[i] = p0 + direction * ( distance - mLengths[segment] );
+		tangents[i] = direction;
+	}
+}
 
-	const float scale = options.getScale();
-	for( size_t texIdx = 0; texIdx < textures.size(); ++texIdx ) {
-		std::vector<float> verts, texCoords;
-		std::vector<ColorA8u> vertColors;
-		const gl::TextureRef &curTex = textures[texIdx];
+// =================================================================================================
+// SdfText::Impostor
+// =================================================================================================
 
-		std::vector<uint32_t> indices;
-		uint32_t curIdx = 0;
-		GLenum indexType = GL_UNSIGNED_INT;
+void SdfText::Impostor::draw( const Rectf &bounds, const std::function<void()> &drawFn )
+{
+	if( ( bounds.getWidth() <= 0.0f ) || ( bounds.getHeight() <= 0.0f ) ) {
+		return;
+	}
 
-		if( options.getPixelSnap() ) {
-			offset = vec2( floor( offset.x ), floor( offset.y ) );
+	const float pixelScale = SdfText::getPixelScale();
+	const ivec2 viewportSize = gl::getViewport().getSize();
+	const ColorA color = gl::context()->getCurrentColor();
+	// Small scale changes from float noise keep the cache
+	const bool sameScale = std::fabs( pixelScale - mPixelScale ) <= ( 0.01f * mPixelScale );
+	const bool sameBounds = ( bounds.getUpperLeft() == mBounds.getUpperLeft() ) && ( bounds.getLowerRight() == mBounds.getLowerRight() );
+	if( ( ! mValid ) || ( ! mFbo ) || ( ! sameScale ) || ( ! sameBounds ) || ( viewportSize != mViewportSize ) || ( color != mColor ) ) {
+		// Pad by a couple of pixels for the anti-aliased edges
+		const float padding = 2.0f / std::max( pixelScale, 0.0001f );
+		const Rectf paddedBounds = Rectf( bounds.x1 - padding, bounds.y1 - padding, bounds.x2 + padding, bounds.y2 + padding );
+		const int kMaxSize = 8192;
+		const ivec2 size = ivec2( 
+			std::min( kMaxSize, std::max( 1, static_cast<int>( std::ceil( paddedBounds.getWidth() * pixelScale ) ) ) ),
+			std::min( kMaxSize, std::max( 1, static_cast<int>( std::ceil( paddedBounds.getHeight() * pixelScale ) ) ) ) );
+		if( ( ! mFbo ) || ( mFbo->getSize() != size ) ) {
+			mFbo = gl::Fbo::create( size.x, size.y, gl::Fbo::Format().disableDepth() );
 		}
 
-		for( std::vector<std::pair<Font::Glyph,vec2> >::const_iterator glyphIt = glyphMeasures.begin(); glyphIt != glyphMeasures.end(); ++glyphIt ) {
-			SdfText::Font::GlyphInfoMap::const_iterator glyphInfoIt = glyphMap.find( glyphIt->first );
-			if( glyphInfoIt == glyphMap.end() ) {
-				continue;
-			}
-				
-			const auto &glyphInfo = glyphInfoIt->second;
-			if( glyphInfo.mTextureIndex != texIdx ) {
-				continue;
-			}
-
-			Rectf srcTexCoords = curTex->getAreaTexCoords( glyphInfo.mTexCoords );
-			Rectf destRect( glyphInfo.mTexCoords );
-			destRect.scale( fontRenderScale );
-			destRect -= destRect.getUpperLeft();
-			destRect.scale( scale );
-			destRect += glyphIt->second * scale;
-			destRect += vec2( offset.x, offset.y );
-			vec2 originOffset = fontOriginScale * glyphInfo.mOriginOffset;
-			destRect += vec2( floor( originOffset.x + 0.5f ), floor( -originOffset.y ) ) * scale;
-			destRect += fontRenderScale * vec2( -sdfPadding.x, -sdfPadding.y );
-			if( options.getPixelSnap() ) {
-				destRect -= vec2( destRect.x1 - floor( destRect.x1 ), destRect.y1 - floor( destRect.y1 ) );	
-			}
+		{
+			gl::ScopedFramebuffer fboScp( mFbo );
+			gl::ScopedViewport viewportScp( ivec2( 0 ), mFbo->getSize() );
+			gl::ScopedMatrices matricesScp;
+			gl::setMatricesWindow( mFbo->getSize() );
+			gl::scale( vec2( mFbo->getSize() ) / paddedBounds.getSize() );
+			gl::translate( -paddedBounds.getUpperLeft() );
+			gl::clear( ColorA( 0, 0, 0, 0 ) );
+			gl::ScopedBlendPremult blendScp;
+			drawFn();
+		}
 
-			// clip
-			Rectf clipped( destRect );
-			if( options.getClipHorizontal() ) {
-				clipped.x1 = std::max( destRect.x1, clip.x1 );
-				clipped.x2 = std::min( destRect.x2, clip.x2 );
-			}
-			if( options.getClipVertical() ) {
-				clipped.y1 = std::max( destRect.y1, clip.y1 );
-				clipped.y2 = std::min( destRect.y2, clip.y2 );
-			}
-			
-			if( clipped.x1 >= clipped.x2 || clipped.y1 >= clipped.y2 ) {
-				continue;
-			}
+		mBounds = bounds;
+		mPixelScale = pixelScale;
+		mViewportSize = viewportSize;
+		mColor = color;
+		mValid = true;
+		++mNumMisses;
+	}
+	else {
+		++mNumHits;
+	}
 
-			verts.push_back( clipped.getX2() ); verts.push_back( clipped.getY1() );
-			verts.push_back( clipped.getX1() ); verts.push_back( clipped.getY1() );
-			verts.push_back( clipped.getX2() ); verts.push_back( clipped.getY2() );
-			verts.push_back( clipped.getX1() ); verts.push_back( clipped.getY2() );
+	const float padding = 2.0f / std::max( mPixelScale, 0.0001f );
+	gl::ScopedBlendPremult blendScp;
+	gl::ScopedColor colorScp( ColorA( 1, 1, 1, 1 ) );
+	gl::draw( mFbo->getColorTexture(), Rectf( bounds.x1 - padding, bounds.y1 - padding, bounds.x2 + padding, bounds.y2 + padding ) );
+}
 
-			vec2 coordScale = vec2( srcTexCoords.getWidth() / destRect.getWidth(), srcTexCoords.getHeight() / destRect.getHeight() );
-			srcTexCoords.x1 = srcTexCoords.x1 + ( clipped.x1 - destRect.x1 ) * coordScale.x;
-			srcTexCoords.x2 = srcTexCoords.x1 + ( clipped.x2 - clipped.x1  ) * coordScale.x;
-			srcTexCoords.y1 = srcTexCoords.y1 + ( clipped.y1 - destRect.y1 ) * coordScale.y;
-			srcTexCoords.y2 = srcTexCoords.y1 + ( clipped.y2 - clipped.y1  ) * coordScale.y;
+void SdfText::Impostor::release()
+{
+	mFbo.reset();
+	mValid = false;
+}
 
-			texCoords.push_back( srcTexCoords.getX2() ); texCoords.push_back( srcTexCoords.getY1() );
-			texCoords.push_back( srcTexCoords.getX1() ); texCoords.push_back( srcTexCoords.getY1() );
-			texCoords.push_back( srcTexCoords.getX2() ); texCoords.push_back( srcTexCoords.getY2() );
-			texCoords.push_back( srcTexCoords.getX1() ); texCoords.push_back( srcTexCoords.getY2() );
+size_t SdfText::Impostor::getMemoryUsage() const
+{
+	return mFbo ? ( static_cast<size_t>( mFbo->getSize().x ) * static_cast<size_t>( mFbo->getSize().y ) * 4 ) : 0;
+}
 
-			if( ! colors.empty() ) {
-				for( int i = 0; i < 4; ++i ) {
-					vertColors.push_back( colors[glyphIt-glyphMeasures.begin()] );
-				}
-			}
-			
-			indices.push_back( curIdx + 0 ); indices.push_back( curIdx + 1 ); indices.push_back( curIdx + 2 );
-			indices.push_back( curIdx + 2 ); indices.push_back( curIdx + 1 ); indices.push_back( curIdx + 3 );
-			curIdx += 4;
-		}
-		
-		if( curIdx == 0 ) {
-			continue;
-		}
-		
-		curTex->bind();
-		auto ctx = gl::context();
-		size_t dataSize = (verts.size() + texCoords.size()) * sizeof(float) + vertColors.size() * sizeof(ColorA8u);
-		gl::ScopedVao vaoScp( ctx->getDefaultVao() );
-		ctx->getDefaultVao()->replacementBindBegin();
-		VboRef defaultElementVbo = ctx->getDefaultElementVbo( indices.size() * sizeof(curIdx) );
-		VboRef defaultArrayVbo = ctx->getDefaultArrayVbo( dataSize );
+// =================================================================================================
+// SdfText::CommandList
+// =================================================================================================
 
-		ScopedBuffer vboArrayScp( defaultArrayVbo );
-		ScopedBuffer vboElScp( defaultElementVbo );
+SdfText::CommandList::CommandList()
+	: CommandList( SdfText::newDeleteResource() )
+{
+}
 
-		size_t dataOffset = 0;
-		int posLoc = shader->getAttribSemanticLocation( geom::Attrib::POSITION );
-		if( posLoc >= 0 ) {
-			enableVertexAttribArray( posLoc );
-			vertexAttribPointer( posLoc, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
-			defaultArrayVbo->bufferSubData( dataOffset, verts.size() * sizeof(float), verts.data() );
-			dataOffset += verts.size() * sizeof(float);
-		}
-		int texLoc = shader->getAttribSemanticLocation( geom::Attrib::TEX_COORD_0 );
-		if( texLoc >= 0 ) {
-			enableVertexAttribArray( texLoc );
-			vertexAttribPointer( texLoc, 2, GL_FLOAT, GL_FALSE, 0, (void*)dataOffset );
-			defaultArrayVbo->bufferSubData( dataOffset, texCoords.size() * sizeof(float), texCoords.data() );
-			dataOffset += texCoords.size() * sizeof(float);
-		}
-		if( ! vertColors.empty() ) {
-			int colorLoc = shader->getAttribSemanticLocation( geom::Attrib::COLOR );
-			if( colorLoc >= 0 ) {
-				enableVertexAttribArray( colorLoc );
-				vertexAttribPointer( colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)dataOffset );
-				defaultArrayVbo->bufferSubData( dataOffset, vertColors.size() * sizeof(ColorA8u), vertColors.data() );
-				dataOffset += vertColors.size() * sizeof(ColorA8u);				
-			}
-		}
+SdfText::CommandList::CommandList( MemoryResource *memoryResource )
+	: mVertices( std::vector<Vertex, SdfText::Allocator<Vertex>>::allocator_type( memoryResource ) ),
+	  mCommands( std::vector<Command, SdfText::Allocator<Command>>::allocator_type( memoryResource ) )
+{
+}
 
-		defaultElementVbo->bufferSubData( 0, indices.size() * sizeof(curIdx), indices.data() );
-		ctx->getDefaultVao()->replacementBindEnd();
-		gl::setDefaultShaderVars();
-		ctx->drawElements( GL_TRIANGLES, (GLsizei)indices.size(), indexType, 0 );
+void SdfText::CommandList::drawString( const SdfTextRef &sdfText, const std::string &str, const vec2 &baseline, const DrawOptions &options, const ColorA &color )
+{
+	if( ! sdfText ) {
+		throw ci::Exception( "command list needs a valid gl::SdfText" );
 	}
+	SdfTextBox tbox = SdfTextBox( sdfText.get() ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
+	ScratchVector<SdfText::Font::GlyphMeasuresList::value_type> glyphMeasures;
+	tbox.measureGlyphs( options, &glyphMeasures );
+	record( sdfText, glyphMeasures, baseline, options, color );
 }
 
-void SdfText::drawString( const std::string &str, const vec2 &baseline, const DrawOptions &options )
+void SdfText::CommandList::drawStringWrapped( const SdfTextRef &sdfText, const std::string &str, const Rectf &fitRect, const vec2 &offset, const DrawOptions &options, const ColorA &color )
 {
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
-	SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
-	drawGlyphs( glyphMeasures, baseline, options );
+	if( ! sdfText ) {
+		throw ci::Exception( "command list needs a valid gl::SdfText" );
+	}
+	SdfTextBox tbox = SdfTextBox( sdfText.get() ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() );
+	ScratchVector<SdfText::Font::GlyphMeasuresList::value_type> glyphMeasures;
+	tbox.measureGlyphs( options, &glyphMeasures );
+	record( sdfText, glyphMeasures, fitRect.getUpperLeft() + offset, options, color );
 }
 
-void SdfText::drawString( const std::string &str, const Rectf &fitRect, const vec2 &offset, const DrawOptions &options )
+void SdfText::CommandList::drawGlyphs( const SdfTextRef &sdfText, const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const DrawOptions &options, const ColorA &color )
 {
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, (int)fitRect.getHeight() ).ligate( options.getLigate() );
-	SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
-	drawGlyphs( glyphMeasures, fitRect, fitRect.getUpperLeft() + offset, options );	
+	if( ! sdfText ) {
+		throw ci::Exception( "command list needs a valid gl::SdfText" );
+	}
+	record( sdfText, glyphMeasures, baseline, options, color );
 }
 
-void SdfText::drawStringWrapped( const std::string &str, const Rectf &fitRect, const vec2 &offset, const DrawOptions &options )
+void SdfText::CommandList::clear()
 {
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() );
-	SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
-	drawGlyphs( glyphMeasures, fitRect.getUpperLeft() + offset, options );
+	mVertices.clear();
+	mCommands.clear();
 }
 
-std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeChars( const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baselineIn, const DrawOptions &options )
+void SdfText::CommandList::record( const SdfTextRef &sdfText, const GlyphMeasuresView &glyphMeasures, const vec2 &baseline, const DrawOptions &options, const ColorA &color )
 {
-	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> result;
+	if( glyphMeasures.empty() ) {
+		return;
+	}
 
-	const auto& textures = mTextureAtlases->mTextures;
-	const auto& glyphMap = mTextureAtlases->mGlyphInfo;
-	const auto& sdfScale = mTextureAtlases->mSdfScale;
-	const auto& sdfPadding = mTextureAtlases->mSdfPadding;
-	const auto& sdfBitmapSize = mTextureAtlases->mSdfBitmapSize;
+	if( sdfText->mUsage ) {
+		sdfText->mUsage->record( glyphMeasures, 0, glyphMeasures.size() );
+	}
 
-	vec2 baseline = baselineIn;
+	// Placed from a snapshot of the glyph tables, the atlas belongs to the drawing thread
+	std::vector<std::vector<CharPlacement>> pagePlacements;
+	{
+		GlyphTablesReader tables( sdfText.get() );
+		sdfText->placeGlyphs( getTileSource( *tables ), nullptr, glyphMeasures, 0, glyphMeasures.size(), baseline, nullptr, options, nullptr, &pagePlacements );
+	}
 
-	const vec2 fontRenderScale = vec2( mFont.getSize() ) / ( 32.0f * mTextureAtlases->mSdfScale );
-	const vec2 fontOriginScale = vec2( mFont.getSize() ) / 32.0f;
+	// One command per page, pages in the order their first glyph appears
+	std::vector<uint8_t> pages;
+	for( size_t page = 0; page < pagePlacements.size(); ++page ) {
+		if( ! pagePlacements[page].empty() ) {
+			pages.push_back( static_cast<uint8_t>( page ) );
+		}
+	}
+	std::sort( pages.begin(), pages.end(), [&]( uint8_t a, uint8_t b ) { return pagePlacements[a].front().mIndex < pagePlacements[b].front().mIndex; } );
+
+	const ColorA8u vertexColor = ColorA8u( color );
+	const float embolden = sdfText->getEmboldenDistance( options );
+	const float oblique = options.getOblique();
+	for( uint8_t page : pages ) {
+		Command command = { sdfText, page, options.getPremultiply(), options.getGamma(), static_cast<uint32_t>( mVertices.size() ), 0 };
+		for( const auto& place : pagePlacements[page] ) {
+			vec2 positions[4], texCoords[4];
+			place.calcQuad( oblique, positions, texCoords );
+			for( int i = 0; i < 4; ++i ) {
+				mVertices.push_back( { positions[i], texCoords[i], vertexColor, embolden } );
+			}
+		}
+		command.mVertexCount = static_cast<uint32_t>( mVertices.size() ) - command.mVertexStart;
+		mCommands.push_back( command );
+	}
+}
 
-	const float scale = options.getScale();
-	for( size_t texIdx = 0; texIdx < textures.size(); ++texIdx ) {
-		std::vector<float> verts, texCoords;
-		std::vector<ColorA8u> vertColors;
-		const gl::TextureRef &curTex = textures[texIdx];
+uint32_t SdfText::CommandList::submit() const
+{
+	return submit( std::vector<const CommandList*>( 1, this ) );
+}
 
-		if( options.getPixelSnap() ) {
-			baseline = vec2( floor( baseline.x ), floor( baseline.y ) );
-		}
+uint32_t SdfText::CommandList::submit( const std::vector<const CommandList*> &lists )
+{
+	struct Draw {
+		gl::TextureRef	mTexture;
+		bool			mPremultiply;
+		float			mGamma;
+		uint32_t		mIndexStart;
+		uint32_t		mIndexCount;
+	};
+
+	size_t numVertices = 0;
+	for( const auto& list : lists ) {
+		numVertices += list ? list->mVertices.size() : 0;
+	}
+	if( 0 == numVertices ) {
+		return 0;
+	}
 
-		std::vector<SdfText::CharPlacement> charPlacements;	
-		for( std::vector<std::pair<SdfText::Font::Glyph,vec2> >::const_iterator glyphIt = glyphMeasures.begin(); glyphIt != glyphMeasures.end(); ++glyphIt ) {
-			SdfText::Font::GlyphInfoMap::const_iterator glyphInfoIt = glyphMap.find( glyphIt->first );
-			if(  glyphInfoIt == glyphMap.end() ) {
+	// Gather the vertices of all lists, texture coords are mapped to the orientation of the page textures
+	ScratchVector<Vertex> vertices;
+	ScratchVector<uint32_t> indices;
+	std::vector<Draw> draws;
+	vertices.reserve( numVertices );
+	indices.reserve( 6 * ( numVertices / 4 ) );
+	for( const auto& list : lists ) {
+		if( ! list ) {
+			continue;
+		}
+		for( const auto& command : list->mCommands ) {
+			const auto& textures = command.mSdfText->mTextureAtlases->getTextures();
+			if( command.mPage >= textures.size() ) {
 				continue;
 			}
-				
-			const auto &glyphInfo = glyphInfoIt->second;
-			if( glyphInfo.mTextureIndex != texIdx ) {
-				continue;
+			const gl::TextureRef &tex = textures[command.mPage];
+			const Rectf pageCoords = tex->getAreaTexCoords( Area( ivec2( 0 ), tex->getSize() ) );
+			const uint32_t indexStart = static_cast<uint32_t>( indices.size() );
+			for( uint32_t i = 0; i < command.mVertexCount; i += 4 ) {
+				const uint32_t curIdx = static_cast<uint32_t>( vertices.size() );
+				for( uint32_t j = 0; j < 4; ++j ) {
+					Vertex vertex = list->mVertices[command.mVertexStart + i + j];
+					vertex.mTexCoord = vec2( pageCoords.x1 + vertex.mTexCoord.x * pageCoords.getWidth(), pageCoords.y1 + vertex.mTexCoord.y * pageCoords.getHeight() );
+					vertices.push_back( vertex );
+				}
+				indices.push_back( curIdx + 0 ); indices.push_back( curIdx + 1 ); indices.push_back( curIdx + 2 );
+				indices.push_back( curIdx + 2 ); indices.push_back( curIdx + 1 ); indices.push_back( curIdx + 3 );
+			}
+			const uint32_t indexCount = static_cast<uint32_t>( indices.size() ) - indexStart;
+			if( ( ! draws.empty() ) && ( draws.back().mTexture == tex ) && ( draws.back().mPremultiply == command.mPremultiply ) && ( draws.back().mGamma == command.mGamma ) ) {
+				draws.back().mIndexCount += indexCount;
+			}
+			else {
+				draws.push_back( { tex, command.mPremultiply, command.mGamma, indexStart, indexCount } );
 			}
+		}
+	}
+	if( draws.empty() ) {
+		return 0;
+	}
+
+	auto shader = SdfText::vertexColorShader();
+	if( ! shader ) {
+		return 0;
+	}
+	ScopedTextureBind texBindScp( draws.front().mTexture );
+	ScopedGlslProg glslScp( shader );
+	shader->uniform( "uFgColor", gl::context()->getCurrentColor() );
+
+	// One upload for all lists
+	auto ctx = gl::context();
+	gl::ScopedVao vaoScp( ctx->getDefaultVao() );
+	ctx->getDefaultVao()->replacementBindBegin();
+	VboRef defaultElementVbo = ctx->getDefaultElementVbo( indices.size() * sizeof( uint32_t ) );
+	VboRef defaultArrayVbo = ctx->getDefaultArrayVbo( vertices.size() * sizeof( Vertex ) );
+
+	ScopedBuffer vboArrayScp( defaultArrayVbo );
+	ScopedBuffer vboElScp( defaultElementVbo );
+
+	int posLoc = shader->getAttribSemanticLocation( geom::Attrib::POSITION );
+	if( posLoc >= 0 ) {
+		enableVertexAttribArray( posLoc );
+		vertexAttribPointer( posLoc, 2, GL_FLOAT, GL_FALSE, sizeof( Vertex ), (void*)offsetof( Vertex, mPosition ) );
+	}
+	int texLoc = shader->getAttribSemanticLocation( geom::Attrib::TEX_COORD_0 );
+	if( texLoc >= 0 ) {
+		enableVertexAttribArray( texLoc );
+		vertexAttribPointer( texLoc, 2, GL_FLOAT, GL_FALSE, sizeof( Vertex ), (void*)offsetof( Vertex, mTexCoord ) );
+	}
+	int colorLoc = shader->getAttribSemanticLocation( geom::Attrib::COLOR );
+	if( colorLoc >= 0 ) {
+		enableVertexAttribArray( colorLoc );
+		vertexAttribPointer( colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( Vertex ), (void*)offsetof( Vertex, mColor ) );
+	}
+	int emboldenLoc = shader->getAttribLocation( "aEmbolden" );
+	if( emboldenLoc >= 0 ) {
+		enableVertexAttribArray( emboldenLoc );
+		vertexAttribPointer( emboldenLoc, 1, GL_FLOAT, GL_FALSE, sizeof( Vertex ), (void*)offsetof( Vertex, mEmbolden ) );
+	}
+	// Nothing is clipped, generic attribute values are context state so slot 0 is set explicitly
+	int clipLoc = shader->getAttribLocation( "aClipIndex" );
+	if( clipLoc >= 0 ) {
+		vertexAttrib1f( clipLoc, 0.0f );
+	}
+	defaultArrayVbo->bufferSubData( 0, vertices.size() * sizeof( Vertex ), vertices.data() );
+	defaultElementVbo->bufferSubData( 0, indices.size() * sizeof( uint32_t ), indices.data() );
+	ctx->getDefaultVao()->replacementBindEnd();
+	gl::setDefaultShaderVars();
+
+	for( const auto& draw : draws ) {
+		draw.mTexture->bind();
+		shader->uniform( "uPremultiply", draw.mPremultiply ? 1.0f : 0.0f );
+		shader->uniform( "uGamma", draw.mGamma );
+#if defined(CINDER_GL_ES)
+		shader->uniform( "uTexSize", vec2( draw.mTexture->getSize() ) );
+#endif
+		ctx->drawElements( GL_TRIANGLES, (GLsizei)draw.mIndexCount, GL_UNSIGNED_INT, (void*)( draw.mIndexStart * sizeof( uint32_t ) ) );
+	}
 
-			const auto &originOffset = glyphInfo.mOriginOffset;
+	return static_cast<uint32_t>( draws.size() );
+}
 
-			Rectf srcTexCoords = curTex->getAreaTexCoords( glyphInfo.mTexCoords );
-			Rectf destRect = Rectf( glyphInfo.mTexCoords );
-			destRect.scale( scale );
-			destRect -= destRect.getUpperLeft();
-			vec2 offset = vec2( 0, -( destRect.getHeight() ) );
-			// Reverse the transformation applied during SDF generation
-			float tx = sdfPadding.x;
-			float ty = std::fabs( originOffset.y ) + sdfPadding.y;
-			offset += scale * sdfScale * vec2( -tx, ty );
-			// Use origin scale for horizontal offset
-			offset += scale * fontOriginScale * vec2( originOffset.x, 0.0f );
-			destRect += offset;
-			destRect.scale( fontRenderScale );
 
-			destRect += glyphIt->second * scale;
-			destRect += baseline;
-			
-			SdfText::CharPlacement place = {};
-			place.mGlyph = glyphIt->first;
-			place.mSrcTexCoords = srcTexCoords;
-			place.mDstRect = destRect;
-			charPlacements.push_back( place );
-		}
+// =================================================================================================
+// SdfText trace
+// =================================================================================================
+
+static const uint32_t kTraceVersion = 2;
+
+//! Records the calls of a trace, one at a time under sTraceMutex
+class TraceRecorder {
+public:
+	TraceRecorder( const fs::path &filePath );
+
+	//! Writes the header of \a call on \a sdfText, preceded by the SdfText itself the first time it is seen. Returns the stream for the arguments.
+	const ci::OStreamRef&	beginCall( uint8_t call, const SdfText *sdfText );
+	//! Returns the id of \a ptr in the trace, assigning the next one if it is new
+	uint32_t				getId( const void *ptr );
+	//! Forgets \a ptr so that a new object at the same address gets a new id
+	void					forget( const void *ptr ) { mIds.erase( ptr ); }
+	//! Remembers that \a run was recorded for the mesh \a meshId
+	void					addRun( uint32_t meshId, const void *run ) { mMeshRuns[meshId].push_back( run ); }
+	//! Forgets the runs recorded for the mesh \a meshId
+	void					forgetRuns( uint32_t meshId );
+	uint32_t				getNumCalls() const { return mNumCalls; }
+
+private:
+	ci::DataTargetRef						mTarget;
+	ci::OStreamRef							mStream;
+	std::chrono::steady_clock::time_point	mStart;
+	std::map<const void*, uint32_t>			mIds;
+	std::map<uint32_t, std::vector<const void*>>	mMeshRuns;
+	uint32_t								mNextId = 1;
+	uint32_t								mNumCalls = 0;
+};
 
-		if( ! charPlacements.empty() ) {
-			result.push_back( std::make_pair( static_cast<uint8_t>( texIdx ), charPlacements ) );
-		}
-	}
+static std::mutex sTraceMutex;
+static std::unique_ptr<TraceRecorder> sTraceRecorder;
+static std::atomic<bool> sTracing( false );
+//! Depth of the traced calls running on the current thread, only the outermost one is recorded
+static thread_local int sTraceDepth = 0;
 
-	return result;
+static double secondsSince( const std::chrono::steady_clock::time_point &start )
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
 }
 
-std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeString( const std::string &str, const vec2 &baseline, const DrawOptions &options )
+static void writeTraceString( const ci::OStreamRef &os, const std::string &str )
 {
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
-	SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
-	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> result = placeChars( glyphMeasures, baseline, options );
-	return result;
+	os->writeLittle( static_cast<uint32_t>( str.size() ) );
+	os->writeData( str.data(), str.size() );
 }
 
-std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> SdfText::placeStringWrapped( const std::string &str, const Rectf &fitRect, const vec2 &offset, const DrawOptions &options )
+static std::string readTraceString( const ci::IStreamRef &is )
 {
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() );
-	SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
-	std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> result = placeChars( glyphMeasures, fitRect.getUpperLeft() + offset, options );
+	uint32_t size = 0;
+	is->readLittle( &size );
+	std::string result( size, '\0' );
+	if( size > 0 ) {
+		is->readData( &result[0], size );
+	}
 	return result;
 }
 
-Rectf SdfText::measureStringImpl( const std::string &str, bool wrapped, const Rectf &fitRect, const DrawOptions &options ) const
+static void writeTraceVec2( const ci::OStreamRef &os, const vec2 &value )
 {
-	SdfTextBox tbox = wrapped ? SdfTextBox( this ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() )
-                              : SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
-	
-    SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
-
-	const SdfText::Font::GlyphInfoMap& glyphMap = mTextureAtlases->mGlyphInfo;
-	const auto& sdfScale = mTextureAtlases->mSdfScale;
-	const auto& sdfPadding = mTextureAtlases->mSdfPadding;
-	const vec2 fontRenderScale = vec2( mFont.getSize() ) / ( 32.0f * mTextureAtlases->mSdfScale );
-	const vec2 fontOriginScale = vec2( mFont.getSize() ) / 32.0f;
-	const float scale = options.getScale();
-
-	Rectf result = Rectf( 0, 0, 0, 0 );
-    for( std::vector<std::pair<SdfText::Font::Glyph,vec2> >::const_iterator glyphIt = glyphMeasures.begin(); glyphIt != glyphMeasures.end(); ++glyphIt ) {
-        SdfText::Font::GlyphInfoMap::const_iterator glyphInfoIt = glyphMap.find( glyphIt->first );
-        if(  glyphInfoIt == glyphMap.end() ) {
-            continue;
-        }
-
-		const auto &glyphInfo = glyphInfoIt->second;          
-        const auto &originOffset = glyphInfo.mOriginOffset;
-		const auto &size = glyphInfo.mSize;
+	os->writeLittle( value.x );
+	os->writeLittle( value.y );
+}
 
-        Rectf destRect = Rectf( glyphInfo.mTexCoords );
-        destRect.scale( scale );
-        destRect -= destRect.getUpperLeft();
-        vec2 offset = vec2( 0, -( destRect.getHeight() ) );
-        // Reverse the transformation applied during SDF generation
-        float tx = sdfPadding.x;
-        float ty = std::fabs( originOffset.y ) + sdfPadding.y;
-        offset += scale * sdfScale * vec2( -tx, ty );
-        // Use origin scale for horizontal offset
-        offset += scale * fontOriginScale * vec2( originOffset.x, 0.0f );
-        destRect += offset;
-        destRect.scale( fontRenderScale );
+static vec2 readTraceVec2( const ci::IStreamRef &is )
+{
+	vec2 result = vec2( 0 );
+	is->readLittle( &result.x );
+	is->readLittle( &result.y );
+	return result;
+}
 
-		destRect += glyphIt->second * scale;
+static void writeTraceRect( const ci::OStreamRef &os, const Rectf &value )
+{
+	writeTraceVec2( os, value.getUpperLeft() );
+	writeTraceVec2( os, value.getLowerRight() );
+}
 
-		destRect.x1 += ( ( sdfPadding.x + originOffset.x ) * fontOriginScale.x );
-		destRect.y2 -= ( sdfPadding.y * fontOriginScale.y );
-		destRect.x2 = destRect.x1 + ( ( size.x + 1.0f ) * fontOriginScale.x );
-		destRect.y1 = destRect.y2 - ( ( size.y + 1.0f ) * fontOriginScale.y );
-		destRect.x1 -= ( 0.5f * fontOriginScale.x );
-		destRect.y1 -= ( 0.5f * fontOriginScale.y );
-		destRect.x2 += ( 0.5f * fontOriginScale.x );
-		destRect.y2 += ( 0.5f * fontOriginScale.y );
+static Rectf readTraceRect( const ci::IStreamRef &is )
+{
+	const vec2 upperLeft = readTraceVec2( is );
+	const vec2 lowerRight = readTraceVec2( is );
+	return Rectf( upperLeft, lowerRight );
+}
 
-		if( ( result.getWidth() > 0 ) || ( result.getHeight() > 0 ) ) {
-			result.x1 = std::min( result.x1, destRect.x1 );
-			result.y1 = std::min( result.y1, destRect.y1 );
-			result.x2 = std::max( result.x2, destRect.x2 );
-			result.y2 = std::max( result.y2, destRect.y2 );
-		}
-		else {
-			result = destRect;
-		}
-	}
+//! Writes \a options, a custom shader is only recorded as a flag
+static void writeTraceOptions( const ci::OStreamRef &os, const SdfText::DrawOptions &options )
+{
+	const uint8_t flags = ( options.getClipHorizontal() ? 0x01 : 0 ) |
+						  ( options.getClipVertical()   ? 0x02 : 0 ) |
+						  ( options.getPixelSnap()      ? 0x04 : 0 ) |
+						  ( options.getLigate()         ? 0x08 : 0 ) |
+						  ( options.getJustify()        ? 0x10 : 0 ) |
+						  ( options.getPremultiply()    ? 0x20 : 0 ) |
+						  ( options.getGlslProg()       ? 0x40 : 0 );
+	os->writeLittle( flags );
+	os->writeLittle( static_cast<uint8_t>( options.getAlignment() ) );
+	os->writeLittle( options.getScale() );
+	os->writeLittle( options.getLeading() );
+	os->writeLittle( options.getGamma() );
+	os->writeLittle( options.getEmbolden() );
+	os->writeLittle( options.getOblique() );
+}
 
+static SdfText::DrawOptions readTraceOptions( const ci::IStreamRef &is )
+{
+	uint8_t flags = 0;
+	uint8_t align = 0;
+	float scale = 1.0f, leading = 0.0f, gamma = 2.2f, embolden = 0.0f, oblique = 0.0f;
+	is->readLittle( &flags );
+	is->readLittle( &align );
+	is->readLittle( &scale );
+	is->readLittle( &leading );
+	is->readLittle( &gamma );
+	is->readLittle( &embolden );
+	is->readLittle( &oblique );
+	SdfText::DrawOptions result;
+	result.clipHorizontal( 0 != ( flags & 0x01 ) )
+		  .clipVertical( 0 != ( flags & 0x02 ) )
+		  .pixelSnap( 0 != ( flags & 0x04 ) )
+		  .ligate( 0 != ( flags & 0x08 ) )
+		  .justify( 0 != ( flags & 0x10 ) )
+		  .premultiply( 0 != ( flags & 0x20 ) )
+		  .alignment( static_cast<SdfText::Alignment>( align ) )
+		  .scale( scale )
+		  .leading( leading )
+		  .gamma( gamma )
+		  .embolden( embolden )
+		  .oblique( oblique );
 	return result;
 }
 
-Rectf SdfText::measureStringBounds( const std::string &str, const DrawOptions &options ) const
+//! Writes \a format short of its memory resource, glyph cache and usage profile, which belong to the recording process
+static void writeTraceFormat( const ci::OStreamRef &os, const SdfText::Format &format )
 {
-    Rectf result = measureStringImpl( str, false, Rectf( 0, 0, 0, 0 ), options );
-    return result;
-
-/*
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
-	SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
-
-	const SdfText::Font::GlyphInfoMap& glyphMap = mTextureAtlases->mGlyphInfo;
-	const auto& sdfScale = mTextureAtlases->mSdfScale;
-	const auto& sdfPadding = mTextureAtlases->mSdfPadding;
-	const vec2 fontRenderScale = vec2( mFont.getSize() ) / ( 32.0f * mTextureAtlases->mSdfScale );
-	const vec2 fontOriginScale = vec2( mFont.getSize() ) / 32.0f;
-	const float scale = options.getScale();
-
-	Rectf result = Rectf( 0, 0, 0, 0 );
-    for( std::vector<std::pair<SdfText::Font::Glyph,vec2> >::const_iterator glyphIt = glyphMeasures.begin(); glyphIt != glyphMeasures.end(); ++glyphIt ) {
-        SdfText::Font::GlyphInfoMap::const_iterator glyphInfoIt = glyphMap.find( glyphIt->first );
-        if(  glyphInfoIt == glyphMap.end() ) {
-            continue;
-        }
+	os->writeLittle( format.getTextureWidth() );
+	os->writeLittle( format.getTextureHeight() );
+	os->writeLittle( static_cast<uint8_t>( format.getAutoTextureSize() ? 1 : 0 ) );
+	os->writeLittle( format.getMaxTextureSize() );
+	writeTraceVec2( os, format.getSdfScale() );
+	os->writeLittle( format.getSdfPadding().x );
+	os->writeLittle( format.getSdfPadding().y );
+	os->writeLittle( format.getSdfRange() );
+	os->writeLittle( format.getSdfAngle() );
+	os->writeLittle( format.getSdfTileSpacing().x );
+	os->writeLittle( format.getSdfTileSpacing().y );
+	os->writeLittle( static_cast<uint8_t>( format.getEmbedOutlines() ? 1 : 0 ) );
+	writeTraceString( os, format.getEmbedChars() );
+	os->writeLittle( static_cast<uint8_t>( format.getSingleChannel() ? 1 : 0 ) );
+	os->writeLittle( static_cast<uint8_t>( format.getCompressed() ? 1 : 0 ) );
+	os->writeLittle( static_cast<uint8_t>( format.getDeferColdChars() ? 1 : 0 ) );
+	os->writeLittle( static_cast<uint32_t>( format.getPageCorpus().size() ) );
+	for( const auto& str : format.getPageCorpus() ) {
+		writeTraceString( os, str );
+	}
+	os->writeLittle( format.getHighResScale() );
+	os->writeLittle( format.getHighResThreshold() );
+	os->writeLittle( format.getGlyphCostLimit() );
+	os->writeLittle( static_cast<uint8_t>( format.getGlyphCostFallback() ) );
+}
 
-		const auto &glyphInfo = glyphInfoIt->second;          
-        const auto &originOffset = glyphInfo.mOriginOffset;
-		const auto &size = glyphInfo.mSize;
+static SdfText::Format readTraceFormat( const ci::IStreamRef &is )
+{
+	int32_t textureWidth = 0, textureHeight = 0, maxTextureSize = 0;
+	uint8_t autoTextureSize = 0, embedOutlines = 0, singleChannel = 0, compressed = 0, deferColdChars = 0, glyphCostFallback = 0;
+	ivec2 sdfPadding = ivec2( 0 ), tileSpacing = ivec2( 0 );
+	float sdfRange = 0.0f, sdfAngle = 0.0f, highResScale = 0.0f, highResThreshold = 0.0f;
+	uint64_t glyphCostLimit = 0;
+	uint32_t numCorpusStrings = 0;
+	is->readLittle( &textureWidth );
+	is->readLittle( &textureHeight );
+	is->readLittle( &autoTextureSize );
+	is->readLittle( &maxTextureSize );
+	const vec2 sdfScale = readTraceVec2( is );
+	is->readLittle( &sdfPadding.x );
+	is->readLittle( &sdfPadding.y );
+	is->readLittle( &sdfRange );
+	is->readLittle( &sdfAngle );
+	is->readLittle( &tileSpacing.x );
+	is->readLittle( &tileSpacing.y );
+	is->readLittle( &embedOutlines );
+	const std::string embedChars = readTraceString( is );
+	is->readLittle( &singleChannel );
+	is->readLittle( &compressed );
+	is->readLittle( &deferColdChars );
+	is->readLittle( &numCorpusStrings );
+	std::vector<std::string> pageCorpus;
+	for( uint32_t i = 0; i < numCorpusStrings; ++i ) {
+		pageCorpus.push_back( readTraceString( is ) );
+	}
+	is->readLittle( &highResScale );
+	is->readLittle( &highResThreshold );
+	is->readLittle( &glyphCostLimit );
+	is->readLittle( &glyphCostFallback );
+	return SdfText::Format().textureWidth( textureWidth ).textureHeight( textureHeight )
+		.autoTextureSize( 0 != autoTextureSize ).maxTextureSize( maxTextureSize )
+		.sdfScale( sdfScale ).sdfPadding( sdfPadding ).sdfRange( sdfRange ).sdfAngle( sdfAngle ).sdfTileSpacing( tileSpacing )
+		.embedOutlines( 0 != embedOutlines ).embedChars( embedChars )
+		.singleChannel( 0 != singleChannel ).compressed( 0 != compressed )
+		.deferColdChars( 0 != deferColdChars ).pageCorpus( pageCorpus )
+		.highResScale( highResScale ).highResThreshold( highResThreshold )
+		.glyphCostLimit( glyphCostLimit ).glyphCostFallback( static_cast<SdfText::GlyphCostFallback>( glyphCostFallback ) );
+}
 
-        Rectf destRect = Rectf( glyphInfo.mTexCoords );
-        destRect.scale( scale );
-        destRect -= destRect.getUpperLeft();
-        vec2 offset = vec2( 0, -( destRect.getHeight() ) );
-        // Reverse the transformation applied during SDF generation
-        float tx = sdfPadding.x;
-        float ty = std::fabs( originOffset.y ) + sdfPadding.y;
-        offset += scale * sdfScale * vec2( -tx, ty );
-        // Use origin scale for horizontal offset
-        offset += scale * fontOriginScale * vec2( originOffset.x, 0.0f );
-        destRect += offset;
-        destRect.scale( fontRenderScale );
+static void writeTracePath( const ci::OStreamRef &os, const SdfText::TextPath &path )
+{
+	os->writeLittle( static_cast<uint32_t>( path.getPoints().size() ) );
+	for( const auto& point : path.getPoints() ) {
+		writeTraceVec2( os, point );
+	}
+}
 
-		destRect += glyphIt->second * scale;
+static SdfText::TextPath readTracePath( const ci::IStreamRef &is )
+{
+	uint32_t numPoints = 0;
+	is->readLittle( &numPoints );
+	std::vector<vec2> points( numPoints );
+	for( auto& point : points ) {
+		point = readTraceVec2( is );
+	}
+	return SdfText::TextPath( points );
+}
 
-		destRect.x1 += ( ( sdfPadding.x + originOffset.x ) * fontOriginScale.x );
-		destRect.y2 -= ( sdfPadding.y * fontOriginScale.y );
-		destRect.x2 = destRect.x1 + ( ( size.x + 1.0f ) * fontOriginScale.x );
-		destRect.y1 = destRect.y2 - ( ( size.y + 1.0f ) * fontOriginScale.y );
-		destRect.x1 -= ( 0.5f * fontOriginScale.x );
-		destRect.y1 -= ( 0.5f * fontOriginScale.y );
-		destRect.x2 += ( 0.5f * fontOriginScale.x );
-		destRect.y2 += ( 0.5f * fontOriginScale.y );
+TraceRecorder::TraceRecorder( const fs::path &filePath )
+	: mStart( std::chrono::steady_clock::now() )
+{
+	mTarget = ci::writeFile( filePath, true );
+	mStream = mTarget ? mTarget->getStream() : ci::OStreamRef();
+	if( ! mStream ) {
+		throw ci::Exception( "Invalid trace file" );
+	}
+	mStream->writeData( "SDTR", 4 );
+	mStream->writeLittle( kTraceVersion );
+}
 
-		if( ( result.getWidth() > 0 ) || ( result.getHeight() > 0 ) ) {
-			result.x1 = std::min( result.x1, destRect.x1 );
-			result.y1 = std::min( result.y1, destRect.y1 );
-			result.x2 = std::max( result.x2, destRect.x2 );
-			result.y2 = std::max( result.y2, destRect.y2 );
+const ci::OStreamRef& TraceRecorder::beginCall( uint8_t call, const SdfText *sdfText )
+{
+	const double time = secondsSince( mStart );
+	uint32_t id = 0;
+	if( nullptr != sdfText ) {
+		auto it = mIds.find( sdfText );
+		if( mIds.end() == it ) {
+			id = getId( sdfText );
+			// Enough to create the SdfText again when replaying
+			// Glyphs can be added while another thread is tracing
+			SdfText::GlyphTablesReader tables( sdfText );
+			std::u32string utf32Chars;
+			for( const auto& it : tables->mCharToGlyph ) {
+				utf32Chars.push_back( it.first );
+			}
+			mStream->writeLittle( static_cast<uint8_t>( TRACE_SDF_TEXT ) );
+			mStream->writeLittle( time );
+			mStream->writeLittle( id );
+			writeTraceString( mStream, sdfText->getFont().getName() );
+			mStream->writeLittle( sdfText->getFont().getSize() );
+			writeTraceString( mStream, ci::toUtf8( utf32Chars ) );
+			writeTraceFormat( mStream, sdfText->getFormat() );
+			// Inverted outlines come from the font data, the replay can only check that its font agrees
+			mStream->writeLittle( static_cast<uint8_t>( sdfText->isSdfInverted() ? 1 : 0 ) );
 		}
 		else {
-			result = destRect;
+			id = it->second;
 		}
 	}
 
+	mStream->writeLittle( call );
+	mStream->writeLittle( time );
+	mStream->writeLittle( id );
+	++mNumCalls;
+	return mStream;
+}
+
+uint32_t TraceRecorder::getId( const void *ptr )
+{
+	auto it = mIds.find( ptr );
+	if( mIds.end() != it ) {
+		return it->second;
+	}
+	const uint32_t result = mNextId++;
+	mIds[ptr] = result;
 	return result;
-*/
 }
 
-Rectf SdfText::measureStringBoundsWrapped( const std::string &str, const Rectf &fitRect, const DrawOptions &options ) const
+void TraceRecorder::forgetRuns( uint32_t meshId )
 {
-    Rectf result = measureStringImpl( str, true, fitRect, options );
-    return result;
+	auto it = mMeshRuns.find( meshId );
+	if( mMeshRuns.end() == it ) {
+		return;
+	}
+	for( const auto& run : it->second ) {
+		forget( run );
+	}
+	mMeshRuns.erase( it );
 }
 
-vec2 SdfText::measureString( const std::string &str, const DrawOptions &options ) const
+SdfText::TraceScope::TraceScope()
+	: mRecording( sTracing && ( 0 == sTraceDepth ) )
 {
-    Rectf bounds = measureStringImpl( str, false, Rectf( 0, 0, 0, 0 ), options );
-	vec2 result = vec2( bounds.getWidth(), bounds.getHeight() );
-	return result;
+	++sTraceDepth;
 }
 
-vec2 SdfText::measureStringWrapped( const std::string &str, const Rectf &fitRect, const DrawOptions &options ) const
+SdfText::TraceScope::~TraceScope()
 {
-    Rectf bounds = measureStringImpl( str, true, fitRect, options );
-	vec2 result = vec2( bounds.getWidth(), bounds.getHeight() );
-	return result;
+	--sTraceDepth;
 }
 
-std::vector<std::pair<SdfText::Font::Glyph, vec2>> SdfText::getGlyphPlacements( const std::string &str, const DrawOptions &options ) const
+void SdfText::startTrace( const fs::path &filePath )
 {
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, SdfTextBox::GROW ).ligate( options.getLigate() );
-	return tbox.measureGlyphs(  options );
+	std::unique_ptr<TraceRecorder> recorder( new TraceRecorder( filePath ) );
+	std::lock_guard<std::mutex> lock( sTraceMutex );
+	sTraceRecorder = std::move( recorder );
+	sTracing = true;
 }
 
-std::vector<std::pair<SdfText::Font::Glyph, vec2>> SdfText::getGlyphPlacements( const std::string &str, const Rectf &fitRect, const DrawOptions &options ) const
+uint32_t SdfText::stopTrace()
 {
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( SdfTextBox::GROW, (int)fitRect.getHeight() ).ligate( options.getLigate() );
-	return tbox.measureGlyphs( options );
+	std::lock_guard<std::mutex> lock( sTraceMutex );
+	sTracing = false;
+	const uint32_t result = sTraceRecorder ? sTraceRecorder->getNumCalls() : 0;
+	sTraceRecorder.reset();
+	return result;
 }
 
-std::vector<std::pair<SdfText::Font::Glyph, vec2>> SdfText::getGlyphPlacementsWrapped( const std::string &str, const Rectf &fitRect, const DrawOptions &options ) const
+void SdfText::traceCall( uint8_t call, const std::string &str, const Rectf &rect, const vec2 &point, float value, const std::string &extra, const DrawOptions &options ) const
 {
-	SdfTextBox tbox = SdfTextBox( this ).text( str ).size( (int)fitRect.getWidth(), (int)fitRect.getHeight() ).ligate( options.getLigate() );
-	return tbox.measureGlyphs( options );
+	std::lock_guard<std::mutex> lock( sTraceMutex );
+	if( ! sTraceRecorder ) {
+		return;
+	}
+	const auto& os = sTraceRecorder->beginCall( call, this );
+	writeTraceString( os, str );
+	writeTraceRect( os, rect );
+	writeTraceVec2( os, point );
+	os->writeLittle( value );
+	writeTraceString( os, extra );
+	writeTraceOptions( os, options );
 }
 
-std::string SdfText::defaultChars()
-{ 
-	return "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz1234567890().?!,:;'\"&*=+-/\\|@#_[]<>%^llflfiphrids\303\251\303\241\303\250\303\240"; 
+void SdfText::traceGlyphs( uint8_t call, const GlyphMeasuresView &glyphMeasures, const vec2 &baseline, const Rectf *clip, const TextPath *path, float pathOffset, const DrawOptions &options ) const
+{
+	std::lock_guard<std::mutex> lock( sTraceMutex );
+	if( ! sTraceRecorder ) {
+		return;
+	}
+	const auto& os = sTraceRecorder->beginCall( call, this );
+	writeTraceVec2( os, baseline );
+	os->writeLittle( static_cast<uint8_t>( clip ? 1 : 0 ) );
+	writeTraceRect( os, clip ? *clip : Rectf( 0, 0, 0, 0 ) );
+	writeTracePath( os, path ? *path : TextPath() );
+	os->writeLittle( pathOffset );
+	writeTraceOptions( os, options );
+	os->writeLittle( static_cast<uint32_t>( glyphMeasures.size() ) );
+	for( const auto& glyphMeasure : glyphMeasures ) {
+		os->writeLittle( static_cast<uint32_t>( glyphMeasure.first ) );
+		writeTraceVec2( os, glyphMeasure.second );
+	}
 }
 
-uint32_t SdfText::getNumTextures() const
+void SdfText::traceMeshRun( const void *mesh, const void *run, uint32_t dirty, const SdfText *sdfText, const std::string &utf8, bool wrapped, const Rectf &fitRect, const vec2 &baseline, const vec2 &offset, const TextPath &path, float pathOffset, const DrawOptions &options )
 {
-	return static_cast<uint32_t>( mTextureAtlases->mTextures.size() );
+	std::lock_guard<std::mutex> lock( sTraceMutex );
+	if( ! sTraceRecorder ) {
+		return;
+	}
+	const uint32_t meshId = sTraceRecorder->getId( mesh );
+	const uint32_t runId = sTraceRecorder->getId( run );
+	sTraceRecorder->addRun( meshId, run );
+	const auto& os = sTraceRecorder->beginCall( TRACE_MESH_RUN, sdfText );
+	os->writeLittle( meshId );
+	os->writeLittle( runId );
+	os->writeLittle( dirty );
+	writeTraceString( os, utf8 );
+	os->writeLittle( static_cast<uint8_t>( wrapped ? 1 : 0 ) );
+	writeTraceRect( os, fitRect );
+	writeTraceVec2( os, baseline );
+	writeTraceVec2( os, offset );
+	writeTracePath( os, path );
+	os->writeLittle( pathOffset );
+	writeTraceOptions( os, options );
 }
 
-const gl::TextureRef& SdfText::getTexture(uint32_t n) const
+void SdfText::traceMeshCache( const void *mesh )
 {
-	return mTextureAtlases->mTextures[static_cast<size_t>( n )];
+	std::lock_guard<std::mutex> lock( sTraceMutex );
+	if( ! sTraceRecorder ) {
+		return;
+	}
+	const uint32_t meshId = sTraceRecorder->getId( mesh );
+	const auto& os = sTraceRecorder->beginCall( TRACE_MESH_CACHE, nullptr );
+	os->writeLittle( meshId );
+	// Runs are recorded again on every cache, new ones at the same addresses must not reuse these ids
+	sTraceRecorder->forgetRuns( meshId );
 }
 
-gl::GlslProgRef SdfText::defaultShader()
+void SdfText::traceForget( const void *ptr )
 {
-	if( ! sDefaultShader ) {
-		try {
-			sDefaultShader = gl::GlslProg::create( kSdfVertShader, kSdfFragShader );
+	if( ! sTracing ) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock( sTraceMutex );
+	if( sTraceRecorder ) {
+		sTraceRecorder->forget( ptr );
+	}
+}
+
+SdfText::TraceStats SdfText::replayTrace( const fs::path &filePath, const TraceFontFn &fontFn )
+{
+	ci::IStreamRef is = ci::DataSourcePath::create( filePath )->createStream();
+	if( ! is ) {
+		throw ci::Exception( "Invalid trace file" );
+	}
+	uint8_t ident[4];
+	is->readData( ident, 4 );
+	if( std::string( "SDTR" ) != std::string( reinterpret_cast<const char*>( ident ), 4 ) ) {
+		throw ci::Exception( "Trace ident not found" );
+	}
+	uint32_t version = 0;
+	is->readLittle( &version );
+	if( kTraceVersion != version ) {
+		throw ci::Exception( "Unsupported trace version" );
+	}
+
+	struct MeshRun {
+		uint32_t	mMesh = 0;
+		uint32_t	mSdfText = 0;
+		std::string	mUtf8;
+		bool		mWrapped = false;
+		Rectf		mFitRect = Rectf( 0, 0, 0, 0 );
+		vec2		mBaseline = vec2( 0 );
+		vec2		mOffset = vec2( 0 );
+		TextPath	mPath;
+		float		mPathOffset = 0.0f;
+		DrawOptions	mOptions;
+	};
+
+	TraceStats result;
+	std::map<uint32_t, SdfTextRef> sdfTexts;
+	std::map<uint32_t, MeshRun> meshRuns;
+	std::vector<std::vector<CharPlacement>> pagePlacements;
+	std::vector<vec2> positions, texCoords;
+	double firstTime = -1.0;
+	double lastTime = 0.0;
+
+	auto layout = [&]( const SdfTextRef &sdfText, const std::string &str, const ivec2 &size, const DrawOptions &options ) -> SdfText::Font::GlyphMeasuresList {
+		const auto start = std::chrono::steady_clock::now();
+		SdfTextBox tbox = SdfTextBox( sdfText.get() ).text( str ).size( size.x, size.y ).ligate( options.getLigate() );
+		SdfText::Font::GlyphMeasuresList glyphMeasures = tbox.measureGlyphs( options );
+		result.mLayoutSeconds += secondsSince( start );
+		result.mNumGlyphs += glyphMeasures.size();
+		return glyphMeasures;
+	};
+	auto truncateTimed = [&]( const SdfTextRef &sdfText, const std::string &str, float maxWidth, const std::string &ellipsis, const DrawOptions &options ) -> SdfText::Font::GlyphMeasuresList {
+		const auto start = std::chrono::steady_clock::now();
+		SdfText::Font::GlyphMeasuresList glyphMeasures = sdfText->truncate( str, maxWidth, ellipsis, options );
+		result.mLayoutSeconds += secondsSince( start );
+		result.mNumGlyphs += glyphMeasures.size();
+		return glyphMeasures;
+	};
+	auto measureTimed = [&]( const SdfTextRef &sdfText, const std::string &str, bool wrapped, const Rectf &fitRect, const DrawOptions &options ) {
+		const auto start = std::chrono::steady_clock::now();
+		sdfText->measureStringImpl( str, wrapped, fitRect, options );
+		result.mLayoutSeconds += secondsSince( start );
+	};
+	auto measureBoundsTimed = [&]( const SdfTextRef &sdfText, const std::string &str, bool wrapped, const Rectf &fitRect, const DrawOptions &options ) {
+		const auto start = std::chrono::steady_clock::now();
+		if( wrapped ) {
+			sdfText->measureStringBoundsWrapped( str, fitRect, options );
 		}
-		catch( const std::exception& e ) {
-			CI_LOG_E( "SdfText::defaultShader error: " << e.what() );
+		else {
+			sdfText->measureStringBounds( str, options );
+		}
+		result.mLayoutSeconds += secondsSince( start );
+	};
+	// Places the glyphs like drawGlyphsImpl() with \a draw and like placeChars() without, from the atlas
+	// that call would use. Draws are replayed without a transform, at one pixel per unit.
+	auto buildVertices = [&]( const SdfTextRef &sdfText, bool draw, const SdfText::Font::GlyphMeasuresList &glyphMeasures, const vec2 &baseline, const Rectf *clip, const TextPath *path, float pathOffset, const DrawOptions &options ) {
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<GlyphTransform> transforms;
+		DrawOptions placeOptions = options;
+		if( path ) {
+			transforms = sdfText->calcPathTransforms( glyphMeasures, *path, pathOffset, options );
+			placeOptions.pixelSnap( draw && options.getPixelSnap() );
+		}
+		const auto& atlas = draw ? sdfText->selectAtlas( glyphMeasures, 0, glyphMeasures.size(), options, 1.0f ) : sdfText->mTextureAtlases;
+		sdfText->placeGlyphs( getTileSource( *atlas ), nullptr, glyphMeasures, 0, glyphMeasures.size(), baseline, clip, placeOptions, transforms.empty() ? nullptr : transforms.data(), &pagePlacements );
+		positions.clear();
+		texCoords.clear();
+		const float oblique = options.getOblique();
+		for( const auto& placements : pagePlacements ) {
+			for( const auto& place : placements ) {
+				vec2 quadPositions[4], quadTexCoords[4];
+				place.calcQuad( oblique, quadPositions, quadTexCoords );
+				positions.insert( positions.end(), quadPositions, quadPositions + 4 );
+				texCoords.insert( texCoords.end(), quadTexCoords, quadTexCoords + 4 );
+			}
+		}
+		result.mNumVertices += positions.size();
+		result.mVertexSeconds += secondsSince( start );
+	};
+
+	while( true ) {
+		uint8_t call = 0;
+		double time = 0.0;
+		uint32_t id = 0;
+		is->readLittle( &call );
+		if( is->isEof() ) {
+			break;
+		}
+		is->readLittle( &time );
+		is->readLittle( &id );
+		firstTime = ( firstTime < 0.0 ) ? time : firstTime;
+		lastTime = time;
+
+		if( TRACE_SDF_TEXT == call ) {
+			const std::string fontName = readTraceString( is );
+			float fontSize = 0.0f;
+			is->readLittle( &fontSize );
+			const std::string utf8Chars = readTraceString( is );
+			const Format format = readTraceFormat( is );
+			uint8_t invertSdf = 0;
+			is->readLittle( &invertSdf );
+			try {
+				const auto start = std::chrono::steady_clock::now();
+				const SdfText::Font font = fontFn ? fontFn( fontName, fontSize ) : SdfText::Font( fontName, fontSize );
+				sdfTexts[id] = SdfText::create( font, format, utf8Chars );
+				result.mCreateSeconds += secondsSince( start );
+				++result.mNumSdfTexts;
+				if( sdfTexts[id]->isSdfInverted() != ( 0 != invertSdf ) ) {
+					CI_LOG_W( "trace replay font for " << fontName << " has differently oriented outlines than the recorded one" );
+				}
+			}
+			catch( const std::exception& e ) {
+				CI_LOG_W( "trace replay skips the calls on " << fontName << ": " << e.what() );
+			}
+			continue;
+		}
+
+		if( ( TRACE_DRAW_GLYPHS == call ) || ( TRACE_DRAW_GLYPHS_ON_PATH == call ) || ( TRACE_PLACE_GLYPHS_ON_PATH == call ) ) {
+			const vec2 baseline = readTraceVec2( is );
+			uint8_t hasClip = 0;
+			is->readLittle( &hasClip );
+			const Rectf clip = readTraceRect( is );
+			const TextPath path = readTracePath( is );
+			float pathOffset = 0.0f;
+			is->readLittle( &pathOffset );
+			const DrawOptions options = readTraceOptions( is );
+			uint32_t numGlyphs = 0;
+			is->readLittle( &numGlyphs );
+			SdfText::Font::GlyphMeasuresList glyphMeasures( numGlyphs );
+			for( auto& glyphMeasure : glyphMeasures ) {
+				is->readLittle( &glyphMeasure.first );
+				glyphMeasure.second = readTraceVec2( is );
+			}
+			auto it = sdfTexts.find( id );
+			if( sdfTexts.end() != it ) {
+				const bool onPath = ( TRACE_DRAW_GLYPHS != call );
+				buildVertices( it->second, ( TRACE_PLACE_GLYPHS_ON_PATH != call ), glyphMeasures, baseline, ( 0 != hasClip ) ? &clip : nullptr, onPath ? &path : nullptr, pathOffset, options );
+				++result.mNumCalls;
+			}
+			continue;
+		}
+
+		if( TRACE_MESH_RUN == call ) {
+			MeshRun meshRun;
+			uint32_t runId = 0;
+			uint32_t dirty = 0;
+			uint8_t wrapped = 0;
+			is->readLittle( &meshRun.mMesh );
+			is->readLittle( &runId );
+			is->readLittle( &dirty );
+			meshRun.mUtf8 = readTraceString( is );
+			is->readLittle( &wrapped );
+			meshRun.mWrapped = ( 0 != wrapped );
+			meshRun.mFitRect = readTraceRect( is );
+			meshRun.mBaseline = readTraceVec2( is );
+			meshRun.mOffset = readTraceVec2( is );
+			meshRun.mPath = readTracePath( is );
+			is->readLittle( &meshRun.mPathOffset );
+			meshRun.mOptions = readTraceOptions( is );
+			meshRun.mSdfText = id;
+			meshRuns[runId] = meshRun;
+			++result.mNumCalls;
+			continue;
+		}
+
+		if( TRACE_MESH_CACHE == call ) {
+			uint32_t meshId = 0;
+			is->readLittle( &meshId );
+			// Same placement and measuring as SdfTextMesh::cache() short of the GL buffers, the next cache records its runs again
+			const ivec2 growSize = ivec2( SdfTextBox::GROW, SdfTextBox::GROW );
+			for( const auto& it : meshRuns ) {
+				const auto& meshRun = it.second;
+				auto sdfTextIt = sdfTexts.find( meshRun.mSdfText );
+				if( ( meshRun.mMesh != meshId ) || ( sdfTexts.end() == sdfTextIt ) ) {
+					continue;
+				}
+				const auto& sdfText = sdfTextIt->second;
+				if( ! meshRun.mPath.empty() ) {
+					auto glyphMeasures = layout( sdfText, meshRun.mUtf8, growSize, meshRun.mOptions );
+					buildVertices( sdfText, false, glyphMeasures, vec2( 0 ), nullptr, &meshRun.mPath, meshRun.mPathOffset, meshRun.mOptions );
+				}
+				else if( meshRun.mWrapped ) {
+					const Rectf &fitRect = meshRun.mFitRect;
+					auto glyphMeasures = layout( sdfText, meshRun.mUtf8, ivec2( (int)fitRect.getWidth(), (int)fitRect.getHeight() ), meshRun.mOptions );
+					buildVertices( sdfText, false, glyphMeasures, fitRect.getUpperLeft() + meshRun.mOffset, nullptr, nullptr, 0.0f, meshRun.mOptions );
+					measureBoundsTimed( sdfText, meshRun.mUtf8, true, fitRect, meshRun.mOptions );
+				}
+				else {
+					auto glyphMeasures = layout( sdfText, meshRun.mUtf8, growSize, meshRun.mOptions );
+					buildVertices( sdfText, false, glyphMeasures, meshRun.mBaseline, nullptr, nullptr, 0.0f, meshRun.mOptions );
+					measureBoundsTimed( sdfText, meshRun.mUtf8, false, Rectf( 0, 0, 0, 0 ), meshRun.mOptions );
+				}
+			}
+			for( auto it = meshRuns.begin(); it != meshRuns.end(); ) {
+				it = ( it->second.mMesh == meshId ) ? meshRuns.erase( it ) : std::next( it );
+			}
+			++result.mNumCalls;
+			continue;
+		}
+
+		// String calls
+		const std::string str = readTraceString( is );
+		const Rectf rect = readTraceRect( is );
+		const vec2 point = readTraceVec2( is );
+		float value = 0.0f;
+		is->readLittle( &value );
+		const std::string extra = readTraceString( is );
+		const DrawOptions options = readTraceOptions( is );
+		auto it = sdfTexts.find( id );
+		if( sdfTexts.end() == it ) {
+			continue;
+		}
+		const auto& sdfText = it->second;
+		const ivec2 growSize = ivec2( SdfTextBox::GROW, SdfTextBox::GROW );
+		const ivec2 fitSize = ivec2( (int)rect.getWidth(), (int)rect.getHeight() );
+		switch( call ) {
+			case TRACE_DRAW_STRING:
+			case TRACE_PLACE_STRING:
+				buildVertices( sdfText, ( TRACE_DRAW_STRING == call ), layout( sdfText, str, growSize, options ), point, nullptr, nullptr, 0.0f, options );
+				break;
+			case TRACE_DRAW_STRING_FIT:
+				buildVertices( sdfText, true, layout( sdfText, str, ivec2( SdfTextBox::GROW, fitSize.y ), options ), rect.getUpperLeft() + point, &rect, nullptr, 0.0f, options );
+				break;
+			case TRACE_DRAW_STRING_WRAPPED:
+			case TRACE_PLACE_STRING_WRAPPED:
+				buildVertices( sdfText, ( TRACE_DRAW_STRING_WRAPPED == call ), layout( sdfText, str, fitSize, options ), rect.getUpperLeft() + point, nullptr, nullptr, 0.0f, options );
+				break;
+			case TRACE_DRAW_STRING_TRUNCATED:
+			case TRACE_PLACE_STRING_TRUNCATED:
+				buildVertices( sdfText, ( TRACE_DRAW_STRING_TRUNCATED == call ), truncateTimed( sdfText, str, value, extra, options ), point, nullptr, nullptr, 0.0f, options );
+				break;
+			case TRACE_GLYPH_PLACEMENTS:
+				layout( sdfText, str, growSize, options );
+				break;
+			case TRACE_GLYPH_PLACEMENTS_FIT:
+				layout( sdfText, str, ivec2( SdfTextBox::GROW, fitSize.y ), options );
+				break;
+			case TRACE_GLYPH_PLACEMENTS_WRAPPED:
+				layout( sdfText, str, fitSize, options );
+				break;
+			case TRACE_TRUNCATE:
+				truncateTimed( sdfText, str, value, extra, options );
+				break;
+			case TRACE_MEASURE_STRING:
+				measureTimed( sdfText, str, false, rect, options );
+				break;
+			case TRACE_MEASURE_STRING_WRAPPED:
+				measureTimed( sdfText, str, true, rect, options );
+				break;
+			default:
+				throw ci::Exception( "Unknown trace call " + std::to_string( call ) );
 		}
+		++result.mNumCalls;
 	}
-	return sDefaultShader;
+
+	result.mRecordedSeconds = ( firstTime >= 0.0 ) ? ( lastTime - firstTime ) : 0.0;
+	return result;
 }
 
 }} // namespace cinder::gl
@@ -34,10 +34,14 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "cinder/gl/SdfTextMesh.h"
 #include "cinder/gl/Context.h"
 #include "cinder/gl/scoped.h"
+#include "cinder/gl/Shader.h"
 #include "cinder/TriMesh.h"
 
 namespace cinder { namespace gl {
 
+//! Clip rect of slot 0 and of unset slots
+static const vec4 kNoClipRect = vec4( -1.0e9f, -1.0e9f, 1.0e9f, 1.0e9f );
+
 // -------------------------------------------------------------------------------------------------
 // SdfTextMesh::Run
 // -------------------------------------------------------------------------------------------------
@@ -96,13 +100,18 @@ void SdfTextMesh::Run::setDirty( Feature value )
 // -------------------------------------------------------------------------------------------------
 // SdfTextMesh
 // -------------------------------------------------------------------------------------------------
-SdfTextMesh::SdfTextMesh()
+SdfTextMesh::SdfTextMesh( SdfText::MemoryResource *memoryResource )
+	: mMemoryResource( memoryResource ? memoryResource : SdfText::getMemoryResource() ),
+	  mRunMaps( RunMap::allocator_type( mMemoryResource ) ),
+	  mTextDrawMaps( TextDrawMap::allocator_type( mMemoryResource ) ),
+	  mRunDrawMaps( RunDrawMap::allocator_type( mMemoryResource ) )
 {
+	mClipRects.fill( kNoClipRect );
 }
 
-SdfTextMeshRef SdfTextMesh::create()
+SdfTextMeshRef SdfTextMesh::create( SdfText::MemoryResource *memoryResource )
 {
-	SdfTextMeshRef result = SdfTextMeshRef( new SdfTextMesh() );
+	SdfTextMeshRef result = SdfTextMeshRef( new SdfTextMesh( memoryResource ) );
 	return result;
 }
 
@@ -136,6 +145,15 @@ SdfTextMesh::RunRef SdfTextMesh::appendTextWrapped( const std::string &utf8, con
 	return run;
 }
 
+SdfTextMesh::RunRef SdfTextMesh::appendTextOnPath( const std::string &utf8, const SdfTextRef &sdfText, const SdfText::TextPath &path, float offset, const Run::Options &options )
+{
+	SdfTextMesh::RunRef run = SdfTextMesh::RunRef( new SdfTextMesh::Run( this, utf8, sdfText, vec2( 0 ), options ) );
+	run->mPath = path;
+	run->mPathOffset = offset;
+	appendText( run );
+	return run;
+}
+
 void SdfTextMesh::appendText( const SdfTextMesh::RunRef &run )
 {
 	const auto& sdfText = run->getSdfText();
@@ -214,6 +232,35 @@ void SdfTextMesh::updateDirty( const Run *run )
 	}
 }
 
+static uint32_t toBits( SdfTextMesh::VertexAttrib attrib )
+{
+	return static_cast<uint32_t>( attrib );
+}
+
+static bool hasVertexAttrib( uint32_t attribs, SdfTextMesh::VertexAttrib attrib )
+{
+	return 0 != ( attribs & toBits( attrib ) );
+}
+
+//! Returns the VertexAttrib bits that only go into the vertices when \a shader reads them
+static uint32_t getShaderVertexAttribs( const GlslProgRef &shader )
+{
+	uint32_t result = 0;
+	if( ( shader->getAttribLocation( "aGlyphInfo" ) >= 0 ) || ( shader->getAttribLocation( "aGlyphCenter" ) >= 0 ) ) {
+		result |= toBits( SdfTextMesh::VertexAttrib::GLYPH_INFO );
+	}
+	return result;
+}
+
+//! Returns the uClipRects slot of \a clipId, ids out of range are not clipped
+static float getClipSlot( uint32_t clipId )
+{
+	return static_cast<float>( ( clipId <= SdfTextMesh::MAX_CLIP_RECTS ) ? clipId : 0 );
+}
+
+//! Number of colors in a span color table, slot 0 is white for glyphs outside of any span
+static const size_t kMaxSpanColors = 64;
+
 struct ClientMesh {
 	struct Tri {
 		uint32_t	v0;
@@ -221,13 +268,61 @@ struct ClientMesh {
 		uint32_t	v2;
 	};
 	
+	//! Values of one vertex, the mesh only stores the attributes in mAttribs
 	struct Vertex {
-		vec4 pos;
+		vec2 pos;
 		vec2 uv;
+		float spanIndex;
+		vec3 glyphInfo;
+		vec2 glyphCenter;
+		float embolden;
+		float clip;
 	};
 
-	std::vector<Tri>		mTriangles;
-	std::vector<Vertex>		mVertices;
+	ClientMesh( SdfText::MemoryResource *memoryResource, uint32_t attribs = 0, float embolden = 0.0f, float clip = 0.0f )
+		: mAttribs( attribs ), mEmbolden( embolden ), mClip( clip ), mTriangles( SdfText::Allocator<Tri>( memoryResource ) ), mVertices( SdfText::Allocator<float>( memoryResource ) ) {}
+
+	//! Attributes stored after the position and tex coord, see SdfTextMesh::VertexAttrib
+	uint32_t										mAttribs = 0;
+	//! Embolden distance of all glyphs when it is not in the vertices
+	float											mEmbolden = 0.0f;
+	//! Clip slot of all glyphs when it is not in the vertices
+	float											mClip = 0.0f;
+	std::vector<Tri, SdfText::Allocator<Tri>>		mTriangles;
+	//! Interleaved vertices of getStride() bytes
+	std::vector<float, SdfText::Allocator<float>>	mVertices;
+	//! Span color tables and the indices that use them
+	std::vector<SdfTextMesh::SpanColorRange>		mSpanColorRanges;
+
+	//! Returns the number of floats of \a attrib
+	static uint32_t getNumFloats( SdfTextMesh::VertexAttrib attrib ) {
+		switch( attrib ) {
+			case SdfTextMesh::VertexAttrib::SPAN_INDEX:
+			case SdfTextMesh::VertexAttrib::EMBOLDEN:
+			case SdfTextMesh::VertexAttrib::CLIP:
+				return 1;
+			case SdfTextMesh::VertexAttrib::GLYPH_INFO:
+				return 3 + 2;
+			default:
+				break;
+		}
+		return 0;
+	}
+
+	//! Returns the byte offset of \a attrib in a vertex, the attributes follow the vec4 position and vec2 tex coord in the order of SdfTextMesh::VertexAttrib
+	size_t getOffset( SdfTextMesh::VertexAttrib attrib ) const {
+		uint32_t result = 4 + 2;
+		for( uint32_t bit = 1; bit < toBits( attrib ); bit <<= 1 ) {
+			if( mAttribs & bit ) {
+				result += getNumFloats( static_cast<SdfTextMesh::VertexAttrib>( bit ) );
+			}
+		}
+		return sizeof( float ) * result;
+	}
+
+	size_t getStride() const {
+		return getOffset( SdfTextMesh::VertexAttrib::END );
+	}
 
 	uint32_t getNumTriangles() const {
 		return static_cast<uint32_t>( mTriangles.size() );
@@ -240,11 +335,65 @@ struct ClientMesh {
 	}
 
 	uint32_t getNumVertices() const {
-		return static_cast<uint32_t>( mVertices.size() );
+		return static_cast<uint32_t>( ( sizeof( float ) * mVertices.size() ) / getStride() );
+	}
+
+	void appendVertex( const Vertex &vertex ) {
+		const float values[] = { vertex.pos.x, vertex.pos.y, 0.0f, 1.0f, vertex.uv.x, vertex.uv.y };
+		mVertices.insert( std::end( mVertices ), std::begin( values ), std::end( values ) );
+		if( hasVertexAttrib( mAttribs, SdfTextMesh::VertexAttrib::SPAN_INDEX ) ) {
+			mVertices.push_back( vertex.spanIndex );
+		}
+		if( hasVertexAttrib( mAttribs, SdfTextMesh::VertexAttrib::GLYPH_INFO ) ) {
+			const float glyphValues[] = { vertex.glyphInfo.x, vertex.glyphInfo.y, vertex.glyphInfo.z, vertex.glyphCenter.x, vertex.glyphCenter.y };
+			mVertices.insert( std::end( mVertices ), std::begin( glyphValues ), std::end( glyphValues ) );
+		}
+		if( hasVertexAttrib( mAttribs, SdfTextMesh::VertexAttrib::EMBOLDEN ) ) {
+			mVertices.push_back( vertex.embolden );
+		}
+		if( hasVertexAttrib( mAttribs, SdfTextMesh::VertexAttrib::CLIP ) ) {
+			mVertices.push_back( vertex.clip );
+		}
+	}
+
+	//! Returns the slot of \a color in the current span color table. A full table is closed at the current index count and a new one started, so that each draw looks colors up in a table of its own.
+	float getSpanIndex( const ColorA8u &color ) {
+		if( mSpanColorRanges.empty() || ( ( 255 == color.r ) && ( 255 == color.g ) && ( 255 == color.b ) && ( 255 == color.a ) ) ) {
+			return 0.0f;
+		}
+		const ColorA c = ColorA( color );
+		const vec4 value = vec4( c.r, c.g, c.b, c.a );
+		auto &colors = mSpanColorRanges.back().mColors;
+		auto it = std::find( std::begin( colors ), std::end( colors ), value );
+		if( std::end( colors ) != it ) {
+			return static_cast<float>( it - std::begin( colors ) );
+		}
+		if( colors.size() >= kMaxSpanColors ) {
+			startSpanColorRange();
+			mSpanColorRanges.back().mColors.push_back( value );
+			return 1.0f;
+		}
+		colors.push_back( value );
+		return static_cast<float>( colors.size() - 1 );
 	}
 
-	void appendVertex( const vec2 &pos, const vec2 &uv ) {
-		mVertices.push_back( { vec4( pos.x, pos.y, 0.0f, 1.0f ), uv } );
+	//! Starts a span color table with white in slot 0 at the current index count
+	void startSpanColorRange() {
+		if( ! mSpanColorRanges.empty() ) {
+			mSpanColorRanges.back().mIndexCount = getNumIndices() - mSpanColorRanges.back().mIndexStart;
+		}
+		SdfTextMesh::SpanColorRange range;
+		range.mIndexStart = getNumIndices();
+		range.mColors.push_back( vec4( 1.0f ) );
+		mSpanColorRanges.push_back( range );
+	}
+
+	//! Closes the last span color table at the current index count
+	void finishSpanColorRanges() {
+		if( mSpanColorRanges.empty() ) {
+			startSpanColorRange();
+		}
+		mSpanColorRanges.back().mIndexCount = getNumIndices() - mSpanColorRanges.back().mIndexStart;
 	}
 
 	void appendTriangle( uint32_t v0, uint32_t v1, uint32_t v2 ) { 
@@ -259,17 +408,115 @@ struct ClientMesh {
 		return reinterpret_cast<const uint32_t *>( getTrianglesData() );
 	}
 
-	const Vertex *getVerticesData() const {
+	const float *getVerticesData() const {
 		return mVertices.data();
 	}
 };
 
+//! Appends two triangles covering the middle half of \a rect, glyph quads include the SDF padding
+static void appendGreekBar( const Rectf &rect, std::vector<vec2> *vertices )
+{
+	const float inset = 0.25f * rect.getHeight();
+	const Rectf bar = Rectf( rect.x1, rect.y1 + inset, rect.x2, rect.y2 - inset );
+	vertices->push_back( vec2( bar.x2, bar.y1 ) );
+	vertices->push_back( vec2( bar.x1, bar.y1 ) );
+	vertices->push_back( vec2( bar.x2, bar.y2 ) );
+	vertices->push_back( vec2( bar.x2, bar.y2 ) );
+	vertices->push_back( vec2( bar.x1, bar.y1 ) );
+	vertices->push_back( vec2( bar.x1, bar.y2 ) );
+}
+
+//! Appends one bar per word and one per line of the placed glyphs of a run. Glyphs without ink end a word.
+static void appendGreekBars( const std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> &placements, const SdfText::GlyphMetricsTable &glyphMetrics, std::vector<vec2> *wordVertices, std::vector<vec2> *lineVertices )
+{
+	std::vector<SdfText::CharPlacement> glyphs;
+	for( const auto& placementsIt : placements ) {
+		for( const auto& place : placementsIt.second ) {
+			auto metricsIt = glyphMetrics.find( place.mGlyph );
+			if( ( glyphMetrics.end() != metricsIt ) && ( metricsIt->second.maximum.x > metricsIt->second.minimum.x ) ) {
+				glyphs.push_back( place );
+			}
+		}
+	}
+	std::sort( std::begin( glyphs ), std::end( glyphs ), 
+		[]( const SdfText::CharPlacement &a, const SdfText::CharPlacement &b ) -> bool {
+			return a.mIndex < b.mIndex;
+		}
+	);
+
+	Rectf word = Rectf( 0, 0, 0, 0 );
+	Rectf line = Rectf( 0, 0, 0, 0 );
+	for( size_t i = 0; i < glyphs.size(); ++i ) {
+		const auto& glyph = glyphs[i];
+		const bool newLine = ( 0 == i ) || ( glyph.mLine != glyphs[i - 1].mLine );
+		const bool newWord = newLine || ( glyph.mIndex != ( glyphs[i - 1].mIndex + 1 ) );
+		if( newWord && ( i > 0 ) ) {
+			appendGreekBar( word, wordVertices );
+		}
+		if( newLine && ( i > 0 ) ) {
+			appendGreekBar( line, lineVertices );
+		}
+		if( newWord ) {
+			word = glyph.mDstRect;
+		}
+		else {
+			word.include( glyph.mDstRect );
+		}
+		if( newLine ) {
+			line = glyph.mDstRect;
+		}
+		else {
+			line.include( glyph.mDstRect );
+		}
+	}
+	if( ! glyphs.empty() ) {
+		appendGreekBar( word, wordVertices );
+		appendGreekBar( line, lineVertices );
+	}
+}
+
+//! Appends one bar per glyph for text on a path, turned with each glyph since words and lines follow the path
+static void appendGreekGlyphBars( const std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> &placements, const SdfText::GlyphMetricsTable &glyphMetrics, std::vector<vec2> *wordVertices, std::vector<vec2> *lineVertices )
+{
+	for( const auto& placementsIt : placements ) {
+		for( const auto& place : placementsIt.second ) {
+			auto metricsIt = glyphMetrics.find( place.mGlyph );
+			if( ( glyphMetrics.end() == metricsIt ) || ( metricsIt->second.maximum.x <= metricsIt->second.minimum.x ) ) {
+				continue;
+			}
+			std::vector<vec2> bar;
+			appendGreekBar( place.mDstRect, &bar );
+			for( auto &vertex : bar ) {
+				vertex = place.transformPoint( vertex );
+			}
+			wordVertices->insert( std::end( *wordVertices ), std::begin( bar ), std::end( bar ) );
+			lineVertices->insert( std::end( *lineVertices ), std::begin( bar ), std::end( bar ) );
+		}
+	}
+}
+
 void SdfTextMesh::cache()
 {
 	if( ! mDirty ) {
 		return;
 	}
 
+	// Vertex data and the layout temporaries of the runs come from the resource of the mesh
+	SdfText::ScopedMemoryResource memScp( mMemoryResource );
+
+	// Every run is laid out again, so the trace gets all of them ahead of the cache
+	SdfText::TraceScope traceScp;
+	if( traceScp.isRecording() ) {
+		for( const auto &runMapIt : mRunMaps ) {
+			for( const auto &run : runMapIt.second ) {
+				const auto &options = run->getOptions();
+				SdfText::traceMeshRun( this, run.get(), run->getDirty(), runMapIt.first.get(), run->getUtf8(), run->getWrapped(), run->getFitRect(), run->getBaseline(), vec2( run->getPosition() ), run->getPath(), run->getPathOffset(), options.getDrawOptions() );
+			}
+		}
+		SdfText::traceMeshCache( this );
+	}
+
+	bool hasBounds = false;
 	for( auto &runMapIt : mRunMaps ) {
 		auto &sdfText = runMapIt.first;
 		auto &runs = runMapIt.second;
@@ -284,6 +531,25 @@ void SdfTextMesh::cache()
 			}
 		}
 
+		// Optional vertex attributes, a span slot is only stored when a run has color spans and glyph info when the shader animates glyphs
+		// Embolden and clip go into the vertices only when the runs differ, otherwise they are set once per batch
+		uint32_t attribs = getShaderVertexAttribs( mGlslProg ? mGlslProg : SdfText::meshShader() );
+		const float batchEmbolden = runs.empty() ? 0.0f : sdfText->getEmboldenDistance( runs.front()->getOptions().getDrawOptions() );
+		const float batchClip = runs.empty() ? 0.0f : getClipSlot( runs.front()->getClipId() );
+		for( const auto &run : runs ) {
+			if( ! run->getColorSpans().empty() ) {
+				attribs |= toBits( VertexAttrib::SPAN_INDEX );
+			}
+			if( sdfText->getEmboldenDistance( run->getOptions().getDrawOptions() ) != batchEmbolden ) {
+				attribs |= toBits( VertexAttrib::EMBOLDEN );
+			}
+			if( getClipSlot( run->getClipId() ) != batchClip ) {
+				attribs |= toBits( VertexAttrib::CLIP );
+			}
+		}
+
+		std::vector<vec2> greekWordVertices, greekLineVertices;
+		float maxFontSize = 0.0f;
 		std::unordered_map<RunRef, std::pair<uint32_t, uint32_t>> runVertRanges;
 		std::unordered_map<Texture2dRef, ClientMesh> texToMesh;
 		for( const auto &run : runs ) {
@@ -291,20 +557,40 @@ void SdfTextMesh::cache()
 			const auto &options = run->getOptions();	
 			auto &bounds = run->mBounds;
 			std::vector<std::pair<uint8_t, std::vector<SdfText::CharPlacement>>> placements; 
-			if( run->getWrapped() ) {
+			const bool onPath = ! run->getPath().empty();
+			if( onPath ) {
+				// Bounds follow the turned quads, they are gathered with the vertices
+				const auto glyphMeasures = sdfText->getGlyphPlacements( run->getUtf8(), options.getDrawOptions() );
+				placements = sdfText->placeGlyphsOnPath( glyphMeasures, run->getPath(), run->getPathOffset(), options.getDrawOptions(), run->getColorSpans() );
+				bounds = Rectf( 0, 0, 0, 0 );
+			}
+			else if( run->getWrapped() ) {
 				const Rectf &fitRect = run->getFitRect();
 				vec2 offset = vec2( run->getPosition() );
-				placements = sdfText->placeStringWrapped( run->getUtf8(), fitRect, offset, options.getDrawOptions() );
+				placements = sdfText->placeStringWrapped( run->getUtf8(), fitRect, offset, options.getDrawOptions(), run->getColorSpans() );
 				bounds = sdfText->measureStringBoundsWrapped( run->getUtf8(), fitRect, options.getDrawOptions() );
 				bounds += vec2( fitRect.x1, fitRect.y1 );
 				bounds += offset;
 			}
 			else {
 				vec2 baseline = vec2( run->getBaseline() );
-				placements = sdfText->placeString( run->getUtf8(), baseline, options.getDrawOptions() );
+				placements = sdfText->placeString( run->getUtf8(), baseline, options.getDrawOptions(), run->getColorSpans() );
 				bounds = sdfText->measureStringBounds( run->getUtf8(),options.getDrawOptions() );
 				bounds += baseline;
 			}
+			// Glyphs can be added while the mesh is cached on another thread
+			SdfText::GlyphTablesReader tables( sdfText.get() );
+			if( onPath ) {
+				appendGreekGlyphBars( placements, tables->mGlyphMetrics, &greekWordVertices, &greekLineVertices );
+			}
+			else {
+				appendGreekBars( placements, tables->mGlyphMetrics, &greekWordVertices, &greekLineVertices );
+			}
+			maxFontSize = std::max( maxFontSize, sdfText->getFont().getSize() * options.getDrawScale() );
+			// Synthetic styles, the bold offset goes to the shader as a distance offset and oblique shears the quads
+			const float emboldenDistance = sdfText->getEmboldenDistance( options.getDrawOptions() );
+			const float oblique = options.getOblique();
+			const float clip = getClipSlot( run->getClipId() );
 			for( const auto &placementsIt : placements ) {
 				Texture2dRef tex = textures[placementsIt.first];
 				const auto& charPlacements = placementsIt.second;
@@ -312,23 +598,38 @@ void SdfTextMesh::cache()
 					continue;
 				}
 
-				auto &mesh = texToMesh[tex];
+				auto meshIt = texToMesh.find( tex );
+				if( texToMesh.end() == meshIt ) {
+					meshIt = texToMesh.insert( std::make_pair( tex, ClientMesh( mMemoryResource, attribs, batchEmbolden, batchClip ) ) ).first;
+					if( hasVertexAttrib( attribs, VertexAttrib::SPAN_INDEX ) ) {
+						meshIt->second.startSpanColorRange();
+					}
+				}
+				auto &mesh = meshIt->second;
 				vertRange.first = static_cast<uint32_t>( mesh.getNumIndices() );
 				for( const auto& place : charPlacements ) {
-					const auto& srcTexCoords = place.mSrcTexCoords;
-					const auto& destRect = place.mDstRect;
-					vec2 P0 = vec2( destRect.getX2(), destRect.getY1() );
-					vec2 P1 = vec2( destRect.getX1(), destRect.getY1() );
-					vec2 P2 = vec2( destRect.getX2(), destRect.getY2() );
-					vec2 P3 = vec2( destRect.getX1(), destRect.getY2() );
-					vec2 uv0 = vec2( srcTexCoords.getX2(), srcTexCoords.getY1() );
-					vec2 uv1 = vec2( srcTexCoords.getX1(), srcTexCoords.getY1() );
-					vec2 uv2 = vec2( srcTexCoords.getX2(), srcTexCoords.getY2() );
-					vec2 uv3 = vec2( srcTexCoords.getX1(), srcTexCoords.getY2() );
-					mesh.appendVertex( P0, uv0 );
-					mesh.appendVertex( P1, uv1 );
-					mesh.appendVertex( P2, uv2 );
-					mesh.appendVertex( P3, uv3 );
+					// Sheared by the oblique and turned about the pen position to follow the path
+					vec2 P[4], uv[4];
+					place.calcQuad( oblique, P, uv );
+					if( onPath ) {
+						for( const auto &corner : P ) {
+							if( ( bounds.getWidth() > 0 ) || ( bounds.getHeight() > 0 ) ) {
+								bounds.include( corner );
+							}
+							else {
+								bounds = Rectf( corner, corner + vec2( 0.001f ) );
+							}
+						}
+					}
+					ClientMesh::Vertex vertex;
+					vertex.spanIndex = mesh.getSpanIndex( place.mColor );
+					vertex.glyphInfo = vec3( static_cast<float>( place.mIndex ), static_cast<float>( place.mLine ), place.mRunPosition );
+					vertex.glyphCenter = place.calcInkCenter( oblique );
+					vertex.embolden = emboldenDistance;
+					vertex.clip = clip;
+					for( int i = 0; i < 4; ++i ) {
+						vertex.pos = P[i]; vertex.uv = uv[i]; mesh.appendVertex( vertex );
+					}
 			
 					uint32_t nverts = static_cast<uint32_t>( mesh.getNumVertices() );
 					uint32_t v0 = nverts - 4;
@@ -341,46 +642,182 @@ void SdfTextMesh::cache()
 				vertRange.second = static_cast<uint32_t>( mesh.getNumIndices() );
 				runVertRanges[run] = vertRange;
 			}
+
+			if( hasBounds ) {
+				mBounds.include( bounds );
+			}
+			else {
+				mBounds = bounds;
+				hasBounds = true;
+			}
 		}
 
 		auto& textDraws = mTextDrawMaps[sdfText];
-		for( const auto& tmIt : texToMesh ) {
+		for( auto& tmIt : texToMesh ) {
 			auto& tex = tmIt.first;
 			auto& mesh = tmIt.second;
 			auto& textBatch = textDraws->mTextBatches[tex];
+			mesh.finishSpanColorRanges();
 
+			// The layout follows the attributes the runs need, rebuild the batch when they change
+			if( textBatch.mBatch && ( textBatch.mAttribs != mesh.mAttribs ) ) {
+				textBatch = TextBatch();
+			}
 			if( ! textBatch.mBatch ) {
 				// Create index buffer
 				textBatch.mIndexBuffer = Vbo::create( GL_ELEMENT_ARRAY_BUFFER );
 				// Create vertex layout
+				const size_t stride = mesh.getStride();
 				auto vertexLayout = geom::BufferLayout();
-				vertexLayout.append( geom::POSITION,    4, sizeof( ClientMesh::Vertex ), static_cast<size_t>( offsetof( ClientMesh::Vertex, pos ) ) );
-				vertexLayout.append( geom::TEX_COORD_0, 2, sizeof( ClientMesh::Vertex ), static_cast<size_t>( offsetof( ClientMesh::Vertex, uv  ) ) );
+				vertexLayout.append( geom::POSITION,    4, stride, 0 );
+				vertexLayout.append( geom::TEX_COORD_0, 2, stride, sizeof( float ) * 4 );
+				if( hasVertexAttrib( mesh.mAttribs, VertexAttrib::SPAN_INDEX ) ) {
+					vertexLayout.append( geom::CUSTOM_4, 1, stride, mesh.getOffset( VertexAttrib::SPAN_INDEX ) );
+				}
+				if( hasVertexAttrib( mesh.mAttribs, VertexAttrib::GLYPH_INFO ) ) {
+					vertexLayout.append( geom::CUSTOM_0, 3, stride, mesh.getOffset( VertexAttrib::GLYPH_INFO ) );
+					vertexLayout.append( geom::CUSTOM_1, 2, stride, mesh.getOffset( VertexAttrib::GLYPH_INFO ) + sizeof( float ) * 3 );
+				}
+				if( hasVertexAttrib( mesh.mAttribs, VertexAttrib::EMBOLDEN ) ) {
+					vertexLayout.append( geom::CUSTOM_2, 1, stride, mesh.getOffset( VertexAttrib::EMBOLDEN ) );
+				}
+				if( hasVertexAttrib( mesh.mAttribs, VertexAttrib::CLIP ) ) {
+					vertexLayout.append( geom::CUSTOM_3, 1, stride, mesh.getOffset( VertexAttrib::CLIP ) );
+				}
 				// Create Vertex buffer
 				textBatch.mVertexBuffer = Vbo::create( GL_ARRAY_BUFFER );
 				// Create vbo mesh - index count is passed in to prevent data corruption on NVIDIA cards
 				VboMeshRef vboMesh = VboMesh::create( 0, GL_TRIANGLES, { std::make_pair( vertexLayout, textBatch.mVertexBuffer  ) }, mesh.getNumIndices(), GL_UNSIGNED_INT, textBatch.mIndexBuffer );
-				// Create batch using vbo mesh and default SdfText sahder
-				textBatch.mBatch = Batch::create( vboMesh, SdfText::defaultShader() );
+				const auto& shader = mGlslProg ? mGlslProg : SdfText::meshShader();
+				textBatch.mBatch = Batch::create( vboMesh, shader, { { geom::CUSTOM_0, "aGlyphInfo" }, { geom::CUSTOM_1, "aGlyphCenter" }, { geom::CUSTOM_2, "aEmbolden" }, { geom::CUSTOM_3, "aClipIndex" }, { geom::CUSTOM_4, "aSpanIndex" } } );
+				textBatch.mAttribs = mesh.mAttribs;
 			}
 
 			// Buffer index and vertex data
 			textBatch.mIndexBuffer->bufferData( sizeof( uint32_t ) * mesh.getNumIndices(), mesh.getIndicesData(), GL_STATIC_DRAW );
-			textBatch.mVertexBuffer->bufferData( sizeof( ClientMesh::Vertex ) * mesh.getNumVertices(), mesh.getVerticesData(), GL_STATIC_DRAW );
+			textBatch.mVertexBuffer->bufferData( sizeof( float ) * mesh.mVertices.size(), mesh.getVerticesData(), GL_STATIC_DRAW );
 			// Update Index count
 			textBatch.mIndexCount = mesh.getNumIndices();
+			textBatch.mSpanColorRanges.assign( std::begin( mesh.mSpanColorRanges ), std::end( mesh.mSpanColorRanges ) );
+			textBatch.mEmbolden = mesh.mEmbolden;
+			textBatch.mClip = mesh.mClip;
+		}
+
+		// Greeking bars share one buffer, words first then lines
+		textDraws->mMaxFontSize = maxFontSize;
+		textDraws->mGreekWordVertexCount = static_cast<uint32_t>( greekWordVertices.size() );
+		textDraws->mGreekLineVertexCount = static_cast<uint32_t>( greekLineVertices.size() );
+		greekWordVertices.insert( std::end( greekWordVertices ), std::begin( greekLineVertices ), std::end( greekLineVertices ) );
+		if( ! greekWordVertices.empty() ) {
+			if( ! textDraws->mGreekBatch ) {
+				auto vertexLayout = geom::BufferLayout();
+				vertexLayout.append( geom::POSITION, 2, sizeof( vec2 ), 0 );
+				textDraws->mGreekVertexBuffer = Vbo::create( GL_ARRAY_BUFFER );
+				VboMeshRef vboMesh = VboMesh::create( static_cast<uint32_t>( greekWordVertices.size() ), GL_TRIANGLES, { std::make_pair( vertexLayout, textDraws->mGreekVertexBuffer ) } );
+				textDraws->mGreekBatch = Batch::create( vboMesh, gl::getStockShader( gl::ShaderDef().color() ) );
+			}
+			textDraws->mGreekVertexBuffer->bufferData( sizeof( vec2 ) * greekWordVertices.size(), greekWordVertices.data(), GL_STATIC_DRAW );
 		}
 	}
 
+	if( ! hasBounds ) {
+		mBounds = Rectf( 0, 0, 0, 0 );
+	}
+
+	mImpostor.invalidate();
 	mDirty = false;
 }
 
+void SdfTextMesh::setGlslProg( const GlslProgRef &glslProg )
+{
+	const auto& prevShader = mGlslProg ? mGlslProg : SdfText::meshShader();
+	const auto& shader = glslProg ? glslProg : SdfText::meshShader();
+	// Glyph attributes are only in the vertices for shaders that read them
+	if( getShaderVertexAttribs( shader ) != getShaderVertexAttribs( prevShader ) ) {
+		mDirty = true;
+	}
+	mGlslProg = glslProg;
+	mImpostor.invalidate();
+	for( auto& textDrawIt : mTextDrawMaps ) {
+		for( auto& textBatchIt : textDrawIt.second->mTextBatches ) {
+			if( textBatchIt.second.mBatch ) {
+				textBatchIt.second.mBatch->replaceGlslProg( shader );
+			}
+		}
+	}
+}
+
+void SdfTextMesh::setClipRect( uint32_t clipId, const Rectf &rect )
+{
+	if( ( 0 == clipId ) || ( clipId > MAX_CLIP_RECTS ) ) {
+		throw ci::Exception( "clip id out of range" );
+	}
+	const Rectf r = rect.canonicalized();
+	mClipRects[clipId] = vec4( r.x1, r.y1, r.x2, r.y2 );
+	mImpostor.invalidate();
+}
+
+void SdfTextMesh::clearClipRect( uint32_t clipId )
+{
+	if( ( 0 == clipId ) || ( clipId > MAX_CLIP_RECTS ) ) {
+		return;
+	}
+	mClipRects[clipId] = kNoClipRect;
+	mImpostor.invalidate();
+}
+
+Rectf SdfTextMesh::getClipRect( uint32_t clipId ) const
+{
+	const vec4 &r = ( clipId <= MAX_CLIP_RECTS ) ? mClipRects[clipId] : kNoClipRect;
+	return Rectf( r.x, r.y, r.z, r.w );
+}
+
+void SdfTextMesh::setImpostorEnabled( bool value )
+{
+	mImpostorEnabled = value;
+	if( ! mImpostorEnabled ) {
+		mImpostor.release();
+	}
+}
+
 void SdfTextMesh::draw( bool premultiply, float gamma )
 {
 	cache();
 
+	if( mImpostorEnabled ) {
+		// The impostor composites premultiplied, so render premultiplied regardless of the argument
+		if( gamma != mImpostorGamma ) {
+			mImpostor.invalidate();
+			mImpostorGamma = gamma;
+		}
+		mImpostor.draw( mBounds, [this, gamma]() { drawBatches( true, gamma ); } );
+		return;
+	}
+
+	drawBatches( premultiply, gamma );
+}
+
+void SdfTextMesh::drawBatches( bool premultiply, float gamma )
+{
+	const float pixelScale = ( mGreekingThreshold > 0.0f ) ? SdfText::getPixelScale() : 0.0f;
 	for( auto& textDrawIt : mTextDrawMaps ) {
 		auto& textDraw = textDrawIt.second;
+
+		// Text too small to read is drawn as bars from the cached layout
+		if( ( mGreekingThreshold > 0.0f ) && textDraw->mGreekBatch && ( ( textDraw->mMaxFontSize * pixelScale ) < mGreekingThreshold ) ) {
+			const bool lines = ( Greeking::LINES == mGreeking );
+			const uint32_t first = lines ? textDraw->mGreekWordVertexCount : 0;
+			const uint32_t count = lines ? textDraw->mGreekLineVertexCount : textDraw->mGreekWordVertexCount;
+			ColorA color = gl::context()->getCurrentColor();
+			color.a *= mGreekingAlpha;
+			if( premultiply ) {
+				color = ColorA( color.r * color.a, color.g * color.a, color.b * color.a, color.a );
+			}
+			gl::ScopedColor colorScp( color );
+			textDraw->mGreekBatch->draw( first, count );
+			continue;
+		}
+
 		for( auto& textBatchIt : textDraw->mTextBatches ) {
 			auto& tex = textBatchIt.first;
 			auto& textBatch = textBatchIt.second;
@@ -394,9 +831,33 @@ void SdfTextMesh::draw( bool premultiply, float gamma )
 			shader->uniform( "uFgColor", gl::context()->getCurrentColor() );
 			shader->uniform( "uPremultiply", premultiply ? 1.0f : 0.0f );
 			shader->uniform( "uGamma", gamma );
+			if( shader->getUniformLocation( "uClipRects" ) >= 0 ) {
+				shader->uniform( "uClipRects", mClipRects.data(), static_cast<int>( mClipRects.size() ) );
+			}
 
+			// Without spans every glyph uses slot 0
+			const int spanIndexLoc = shader->getAttribLocation( "aSpanIndex" );
+			if( ( spanIndexLoc >= 0 ) && ( ! hasVertexAttrib( textBatch.mAttribs, VertexAttrib::SPAN_INDEX ) ) ) {
+				gl::vertexAttrib1f( spanIndexLoc, 0.0f );
+			}
+			// Runs with the same embolden distance share it as a constant attribute
+			const int emboldenLoc = shader->getAttribLocation( "aEmbolden" );
+			if( ( emboldenLoc >= 0 ) && ( ! hasVertexAttrib( textBatch.mAttribs, VertexAttrib::EMBOLDEN ) ) ) {
+				gl::vertexAttrib1f( emboldenLoc, textBatch.mEmbolden );
+			}
+			const int clipLoc = shader->getAttribLocation( "aClipIndex" );
+			if( ( clipLoc >= 0 ) && ( ! hasVertexAttrib( textBatch.mAttribs, VertexAttrib::CLIP ) ) ) {
+				gl::vertexAttrib1f( clipLoc, textBatch.mClip );
+			}
 
-			batch->draw( 0, textBatch.mIndexCount );
+			// Each span color table covers a range of the indices, usually all of them
+			const bool hasSpanColors = ( shader->getUniformLocation( "uSpanColors" ) >= 0 );
+			for( const auto& range : textBatch.mSpanColorRanges ) {
+				if( hasSpanColors ) {
+					shader->uniform( "uSpanColors", range.mColors.data(), static_cast<int>( range.mColors.size() ) );
+				}
+				batch->draw( static_cast<GLint>( range.mIndexStart ), static_cast<GLsizei>( range.mIndexCount ) );
+			}
 		}
 	}
 }
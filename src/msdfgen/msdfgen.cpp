@@ -5,57 +5,95 @@
 
 namespace msdfgen {
 
-void generateSDF(Bitmap<float> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate) {
-    int w = output.width(), h = output.height();
+static ParallelFor parallelForRows = NULL;
+
+void setParallelFor(ParallelFor parallelFor) {
+    parallelForRows = parallelFor;
+}
+
+/// Calls body for each row, using the installed ParallelFor if there is one.
+static void forEachRow(int h, void (*body)(int, void *), void *userData) {
+    if (parallelForRows) {
+        parallelForRows(h, body, userData);
+        return;
+    }
 #ifdef MSDFGEN_USE_OPENMP
     #pragma omp parallel for
 #endif
-    for (int y = 0; y < h; ++y) {
-        int row = shape.inverseYAxis ? h-y-1 : y;
-        for (int x = 0; x < w; ++x) {
-            double dummy;
-            Point2 p = Vector2(x+.5, y+.5)/scale-translate;
-            SignedDistance minDistance;
-            for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
-                for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge) {
-                    SignedDistance distance = (*edge)->signedDistance(p, dummy);
-                    if (distance < minDistance)
-                        minDistance = distance;
-                }
-            output(x, row) = float(minDistance.distance/range+.5);
-        }
+    for (int y = 0; y < h; ++y)
+        body(y, userData);
+}
+
+/// Arguments of a generator, shared by its rows.
+template <typename T>
+struct GeneratorRows {
+    Bitmap<T> *output;
+    const Shape *shape;
+    double range;
+    Vector2 scale, translate;
+};
+
+static void generateSDFRow(int y, void *userData) {
+    const GeneratorRows<float> &rows = *static_cast<const GeneratorRows<float> *>(userData);
+    Bitmap<float> &output = *rows.output;
+    const Shape &shape = *rows.shape;
+    double range = rows.range;
+    const Vector2 &scale = rows.scale, &translate = rows.translate;
+    int w = output.width(), h = output.height();
+    int row = shape.inverseYAxis ? h-y-1 : y;
+    for (int x = 0; x < w; ++x) {
+        double dummy;
+        Point2 p = Vector2(x+.5, y+.5)/scale-translate;
+        SignedDistance minDistance;
+        for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
+            for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge) {
+                SignedDistance distance = (*edge)->signedDistance(p, dummy);
+                if (distance < minDistance)
+                    minDistance = distance;
+            }
+        output(x, row) = float(minDistance.distance/range+.5);
     }
 }
 
-void generatePseudoSDF(Bitmap<float> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate) {
+void generateSDF(Bitmap<float> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate) {
+    GeneratorRows<float> rows = { &output, &shape, range, scale, translate };
+    forEachRow(output.height(), generateSDFRow, &rows);
+}
+
+static void generatePseudoSDFRow(int y, void *userData) {
+    const GeneratorRows<float> &rows = *static_cast<const GeneratorRows<float> *>(userData);
+    Bitmap<float> &output = *rows.output;
+    const Shape &shape = *rows.shape;
+    double range = rows.range;
+    const Vector2 &scale = rows.scale, &translate = rows.translate;
     int w = output.width(), h = output.height();
-#ifdef MSDFGEN_USE_OPENMP
-    #pragma omp parallel for
-#endif
-    for (int y = 0; y < h; ++y) {
-        int row = shape.inverseYAxis ? h-y-1 : y;
-        for (int x = 0; x < w; ++x) {
-            Point2 p = Vector2(x+.5, y+.5)/scale-translate;
-            SignedDistance minDistance;
-            const EdgeHolder *nearEdge = NULL;
-            double nearParam = 0;
-            for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
-                for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge) {
-                    double param;
-                    SignedDistance distance = (*edge)->signedDistance(p, param);
-                    if (distance < minDistance) {
-                        minDistance = distance;
-                        nearEdge = &*edge;
-                        nearParam = param;
-                    }
+    int row = shape.inverseYAxis ? h-y-1 : y;
+    for (int x = 0; x < w; ++x) {
+        Point2 p = Vector2(x+.5, y+.5)/scale-translate;
+        SignedDistance minDistance;
+        const EdgeHolder *nearEdge = NULL;
+        double nearParam = 0;
+        for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
+            for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge) {
+                double param;
+                SignedDistance distance = (*edge)->signedDistance(p, param);
+                if (distance < minDistance) {
+                    minDistance = distance;
+                    nearEdge = &*edge;
+                    nearParam = param;
                 }
-            if (nearEdge)
-                (*nearEdge)->distanceToPseudoDistance(minDistance, p, nearParam);
-            output(x, row) = float(minDistance.distance/range+.5);
-        }
+            }
+        if (nearEdge)
+            (*nearEdge)->distanceToPseudoDistance(minDistance, p, nearParam);
+        output(x, row) = float(minDistance.distance/range+.5);
     }
 }
 
+void generatePseudoSDF(Bitmap<float> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate) {
+    GeneratorRows<float> rows = { &output, &shape, range, scale, translate };
+    forEachRow(output.height(), generatePseudoSDFRow, &rows);
+}
+
 static inline bool pixelClash(const FloatRGB &a, const FloatRGB &b, double threshold) {
     // Only consider pair where both are on the inside or both are on the outside
     bool aIn = (a.r > .5f)+(a.g > .5f)+(a.b > .5f) >= 2;
@@ -108,56 +146,61 @@ void msdfErrorCorrection(Bitmap<FloatRGB> &output, const Vector2 &threshold) {
     }
 }
 
-void generateMSDF(Bitmap<FloatRGB> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate, double edgeThreshold) {
+static void generateMSDFRow(int y, void *userData) {
+    const GeneratorRows<FloatRGB> &rows = *static_cast<const GeneratorRows<FloatRGB> *>(userData);
+    Bitmap<FloatRGB> &output = *rows.output;
+    const Shape &shape = *rows.shape;
+    double range = rows.range;
+    const Vector2 &scale = rows.scale, &translate = rows.translate;
     int w = output.width(), h = output.height();
-#ifdef MSDFGEN_USE_OPENMP
-    #pragma omp parallel for
-#endif
-    for (int y = 0; y < h; ++y) {
-        int row = shape.inverseYAxis ? h-y-1 : y;
-        for (int x = 0; x < w; ++x) {
-            Point2 p = Vector2(x+.5, y+.5)/scale-translate;
-
-            struct {
-                SignedDistance minDistance;
-                const EdgeHolder *nearEdge;
-                double nearParam;
-            } r, g, b;
-            r.nearEdge = g.nearEdge = b.nearEdge = NULL;
-            r.nearParam = g.nearParam = b.nearParam = 0;
-
-            for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
-                for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge) {
-                    double param;
-                    SignedDistance distance = (*edge)->signedDistance(p, param);
-                    if ((*edge)->color&RED && distance < r.minDistance) {
-                        r.minDistance = distance;
-                        r.nearEdge = &*edge;
-                        r.nearParam = param;
-                    }
-                    if ((*edge)->color&GREEN && distance < g.minDistance) {
-                        g.minDistance = distance;
-                        g.nearEdge = &*edge;
-                        g.nearParam = param;
-                    }
-                    if ((*edge)->color&BLUE && distance < b.minDistance) {
-                        b.minDistance = distance;
-                        b.nearEdge = &*edge;
-                        b.nearParam = param;
-                    }
+    int row = shape.inverseYAxis ? h-y-1 : y;
+    for (int x = 0; x < w; ++x) {
+        Point2 p = Vector2(x+.5, y+.5)/scale-translate;
+
+        struct {
+            SignedDistance minDistance;
+            const EdgeHolder *nearEdge;
+            double nearParam;
+        } r, g, b;
+        r.nearEdge = g.nearEdge = b.nearEdge = NULL;
+        r.nearParam = g.nearParam = b.nearParam = 0;
+
+        for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
+            for (std::vector<EdgeHolder>::const_iterator edge = contour->edges.begin(); edge != contour->edges.end(); ++edge) {
+                double param;
+                SignedDistance distance = (*edge)->signedDistance(p, param);
+                if ((*edge)->color&RED && distance < r.minDistance) {
+                    r.minDistance = distance;
+                    r.nearEdge = &*edge;
+                    r.nearParam = param;
+                }
+                if ((*edge)->color&GREEN && distance < g.minDistance) {
+                    g.minDistance = distance;
+                    g.nearEdge = &*edge;
+                    g.nearParam = param;
                 }
+                if ((*edge)->color&BLUE && distance < b.minDistance) {
+                    b.minDistance = distance;
+                    b.nearEdge = &*edge;
+                    b.nearParam = param;
+                }
+            }
 
-            if (r.nearEdge)
-                (*r.nearEdge)->distanceToPseudoDistance(r.minDistance, p, r.nearParam);
-            if (g.nearEdge)
-                (*g.nearEdge)->distanceToPseudoDistance(g.minDistance, p, g.nearParam);
-            if (b.nearEdge)
-                (*b.nearEdge)->distanceToPseudoDistance(b.minDistance, p, b.nearParam);
-            output(x, row).r = float(r.minDistance.distance/range+.5);
-            output(x, row).g = float(g.minDistance.distance/range+.5);
-            output(x, row).b = float(b.minDistance.distance/range+.5);
-        }
+        if (r.nearEdge)
+            (*r.nearEdge)->distanceToPseudoDistance(r.minDistance, p, r.nearParam);
+        if (g.nearEdge)
+            (*g.nearEdge)->distanceToPseudoDistance(g.minDistance, p, g.nearParam);
+        if (b.nearEdge)
+            (*b.nearEdge)->distanceToPseudoDistance(b.minDistance, p, b.nearParam);
+        output(x, row).r = float(r.minDistance.distance/range+.5);
+        output(x, row).g = float(g.minDistance.distance/range+.5);
+        output(x, row).b = float(b.minDistance.distance/range+.5);
     }
+}
+
+void generateMSDF(Bitmap<FloatRGB> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate, double edgeThreshold) {
+    GeneratorRows<FloatRGB> rows = { &output, &shape, range, scale, translate };
+    forEachRow(output.height(), generateMSDFRow, &rows);
 
     if (edgeThreshold > 0)
         msdfErrorCorrection(output, edgeThreshold/(scale*range));